@@ -0,0 +1,31 @@
+-- Migration script adding hand history tables
+-- The server appends finished hands to these in batches with COPY (see server/include/history.h)
+
+-- One row per finished hand
+CREATE TABLE IF NOT EXISTS hand_history
+(
+    hand_key BIGINT PRIMARY KEY, -- Assigned by the server: Unix milliseconds << 20 plus a counter
+    table_id INTEGER     NOT NULL,
+    hand_no  INTEGER     NOT NULL, -- Hand number at the table
+    ended_at TIMESTAMPTZ NOT NULL,
+    board    VARCHAR(10) NOT NULL, -- Community cards, e.g. 'AhKd7c2s9s'
+    pot      INTEGER     NOT NULL,
+    actions  TEXT        NOT NULL  -- Seat, action and chips put in, e.g. '3c100 4f 5r300'; blinds are not listed
+);
+
+-- One row per player dealt into a hand. No foreign keys: rows arrive by COPY in large batches, and
+-- each batch's hands and players commit in one transaction.
+CREATE TABLE IF NOT EXISTS hand_players
+(
+    hand_key    BIGINT     NOT NULL,
+    seat        SMALLINT   NOT NULL,
+    user_id     INTEGER    NOT NULL, -- For a bot, the player it replaced
+    is_bot      BOOLEAN    NOT NULL,
+    hole_cards  VARCHAR(4) NOT NULL,
+    start_stack INTEGER    NOT NULL,
+    bet         INTEGER    NOT NULL, -- Chips put in the pot, blinds included
+    won         INTEGER    NOT NULL, -- Chips taken from the pot
+    PRIMARY KEY (hand_key, seat)
+);
+
+CREATE INDEX IF NOT EXISTS idx_hand_players_user ON hand_players(user_id, hand_key);
@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_server.dir/src/admin.c.o"
+  "CMakeFiles/Cardio_server.dir/src/admin.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/bot.c.o"
+  "CMakeFiles/Cardio_server.dir/src/bot.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/game_room.c.o"
+  "CMakeFiles/Cardio_server.dir/src/game_room.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/handler.c.o"
+  "CMakeFiles/Cardio_server.dir/src/handler.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/handoff.c.o"
+  "CMakeFiles/Cardio_server.dir/src/handoff.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/history.c.o"
+  "CMakeFiles/Cardio_server.dir/src/history.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/journal.c.o"
+  "CMakeFiles/Cardio_server.dir/src/journal.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/leaderboard.c.o"
+  "CMakeFiles/Cardio_server.dir/src/leaderboard.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/lobby.c.o"
+  "CMakeFiles/Cardio_server.dir/src/lobby.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/mailbox.c.o"
+  "CMakeFiles/Cardio_server.dir/src/mailbox.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/main.c.o"
+  "CMakeFiles/Cardio_server.dir/src/main.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/metrics.c.o"
+  "CMakeFiles/Cardio_server.dir/src/metrics.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/outbox.c.o"
+  "CMakeFiles/Cardio_server.dir/src/outbox.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/presence.c.o"
+  "CMakeFiles/Cardio_server.dir/src/presence.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/protocol.c.o"
+  "CMakeFiles/Cardio_server.dir/src/protocol.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/protocol_game.c.o"
+  "CMakeFiles/Cardio_server.dir/src/protocol_game.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/replay_log.c.o"
+  "CMakeFiles/Cardio_server.dir/src/replay_log.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/server.c.o"
+  "CMakeFiles/Cardio_server.dir/src/server.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/session.c.o"
+  "CMakeFiles/Cardio_server.dir/src/session.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/social_cache.c.o"
+  "CMakeFiles/Cardio_server.dir/src/social_cache.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/spectator.c.o"
+  "CMakeFiles/Cardio_server.dir/src/spectator.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/table_actor.c.o"
+  "CMakeFiles/Cardio_server.dir/src/table_actor.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/uring.c.o"
+  "CMakeFiles/Cardio_server.dir/src/uring.c.o.d"
+  "CMakeFiles/Cardio_server.dir/src/utils.c.o"
+  "CMakeFiles/Cardio_server.dir/src/utils.c.o.d"
+  "Cardio_server"
+  "Cardio_server.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,42 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/server/src/admin.c" "CMakeFiles/bench_protocol.dir/src/admin.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/admin.c.o.d"
+  "/root/repo/server/src/bot.c" "CMakeFiles/bench_protocol.dir/src/bot.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/bot.c.o.d"
+  "/root/repo/server/src/game_room.c" "CMakeFiles/bench_protocol.dir/src/game_room.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/game_room.c.o.d"
+  "/root/repo/server/src/handler.c" "CMakeFiles/bench_protocol.dir/src/handler.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/handler.c.o.d"
+  "/root/repo/server/src/handoff.c" "CMakeFiles/bench_protocol.dir/src/handoff.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/handoff.c.o.d"
+  "/root/repo/server/src/history.c" "CMakeFiles/bench_protocol.dir/src/history.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/history.c.o.d"
+  "/root/repo/server/src/journal.c" "CMakeFiles/bench_protocol.dir/src/journal.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/journal.c.o.d"
+  "/root/repo/server/src/leaderboard.c" "CMakeFiles/bench_protocol.dir/src/leaderboard.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/leaderboard.c.o.d"
+  "/root/repo/server/src/lobby.c" "CMakeFiles/bench_protocol.dir/src/lobby.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/lobby.c.o.d"
+  "/root/repo/server/src/mailbox.c" "CMakeFiles/bench_protocol.dir/src/mailbox.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/mailbox.c.o.d"
+  "/root/repo/server/src/metrics.c" "CMakeFiles/bench_protocol.dir/src/metrics.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/metrics.c.o.d"
+  "/root/repo/server/src/outbox.c" "CMakeFiles/bench_protocol.dir/src/outbox.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/outbox.c.o.d"
+  "/root/repo/server/src/presence.c" "CMakeFiles/bench_protocol.dir/src/presence.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/presence.c.o.d"
+  "/root/repo/server/src/protocol.c" "CMakeFiles/bench_protocol.dir/src/protocol.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/protocol.c.o.d"
+  "/root/repo/server/src/protocol_game.c" "CMakeFiles/bench_protocol.dir/src/protocol_game.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/protocol_game.c.o.d"
+  "/root/repo/server/src/replay_log.c" "CMakeFiles/bench_protocol.dir/src/replay_log.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/replay_log.c.o.d"
+  "/root/repo/server/src/server.c" "CMakeFiles/bench_protocol.dir/src/server.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/server.c.o.d"
+  "/root/repo/server/src/session.c" "CMakeFiles/bench_protocol.dir/src/session.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/session.c.o.d"
+  "/root/repo/server/src/social_cache.c" "CMakeFiles/bench_protocol.dir/src/social_cache.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/social_cache.c.o.d"
+  "/root/repo/server/src/spectator.c" "CMakeFiles/bench_protocol.dir/src/spectator.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/spectator.c.o.d"
+  "/root/repo/server/src/table_actor.c" "CMakeFiles/bench_protocol.dir/src/table_actor.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/table_actor.c.o.d"
+  "/root/repo/server/src/uring.c" "CMakeFiles/bench_protocol.dir/src/uring.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/uring.c.o.d"
+  "/root/repo/server/src/utils.c" "CMakeFiles/bench_protocol.dir/src/utils.c.o" "gcc" "CMakeFiles/bench_protocol.dir/src/utils.c.o.d"
+  "/root/repo/server/test/bench_protocol.c" "CMakeFiles/bench_protocol.dir/test/bench_protocol.c.o" "gcc" "CMakeFiles/bench_protocol.dir/test/bench_protocol.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_protocol.dir/src/admin.c.o"
+  "CMakeFiles/bench_protocol.dir/src/admin.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/bot.c.o"
+  "CMakeFiles/bench_protocol.dir/src/bot.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/game_room.c.o"
+  "CMakeFiles/bench_protocol.dir/src/game_room.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/handler.c.o"
+  "CMakeFiles/bench_protocol.dir/src/handler.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/handoff.c.o"
+  "CMakeFiles/bench_protocol.dir/src/handoff.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/history.c.o"
+  "CMakeFiles/bench_protocol.dir/src/history.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/journal.c.o"
+  "CMakeFiles/bench_protocol.dir/src/journal.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/leaderboard.c.o"
+  "CMakeFiles/bench_protocol.dir/src/leaderboard.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/lobby.c.o"
+  "CMakeFiles/bench_protocol.dir/src/lobby.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/mailbox.c.o"
+  "CMakeFiles/bench_protocol.dir/src/mailbox.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/metrics.c.o"
+  "CMakeFiles/bench_protocol.dir/src/metrics.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/outbox.c.o"
+  "CMakeFiles/bench_protocol.dir/src/outbox.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/presence.c.o"
+  "CMakeFiles/bench_protocol.dir/src/presence.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/protocol.c.o"
+  "CMakeFiles/bench_protocol.dir/src/protocol.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/protocol_game.c.o"
+  "CMakeFiles/bench_protocol.dir/src/protocol_game.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/replay_log.c.o"
+  "CMakeFiles/bench_protocol.dir/src/replay_log.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/server.c.o"
+  "CMakeFiles/bench_protocol.dir/src/server.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/session.c.o"
+  "CMakeFiles/bench_protocol.dir/src/session.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/social_cache.c.o"
+  "CMakeFiles/bench_protocol.dir/src/social_cache.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/spectator.c.o"
+  "CMakeFiles/bench_protocol.dir/src/spectator.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/table_actor.c.o"
+  "CMakeFiles/bench_protocol.dir/src/table_actor.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/uring.c.o"
+  "CMakeFiles/bench_protocol.dir/src/uring.c.o.d"
+  "CMakeFiles/bench_protocol.dir/src/utils.c.o"
+  "CMakeFiles/bench_protocol.dir/src/utils.c.o.d"
+  "CMakeFiles/bench_protocol.dir/test/bench_protocol.c.o"
+  "CMakeFiles/bench_protocol.dir/test/bench_protocol.c.o.d"
+  "bench_protocol"
+  "bench_protocol.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/bench_protocol.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
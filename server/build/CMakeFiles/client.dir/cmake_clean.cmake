@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/client.dir/src/admin.c.o"
+  "CMakeFiles/client.dir/src/admin.c.o.d"
+  "CMakeFiles/client.dir/src/bot.c.o"
+  "CMakeFiles/client.dir/src/bot.c.o.d"
+  "CMakeFiles/client.dir/src/game_room.c.o"
+  "CMakeFiles/client.dir/src/game_room.c.o.d"
+  "CMakeFiles/client.dir/src/handler.c.o"
+  "CMakeFiles/client.dir/src/handler.c.o.d"
+  "CMakeFiles/client.dir/src/handoff.c.o"
+  "CMakeFiles/client.dir/src/handoff.c.o.d"
+  "CMakeFiles/client.dir/src/history.c.o"
+  "CMakeFiles/client.dir/src/history.c.o.d"
+  "CMakeFiles/client.dir/src/journal.c.o"
+  "CMakeFiles/client.dir/src/journal.c.o.d"
+  "CMakeFiles/client.dir/src/leaderboard.c.o"
+  "CMakeFiles/client.dir/src/leaderboard.c.o.d"
+  "CMakeFiles/client.dir/src/lobby.c.o"
+  "CMakeFiles/client.dir/src/lobby.c.o.d"
+  "CMakeFiles/client.dir/src/mailbox.c.o"
+  "CMakeFiles/client.dir/src/mailbox.c.o.d"
+  "CMakeFiles/client.dir/src/metrics.c.o"
+  "CMakeFiles/client.dir/src/metrics.c.o.d"
+  "CMakeFiles/client.dir/src/outbox.c.o"
+  "CMakeFiles/client.dir/src/outbox.c.o.d"
+  "CMakeFiles/client.dir/src/presence.c.o"
+  "CMakeFiles/client.dir/src/presence.c.o.d"
+  "CMakeFiles/client.dir/src/protocol.c.o"
+  "CMakeFiles/client.dir/src/protocol.c.o.d"
+  "CMakeFiles/client.dir/src/protocol_game.c.o"
+  "CMakeFiles/client.dir/src/protocol_game.c.o.d"
+  "CMakeFiles/client.dir/src/replay_log.c.o"
+  "CMakeFiles/client.dir/src/replay_log.c.o.d"
+  "CMakeFiles/client.dir/src/server.c.o"
+  "CMakeFiles/client.dir/src/server.c.o.d"
+  "CMakeFiles/client.dir/src/session.c.o"
+  "CMakeFiles/client.dir/src/session.c.o.d"
+  "CMakeFiles/client.dir/src/social_cache.c.o"
+  "CMakeFiles/client.dir/src/social_cache.c.o.d"
+  "CMakeFiles/client.dir/src/spectator.c.o"
+  "CMakeFiles/client.dir/src/spectator.c.o.d"
+  "CMakeFiles/client.dir/src/table_actor.c.o"
+  "CMakeFiles/client.dir/src/table_actor.c.o.d"
+  "CMakeFiles/client.dir/src/uring.c.o"
+  "CMakeFiles/client.dir/src/uring.c.o.d"
+  "CMakeFiles/client.dir/src/utils.c.o"
+  "CMakeFiles/client.dir/src/utils.c.o.d"
+  "CMakeFiles/client.dir/test/client.c.o"
+  "CMakeFiles/client.dir/test/client.c.o.d"
+  "client"
+  "client.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/client.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/e2e_multiplayer_test.dir/src/admin.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/admin.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/bot.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/bot.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/game_room.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/game_room.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/handler.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/handler.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/handoff.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/handoff.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/history.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/history.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/journal.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/journal.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/leaderboard.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/leaderboard.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/lobby.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/lobby.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/mailbox.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/mailbox.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/metrics.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/metrics.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/outbox.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/outbox.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/presence.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/presence.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/protocol.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/protocol.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/protocol_game.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/protocol_game.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/replay_log.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/replay_log.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/server.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/server.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/session.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/session.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/social_cache.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/social_cache.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/spectator.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/spectator.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/table_actor.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/table_actor.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/uring.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/uring.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/utils.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/src/utils.c.o.d"
+  "CMakeFiles/e2e_multiplayer_test.dir/test/e2e_multiplayer_test.c.o"
+  "CMakeFiles/e2e_multiplayer_test.dir/test/e2e_multiplayer_test.c.o.d"
+  "e2e_multiplayer_test"
+  "e2e_multiplayer_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/e2e_multiplayer_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,42 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/server/src/admin.c" "CMakeFiles/e2e_table_invite_test.dir/src/admin.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/admin.c.o.d"
+  "/root/repo/server/src/bot.c" "CMakeFiles/e2e_table_invite_test.dir/src/bot.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/bot.c.o.d"
+  "/root/repo/server/src/game_room.c" "CMakeFiles/e2e_table_invite_test.dir/src/game_room.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/game_room.c.o.d"
+  "/root/repo/server/src/handler.c" "CMakeFiles/e2e_table_invite_test.dir/src/handler.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/handler.c.o.d"
+  "/root/repo/server/src/handoff.c" "CMakeFiles/e2e_table_invite_test.dir/src/handoff.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/handoff.c.o.d"
+  "/root/repo/server/src/history.c" "CMakeFiles/e2e_table_invite_test.dir/src/history.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/history.c.o.d"
+  "/root/repo/server/src/journal.c" "CMakeFiles/e2e_table_invite_test.dir/src/journal.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/journal.c.o.d"
+  "/root/repo/server/src/leaderboard.c" "CMakeFiles/e2e_table_invite_test.dir/src/leaderboard.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/leaderboard.c.o.d"
+  "/root/repo/server/src/lobby.c" "CMakeFiles/e2e_table_invite_test.dir/src/lobby.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/lobby.c.o.d"
+  "/root/repo/server/src/mailbox.c" "CMakeFiles/e2e_table_invite_test.dir/src/mailbox.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/mailbox.c.o.d"
+  "/root/repo/server/src/metrics.c" "CMakeFiles/e2e_table_invite_test.dir/src/metrics.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/metrics.c.o.d"
+  "/root/repo/server/src/outbox.c" "CMakeFiles/e2e_table_invite_test.dir/src/outbox.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/outbox.c.o.d"
+  "/root/repo/server/src/presence.c" "CMakeFiles/e2e_table_invite_test.dir/src/presence.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/presence.c.o.d"
+  "/root/repo/server/src/protocol.c" "CMakeFiles/e2e_table_invite_test.dir/src/protocol.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/protocol.c.o.d"
+  "/root/repo/server/src/protocol_game.c" "CMakeFiles/e2e_table_invite_test.dir/src/protocol_game.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/protocol_game.c.o.d"
+  "/root/repo/server/src/replay_log.c" "CMakeFiles/e2e_table_invite_test.dir/src/replay_log.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/replay_log.c.o.d"
+  "/root/repo/server/src/server.c" "CMakeFiles/e2e_table_invite_test.dir/src/server.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/server.c.o.d"
+  "/root/repo/server/src/session.c" "CMakeFiles/e2e_table_invite_test.dir/src/session.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/session.c.o.d"
+  "/root/repo/server/src/social_cache.c" "CMakeFiles/e2e_table_invite_test.dir/src/social_cache.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/social_cache.c.o.d"
+  "/root/repo/server/src/spectator.c" "CMakeFiles/e2e_table_invite_test.dir/src/spectator.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/spectator.c.o.d"
+  "/root/repo/server/src/table_actor.c" "CMakeFiles/e2e_table_invite_test.dir/src/table_actor.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/table_actor.c.o.d"
+  "/root/repo/server/src/uring.c" "CMakeFiles/e2e_table_invite_test.dir/src/uring.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/uring.c.o.d"
+  "/root/repo/server/src/utils.c" "CMakeFiles/e2e_table_invite_test.dir/src/utils.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/src/utils.c.o.d"
+  "/root/repo/server/test/e2e_table_invite_test.c" "CMakeFiles/e2e_table_invite_test.dir/test/e2e_table_invite_test.c.o" "gcc" "CMakeFiles/e2e_table_invite_test.dir/test/e2e_table_invite_test.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
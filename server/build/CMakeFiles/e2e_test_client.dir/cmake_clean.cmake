@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/e2e_test_client.dir/src/admin.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/admin.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/bot.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/bot.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/game_room.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/game_room.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/handler.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/handler.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/handoff.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/handoff.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/history.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/history.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/journal.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/journal.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/leaderboard.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/leaderboard.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/lobby.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/lobby.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/mailbox.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/mailbox.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/metrics.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/metrics.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/outbox.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/outbox.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/presence.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/presence.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/protocol.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/protocol.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/protocol_game.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/protocol_game.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/replay_log.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/replay_log.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/server.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/server.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/session.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/session.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/social_cache.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/social_cache.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/spectator.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/spectator.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/table_actor.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/table_actor.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/uring.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/uring.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/src/utils.c.o"
+  "CMakeFiles/e2e_test_client.dir/src/utils.c.o.d"
+  "CMakeFiles/e2e_test_client.dir/test/e2e_test_client.c.o"
+  "CMakeFiles/e2e_test_client.dir/test/e2e_test_client.c.o.d"
+  "e2e_test_client"
+  "e2e_test_client.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/e2e_test_client.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/loadgen.dir/src/admin.c.o"
+  "CMakeFiles/loadgen.dir/src/admin.c.o.d"
+  "CMakeFiles/loadgen.dir/src/bot.c.o"
+  "CMakeFiles/loadgen.dir/src/bot.c.o.d"
+  "CMakeFiles/loadgen.dir/src/game_room.c.o"
+  "CMakeFiles/loadgen.dir/src/game_room.c.o.d"
+  "CMakeFiles/loadgen.dir/src/handler.c.o"
+  "CMakeFiles/loadgen.dir/src/handler.c.o.d"
+  "CMakeFiles/loadgen.dir/src/handoff.c.o"
+  "CMakeFiles/loadgen.dir/src/handoff.c.o.d"
+  "CMakeFiles/loadgen.dir/src/history.c.o"
+  "CMakeFiles/loadgen.dir/src/history.c.o.d"
+  "CMakeFiles/loadgen.dir/src/journal.c.o"
+  "CMakeFiles/loadgen.dir/src/journal.c.o.d"
+  "CMakeFiles/loadgen.dir/src/leaderboard.c.o"
+  "CMakeFiles/loadgen.dir/src/leaderboard.c.o.d"
+  "CMakeFiles/loadgen.dir/src/lobby.c.o"
+  "CMakeFiles/loadgen.dir/src/lobby.c.o.d"
+  "CMakeFiles/loadgen.dir/src/mailbox.c.o"
+  "CMakeFiles/loadgen.dir/src/mailbox.c.o.d"
+  "CMakeFiles/loadgen.dir/src/metrics.c.o"
+  "CMakeFiles/loadgen.dir/src/metrics.c.o.d"
+  "CMakeFiles/loadgen.dir/src/outbox.c.o"
+  "CMakeFiles/loadgen.dir/src/outbox.c.o.d"
+  "CMakeFiles/loadgen.dir/src/presence.c.o"
+  "CMakeFiles/loadgen.dir/src/presence.c.o.d"
+  "CMakeFiles/loadgen.dir/src/protocol.c.o"
+  "CMakeFiles/loadgen.dir/src/protocol.c.o.d"
+  "CMakeFiles/loadgen.dir/src/protocol_game.c.o"
+  "CMakeFiles/loadgen.dir/src/protocol_game.c.o.d"
+  "CMakeFiles/loadgen.dir/src/replay_log.c.o"
+  "CMakeFiles/loadgen.dir/src/replay_log.c.o.d"
+  "CMakeFiles/loadgen.dir/src/server.c.o"
+  "CMakeFiles/loadgen.dir/src/server.c.o.d"
+  "CMakeFiles/loadgen.dir/src/session.c.o"
+  "CMakeFiles/loadgen.dir/src/session.c.o.d"
+  "CMakeFiles/loadgen.dir/src/social_cache.c.o"
+  "CMakeFiles/loadgen.dir/src/social_cache.c.o.d"
+  "CMakeFiles/loadgen.dir/src/spectator.c.o"
+  "CMakeFiles/loadgen.dir/src/spectator.c.o.d"
+  "CMakeFiles/loadgen.dir/src/table_actor.c.o"
+  "CMakeFiles/loadgen.dir/src/table_actor.c.o.d"
+  "CMakeFiles/loadgen.dir/src/uring.c.o"
+  "CMakeFiles/loadgen.dir/src/uring.c.o.d"
+  "CMakeFiles/loadgen.dir/src/utils.c.o"
+  "CMakeFiles/loadgen.dir/src/utils.c.o.d"
+  "CMakeFiles/loadgen.dir/test/loadgen.c.o"
+  "CMakeFiles/loadgen.dir/test/loadgen.c.o.d"
+  "loadgen"
+  "loadgen.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/loadgen.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
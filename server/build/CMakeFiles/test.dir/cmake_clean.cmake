@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test.dir/src/admin.c.o"
+  "CMakeFiles/test.dir/src/admin.c.o.d"
+  "CMakeFiles/test.dir/src/bot.c.o"
+  "CMakeFiles/test.dir/src/bot.c.o.d"
+  "CMakeFiles/test.dir/src/game_room.c.o"
+  "CMakeFiles/test.dir/src/game_room.c.o.d"
+  "CMakeFiles/test.dir/src/handler.c.o"
+  "CMakeFiles/test.dir/src/handler.c.o.d"
+  "CMakeFiles/test.dir/src/handoff.c.o"
+  "CMakeFiles/test.dir/src/handoff.c.o.d"
+  "CMakeFiles/test.dir/src/history.c.o"
+  "CMakeFiles/test.dir/src/history.c.o.d"
+  "CMakeFiles/test.dir/src/journal.c.o"
+  "CMakeFiles/test.dir/src/journal.c.o.d"
+  "CMakeFiles/test.dir/src/leaderboard.c.o"
+  "CMakeFiles/test.dir/src/leaderboard.c.o.d"
+  "CMakeFiles/test.dir/src/lobby.c.o"
+  "CMakeFiles/test.dir/src/lobby.c.o.d"
+  "CMakeFiles/test.dir/src/mailbox.c.o"
+  "CMakeFiles/test.dir/src/mailbox.c.o.d"
+  "CMakeFiles/test.dir/src/metrics.c.o"
+  "CMakeFiles/test.dir/src/metrics.c.o.d"
+  "CMakeFiles/test.dir/src/outbox.c.o"
+  "CMakeFiles/test.dir/src/outbox.c.o.d"
+  "CMakeFiles/test.dir/src/presence.c.o"
+  "CMakeFiles/test.dir/src/presence.c.o.d"
+  "CMakeFiles/test.dir/src/protocol.c.o"
+  "CMakeFiles/test.dir/src/protocol.c.o.d"
+  "CMakeFiles/test.dir/src/protocol_game.c.o"
+  "CMakeFiles/test.dir/src/protocol_game.c.o.d"
+  "CMakeFiles/test.dir/src/replay_log.c.o"
+  "CMakeFiles/test.dir/src/replay_log.c.o.d"
+  "CMakeFiles/test.dir/src/server.c.o"
+  "CMakeFiles/test.dir/src/server.c.o.d"
+  "CMakeFiles/test.dir/src/session.c.o"
+  "CMakeFiles/test.dir/src/session.c.o.d"
+  "CMakeFiles/test.dir/src/social_cache.c.o"
+  "CMakeFiles/test.dir/src/social_cache.c.o.d"
+  "CMakeFiles/test.dir/src/spectator.c.o"
+  "CMakeFiles/test.dir/src/spectator.c.o.d"
+  "CMakeFiles/test.dir/src/table_actor.c.o"
+  "CMakeFiles/test.dir/src/table_actor.c.o.d"
+  "CMakeFiles/test.dir/src/uring.c.o"
+  "CMakeFiles/test.dir/src/uring.c.o.d"
+  "CMakeFiles/test.dir/src/utils.c.o"
+  "CMakeFiles/test.dir/src/utils.c.o.d"
+  "CMakeFiles/test.dir/test/unit_test.c.o"
+  "CMakeFiles/test.dir/test/unit_test.c.o.d"
+  "test"
+  "test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
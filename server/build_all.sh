@@ -18,7 +18,9 @@ fi
 # mpack: no dependencies
 # db: depends on logger
 # pokergame: depends on card
-BUILD_ORDER=("logger" "card" "mpack" "db" "pokergame")
+# jobs: no dependencies
+# archive: no dependencies
+BUILD_ORDER=("logger" "card" "mpack" "db" "pokergame" "jobs" "archive")
 
 # Function to build a library
 build_library() {
@@ -0,0 +1,27 @@
+#pragma once
+#include <stddef.h>
+#include "game.h"
+
+// Local admin endpoint for operators. Every client that connects to the Unix socket gets one text
+// snapshot and is disconnected, e.g. `socat - UNIX-CONNECT:/tmp/cardio_admin.sock`. The listener is
+// polled by the event loop like the other fds; a snapshot only reads in-memory state, so it can be
+// scraped every second without holding up gameplay.
+//
+// One sample per line, `name{label="value"} number`, as in the Prometheus text format. Lines starting
+// with '#' are comments and the snapshot ends with "# EOF", so a reader can detect a truncated one.
+#define ADMIN_SOCKET_PATH "/tmp/cardio_admin.sock" // CARDIO_ADMIN_SOCKET overrides it
+#define ADMIN_MAX_ACCEPTS 16                       // Clients served per wakeup; the rest wait for the next
+#define ADMIN_SEND_BUFFER (1 << 20)                // A snapshot larger than the socket buffer is cut short
+
+// Bind the admin socket at path (ADMIN_SOCKET_PATH if NULL), replacing a stale one.
+// Returns the listening fd to register with epoll, -1 on failure.
+int admin_init(const char* path);
+
+// Answer pending admin clients. Call when the admin listener becomes readable.
+void admin_accept(int listen_fd, TableList* table_list);
+
+// Render the snapshot into a malloc'd string (*out, owned by the caller). Returns its length, 0 on failure.
+size_t admin_render(TableList* table_list, char** out);
+
+// Close the listener and remove the socket file
+void admin_shutdown(void);
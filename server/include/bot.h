@@ -0,0 +1,22 @@
+#pragma once
+#include "game.h"
+#include "jobs.h"
+
+// Bot decisions run as high priority jobs on the shared job pool so equity sampling never blocks the
+// event loop. Finished decisions are posted to the table's mailbox (table_actor.h) and applied by its owner.
+#define BOT_DECISION_BUDGET_MS 40 // Wall-clock budget for one decision, queueing included
+#define BOT_MAX_SAMPLES 5000      // Upper bound on Monte Carlo samples per decision
+
+// Run decisions on pool from now on. Returns 0 on success, -1 on failure.
+int bot_init(JobPool* pool);
+// Decisions waiting for a free worker
+int bot_queue_depth(void);
+
+// Queue a decision for the bot at table->game_state->active_seat.
+// Returns 1 if queued, 0 if a decision for this turn is already pending, -1 on error.
+int bot_schedule_decision(Table* table);
+
+struct BotJob;
+// Apply a finished decision if the bot's turn is still the one it was asked about.
+// Returns true if the hand changed; the caller broadcasts. Owner thread only.
+bool bot_apply_decision(Table* table, const struct BotJob* job);
@@ -4,6 +4,11 @@
 
 // Forward declaration to avoid circular dependency
 typedef struct conn_data_t conn_data_t;
+struct TableActor;
+struct JournalBuffer;
+
+#define TABLE_MAX_PENDING_ACTIONS 32 // Automatic actions coalesced into one broadcast
+#define TABLE_HISTORY_ACTIONS 64     // Recent actions of the hand replayed to a resumed client
 
 struct
 {
@@ -18,6 +23,14 @@ struct
     int seat_to_conn_idx[MAX_PLAYERS];      // Map seat number to connections index
     int active_seat;             // Currently active seat number (-1 if no active player)
     bool game_started;           // Whether the game has started
+    uint64_t bot_ticket;         // Pending bot decision ticket (0 if none), see bot.c
+    ActionRecord pending_actions[TABLE_MAX_PENDING_ACTIONS]; // Actions not yet broadcast
+    int num_pending_actions;
+    ActionRecord history[TABLE_HISTORY_ACTIONS]; // Action with seq s at (s - 1) % TABLE_HISTORY_ACTIONS
+    struct TableActor* actor;    // Mailbox for commands that change the hand, see table_actor.h
+    struct JournalBuffer* journal_hand; // Journal records of the hand in progress, see journal.h
+    int hand_start_stacks[MAX_PLAYERS]; // Stacks before the blinds of the hand in progress, -1 if unknown (see history.h)
+    uint8_t hand_flags[MAX_PLAYERS];    // ARCHIVE_FLAG_VPIP/PFR earned so far in the hand in progress
 } typedef Table;
 
 typedef struct
@@ -29,6 +42,8 @@ typedef struct
 
 TableList* init_table_list(size_t capacity); // returns pointer to TableList, NULL on failure
 int add_table(TableList* table_list, char* table_name, int max_player, int min_bet);
+// add_table with the given id, for tables rebuilt from the journal; returns -1 if the id is taken
+int restore_table(TableList* table_list, int id, char* table_name, int max_player, int min_bet);
 int remove_table(TableList* table_list, int id);     // returns 0 on success, -1 on failure
 int find_table_by_id(TableList* table_list, int id); // returns index of room in list, -1 if not found
 void free_table_list(TableList* table_list);
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+
+// Hot upgrade: a new server binary takes over from a running one without dropping players.
+// Start the new binary with CARDIO_TAKEOVER=1. It connects to the running server's handoff socket
+// and receives, over SCM_RIGHTS:
+//   1. the listening socket, with the session signing key (so issued tokens keep working)
+//   2. every logged-in client socket, with the connection's user, session id, lobby subscription
+//      and spectated table; parked sessions come without a socket
+// Before sending, the old process drains its outboxes and writes a journal checkpoint (see journal.h),
+// which the new one replays for tables, hands and seats. A handed-over socket of a seated player is
+// moved onto the seat the journal brought back, the way PACKET_RESUME would.
+//
+// The new process replies READY once it has replayed the journal and is ready to serve; the old one
+// answers GO and exits, and only then does the new one open its own admin and handoff sockets and
+// enter the loop. If anything fails or times out first, the new process exits and the old one carries on. Clients see a stall, not a disconnect; unread requests
+// stay in their sockets. Connections that have not logged in are not handed over.
+//
+// Only the epoll backend hands off (the io_uring one owns receives in flight), and only with the
+// journal enabled. Both processes must be the same build architecture; HANDOFF_VERSION guards the wire format.
+#define HANDOFF_SOCKET_PATH "/tmp/cardio_handoff.sock" // CARDIO_HANDOFF_SOCKET overrides it
+#define HANDOFF_VERSION 1
+#define HANDOFF_FDS_PER_MESSAGE 200 // Under the kernel's SCM_MAX_FD of 253
+#define HANDOFF_TIMEOUT_MS 5000     // Per message, and for outboxes to drain
+#define HANDOFF_READY_TIMEOUT_MS 30000 // For the new process to replay the journal
+
+// ===== Old process =====
+
+// Bind the handoff socket, replacing a stale one. Returns the listening fd to register with epoll,
+// -1 on failure (the server runs without hot upgrade).
+int handoff_init(void);
+// A new process is taking over: hand everything to it. Returns only if the handoff failed.
+void handoff_accept(int listen_fd, int listener, TableList* table_list);
+// Send the listener and every logged-in connection on peer. Returns 0 on success, -1 on failure.
+int handoff_send_state(int peer, int listener);
+
+// ===== New process =====
+
+// True if CARDIO_TAKEOVER asks this process to take over from a running server
+bool handoff_requested(void);
+// Connect to the running server and receive its state. Returns the listening socket, -1 on failure.
+int handoff_receive(void);
+// Receive on peer what handoff_send_state sent. Returns the listening socket, -1 on failure.
+int handoff_recv_state(int peer);
+// Tell the old process we are ready and wait for it to let go. Returns 0 once it has, -1 on failure.
+int handoff_confirm(void);
+// Bring the received connections into the event loop: seated players onto the seats the journal
+// restored, everyone else into the lobby. Call once at the start of the loop, after handoff_confirm
+// (epoll_fd is -1 under io_uring). Does nothing if no state was received.
+void handoff_adopt(int epoll_fd, TableList* table_list);
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "archive.h"
+#include "game.h"
+
+// Hand history. Every finished hand becomes one hand_history row (board, pot, actions) and one
+// hand_players row per player dealt in (seat, hole cards, stack, chips put in and won); see
+// database/migration_hand_history.sql.
+//
+// The event loop only copies a compact binary record of the hand into a local buffer, and hands the
+// whole buffer to the writer thread once per iteration under one lock. The writer renders the queued
+// hands as COPY text and appends them with dbCopyHandHistory in batches of up to HISTORY_BATCH_HANDS,
+// at least every HISTORY_FLUSH_MS. If the database is down the writer retries and the queue grows up
+// to HISTORY_MAX_QUEUED_BYTES; hands finished beyond that are dropped and counted, never waited for.
+//
+// Actions come from the table's action ring, so a hand longer than TABLE_HISTORY_ACTIONS actions keeps
+// only its last ones, and a hand that was in progress across a restart is not recorded.
+//
+// The writer also appends every hand it takes to a columnar archive for offline analytics (see
+// archive.h and Cardio_archive_query): one row per player with the hand's pot and VPIP/PFR flags. Rows
+// are written a chunk at a time, when ARCHIVE_CHUNK_ROWS have built up or HISTORY_ARCHIVE_FLUSH_MS
+// after the last chunk; the rows not yet written when the server dies are lost to the archive.
+#define HISTORY_BATCH_HANDS 8192
+#define HISTORY_FLUSH_MS 250
+#define HISTORY_RETRY_MS 1000
+#define HISTORY_MAX_QUEUED_BYTES (64 << 20)
+#define HISTORY_ARCHIVE_PATH "cardio.archive" // CARDIO_ARCHIVE overrides it, empty disables the archive
+#define HISTORY_ARCHIVE_FLUSH_MS 60000
+
+// Start the writer thread. Returns 0 on success, -1 on failure (hands are then kept until the queue is full).
+int history_init(void);
+// Write what is queued, flush the archive and stop the writer
+void history_shutdown(void);
+
+// ===== Event loop =====
+
+// game_start_hand is about to deal: remember the stacks before the blinds
+void history_hand_start(Table* table);
+// An action was applied: note whether it puts chips in voluntarily before the flop
+void history_action(Table* table, const ActionRecord* record);
+// The hand is over and its pots are paid out: record it. Call before bots and busted players leave.
+void history_hand_end(Table* table);
+// Hand the hands finished this iteration to the writer. Call once per loop iteration.
+void history_flush(void);
+
+// ===== Writer =====
+
+// Take up to max_hands queued hands off the queue and render them as COPY text for hand_history and
+// hand_players. The buffers are malloc'd for the caller. Returns the number of hands, 0 if none were
+// queued, -1 if memory ran out (the hands stay queued).
+int history_take_batch(int max_hands, char** hands, size_t* hands_len, char** players, size_t* players_len);
+// Bytes of finished hands waiting for the writer
+size_t history_queued_bytes(void);
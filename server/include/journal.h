@@ -0,0 +1,58 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+
+// Write-ahead journal of table events, so a restarted server picks every table up where it was,
+// down to the next card of a hand in progress. Tables append compact binary records to one file:
+// the table's settings, seat changes, the start of each hand with its roster and deck seed, every
+// action, and the settled stacks at the end of the hand. A hand is replayed by dealing from the same
+// seed and applying the same actions through the engine, which makes the same GameState.
+//
+// Records are buffered and written in one group commit per event loop iteration, with an
+// fdatasync, before that iteration's replies leave the server: no client sees an action the journal
+// could lose. Seat changes and settlements follow writes to the database, so they are committed
+// right away: a crash can leave the journal and the database disagreeing about one buy-in, cash-out
+// or settlement, but only if it lands between that write and one fdatasync.
+//
+// Once the file passes JOURNAL_CHECKPOINT_BYTES it is rewritten as a checkpoint: each table's
+// settings and settled stacks, plus the records of the hand it is playing. A torn record at the
+// end of the file (the crash happened mid-write) fails its CRC and is dropped with everything after.
+//
+// On replay, seated players come back as parked sessions (see session.h): logging in within
+// SESSION_GRACE_MS takes the seat back, otherwise leave_table hands it to a bot and returns the
+// chips, as for any other disconnect.
+#define JOURNAL_PATH "cardio.journal" // Relative to the working directory; CARDIO_JOURNAL overrides it
+#define JOURNAL_CHECKPOINT_BYTES (16 * 1024 * 1024)
+#define JOURNAL_MAX_RECORD 1024
+
+typedef struct JournalBuffer JournalBuffer;
+
+// Open (or create) the journal at path. Returns 0 on success, -1 on failure; every other
+// function is a no-op while no journal is open.
+int journal_open(const char* path);
+void journal_close(void);
+bool journal_enabled(void);
+// The file journal_open was given
+const char* journal_file(void);
+
+// Rebuild tables from the journal into an empty table_list, bring their players back as parked
+// sessions, let bots finish what they were doing and write a fresh checkpoint. Call once at startup,
+// after the other modules are initialized. Returns the number of records applied, -1 on failure.
+int journal_replay(TableList* table_list);
+// Rewrite the journal as one checkpoint of table_list. Returns 0 on success, -1 on failure.
+int journal_checkpoint(TableList* table_list);
+// Group commit: write and sync what this loop iteration appended, checkpointing if the file is large
+void journal_flush(TableList* table_list);
+
+// ===== Events, recorded by the owner of the table =====
+void journal_table_created(const Table* table);
+void journal_table_removed(Table* table);
+// seat was taken, left, or handed to a bot; committed before returning
+void journal_seat(const Table* table, int seat);
+// Pick the deck seed of the hand game_start_hand is about to deal, and record the hand
+void journal_hand_start(Table* table);
+// The action applied at seat; call after game_process_action succeeded
+void journal_action(Table* table, int seat, const Action* action);
+// The hand was settled and the table waits for the next one
+void journal_hand_settled(Table* table);
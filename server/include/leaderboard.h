@@ -0,0 +1,28 @@
+#pragma once
+#include <stdbool.h>
+#include "db.h"
+#include "protocol.h"
+
+// In-memory leaderboard: every known user's balance in a skiplist ordered by balance (descending,
+// then user id), plus a user id hash to find a user's node. Seeded from the database once and kept
+// current by the code paths that change balances, so PACKET_SCOREBOARD needs no database work.
+// The encoded top LEADERBOARD_SIZE packet is cached until a change touches the top of the board.
+#define LEADERBOARD_SIZE 20
+
+// Load every user's balance. Returns 0 on success, -1 on failure (the board stays unseeded).
+int leaderboard_seed(PGconn* conn);
+bool leaderboard_is_seeded(void);
+
+// Record a user's new absolute balance (inserting the user if unknown)
+void leaderboard_set_balance(int user_id, int balance);
+// Apply a relative change. Ignored for users the board does not know yet.
+void leaderboard_add_balance(int user_id, int amount);
+
+// Copy up to k leaders into out, best first. Returns the number copied.
+int leaderboard_top(dbRanking* out, int k);
+int leaderboard_size(void);
+
+// Complete PACKET_SCOREBOARD packet (header included), owned by the leaderboard
+const RawBytes* leaderboard_packet(void);
+
+void leaderboard_free(void);
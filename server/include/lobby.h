@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include "game.h"
+#include "protocol.h"
+
+// Lobby snapshot cache: the PACKET_TABLES response is encoded once per lobby change
+// and the same bytes are sent to every requester until something invalidates it.
+//
+// Lobby subscribers get that snapshot once, then PACKET_LOBBY_DELTA pushes. Changes are
+// coalesced: the first invalidation arms a one-shot timer and everything that changes
+// before it fires goes out as a single delta, encoded once for all subscribers.
+#define LOBBY_TICK_MS 250
+#define LOBBY_MAX_SUBSCRIBERS 4096
+// Removed, added and updated entries per PACKET_LOBBY_DELTA. An added table encodes to at most
+// about 100 bytes, so a full packet stays within the 16-bit packet length.
+#define LOBBY_DELTA_MAX_ENTRIES 512
+
+// Create the lobby tick timer. Returns the timerfd to register with epoll, -1 on failure.
+int lobby_init(void);
+
+// Mark the cached table list stale. Call whenever a table is created or removed,
+// or a table's seat count or stakes change.
+void lobby_invalidate(void);
+
+// Monotonic lobby version, bumped by every lobby_invalidate()
+uint64_t lobby_version(void);
+
+// Complete PACKET_TABLES packet (header included) for the current lobby, rebuilt on demand.
+// The returned bytes are owned by the cache and stay valid until the next invalidation.
+const RawBytes* lobby_tables_packet(TableList* table_list);
+
+// ===== Lobby Index =====
+// Tables are also kept sorted by stakes, free seats and name so filtered PACKET_TABLES
+// queries touch only the page they return. add_table/remove_table and every seat count
+// change keep it current; each of these also invalidates the cached snapshot.
+void lobby_table_added(const Table* table);
+void lobby_table_removed(int table_id);
+void lobby_table_seats_changed(const Table* table);
+
+// Fill out (room for TABLES_PAGE_MAX entries) with the page matching query. Returns the number
+// of tables written; *next is set up as the follow-up query and *has_more tells whether to send it.
+int lobby_query_tables(const TablesQuery* query, TableSummary* out, TablesQuery* next, bool* has_more);
+
+// ===== Subscriptions =====
+// Returns 0 on success, -1 if the subscriber set is full
+int lobby_subscribe(int fd, TableList* table_list);
+void lobby_unsubscribe(int fd);
+bool lobby_is_subscribed(int fd);
+int lobby_subscriber_count(void);
+
+// Diff the lobby against what subscribers last saw and push it as delta packets of at most
+// LOBBY_DELTA_MAX_ENTRIES entries. Call when the lobby timerfd becomes readable.
+void lobby_flush(TableList* table_list);
+
+void lobby_cache_free(void);
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Lock-free multi-producer, single-consumer FIFO (Vyukov's intrusive queue). Any thread may push;
+// only the owning thread pops. Push is one atomic exchange and never fails or blocks, so producers
+// never contend on a lock. Nodes are embedded in the caller's structs and never copied; recover the
+// containing struct with MAILBOX_ENTRY.
+typedef struct MailboxNode
+{
+    _Atomic(struct MailboxNode*) next;
+} MailboxNode;
+
+typedef struct
+{
+    _Atomic(MailboxNode*) head; // Last pushed node; producers swap themselves in here
+    MailboxNode* tail;          // Next node to pop, owned by the consumer
+    MailboxNode stub;
+} Mailbox;
+
+#define MAILBOX_ENTRY(node, type, member) ((type*) ((char*) (node) - offsetof(type, member)))
+
+void mailbox_init(Mailbox* mailbox);
+// Append node; safe from any thread
+void mailbox_push(Mailbox* mailbox, MailboxNode* node);
+// Take the oldest node, NULL if the mailbox is empty. Owner thread only.
+MailboxNode* mailbox_pop(Mailbox* mailbox);
+// True if nothing has been pushed since the last pop that returned NULL. Owner thread only.
+bool mailbox_empty(Mailbox* mailbox);
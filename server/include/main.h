@@ -12,12 +12,30 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "admin.h"
+#include "bot.h"
 #include "db.h"
 #include "game.h"
+#include "handoff.h"
+#include "history.h"
+#include "jobs.h"
+#include "journal.h"
+#include "leaderboard.h"
+#include "lobby.h"
 #include "logger.h"
+#include "mailbox.h"
+#include "metrics.h"
 #include "mpack.h"
+#include "outbox.h"
+#include "presence.h"
 #include "protocol.h"
+#include "replay_log.h"
 #include "server.h"
+#include "session.h"
+#include "social_cache.h"
+#include "spectator.h"
+#include "table_actor.h"
+#include "uring.h"
 
 #define dbconninfo "dbname=cardio user=postgres password=postgres host=localhost port=5433"
 #define MAIN_LOG "server.log"
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Process-wide counters and latency histograms. Every thread records into its own shard, so the hot
+// path is a few uncontended relaxed atomic adds: no locks and no cache lines shared between threads.
+// Readers sum the shards, which costs a few hundred microseconds and never blocks a writer.
+//
+// Histograms are log-linear, in the style of HdrHistogram: each power of two is split into 8 linear
+// sub-buckets, so a reported percentile is within 12.5% of the true value. Values are nanoseconds.
+
+typedef enum
+{
+    METRIC_BYTES_IN = 0,
+    METRIC_BYTES_OUT,
+    METRIC_PACKETS_IN,
+    METRIC_PACKETS_OUT,
+    METRIC_CONNECTIONS_OPENED,
+    METRIC_CONNECTIONS_CLOSED,
+    METRIC_TABLES_CREATED,
+    METRIC_TABLES_REMOVED,
+    METRIC_HANDS_COMPLETED,
+    METRIC_SOCKET_WRITES, // send/writev calls (or io_uring sends) carrying outbound packets
+    METRIC_HISTORY_HANDS_WRITTEN,
+    METRIC_HISTORY_HANDS_DROPPED, // Finished hands the history queue had no room for, or the database never took
+    METRIC_HISTORY_ARCHIVE_DROPPED, // Hands the writer could not add to the analytics archive
+    METRIC_REPLAY_HANDS_DROPPED,  // Finished hands the replay log could not write
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+typedef enum
+{
+    METRIC_LATENCY_BROADCAST = 0, // broadcast_game_state_to_table
+    METRIC_LATENCY_DB_CONNECT,    // PQconnectdb
+    METRIC_LATENCY_DB_QUERY,      // One lib/db call
+    METRIC_LATENCY_BOT_DECISION,  // Equity sampling on a bot worker
+    METRIC_LATENCY_JOURNAL_SYNC,  // Writing and fdatasync-ing one group commit of the table journal
+    METRIC_LATENCY_HISTORY_COPY,  // One batch of hand history written with COPY, on the history writer
+    METRIC_LATENCY_COUNT
+} MetricLatency;
+
+#define METRICS_MAX_THREADS 32     // Threads beyond this share one extra shard
+#define METRICS_PACKET_SLOTS 100   // Request latency is kept per packet_type / 10 (types 10..999)
+#define METRICS_HIST_SUB_BUCKETS 8 // Linear sub-buckets per power of two
+#define METRICS_HIST_BUCKETS 320   // Covers up to 2^42 ns (~73 minutes); larger values land in the last bucket
+#define METRICS_REPORT_INTERVAL_MS 60000
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[METRICS_HIST_BUCKETS];
+} MetricsHistogram;
+
+uint64_t metrics_now_ns(void);
+
+// ===== Recording (any thread) =====
+void metrics_add(MetricCounter counter, uint64_t amount);
+void metrics_record(MetricLatency latency, uint64_t elapsed_ns);
+// Time spent handling one request of packet_type on the event loop
+void metrics_record_packet(int packet_type, uint64_t elapsed_ns);
+
+// Evaluate call and record how long it took, e.g. METRICS_TIME(METRIC_LATENCY_DB_QUERY, dbLogin(conn, u, p))
+#define METRICS_TIME(latency, call)                                                                                \
+    __extension__({                                                                                                \
+        uint64_t metrics_started_ = metrics_now_ns();                                                              \
+        __typeof__(call) metrics_result_ = (call);                                                                 \
+        metrics_record((latency), metrics_now_ns() - metrics_started_);                                            \
+        metrics_result_;                                                                                           \
+    })
+#define METRICS_DB_CONNECT(call) METRICS_TIME(METRIC_LATENCY_DB_CONNECT, call)
+#define METRICS_DB_QUERY(call) METRICS_TIME(METRIC_LATENCY_DB_QUERY, call)
+
+// ===== Snapshots (sums over every shard) =====
+uint64_t metrics_counter(MetricCounter counter);
+void metrics_latency(MetricLatency latency, MetricsHistogram* out);
+// Returns false if no request of that slot was recorded
+bool metrics_packet_latency(int slot, MetricsHistogram* out);
+// Record into a caller-owned histogram, not thread safe. Lets tools reuse the bucketing.
+void metrics_histogram_add(MetricsHistogram* histogram, uint64_t value_ns);
+// Upper bound of the bucket holding the given quantile (0.0 - 1.0), 0 for an empty histogram
+uint64_t metrics_percentile(const MetricsHistogram* histogram, double quantile);
+
+const char* metrics_counter_name(MetricCounter counter);
+const char* metrics_latency_name(MetricLatency latency);
+
+// Periodic summary in server.log. metrics_init returns the timerfd to register with epoll, -1 on failure.
+int metrics_init(void);
+void metrics_report(void);
+
+void metrics_reset(void);
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+// Per-connection output batching for the epoll loop. Once enabled, sendall() appends to the
+// connection's outbox instead of writing, and the loop calls outbox_flush() at the end of each
+// iteration: whatever one action produced for a socket (its ACTION_RESULT, the table broadcast,
+// bot moves, balance updates) leaves in a single send. Client sockets run with TCP_NODELAY, so the
+// batch goes on the wire at once; batching here is what Nagle or TCP_CORK would otherwise do.
+//
+// A socket that can't take everything keeps the rest and is retried on EPOLLOUT. A connection whose
+// backlog passes OUTBOX_MAX_PENDING is not reading; it is shut down and the loop closes it as usual.
+#define OUTBOX_MAX_PENDING (4 << 20)
+#define OUTBOX_KEEP_CAPACITY (64 << 10) // Larger buffers are freed once drained
+
+// Start batching. Until then sendall() writes immediately.
+void outbox_enable(void);
+bool outbox_enabled(void);
+
+// Append len bytes for fd. Returns 0 on success, -1 if batching is off or memory ran out.
+int outbox_queue(int fd, const char* buf, int len);
+// Write every outbox that gained bytes this iteration. Call once per loop iteration.
+void outbox_flush(void);
+// fd reported EPOLLOUT: write what it still holds
+void outbox_writable(int fd);
+// Try to write fd's backlog now. Returns true if nothing is left queued for it.
+bool outbox_drain(int fd);
+// Flush what the socket takes without waiting, then drop the rest; call before closing fd
+void outbox_close(int fd);
+
+// Connections with unsent bytes and the bytes they hold
+void outbox_stats(int* connections, size_t* bytes);
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdbool.h>
+#include "game.h"
+#include "protocol.h"
+
+// Presence of logged-in users, indexed by user id and by username. Every logged-in connection is
+// registered here through register_connection/unregister_connection, and a user's status is the most
+// specific one among their connections (PRESENCE_TABLE > PRESENCE_LOBBY > PRESENCE_ONLINE).
+//
+// Changes are not pushed right away: the first change arms a one-shot timer, and when it fires every
+// online friend (friend lists come from the social cache) receives one PACKET_PRESENCE_UPDATE holding
+// all friend changes of that tick. A user who flaps several times within a tick is published once, with
+// the final state. A user coming online receives the current status of their online friends.
+#define PRESENCE_TICK_MS 250
+#define PRESENCE_BUCKETS 1024
+#define PRESENCE_MAX_CONNECTIONS 8         // Connections tracked per user
+#define PRESENCE_MAX_USERS_PER_TICK 512    // Changed users published per tick; the rest wait for the next
+#define PRESENCE_MAX_CHANGES_PER_PACKET 256
+
+// Create the presence tick timer. Returns the timerfd to register with epoll, -1 on failure.
+int presence_init(void);
+
+// A logged-in connection appeared or went away
+void presence_connect(conn_data_t* conn_data);
+void presence_disconnect(conn_data_t* conn_data);
+// Recompute a user's status after one of their connections sat down, left a table or (un)subscribed the lobby
+void presence_refresh(const conn_data_t* conn_data);
+// Let two online users that just became friends see each other's status
+void presence_friendship_added(int user_id, int friend_id);
+
+// A logged-in connection of the user, NULL if offline
+conn_data_t* presence_find_by_username(const char* username);
+conn_data_t* presence_find_by_user_id(int user_id);
+// PRESENCE_* status of a user; *table_id (if given) is set when at a table
+int presence_status(int user_id, int* table_id);
+int presence_online_count(void);
+// Users whose change is waiting for the next tick
+int presence_pending_count(void);
+
+// Publish the pending changes. Call when the presence timerfd becomes readable.
+void presence_flush(void);
+
+void presence_free(void);
@@ -2,6 +2,7 @@
 #include "../lib/db/include/db.h"
 #include "db.h"
 #include "game.h"
+#include "session.h"
 
 #define MAXLINE 65540
 #define PROTOCOL_V1 0x01
@@ -15,6 +16,11 @@
 #define R_LOGIN_OK 101
 #define R_LOGIN_NOT_OK 102
 
+// Resume a dropped session on a new socket: {"token", "handId", "seq"} (handId/seq: the last game state
+// the client saw, see session.h). Replies {"result": 0, ...} like a login, or {"res": R_RESUME_NOT_OK}.
+#define PACKET_RESUME 110
+#define R_RESUME_NOT_OK 112
+
 #define PACKET_SIGNUP 200
 #define R_SIGNUP_OK 201
 #define R_SIGNUP_NOT_OK 202
@@ -30,6 +36,13 @@
 
 #define PACKET_TABLES 500
 
+// Lobby subscription: {"subscribe": bool} (empty payload subscribes). Subscribing is answered with a
+// PACKET_TABLES snapshot, after which PACKET_LOBBY_DELTA packets are pushed at most once per lobby tick.
+#define PACKET_LOBBY_SUBSCRIBE 510
+#define R_LOBBY_SUBSCRIBE_NOT_OK 511
+#define R_LOBBY_UNSUBSCRIBE_OK 512
+#define PACKET_LOBBY_DELTA 520
+
 #define PACKET_UPDATE_GAMESTATE 600
 
 #define PACKET_LEAVE_TABLE 700
@@ -81,6 +94,9 @@
 #define R_INVITE_TO_TABLE_NOT_FRIENDS 983
 #define R_INVITE_TO_TABLE_ALREADY_IN_GAME 984
 
+// Friend presence push (server -> client), batched per presence tick (see presence.h)
+#define PACKET_PRESENCE_UPDATE 990
+
 // Game action packets (following protocol spec)
 #define PACKET_ACTION_REQUEST 450
 #define PACKET_ACTION_RESULT 451
@@ -88,6 +104,12 @@
 #define PACKET_RESYNC_REQUEST 470
 #define PACKET_RESYNC_RESPONSE 471
 
+// Spectating: {"tableId": id, "watch": bool} ("watch" defaults to true). Watchers then receive
+// public PACKET_UPDATE_GAMESTATE packets, throttled and optionally delayed (see spectator.h)
+#define PACKET_SPECTATE 480
+#define R_SPECTATE_OK 481
+#define R_SPECTATE_NOT_OK 482
+
 typedef struct
 {
     char* data;
@@ -160,12 +182,71 @@ RawBytes* encode_full_tables_response(TableList* table_list);
 // Decode join TABLE request
 int decode_join_table_request(char* payload);
 
-// Todo
-// Decode refresh tables request
-RawBytes* decode_refresh_tables_request(char* payload);
+// Lobby view of one table, as listed in PACKET_TABLES
+typedef struct
+{
+    int id;
+    char name[32];
+    int max_player;
+    int min_bet;
+    int current_player;
+} TableSummary;
+
+// Lobby query sent as the PACKET_TABLES payload (an empty payload still returns the full list).
+// Pages are keyset-paginated: the response cursor names the last table returned, so inserts and
+// removals between requests never shift or repeat entries.
+#define TABLES_SORT_STAKES 0     // min_bet
+#define TABLES_SORT_FREE_SEATS 1 // max_player - current_player
+#define TABLES_SORT_NAME 2       // case-insensitive
+#define TABLES_PAGE_DEFAULT 50
+#define TABLES_PAGE_MAX 200
+
+typedef struct
+{
+    int min_bet;        // -1 if unbounded
+    int max_bet;        // -1 if unbounded
+    int min_free_seats; // 0 for any
+    char name_prefix[32];
+    int sort;
+    bool desc;
+    int limit;
+    bool has_cursor;    // Resume after (cursor_key or cursor_name, cursor_id) in sort order
+    int cursor_key;
+    char cursor_name[32];
+    int cursor_id;
+} TablesQuery;
+
+// Decode PACKET_TABLES query: {"minBet", "maxBet", "minFreeSeats", "namePrefix", "sort": "stakes"|"freeSeats"|"name",
+// "desc", "limit", "cursor": {"key", "id"}}, every key optional. Returns 0 on success, -1 on error
+int decode_tables_query(char* payload, size_t payload_len, TablesQuery* query);
+// Encode one page: {"size": n, "tables": [...], "cursor": {"key", "id"} or nil when there is nothing after it}
+RawBytes* encode_tables_page_response(const TableSummary* tables, int num_tables, const TablesQuery* next);
+
+// Decode lobby subscribe request. Returns 1 to subscribe, 0 to unsubscribe, -1 on error
+int decode_lobby_subscribe_request(char* payload, size_t payload_len);
+
+// Encode lobby delta: {"version": n, "removed": [id, ...], "added": [table, ...], "updated": [{"id", "currentPlayer"}]}
+// Clients apply removed, then added, then updated; every entry is idempotent
+RawBytes* encode_update_tables_response(uint64_t version, const int* removed, int num_removed,
+                                        const TableSummary* added, int num_added, const TableSummary* updated,
+                                        int num_updated);
+
+// Where a logged-in user is. A user with several connections reports the most specific one.
+#define PRESENCE_OFFLINE 0
+#define PRESENCE_ONLINE 1 // Logged in, neither seated nor following the lobby
+#define PRESENCE_LOBBY 2  // Subscribed to lobby updates
+#define PRESENCE_TABLE 3  // Seated at table_id
+
+typedef struct
+{
+    int user_id;
+    char username[32];
+    int status;
+    int table_id; // 0 unless status is PRESENCE_TABLE
+} PresenceChange;
 
-// Encode update tables response
-RawBytes* encode_update_tables_response(TableList* new_tables);
+// Encode presence update: {"friends": [{"id", "username", "status": "offline"|"online"|"lobby"|"table", "tableId"}]}
+RawBytes* encode_presence_update(const PresenceChange* changes, int num_changes);
 
 // Encode scoreboard response
 RawBytes* encode_scoreboard_response(dbScoreboard* dbScoreboard);
@@ -173,8 +254,20 @@ RawBytes* encode_scoreboard_response(dbScoreboard* dbScoreboard);
 // Encode friendlist response
 RawBytes* encode_friendlist_response(FriendList* friendlist);
 
-// Encode login success response
-RawBytes* encode_login_success_response(dbUser* user);
+// Encode login success response; session_token is left out when NULL
+RawBytes* encode_login_success_response(dbUser* user, const char* session_token);
+
+typedef struct
+{
+    char token[SESSION_TOKEN_LEN + 1];
+    uint32_t hand_id; // 0 if the client never saw a game state
+    uint32_t seq;
+} ResumeRequest;
+
+// Decode PACKET_RESUME. Returns 0 on success, -1 on a malformed payload or a token of the wrong length.
+int decode_resume_request(char* payload, size_t payload_len, ResumeRequest* request);
+// Encode resume success: {"result": 0, "user_id", "username", "balance", "table_id", "seat", "session_token"}
+RawBytes* encode_resume_success_response(const conn_data_t* conn_data, const char* session_token);
 
 // ===== Friend Management =====
 
@@ -218,6 +311,9 @@ typedef struct {
 // Decode table invite request
 TableInviteRequest* decode_table_invite_request(char* payload);
 
+// Decode spectate request. Returns 0 on success, -1 on error
+int decode_spectate_request(char* payload, size_t payload_len, int* table_id, bool* watch);
+
 // ===== Game Action Packets =====
 
 // Action request from client
@@ -242,6 +338,9 @@ RawBytes* encode_action_result(ActionResult* result);
 
 // Encode full game state (for JOIN_TABLE_OK and RESYNC_RESPONSE)
 RawBytes* encode_game_state(GameState* state, int viewer_player_id);
+// Full game state plus a "notifications" list of the actions that led to it (coalesced UPDATE_BUNDLE)
+RawBytes* encode_game_state_with_actions(GameState* state, int viewer_player_id, const ActionRecord* actions,
+                                         int num_actions);
 
 // Encode update bundle (for broadcasting game state changes)
 RawBytes* encode_update_bundle(uint32_t seq, const char** notifications, int num_notifications,
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdbool.h>
+#include "game.h"
+#include "replay.h"
+
+// Hand logs for deterministic replay (see replay.h in the engine). Every table's GameState records its
+// hands; each finished one is appended to a file of the day it ended, <path>.YYYY-MM-DD (UTC), so a
+// hand that went wrong can be played again action by action with Cardio_replay, and a whole day of
+// traffic makes an engine benchmark.
+//
+// The event loop encodes finished hands into a local buffer and writes it once per iteration with
+// one append, without fdatasync: a crash can lose the last iteration's hands, or tear the last
+// record, which Cardio_replay skips. Hands longer than HAND_LOG_MAX_EVENTS events, or cut short by
+// the server rather than the engine, are not logged.
+#define REPLAY_LOG_PATH "cardio.hands" // CARDIO_REPLAY_LOG overrides it, empty disables the log
+
+// Start logging to files named after path. Returns 0 on success, -1 on failure (nothing is logged).
+int replay_log_open(const char* path);
+// Write what is buffered and close the file
+void replay_log_close(void);
+bool replay_log_enabled(void);
+
+// A table was created: have its engine record hands
+void replay_log_table(Table* table);
+// The hand is over: queue its log if the engine finished it
+void replay_log_hand_end(Table* table);
+// Write the hands queued this iteration. Call once per loop iteration.
+void replay_log_flush(void);
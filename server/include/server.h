@@ -1,6 +1,7 @@
 #pragma once
 #include "main.h"
 #define MAXEVENTS 100
+#define JOB_WORKERS 2 // Threads for CPU-heavy side work (bot decisions), see lib/jobs
 
 void* get_in_addr(struct sockaddr* sa);
 int get_listener_socket(const char* ipaddr, const char* port, int backlog);
@@ -21,22 +22,32 @@ typedef struct conn_data_t
     int seat;                // Seat number at table (-1 if not seated)
     size_t buffer_len;       // Length of valid data in the buffer
     bool is_active;          // Player's activity status
+    bool social_ref;         // Holds a social_cache reference for user_id, released on close
+    struct Session* session; // Resumable session, NULL until login (see session.h)
     struct conn_data_t* next; // For global connection list
 } conn_data_t;
 // Initialize connection data with default values
 conn_data_t* init_connection_data(int client_fd);
-// Add connection to epoll
-int add_connection_to_epoll(int epoll_fd, int client_fd);
-// Close connection
+// Add connection to epoll. Returns its connection data, NULL on failure (the socket is closed).
+conn_data_t* add_connection_to_epoll(int epoll_fd, int client_fd);
+// Close connection (epoll_fd is unused under the io_uring backend)
 int close_connection(int epoll_fd, conn_data_t* conn_data);
+// The client hung up or its socket failed: park a logged-in connection for PACKET_RESUME, close anyone else
+void drop_connection(int epoll_fd, conn_data_t* conn_data, TableList* table_list);
+// Move conn_data's socket onto session_conn, closing any socket session_conn still had, and free conn_data
+int resume_connection(int epoll_fd, conn_data_t* conn_data, conn_data_t* session_conn);
+// A parked connection for the player seated at seat, as the journal left them; logging in resumes it
+conn_data_t* restore_connection(Table* table, int seat);
 // Update connection data
 int update_conn_data(int epoll_fd, int client_fd, conn_data_t* conn_data);
 
 // Handler
-void handle_login_request(conn_data_t* conn_data, char* data, size_t data_len);
+void handle_login_request(int epoll_fd, conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
+void handle_resume_request(int epoll_fd, conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 void handle_signup_request(conn_data_t* conn_data, char* data, size_t data_len);
 void handle_create_table_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 void handle_get_all_tables_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
+void handle_lobby_subscribe_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 void handle_join_table_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 void handle_get_scoreboard(conn_data_t* conn_data, char* data, size_t data_len);
 void handle_get_friendlist(conn_data_t* conn_data, char* data, size_t data_len);
@@ -48,6 +59,7 @@ void handle_get_invites_request(conn_data_t* conn_data, char* data, size_t data_
 void handle_get_friend_list_request(conn_data_t* conn_data, char* data, size_t data_len);
 void handle_invite_to_table_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 void handle_unknown_request(conn_data_t* conn_data, char* data, size_t data_len);
+void handle_spectate_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 void handle_leave_table_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list);
 
@@ -57,11 +69,19 @@ int join_table(conn_data_t* conn_data, TableList* table_list, int table_id);
 // Game state management
 void broadcast_to_table(int table_id, TableList* table_list, char* data, int len);
 int broadcast_game_state_to_table(Table* table);
+void table_record_action(Table* table, const ActionRecord* record);
+void table_remember_action(Table* table, const ActionRecord* record);
+void table_send_catch_up(Table* table, conn_data_t* conn_data, uint32_t hand_id, uint32_t seq);
 void start_game_if_ready(Table* table);
 void process_player_action(conn_data_t* conn_data, Table* table, ActionRequest* action_req);
+struct TableCommand;
+bool apply_player_action(Table* table, const struct TableCommand* cmd); // true if the hand changed
 bool process_all_bot_actions(Table* table);
+void handle_hand_complete(Table* table, TableList* table_list);
 
 // Global connection map for finding users by username
 conn_data_t* find_connection_by_username(const char* username, int epoll_fd);
 void register_connection(conn_data_t* conn_data);
-void unregister_connection(conn_data_t* conn_data);
\ No newline at end of file
+void unregister_connection(conn_data_t* conn_data);
+// Every logged-in connection, live or parked, linked through next
+conn_data_t* registered_connections(void);
\ No newline at end of file
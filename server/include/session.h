@@ -0,0 +1,58 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+
+// Resumable sessions. A successful login starts a session and hands the client a token naming it:
+// user id, session id and expiry, signed with HMAC-SHA256 under a key drawn at startup (so tokens
+// die with the process). When a logged-in client's socket drops, its conn_data_t is parked instead
+// of freed: seat, presence and social cache stay as they are, and a PACKET_RESUME on a new socket
+// within SESSION_GRACE_MS moves that socket onto it with no password check and no database query.
+// A parked session nobody resumes is closed the way a disconnect always was: leave_table hands the
+// seat to a bot and returns the chips.
+//
+// Every issue rotates the session id, so a token is good for one resume. A resume for a session
+// whose old socket is still open (a half-open TCP connection the server has not noticed) takes the
+// session over and closes the old socket.
+#define SESSION_GRACE_MS 30000
+#define SESSION_TOKEN_TTL_S (24 * 60 * 60)
+#define SESSION_TOKEN_LEN 96 // Hex characters of payload and MAC, without the terminator
+#define SESSION_SWEEP_MS 1000
+#define SESSION_BUCKETS 1024
+#define SESSION_KEY_LEN 32
+
+typedef struct Session Session;
+
+// Draw the signing key and create the expiry timer. Returns the timerfd to register with epoll, -1 on failure.
+int session_init(void);
+
+// Start conn's session, or rotate it, and write its token (SESSION_TOKEN_LEN + 1 bytes) into token.
+// Returns 0 on success, -1 if memory ran out.
+int session_issue(conn_data_t* conn, char* token);
+// The live or parked connection the token names; NULL if it is forged, expired or already used
+conn_data_t* session_find(const char* token);
+// conn is being freed
+void session_end(conn_data_t* conn);
+
+// Carry sessions over a hot upgrade (see handoff.h): the signing key, and each connection's session id,
+// so tokens issued by the old process keep working in the new one
+void session_export_key(unsigned char* key_out);
+void session_import_key(const unsigned char* key_in);
+// conn's session id, 0 if it has none
+uint64_t session_id_of(const conn_data_t* conn);
+// Give conn the session id it had in the old process. Returns 0 on success, -1 if the id is taken or zero.
+int session_restore(conn_data_t* conn, uint64_t id);
+
+// conn lost its socket: keep it for SESSION_GRACE_MS. Returns 0, or -1 if conn has no session.
+int session_park(conn_data_t* conn);
+// conn has a socket again
+void session_unpark(conn_data_t* conn);
+bool session_parked(const conn_data_t* conn);
+// The parked connection of user_id, if any; a password login takes it over instead of starting afresh
+conn_data_t* session_find_parked(unsigned int user_id);
+int session_parked_count(void);
+
+// Close parked sessions whose grace window is over. Call when the session timerfd becomes readable.
+void session_expire(TableList* table_list);
+// Same, against a given CLOCK_MONOTONIC time in milliseconds
+void session_expire_at(TableList* table_list, uint64_t now_ms);
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdbool.h>
+#include "db.h"
+
+// Friend graph and pending friend invites of logged-in users, kept in memory so friend-list and invite
+// packets need no database work. An entry is loaded at login, updated write-through after each successful
+// database mutation and dropped when the user's last connection closes.
+#define SOCIAL_CACHE_BUCKETS 1024
+
+// Load user_id's friends and pending invites, or take another reference if already cached.
+// Returns 0 on success, -1 if the database could not be read (the user is then served from the database).
+int social_cache_load(PGconn* conn, int user_id);
+// Install lists fetched by the caller as a new entry; takes ownership of both. Returns 0 or -1.
+int social_cache_adopt(int user_id, dbFriendList* friends, dbInviteList* invites);
+// Re-read a cached user's lists, keeping its reference count
+int social_cache_refresh(PGconn* conn, int user_id);
+// Drop one reference; the entry is freed with the last one
+void social_cache_release(int user_id);
+bool social_cache_has(int user_id);
+int social_cache_size(void);
+
+// Lists owned by the cache, valid until the next cache call. NULL if user_id is not cached.
+dbFriendList* social_cache_friends(int user_id);
+dbInviteList* social_cache_invites(int user_id);
+
+// 1 if other_id is a friend of user_id, 0 if not, -1 if user_id is not cached
+int social_cache_is_friend(int user_id, int other_id);
+// user_id of the friend called username, 0 if no such friend, -1 if user_id is not cached
+int social_cache_friend_id(int user_id, const char* username);
+// 1 if to_user_id has a pending invite from from_user_id, 0 if not, -1 if to_user_id is not cached
+int social_cache_has_invite_from(int to_user_id, int from_user_id);
+// Copy a pending invite of user_id into out. Returns 0 if found, -1 otherwise.
+int social_cache_get_invite(int user_id, int invite_id, dbInvite* out);
+
+// Write-through hooks, called after the database change succeeded. Users that are not cached are skipped.
+void social_cache_friendship_added(int user_id, const char* username, int friend_id, const char* friend_name);
+void social_cache_invite_sent(const dbInvite* invite);
+void social_cache_invite_removed(int to_user_id, int invite_id);
+
+void social_cache_free(void);
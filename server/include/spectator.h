@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include "game.h"
+
+// Spectators watch a table without a seat. Each table keeps its own watcher list, separate
+// from Table.connections, and the public game state (viewer 0: no hole cards before showdown)
+// is encoded once per update into a ref-counted packet shared by every watcher's out-queue.
+//
+// Big audiences are kept off the hand's critical path:
+//   - throttling: at most one encode per table every min_interval_ms; updates in between
+//     collapse into the next one
+//   - delay: frames are released delay_ms after they were encoded
+//   - conflation: a watcher that can't keep up holds at most the frame being written plus
+//     the newest one; older unsent frames are dropped since each carries the full state
+#define SPECTATE_MAX_PER_TABLE 1024
+#define SPECTATE_DEFAULT_DELAY_MS 0
+#define SPECTATE_DEFAULT_INTERVAL_MS 200
+#define SPECTATE_MAX_DELAYED_FRAMES 64
+#define SPECTATE_TICK_MS 50
+
+// Create the spectator timer. Returns the timerfd to register with epoll, -1 on failure.
+int spectator_init(void);
+
+// Returns 0 on success, -1 if the table's watcher list is full or out of memory.
+// A connection watches at most one table; watching another moves it.
+int spectator_add(int fd, Table* table);
+void spectator_remove(int fd);
+// The table fd watches, 0 if none
+int spectator_table_of(int fd);
+int spectator_count(int table_id);
+// Totals over every table: watchers, watchers with a frame still being written, frames held back by delay
+void spectator_stats(int* watchers, int* blocked, int* delayed_frames);
+
+// Per-table options; negative values keep the current setting
+void spectator_configure(int table_id, int delay_ms, int min_interval_ms);
+
+// The table's public state changed. Cheap when nobody watches.
+void spectator_state_changed(Table* table);
+// Drop the table's watchers and queued frames
+void spectator_table_removed(int table_id);
+
+// Encode throttled updates, release due frames and retry blocked sockets.
+// Call when the spectator timerfd becomes readable.
+void spectator_flush(TableList* table_list);
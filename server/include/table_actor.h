@@ -0,0 +1,64 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdint.h>
+#include "game.h"
+#include "mailbox.h"
+
+// Tables as actors. Everything that changes a hand arrives as a command in the table's own mailbox,
+// a lock-free MPSC queue that any thread may post to: player actions from the packet handlers, bot
+// decisions straight from the bot workers. Each table is pinned to an owner thread, the only one that
+// touches its GameState; today that is the event loop, which also owns connections, the lobby and
+// spectators. The owner drains mailboxes in batches of up to TABLE_ACTOR_BATCH commands at the end
+// of each loop iteration, then follows up once per batch: the next bot is scheduled, one update is
+// broadcast, and a finished hand is settled.
+//
+// Tables move inside TableList, so an actor is a separate allocation found through Table.actor and
+// addressed by table id. Joining and leaving stay direct calls on the owner: they hand a connection
+// to or from the table, and a disconnect frees it before a queued command could run.
+#define TABLE_ACTOR_BATCH 64 // Commands applied per table before other ready tables get a turn
+
+struct BotJob;
+
+typedef enum
+{
+    TABLE_CMD_ACTION,      // A seated player's action
+    TABLE_CMD_BOT_DECISION // A bot worker finished deciding
+} TableCommandType;
+
+typedef struct TableCommand
+{
+    MailboxNode node;
+    TableCommandType type;
+    int user_id;          // TABLE_CMD_ACTION: who acted; resolved to a connection when applied
+    uint32_t client_seq;  // TABLE_CMD_ACTION: echoed in the ACTION_RESULT
+    Action action;        // TABLE_CMD_ACTION
+    struct BotJob* job;   // TABLE_CMD_BOT_DECISION, freed with the command
+} TableCommand;
+
+typedef struct TableActor
+{
+    Mailbox mailbox;
+    MailboxNode ready_node; // Link in the owner's queue of tables with commands waiting
+    atomic_bool scheduled;  // In the ready queue or being drained
+    atomic_int refs;        // The table's own, one while scheduled, one per bot job in flight
+    int table_id;
+} TableActor;
+
+// Set up the owner's wakeup. Call on the owner thread. Returns the eventfd to watch, -1 on failure.
+int table_actors_init(void);
+int table_actors_fd(void);
+
+// Actor for a new table, holding the table's reference. NULL if memory ran out.
+TableActor* table_actor_create(int table_id);
+void table_actor_retain(TableActor* actor);
+// Drop a reference; the last one frees the actor and any commands nobody will apply
+void table_actor_release(TableActor* actor);
+
+// Queue cmd for the table. The caller must hold a reference to actor; cmd now belongs to the mailbox.
+// Posts from other threads wake the owner through table_actors_fd().
+void table_actor_post(TableActor* actor, TableCommand* cmd);
+
+// Apply every queued command. Owner thread only; call once per loop iteration and when the eventfd fires.
+void table_actors_run(TableList* table_list);
+// Commands posted and not yet applied
+int table_actors_pending(void);
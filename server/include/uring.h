@@ -0,0 +1,66 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// io_uring network backend, the alternative to the epoll loop in main.c. Set CARDIO_IO_BACKEND=uring
+// to select it; if the kernel cannot provide what it needs (Linux 6.0+), the server logs why and
+// stays on epoll.
+//
+// One ring, owned by the event loop thread:
+//   - multishot accept on the listener and multishot recv on every client, into a ring of provided
+//     buffers, so an idle connection holds no buffer and a readable one costs no syscall of its own
+//   - multishot poll for the timer/event fds (bot, lobby, spectator, presence, metrics, admin)
+//   - sendall() only queues: bytes for the same connection are coalesced during a loop tick, and
+//     each connection's batch goes out as one send, submitted with the next wait in one io_uring_enter
+// A connection has at most one send in flight, so its packets are never reordered.
+#define URING_ENTRIES 4096
+#define URING_BUFFERS 1024      // Provided receive buffers, a power of two
+#define URING_BUFFER_SIZE 16384 // Largest single receive; client requests are far smaller
+#define URING_BUFFER_GROUP 0
+
+struct conn_data_t;
+
+typedef enum
+{
+    URING_EVENT_ACCEPT, // fd: a new client socket
+    URING_EVENT_DATA,   // conn sent len bytes at data; hand the buffer back with uring_release
+    URING_EVENT_CLOSED, // conn hung up (len 0) or its socket failed (len -errno)
+    URING_EVENT_READY   // fd, registered with uring_watch, is readable
+} UringEventType;
+
+typedef struct
+{
+    UringEventType type;
+    int fd;
+    struct conn_data_t* conn;
+    char* data;
+    int len;
+    uint16_t buffer_id;
+} UringEvent;
+
+// True if CARDIO_IO_BACKEND asks for io_uring
+bool uring_requested(void);
+// Set up the ring and the receive buffers, and start accepting on listener (a blocking socket).
+// Returns 0 on success, -1 if io_uring is unavailable; nothing is left behind on failure.
+int uring_init(int listener);
+bool uring_enabled(void);
+
+// Report fd as URING_EVENT_READY whenever it is readable. Returns 0 on success, -1 on failure.
+int uring_watch(int fd);
+// Create the connection data for an accepted socket and start receiving on it. NULL on failure.
+struct conn_data_t* uring_add_connection(int client_fd);
+// Stop every operation on fd; call before closing it
+void uring_forget(int fd);
+// Report fd's events for conn_data from now on (a resumed session). Returns 0 on success, -1 if fd is not a ring connection.
+int uring_rebind(int fd, struct conn_data_t* conn_data);
+
+// Queue len bytes for fd; they go out with the next uring_wait. Returns 0 on success,
+// -1 if fd is not a ring connection or memory ran out.
+int uring_send(int fd, const char* buf, int len);
+
+// Submit queued sends and wait for at least one completion. Returns 0 on success, -1 on failure.
+int uring_wait(void);
+// Take the next completion as an event. Returns false once they are all consumed.
+bool uring_next(UringEvent* event);
+// Return a URING_EVENT_DATA buffer to the kernel
+void uring_release(const UringEvent* event);
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_archive.dir/src/archive.c.o"
+  "CMakeFiles/Cardio_archive.dir/src/archive.c.o.d"
+  "CMakeFiles/Cardio_archive.dir/src/query.c.o"
+  "CMakeFiles/Cardio_archive.dir/src/query.c.o.d"
+  "libCardio_archive.a"
+  "libCardio_archive.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_archive.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_archive_bench.dir/src/archive.c.o"
+  "CMakeFiles/Cardio_archive_bench.dir/src/archive.c.o.d"
+  "CMakeFiles/Cardio_archive_bench.dir/src/query.c.o"
+  "CMakeFiles/Cardio_archive_bench.dir/src/query.c.o.d"
+  "CMakeFiles/Cardio_archive_bench.dir/test/bench_archive.c.o"
+  "CMakeFiles/Cardio_archive_bench.dir/test/bench_archive.c.o.d"
+  "Cardio_archive_bench"
+  "Cardio_archive_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_archive_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_archive_query.dir/src/archive.c.o"
+  "CMakeFiles/Cardio_archive_query.dir/src/archive.c.o.d"
+  "CMakeFiles/Cardio_archive_query.dir/src/query.c.o"
+  "CMakeFiles/Cardio_archive_query.dir/src/query.c.o.d"
+  "CMakeFiles/Cardio_archive_query.dir/tool/archive_query.c.o"
+  "CMakeFiles/Cardio_archive_query.dir/tool/archive_query.c.o.d"
+  "Cardio_archive_query"
+  "Cardio_archive_query.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_archive_query.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
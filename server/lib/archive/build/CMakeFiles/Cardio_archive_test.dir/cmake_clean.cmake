@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_archive_test.dir/src/archive.c.o"
+  "CMakeFiles/Cardio_archive_test.dir/src/archive.c.o.d"
+  "CMakeFiles/Cardio_archive_test.dir/src/query.c.o"
+  "CMakeFiles/Cardio_archive_test.dir/src/query.c.o.d"
+  "CMakeFiles/Cardio_archive_test.dir/test/unit_tests.c.o"
+  "CMakeFiles/Cardio_archive_test.dir/test/unit_tests.c.o.d"
+  "Cardio_archive_test"
+  "Cardio_archive_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_archive_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
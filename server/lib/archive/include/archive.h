@@ -0,0 +1,177 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Columnar archive of finished hands for offline analytics (VPIP, win rate, biggest pots).
+//
+// One row per player dealt into a hand, with the hand's fields repeated on each of its rows. Rows are
+// stored in chunks of up to ARCHIVE_CHUNK_ROWS; a hand never straddles two chunks. Each chunk is a
+// header followed by one array per column, every array 64-byte aligned so the file can be mmap'd and
+// scanned in place with SIMD-friendly loops. The header keeps each column's min and max, so a filter
+// skips whole chunks (a user who never sat in them, a time range) and skips the compares of a column
+// whose whole chunk is inside the range.
+//
+// File layout: ArchiveFileHeader, then ArchiveChunkHeader + columns, repeated. Chunks are only ever
+// appended, each with a single write; a torn last chunk is ignored by readers and cut off by the next
+// writer. The writer holds an flock on the file, so two servers never append to the same archive.
+#define ARCHIVE_MAGIC "CRDARCH1"
+#define ARCHIVE_CHUNK_MAGIC 0x4B4E4843 // "CHNK"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_CHUNK_ROWS 65536
+#define ARCHIVE_ALIGN 64
+#define ARCHIVE_MAX_THREADS 64
+
+// Player flags
+#define ARCHIVE_FLAG_BOT 0x01
+#define ARCHIVE_FLAG_VPIP 0x02 // Put chips in voluntarily before the flop (blinds do not count)
+#define ARCHIVE_FLAG_PFR 0x04  // Bet or raised before the flop
+
+typedef enum
+{
+    ARCHIVE_COL_HAND_KEY = 0, // int64, unique per hand (hand_history.hand_key)
+    ARCHIVE_COL_ENDED_MS,     // int64, Unix milliseconds
+    ARCHIVE_COL_TABLE_ID,     // int32
+    ARCHIVE_COL_POT,          // int32, chips put in by everyone
+    ARCHIVE_COL_USER_ID,      // int32, the bot's owner for a bot seat
+    ARCHIVE_COL_START_STACK,  // int32, before the blinds
+    ARCHIVE_COL_BET,          // int32, chips this player put in
+    ARCHIVE_COL_WON,          // int32, chips this player took from the pot
+    ARCHIVE_COL_SEAT,         // uint8
+    ARCHIVE_COL_FLAGS,        // uint8, ARCHIVE_FLAG_*
+    ARCHIVE_NUM_COLUMNS
+} ArchiveColumn;
+
+typedef struct
+{
+    int64_t hand_key;
+    int64_t ended_ms;
+    int32_t table_id;
+    int32_t pot;
+    int32_t user_id;
+    int32_t start_stack;
+    int32_t bet;
+    int32_t won;
+    uint8_t seat;
+    uint8_t flags;
+} ArchiveRow;
+
+typedef struct
+{
+    char magic[8]; // ARCHIVE_MAGIC
+    uint32_t version;
+    uint32_t header_size; // Offset of the first chunk
+    uint8_t reserved[48];
+} ArchiveFileHeader;
+
+typedef struct
+{
+    uint32_t magic; // ARCHIVE_CHUNK_MAGIC
+    uint32_t rows;
+    uint64_t size;                          // Bytes from this header to the next chunk
+    uint64_t offsets[ARCHIVE_NUM_COLUMNS];  // Of each column's array, from this header
+    int64_t min[ARCHIVE_NUM_COLUMNS];
+    int64_t max[ARCHIVE_NUM_COLUMNS];
+    uint32_t crc;                           // CRC-32 of the bytes after the header
+    uint32_t reserved;
+} ArchiveChunkHeader;
+
+// Bytes per value of a column
+int archive_column_width(ArchiveColumn column);
+const char* archive_column_name(ArchiveColumn column);
+
+// ===== Writing =====
+
+typedef struct ArchiveWriter ArchiveWriter;
+
+// Buffer rows for the archive at path. The file is opened (and created) at the first flush, so creating
+// a writer never fails on the file. NULL if memory ran out.
+ArchiveWriter* archive_writer_create(const char* path);
+// Flush what is buffered, close the file and free the writer. Returns 0, or -1 if the last flush failed.
+int archive_writer_close(ArchiveWriter* writer);
+// Add the rows of one hand. A full chunk is flushed first. Returns 0, or -1 if that flush failed or
+// the hand has more than ARCHIVE_CHUNK_ROWS rows (the hand is not added).
+int archive_writer_append_hand(ArchiveWriter* writer, const ArchiveRow* rows, int num_rows);
+// Write the buffered rows as one chunk and fdatasync. Returns 0, or -1 on failure (the rows stay buffered).
+int archive_writer_flush(ArchiveWriter* writer);
+// Rows buffered and not yet flushed
+uint32_t archive_writer_pending(const ArchiveWriter* writer);
+
+// ===== Reading =====
+
+typedef struct ArchiveReader ArchiveReader;
+
+// One chunk, pointing into the mapping
+typedef struct
+{
+    const ArchiveChunkHeader* header;
+    uint32_t rows;
+    const int64_t* hand_key;
+    const int64_t* ended_ms;
+    const int32_t* table_id;
+    const int32_t* pot;
+    const int32_t* user_id;
+    const int32_t* start_stack;
+    const int32_t* bet;
+    const int32_t* won;
+    const uint8_t* seat;
+    const uint8_t* flags;
+} ArchiveChunk;
+
+// Map the archive read-only. A torn last chunk is left out. NULL if the file cannot be read or is not an archive.
+ArchiveReader* archive_open(const char* path);
+void archive_close(ArchiveReader* reader);
+int archive_num_chunks(const ArchiveReader* reader);
+uint64_t archive_num_rows(const ArchiveReader* reader);
+void archive_chunk(const ArchiveReader* reader, int index, ArchiveChunk* chunk);
+// Check every chunk's CRC. Returns the index of the first bad chunk, -1 if all are good.
+int archive_verify(const ArchiveReader* reader);
+
+// ===== Queries =====
+
+// Rows to scan: an inclusive range per column and flags that must be set or clear. Columns without a
+// range are not checked.
+typedef struct
+{
+    uint32_t ranged; // Bit per ArchiveColumn with a range
+    int64_t lo[ARCHIVE_NUM_COLUMNS];
+    int64_t hi[ARCHIVE_NUM_COLUMNS];
+    uint8_t flags_set;
+    uint8_t flags_clear;
+} ArchiveFilter;
+
+void archive_filter_init(ArchiveFilter* filter);
+void archive_filter_range(ArchiveFilter* filter, ArchiveColumn column, int64_t lo, int64_t hi);
+// False if the chunk's min/max prove no row can match
+bool archive_chunk_may_match(const ArchiveChunkHeader* header, const ArchiveFilter* filter);
+// Set mask[i] to 1 for each matching row of the chunk, 0 otherwise. mask needs chunk->rows bytes.
+// Returns the number of matching rows.
+uint32_t archive_select(const ArchiveChunk* chunk, const ArchiveFilter* filter, uint8_t* mask);
+
+typedef struct
+{
+    int32_t user_id;
+    uint64_t hands;
+    uint64_t vpip;      // Hands with ARCHIVE_FLAG_VPIP
+    uint64_t pfr;       // Hands with ARCHIVE_FLAG_PFR
+    uint64_t hands_won; // Hands where the player took chips from the pot
+    int64_t net;        // Chips won minus chips put in
+    int32_t biggest_pot;
+} ArchivePlayerStats;
+
+// Per-player stats over the matching rows, scanning chunks on num_threads threads. *stats is malloc'd
+// for the caller, sorted by hands played, most first. Returns the number of players, -1 if memory ran out.
+int archive_player_stats(const ArchiveReader* reader, const ArchiveFilter* filter, int num_threads,
+                         ArchivePlayerStats** stats);
+
+typedef struct
+{
+    int64_t hand_key;
+    int64_t ended_ms;
+    int32_t table_id;
+    int32_t pot;
+} ArchivePot;
+
+// The n biggest pots among hands with a matching row, biggest first. out needs n entries.
+// Returns how many were found.
+int archive_top_pots(const ArchiveReader* reader, const ArchiveFilter* filter, int n, ArchivePot* out);
@@ -0,0 +1,452 @@
+#include "archive.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const int column_widths[ARCHIVE_NUM_COLUMNS] = {8, 8, 4, 4, 4, 4, 4, 4, 1, 1};
+static const char* column_names[ARCHIVE_NUM_COLUMNS] = {"hand_key", "ended_ms", "table_id", "pot",  "user_id",
+                                                        "start_stack", "bet", "won",   "seat", "flags"};
+
+struct ArchiveWriter
+{
+    char* path;
+    int fd;    // -1 until the first flush opens the file
+    off_t end; // Where the next chunk goes
+    uint32_t rows;
+    void* columns[ARCHIVE_NUM_COLUMNS]; // ARCHIVE_CHUNK_ROWS values each
+    char* chunk;                        // One chunk as written, header included
+};
+
+struct ArchiveReader
+{
+    int fd;
+    const char* map;
+    size_t size;
+    const ArchiveChunkHeader** chunks;
+    int num_chunks;
+    uint64_t num_rows;
+};
+
+int archive_column_width(ArchiveColumn column)
+{
+    return column_widths[column];
+}
+
+const char* archive_column_name(ArchiveColumn column)
+{
+    return column_names[column];
+}
+
+static size_t align_up(size_t value)
+{
+    return (value + ARCHIVE_ALIGN - 1) & ~(size_t) (ARCHIVE_ALIGN - 1);
+}
+
+// Where each column goes in a chunk of rows rows; returns the chunk's size
+static size_t chunk_layout(uint32_t rows, uint64_t offsets[ARCHIVE_NUM_COLUMNS])
+{
+    size_t offset = align_up(sizeof(ArchiveChunkHeader));
+    for (int c = 0; c < ARCHIVE_NUM_COLUMNS; c++)
+    {
+        offsets[c] = offset;
+        offset = align_up(offset + (size_t) rows * column_widths[c]);
+    }
+    return offset;
+}
+
+static uint32_t crc_table[256];
+
+static uint32_t crc32(const unsigned char* data, size_t len)
+{
+    if (crc_table[1] == 0)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+            {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            crc_table[i] = c;
+        }
+    }
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// A chunk header is usable if it describes a chunk that fits in the available bytes
+static bool chunk_fits(const ArchiveChunkHeader* header, size_t available)
+{
+    if (header->magic != ARCHIVE_CHUNK_MAGIC || header->rows == 0 || header->rows > ARCHIVE_CHUNK_ROWS)
+    {
+        return false;
+    }
+    uint64_t offsets[ARCHIVE_NUM_COLUMNS];
+    size_t size = chunk_layout(header->rows, offsets);
+    return header->size == size && size <= available &&
+           memcmp(header->offsets, offsets, sizeof(offsets)) == 0;
+}
+
+// ===== Writing =====
+
+ArchiveWriter* archive_writer_create(const char* path)
+{
+    ArchiveWriter* writer = calloc(1, sizeof(ArchiveWriter));
+    if (writer == NULL)
+    {
+        return NULL;
+    }
+    writer->fd = -1;
+    writer->path = strdup(path);
+    bool ok = writer->path != NULL;
+    for (int c = 0; c < ARCHIVE_NUM_COLUMNS && ok; c++)
+    {
+        writer->columns[c] = malloc((size_t) ARCHIVE_CHUNK_ROWS * column_widths[c]);
+        ok = writer->columns[c] != NULL;
+    }
+    uint64_t offsets[ARCHIVE_NUM_COLUMNS];
+    writer->chunk = ok ? aligned_alloc(ARCHIVE_ALIGN, chunk_layout(ARCHIVE_CHUNK_ROWS, offsets)) : NULL;
+    if (writer->chunk == NULL)
+    {
+        archive_writer_close(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+// Open the file for appending: write the file header if it is new, otherwise find the end of the last
+// whole chunk and cut off anything after it
+static int writer_open(ArchiveWriter* writer)
+{
+    int fd = open(writer->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0 || fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    ArchiveFileHeader file_header;
+    off_t end = 0;
+    if (st.st_size == 0)
+    {
+        memset(&file_header, 0, sizeof(file_header));
+        memcpy(file_header.magic, ARCHIVE_MAGIC, sizeof(file_header.magic));
+        file_header.version = ARCHIVE_VERSION;
+        file_header.header_size = sizeof(file_header);
+        if (pwrite(fd, &file_header, sizeof(file_header), 0) != (ssize_t) sizeof(file_header))
+        {
+            close(fd);
+            return -1;
+        }
+        end = sizeof(file_header);
+    }
+    else
+    {
+        // Never append to something that is not an archive
+        if (pread(fd, &file_header, sizeof(file_header), 0) != (ssize_t) sizeof(file_header) ||
+            memcmp(file_header.magic, ARCHIVE_MAGIC, sizeof(file_header.magic)) != 0 ||
+            file_header.version != ARCHIVE_VERSION)
+        {
+            close(fd);
+            return -1;
+        }
+        end = file_header.header_size;
+        ArchiveChunkHeader header;
+        while (pread(fd, &header, sizeof(header), end) == (ssize_t) sizeof(header) &&
+               chunk_fits(&header, (size_t) (st.st_size - end)))
+        {
+            // Earlier chunks were synced before this one was written, so only the last can be torn
+            if (end + (off_t) header.size == st.st_size)
+            {
+                size_t data_len = header.size - sizeof(header);
+                char* data = malloc(data_len);
+                bool whole = data != NULL &&
+                             pread(fd, data, data_len, end + (off_t) sizeof(header)) == (ssize_t) data_len &&
+                             crc32((const unsigned char*) data, data_len) == header.crc;
+                free(data);
+                if (!whole)
+                {
+                    break;
+                }
+            }
+            end += (off_t) header.size;
+        }
+        if (end != st.st_size && ftruncate(fd, end) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+
+    writer->fd = fd;
+    writer->end = end;
+    return 0;
+}
+
+#define MIN_MAX(type, values, rows, lo, hi)                                                                            \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        const type* v = (const type*) (values);                                                                        \
+        type low = v[0];                                                                                               \
+        type high = v[0];                                                                                              \
+        for (uint32_t i = 1; i < (rows); i++)                                                                          \
+        {                                                                                                              \
+            low = v[i] < low ? v[i] : low;                                                                             \
+            high = v[i] > high ? v[i] : high;                                                                          \
+        }                                                                                                              \
+        *(lo) = low;                                                                                                   \
+        *(hi) = high;                                                                                                  \
+    } while (0)
+
+int archive_writer_flush(ArchiveWriter* writer)
+{
+    if (writer->rows == 0)
+    {
+        return 0;
+    }
+    if (writer->fd < 0 && writer_open(writer) != 0)
+    {
+        return -1;
+    }
+
+    ArchiveChunkHeader* header = (ArchiveChunkHeader*) writer->chunk;
+    memset(header, 0, sizeof(*header));
+    header->magic = ARCHIVE_CHUNK_MAGIC;
+    header->rows = writer->rows;
+    header->size = chunk_layout(writer->rows, header->offsets);
+    memset(writer->chunk + sizeof(*header), 0, header->size - sizeof(*header)); // Padding
+    for (int c = 0; c < ARCHIVE_NUM_COLUMNS; c++)
+    {
+        memcpy(writer->chunk + header->offsets[c], writer->columns[c], (size_t) writer->rows * column_widths[c]);
+        switch (column_widths[c])
+        {
+        case 8:
+            MIN_MAX(int64_t, writer->columns[c], writer->rows, &header->min[c], &header->max[c]);
+            break;
+        case 4:
+            MIN_MAX(int32_t, writer->columns[c], writer->rows, &header->min[c], &header->max[c]);
+            break;
+        default:
+            MIN_MAX(uint8_t, writer->columns[c], writer->rows, &header->min[c], &header->max[c]);
+            break;
+        }
+    }
+    header->crc = crc32((const unsigned char*) writer->chunk + sizeof(*header), header->size - sizeof(*header));
+
+    size_t done = 0;
+    while (done < header->size)
+    {
+        ssize_t n = pwrite(writer->fd, writer->chunk + done, header->size - done, writer->end + (off_t) done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            // Leave no half chunk behind for the next one to land after
+            if (ftruncate(writer->fd, writer->end) != 0)
+            {
+                close(writer->fd);
+                writer->fd = -1;
+            }
+            return -1;
+        }
+        done += (size_t) n;
+    }
+    // The chunk is in the file either way; a failed sync only loses the guarantee
+    writer->end += (off_t) header->size;
+    writer->rows = 0;
+    return fdatasync(writer->fd) == 0 ? 0 : -1;
+}
+
+int archive_writer_append_hand(ArchiveWriter* writer, const ArchiveRow* rows, int num_rows)
+{
+    if (num_rows <= 0 || num_rows > ARCHIVE_CHUNK_ROWS)
+    {
+        return -1;
+    }
+    if (writer->rows + (uint32_t) num_rows > ARCHIVE_CHUNK_ROWS && archive_writer_flush(writer) != 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < num_rows; i++)
+    {
+        uint32_t r = writer->rows++;
+        ((int64_t*) writer->columns[ARCHIVE_COL_HAND_KEY])[r] = rows[i].hand_key;
+        ((int64_t*) writer->columns[ARCHIVE_COL_ENDED_MS])[r] = rows[i].ended_ms;
+        ((int32_t*) writer->columns[ARCHIVE_COL_TABLE_ID])[r] = rows[i].table_id;
+        ((int32_t*) writer->columns[ARCHIVE_COL_POT])[r] = rows[i].pot;
+        ((int32_t*) writer->columns[ARCHIVE_COL_USER_ID])[r] = rows[i].user_id;
+        ((int32_t*) writer->columns[ARCHIVE_COL_START_STACK])[r] = rows[i].start_stack;
+        ((int32_t*) writer->columns[ARCHIVE_COL_BET])[r] = rows[i].bet;
+        ((int32_t*) writer->columns[ARCHIVE_COL_WON])[r] = rows[i].won;
+        ((uint8_t*) writer->columns[ARCHIVE_COL_SEAT])[r] = rows[i].seat;
+        ((uint8_t*) writer->columns[ARCHIVE_COL_FLAGS])[r] = rows[i].flags;
+    }
+    return 0;
+}
+
+uint32_t archive_writer_pending(const ArchiveWriter* writer)
+{
+    return writer->rows;
+}
+
+int archive_writer_close(ArchiveWriter* writer)
+{
+    if (writer == NULL)
+    {
+        return 0;
+    }
+    int result = writer->chunk != NULL ? archive_writer_flush(writer) : 0;
+    if (writer->fd >= 0)
+    {
+        close(writer->fd); // Releases the lock
+    }
+    for (int c = 0; c < ARCHIVE_NUM_COLUMNS; c++)
+    {
+        free(writer->columns[c]);
+    }
+    free(writer->chunk);
+    free(writer->path);
+    free(writer);
+    return result;
+}
+
+// ===== Reading =====
+
+ArchiveReader* archive_open(const char* path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(ArchiveFileHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    const char* map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        close(fd);
+        return NULL;
+    }
+    ArchiveReader* reader = calloc(1, sizeof(ArchiveReader));
+    if (reader == NULL)
+    {
+        munmap((void*) map, (size_t) st.st_size);
+        close(fd);
+        return NULL;
+    }
+    reader->fd = fd;
+    reader->map = map;
+    reader->size = (size_t) st.st_size;
+
+    const ArchiveFileHeader* file_header = (const ArchiveFileHeader*) map;
+    if (memcmp(file_header->magic, ARCHIVE_MAGIC, sizeof(file_header->magic)) != 0 ||
+        file_header->version != ARCHIVE_VERSION || file_header->header_size % ARCHIVE_ALIGN != 0 ||
+        file_header->header_size > reader->size)
+    {
+        archive_close(reader);
+        return NULL;
+    }
+
+    // Index the chunks, stopping at a torn one
+    int capacity = 0;
+    size_t offset = file_header->header_size;
+    while (offset + sizeof(ArchiveChunkHeader) <= reader->size)
+    {
+        const ArchiveChunkHeader* header = (const ArchiveChunkHeader*) (map + offset);
+        if (!chunk_fits(header, reader->size - offset))
+        {
+            break;
+        }
+        if (reader->num_chunks == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            const ArchiveChunkHeader** grown = realloc(reader->chunks, sizeof(*grown) * (size_t) capacity);
+            if (grown == NULL)
+            {
+                archive_close(reader);
+                return NULL;
+            }
+            reader->chunks = grown;
+        }
+        reader->chunks[reader->num_chunks++] = header;
+        reader->num_rows += header->rows;
+        offset += header->size;
+    }
+    madvise((void*) map, reader->size, MADV_SEQUENTIAL);
+    return reader;
+}
+
+void archive_close(ArchiveReader* reader)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+    munmap((void*) reader->map, reader->size);
+    close(reader->fd);
+    free(reader->chunks);
+    free(reader);
+}
+
+int archive_num_chunks(const ArchiveReader* reader)
+{
+    return reader->num_chunks;
+}
+
+uint64_t archive_num_rows(const ArchiveReader* reader)
+{
+    return reader->num_rows;
+}
+
+void archive_chunk(const ArchiveReader* reader, int index, ArchiveChunk* chunk)
+{
+    const ArchiveChunkHeader* header = reader->chunks[index];
+    const char* base = (const char*) header;
+    chunk->header = header;
+    chunk->rows = header->rows;
+    chunk->hand_key = (const int64_t*) (base + header->offsets[ARCHIVE_COL_HAND_KEY]);
+    chunk->ended_ms = (const int64_t*) (base + header->offsets[ARCHIVE_COL_ENDED_MS]);
+    chunk->table_id = (const int32_t*) (base + header->offsets[ARCHIVE_COL_TABLE_ID]);
+    chunk->pot = (const int32_t*) (base + header->offsets[ARCHIVE_COL_POT]);
+    chunk->user_id = (const int32_t*) (base + header->offsets[ARCHIVE_COL_USER_ID]);
+    chunk->start_stack = (const int32_t*) (base + header->offsets[ARCHIVE_COL_START_STACK]);
+    chunk->bet = (const int32_t*) (base + header->offsets[ARCHIVE_COL_BET]);
+    chunk->won = (const int32_t*) (base + header->offsets[ARCHIVE_COL_WON]);
+    chunk->seat = (const uint8_t*) (base + header->offsets[ARCHIVE_COL_SEAT]);
+    chunk->flags = (const uint8_t*) (base + header->offsets[ARCHIVE_COL_FLAGS]);
+}
+
+int archive_verify(const ArchiveReader* reader)
+{
+    for (int i = 0; i < reader->num_chunks; i++)
+    {
+        const ArchiveChunkHeader* header = reader->chunks[i];
+        const unsigned char* data = (const unsigned char*) header + sizeof(*header);
+        if (crc32(data, header->size - sizeof(*header)) != header->crc)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,572 @@
+#include "archive.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The column loops below are written to be vectorized by the compiler: no branches on the data, one
+// mask byte per row, and restrict pointers so loads and stores may be reordered.
+
+void archive_filter_init(ArchiveFilter* filter)
+{
+    memset(filter, 0, sizeof(*filter));
+}
+
+void archive_filter_range(ArchiveFilter* filter, ArchiveColumn column, int64_t lo, int64_t hi)
+{
+    filter->ranged |= 1u << column;
+    filter->lo[column] = lo;
+    filter->hi[column] = hi;
+}
+
+bool archive_chunk_may_match(const ArchiveChunkHeader* header, const ArchiveFilter* filter)
+{
+    for (int c = 0; c < ARCHIVE_NUM_COLUMNS; c++)
+    {
+        if ((filter->ranged & (1u << c)) && (header->max[c] < filter->lo[c] || header->min[c] > filter->hi[c]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#define RANGE_LOOP(type, values, rows, lo, hi, mask, first)                                                           \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        const type* restrict v = (const type*) (values);                                                               \
+        uint8_t* restrict m = (mask);                                                                                  \
+        type low = (type) (lo);                                                                                        \
+        type high = (type) (hi);                                                                                       \
+        if (first)                                                                                                     \
+        {                                                                                                              \
+            for (uint32_t i = 0; i < (rows); i++)                                                                      \
+            {                                                                                                          \
+                m[i] = (uint8_t) ((v[i] >= low) & (v[i] <= high));                                                     \
+            }                                                                                                          \
+        }                                                                                                              \
+        else                                                                                                           \
+        {                                                                                                              \
+            for (uint32_t i = 0; i < (rows); i++)                                                                      \
+            {                                                                                                          \
+                m[i] &= (uint8_t) ((v[i] >= low) & (v[i] <= high));                                                    \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (0)
+
+// A range on a column of a narrower type is clamped to the type first, so the compares stay exact
+static void clamp_range(int width, int64_t* lo, int64_t* hi)
+{
+    int64_t min = width == 4 ? INT32_MIN : width == 1 ? 0 : INT64_MIN;
+    int64_t max = width == 4 ? INT32_MAX : width == 1 ? UINT8_MAX : INT64_MAX;
+    *lo = *lo < min ? min : *lo > max ? max : *lo;
+    *hi = *hi < min ? min : *hi > max ? max : *hi;
+}
+
+uint32_t archive_select(const ArchiveChunk* chunk, const ArchiveFilter* filter, uint8_t* mask)
+{
+    const ArchiveChunkHeader* header = chunk->header;
+    const char* base = (const char*) header;
+    uint32_t rows = chunk->rows;
+    bool first = true;
+
+    for (int c = 0; c < ARCHIVE_NUM_COLUMNS; c++)
+    {
+        if (!(filter->ranged & (1u << c)))
+        {
+            continue;
+        }
+        int64_t lo = filter->lo[c];
+        int64_t hi = filter->hi[c];
+        if (lo > hi || header->max[c] < lo || header->min[c] > hi)
+        {
+            memset(mask, 0, rows);
+            return 0;
+        }
+        if (lo <= header->min[c] && header->max[c] <= hi)
+        {
+            continue; // Every row of the chunk is in range
+        }
+        int width = archive_column_width((ArchiveColumn) c);
+        clamp_range(width, &lo, &hi);
+        const void* values = base + header->offsets[c];
+        switch (width)
+        {
+        case 8:
+            RANGE_LOOP(int64_t, values, rows, lo, hi, mask, first);
+            break;
+        case 4:
+            RANGE_LOOP(int32_t, values, rows, lo, hi, mask, first);
+            break;
+        default:
+            RANGE_LOOP(uint8_t, values, rows, lo, hi, mask, first);
+            break;
+        }
+        first = false;
+    }
+
+    if (filter->flags_set || filter->flags_clear)
+    {
+        const uint8_t* restrict flags = chunk->flags;
+        uint8_t* restrict m = mask;
+        uint8_t set = filter->flags_set;
+        uint8_t clear = filter->flags_clear;
+        if (first)
+        {
+            for (uint32_t i = 0; i < rows; i++)
+            {
+                m[i] = (uint8_t) (((flags[i] & set) == set) & ((flags[i] & clear) == 0));
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < rows; i++)
+            {
+                m[i] &= (uint8_t) (((flags[i] & set) == set) & ((flags[i] & clear) == 0));
+            }
+        }
+        first = false;
+    }
+
+    if (first)
+    {
+        memset(mask, 1, rows);
+        return rows;
+    }
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        count += mask[i];
+    }
+    return count;
+}
+
+// ===== Player stats =====
+
+// Open addressing on user_id; a slot with hands == 0 is empty
+typedef struct
+{
+    ArchivePlayerStats* slots;
+    uint32_t capacity; // Power of two
+    uint32_t count;
+} StatsTable;
+
+static bool stats_table_init(StatsTable* table, uint32_t capacity)
+{
+    table->slots = calloc(capacity, sizeof(ArchivePlayerStats));
+    table->capacity = capacity;
+    table->count = 0;
+    return table->slots != NULL;
+}
+
+static uint32_t stats_hash(int32_t user_id, uint32_t capacity)
+{
+    return ((uint32_t) user_id * 2654435761u) & (capacity - 1);
+}
+
+static bool stats_table_grow(StatsTable* table)
+{
+    StatsTable grown;
+    if (!stats_table_init(&grown, table->capacity * 2))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < table->capacity; i++)
+    {
+        ArchivePlayerStats* slot = &table->slots[i];
+        if (slot->hands == 0)
+        {
+            continue;
+        }
+        uint32_t j = stats_hash(slot->user_id, grown.capacity);
+        while (grown.slots[j].hands != 0)
+        {
+            j = (j + 1) & (grown.capacity - 1);
+        }
+        grown.slots[j] = *slot;
+        grown.count++;
+    }
+    free(table->slots);
+    *table = grown;
+    return true;
+}
+
+// The user's slot, claimed if new. NULL if memory ran out.
+static ArchivePlayerStats* stats_slot(StatsTable* table, int32_t user_id)
+{
+    uint32_t i = stats_hash(user_id, table->capacity);
+    for (;;)
+    {
+        ArchivePlayerStats* slot = &table->slots[i];
+        if (slot->hands != 0 && slot->user_id == user_id)
+        {
+            return slot;
+        }
+        if (slot->hands == 0)
+        {
+            if (table->count * 2 >= table->capacity)
+            {
+                return stats_table_grow(table) ? stats_slot(table, user_id) : NULL;
+            }
+            table->count++;
+            slot->user_id = user_id;
+            return slot;
+        }
+        i = (i + 1) & (table->capacity - 1);
+    }
+}
+
+static bool stats_add(StatsTable* table, const ArchivePlayerStats* stats)
+{
+    ArchivePlayerStats* slot = stats_slot(table, stats->user_id);
+    if (slot == NULL)
+    {
+        return false;
+    }
+    slot->hands += stats->hands;
+    slot->vpip += stats->vpip;
+    slot->pfr += stats->pfr;
+    slot->hands_won += stats->hands_won;
+    slot->net += stats->net;
+    slot->biggest_pot = stats->biggest_pot > slot->biggest_pot ? stats->biggest_pot : slot->biggest_pot;
+    return true;
+}
+
+typedef struct
+{
+    const ArchiveReader* reader;
+    const ArchiveFilter* filter;
+    atomic_int next_chunk;
+    atomic_bool failed;
+} StatsScan;
+
+// Counters for one user in one chunk
+typedef struct
+{
+    uint32_t hands;
+    uint32_t vpip;
+    uint32_t pfr;
+    uint32_t hands_won;
+    int64_t net;
+    int32_t biggest_pot;
+} DenseStats;
+
+// Users playing in the same stretch of time tend to have nearby ids, so a chunk's user_id range is often
+// narrow. Such a chunk is first counted in an array indexed by user_id - min, which stays in cache, and
+// each user seen is then added to the hash table once instead of once per row.
+#define DENSE_SPAN (1 << 16)
+
+typedef struct
+{
+    StatsScan* scan;
+    StatsTable table;
+    DenseStats* dense; // DENSE_SPAN entries, all zero between chunks
+    pthread_t thread;
+} StatsWorker;
+
+static bool add_rows_hashed(StatsTable* table, const ArchiveChunk* chunk, const uint8_t* mask)
+{
+    for (uint32_t i = 0; i < chunk->rows; i++)
+    {
+        if (!mask[i])
+        {
+            continue;
+        }
+        ArchivePlayerStats* slot = stats_slot(table, chunk->user_id[i]);
+        if (slot == NULL)
+        {
+            return false;
+        }
+        uint8_t flags = chunk->flags[i];
+        slot->hands++;
+        slot->vpip += (flags & ARCHIVE_FLAG_VPIP) != 0;
+        slot->pfr += (flags & ARCHIVE_FLAG_PFR) != 0;
+        slot->hands_won += chunk->won[i] > 0;
+        slot->net += (int64_t) chunk->won[i] - chunk->bet[i];
+        slot->biggest_pot = chunk->pot[i] > slot->biggest_pot ? chunk->pot[i] : slot->biggest_pot;
+    }
+    return true;
+}
+
+// Matching rows all have base <= user_id < base + span
+static bool add_rows_dense(StatsTable* table, DenseStats* dense, int32_t base, uint32_t span, const ArchiveChunk* chunk,
+                           const uint8_t* mask)
+{
+    for (uint32_t i = 0; i < chunk->rows; i++)
+    {
+        if (!mask[i])
+        {
+            continue;
+        }
+        DenseStats* d = &dense[chunk->user_id[i] - base];
+        uint8_t flags = chunk->flags[i];
+        d->hands++;
+        d->vpip += (flags & ARCHIVE_FLAG_VPIP) != 0;
+        d->pfr += (flags & ARCHIVE_FLAG_PFR) != 0;
+        d->hands_won += chunk->won[i] > 0;
+        d->net += (int64_t) chunk->won[i] - chunk->bet[i];
+        d->biggest_pot = chunk->pot[i] > d->biggest_pot ? chunk->pot[i] : d->biggest_pot;
+    }
+
+    bool ok = true;
+    for (uint32_t u = 0; u < span; u++)
+    {
+        DenseStats* d = &dense[u];
+        if (d->hands == 0)
+        {
+            continue;
+        }
+        ArchivePlayerStats stats = {base + (int32_t) u, d->hands, d->vpip, d->pfr, d->hands_won, d->net, d->biggest_pot};
+        ok = ok && stats_add(table, &stats);
+        memset(d, 0, sizeof(*d));
+    }
+    return ok;
+}
+
+static void* stats_worker(void* arg)
+{
+    StatsWorker* worker = arg;
+    StatsScan* scan = worker->scan;
+    uint8_t* mask = malloc(ARCHIVE_CHUNK_ROWS);
+    worker->dense = calloc(DENSE_SPAN, sizeof(DenseStats));
+    if (mask == NULL || worker->dense == NULL)
+    {
+        atomic_store(&scan->failed, true);
+        free(mask);
+        free(worker->dense);
+        return NULL;
+    }
+
+    int num_chunks = archive_num_chunks(scan->reader);
+    for (int index = atomic_fetch_add(&scan->next_chunk, 1); index < num_chunks && !atomic_load(&scan->failed);
+         index = atomic_fetch_add(&scan->next_chunk, 1))
+    {
+        ArchiveChunk chunk;
+        archive_chunk(scan->reader, index, &chunk);
+        uint32_t matched;
+        if (!archive_chunk_may_match(chunk.header, scan->filter) ||
+            (matched = archive_select(&chunk, scan->filter, mask)) == 0)
+        {
+            continue;
+        }
+        // The user ids the matching rows can have: the chunk's, narrowed by the filter's
+        int64_t lo = chunk.header->min[ARCHIVE_COL_USER_ID];
+        int64_t hi = chunk.header->max[ARCHIVE_COL_USER_ID];
+        if (scan->filter->ranged & (1u << ARCHIVE_COL_USER_ID))
+        {
+            lo = scan->filter->lo[ARCHIVE_COL_USER_ID] > lo ? scan->filter->lo[ARCHIVE_COL_USER_ID] : lo;
+            hi = scan->filter->hi[ARCHIVE_COL_USER_ID] < hi ? scan->filter->hi[ARCHIVE_COL_USER_ID] : hi;
+        }
+        int64_t span = hi - lo + 1;
+        bool ok = span <= DENSE_SPAN && span <= 4 * (int64_t) matched
+                      ? add_rows_dense(&worker->table, worker->dense, (int32_t) lo, (uint32_t) span, &chunk, mask)
+                      : add_rows_hashed(&worker->table, &chunk, mask);
+        if (!ok)
+        {
+            atomic_store(&scan->failed, true);
+        }
+    }
+    free(mask);
+    free(worker->dense);
+    return NULL;
+}
+
+static int compare_stats(const void* a, const void* b)
+{
+    const ArchivePlayerStats* x = a;
+    const ArchivePlayerStats* y = b;
+    if (x->hands != y->hands)
+    {
+        return x->hands > y->hands ? -1 : 1;
+    }
+    return (x->user_id > y->user_id) - (x->user_id < y->user_id);
+}
+
+int archive_player_stats(const ArchiveReader* reader, const ArchiveFilter* filter, int num_threads,
+                         ArchivePlayerStats** stats)
+{
+    int num_chunks = archive_num_chunks(reader);
+    num_threads = num_threads < 1 ? 1 : num_threads > ARCHIVE_MAX_THREADS ? ARCHIVE_MAX_THREADS : num_threads;
+    num_threads = num_threads > num_chunks && num_chunks > 0 ? num_chunks : num_threads;
+
+    StatsScan scan = {.reader = reader, .filter = filter};
+    atomic_init(&scan.next_chunk, 0);
+    atomic_init(&scan.failed, false);
+    StatsWorker workers[ARCHIVE_MAX_THREADS];
+    int started = 0;
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers[i].scan = &scan;
+        if (!stats_table_init(&workers[i].table, 1024))
+        {
+            atomic_store(&scan.failed, true);
+            break;
+        }
+        started++;
+        // The first worker runs on this thread once the others are going
+        if (i > 0 && pthread_create(&workers[i].thread, NULL, stats_worker, &workers[i]) != 0)
+        {
+            atomic_store(&scan.failed, true);
+            free(workers[i].table.slots);
+            started--;
+            break;
+        }
+    }
+    if (started > 0)
+    {
+        stats_worker(&workers[0]);
+    }
+    for (int i = 1; i < started; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    // Fold every table into the first
+    bool failed = started == 0 || atomic_load(&scan.failed);
+    for (int i = 1; i < started; i++)
+    {
+        for (uint32_t j = 0; j < workers[i].table.capacity && !failed; j++)
+        {
+            if (workers[i].table.slots[j].hands != 0)
+            {
+                failed = !stats_add(&workers[0].table, &workers[i].table.slots[j]);
+            }
+        }
+        free(workers[i].table.slots);
+    }
+    if (failed)
+    {
+        if (started > 0)
+        {
+            free(workers[0].table.slots);
+        }
+        return -1;
+    }
+
+    StatsTable* table = &workers[0].table;
+    ArchivePlayerStats* out = malloc(sizeof(ArchivePlayerStats) * (table->count ? table->count : 1));
+    if (out == NULL)
+    {
+        free(table->slots);
+        return -1;
+    }
+    int count = 0;
+    for (uint32_t j = 0; j < table->capacity; j++)
+    {
+        if (table->slots[j].hands != 0)
+        {
+            out[count++] = table->slots[j];
+        }
+    }
+    free(table->slots);
+    qsort(out, (size_t) count, sizeof(*out), compare_stats);
+    *stats = out;
+    return count;
+}
+
+// ===== Biggest pots =====
+
+// Min-heap on pot, so the smallest of the n kept is at the root
+static void heap_push(ArchivePot* heap, int* size, int n, const ArchivePot* pot)
+{
+    int i;
+    if (*size < n)
+    {
+        i = (*size)++;
+        while (i > 0 && heap[(i - 1) / 2].pot > pot->pot)
+        {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = *pot;
+        return;
+    }
+    // Replace the root and sift down
+    i = 0;
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= n)
+        {
+            break;
+        }
+        if (child + 1 < n && heap[child + 1].pot < heap[child].pot)
+        {
+            child++;
+        }
+        if (heap[child].pot >= pot->pot)
+        {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = *pot;
+}
+
+static int compare_pots(const void* a, const void* b)
+{
+    const ArchivePot* x = a;
+    const ArchivePot* y = b;
+    if (x->pot != y->pot)
+    {
+        return x->pot > y->pot ? -1 : 1;
+    }
+    return (x->hand_key > y->hand_key) - (x->hand_key < y->hand_key);
+}
+
+int archive_top_pots(const ArchiveReader* reader, const ArchiveFilter* filter, int n, ArchivePot* out)
+{
+    if (n <= 0)
+    {
+        return 0;
+    }
+    uint8_t* mask = malloc(ARCHIVE_CHUNK_ROWS);
+    if (mask == NULL)
+    {
+        return 0;
+    }
+
+    int size = 0;
+    for (int index = 0; index < archive_num_chunks(reader); index++)
+    {
+        ArchiveChunk chunk;
+        archive_chunk(reader, index, &chunk);
+        // Once n pots are kept, a chunk whose biggest pot is no bigger than the smallest kept has nothing to add
+        ArchiveFilter bigger = *filter;
+        if (size == n)
+        {
+            int64_t lo = (int64_t) out[0].pot + 1;
+            if (!(bigger.ranged & (1u << ARCHIVE_COL_POT)) || bigger.lo[ARCHIVE_COL_POT] < lo)
+            {
+                int64_t hi = (bigger.ranged & (1u << ARCHIVE_COL_POT)) ? bigger.hi[ARCHIVE_COL_POT] : INT64_MAX;
+                archive_filter_range(&bigger, ARCHIVE_COL_POT, lo, hi);
+            }
+        }
+        if (!archive_chunk_may_match(chunk.header, &bigger) || archive_select(&chunk, &bigger, mask) == 0)
+        {
+            continue;
+        }
+        // A hand's rows are adjacent, so its pot is offered once
+        int64_t last_key = 0;
+        bool have_last = false;
+        for (uint32_t i = 0; i < chunk.rows; i++)
+        {
+            if (!mask[i] || (have_last && chunk.hand_key[i] == last_key))
+            {
+                continue;
+            }
+            last_key = chunk.hand_key[i];
+            have_last = true;
+            if (size == n && chunk.pot[i] <= out[0].pot)
+            {
+                continue;
+            }
+            ArchivePot pot = {chunk.hand_key[i], chunk.ended_ms[i], chunk.table_id[i], chunk.pot[i]};
+            heap_push(out, &size, n, &pot);
+        }
+    }
+    free(mask);
+    qsort(out, (size_t) size, sizeof(*out), compare_pots);
+    return size;
+}
@@ -0,0 +1,150 @@
+// Archive write and scan throughput.
+//
+//   ./Cardio_archive_bench [million_hands] [max_threads]
+//
+// write:   rows appended and flushed as chunks, the hand-history writer's side
+// stats:   per-player VPIP/PFR/net over every row, on 1 thread and on max_threads
+// user:    one player's stats; chunks they never sat in are skipped by their min/max
+// pots:    the 10 biggest pots; most chunks are skipped once 10 big ones are kept
+//
+// The archive is written under /tmp and removed afterwards. Scans run on a warm page cache.
+#include "archive.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define USERS 200000
+#define TABLES 5000
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t next_random(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t) (rng_state >> 32);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void report(const char* name, uint64_t rows, double seconds)
+{
+    printf("%-24s %8.3f s  %8.1f M rows/s\n", name, seconds, (double) rows / seconds / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+    long million_hands = argc > 1 ? atol(argv[1]) : 4;
+    int max_threads = argc > 2 ? atoi(argv[2]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    long hands = million_hands * 1000000L;
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/cardio_archive_bench_%d", (int) getpid());
+    unlink(path);
+
+    // Users sit at a table for a while, so a user's hands cluster in time the way real ones do
+    ArchiveWriter* writer = archive_writer_create(path);
+    if (writer == NULL)
+    {
+        return 1;
+    }
+    uint64_t rows_written = 0;
+    double start = now_s();
+    for (long h = 0; h < hands; h++)
+    {
+        ArchiveRow rows[6];
+        int players = 2 + (int) (next_random() % 5);
+        int table = (int) (h % TABLES);
+        int pot = 0;
+        for (int i = 0; i < players; i++)
+        {
+            rows[i] = (ArchiveRow){
+                .hand_key = h,
+                .ended_ms = 1700000000000LL + h * 10,
+                .table_id = table,
+                .user_id = (int32_t) ((table * 6 + i + h / 100000 * 7919) % USERS),
+                .start_stack = 1000 + (int32_t) (next_random() % 10000),
+                .bet = (int32_t) (next_random() % 400),
+                .seat = (uint8_t) i,
+                .flags = (uint8_t) (next_random() & (ARCHIVE_FLAG_VPIP | ARCHIVE_FLAG_PFR)),
+            };
+            pot += rows[i].bet;
+        }
+        for (int i = 0; i < players; i++)
+        {
+            rows[i].pot = pot;
+        }
+        rows[next_random() % (uint32_t) players].won = pot;
+        if (archive_writer_append_hand(writer, rows, players) != 0)
+        {
+            fprintf(stderr, "append failed\n");
+            return 1;
+        }
+        rows_written += (uint64_t) players;
+    }
+    if (archive_writer_close(writer) != 0)
+    {
+        fprintf(stderr, "flush failed\n");
+        return 1;
+    }
+    report("write", rows_written, now_s() - start);
+
+    ArchiveReader* reader = archive_open(path);
+    if (reader == NULL)
+    {
+        return 1;
+    }
+    uint64_t rows = archive_num_rows(reader);
+    printf("%ld hands, %llu rows, %d chunks\n", hands, (unsigned long long) rows, archive_num_chunks(reader));
+
+    ArchiveFilter all;
+    archive_filter_init(&all);
+    ArchivePlayerStats* stats = NULL;
+    int players = archive_player_stats(reader, &all, 1, &stats); // Also warms the page cache
+    free(stats);
+    for (int threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "stats, %d threads", threads);
+        start = now_s();
+        players = archive_player_stats(reader, &all, threads, &stats);
+        report(name, rows, now_s() - start);
+        free(stats);
+        if (threads >= max_threads)
+        {
+            break;
+        }
+    }
+    printf("%d players\n", players);
+
+    ArchiveFilter user;
+    archive_filter_init(&user);
+    archive_filter_range(&user, ARCHIVE_COL_USER_ID, 4242, 4242);
+    start = now_s();
+    players = archive_player_stats(reader, &user, max_threads, &stats);
+    report("user, all threads", rows, now_s() - start);
+    if (players == 1)
+    {
+        printf("user 4242: %llu hands, net %lld\n", (unsigned long long) stats[0].hands, (long long) stats[0].net);
+    }
+    free(stats);
+
+    ArchivePot pots[10];
+    start = now_s();
+    int found = archive_top_pots(reader, &all, 10, pots);
+    report("pots, top 10", rows, now_s() - start);
+    if (found > 0)
+    {
+        printf("biggest pot: %d (hand %lld)\n", pots[0].pot, (long long) pots[0].hand_key);
+    }
+
+    archive_close(reader);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,270 @@
+#include "archive.h"
+#include "testing.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+#define TEST_USERS 50
+
+static uint64_t rng_state;
+
+static uint32_t next_random(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t) (rng_state >> 32);
+}
+
+// Hand h of a made-up archive: 2 to 6 players, one winner taking the pot
+static int make_hand(int h, ArchiveRow* rows)
+{
+    int players = 2 + (int) (next_random() % 5);
+    int pot = 0;
+    for (int i = 0; i < players; i++)
+    {
+        ArchiveRow* row = &rows[i];
+        memset(row, 0, sizeof(*row));
+        row->hand_key = 1000 + h;
+        row->ended_ms = 1700000000000LL + (int64_t) h * 1000;
+        row->table_id = 1 + h % 7;
+        // Bots get ids far from everyone else's, so unfiltered chunks span too many ids to count densely
+        row->user_id = i == 5 ? 1000000 + h : 1 + (int32_t) ((h * 7 + i * 13) % TEST_USERS);
+        row->start_stack = 1000 + (int32_t) (next_random() % 5000);
+        row->bet = (int32_t) (next_random() % 500);
+        row->seat = (uint8_t) i;
+        row->flags = (uint8_t) (next_random() & (ARCHIVE_FLAG_VPIP | ARCHIVE_FLAG_PFR)) | (i == 5 ? ARCHIVE_FLAG_BOT : 0);
+        pot += row->bet;
+    }
+    for (int i = 0; i < players; i++)
+    {
+        rows[i].pot = pot;
+    }
+    rows[h % players].won = pot;
+    return players;
+}
+
+static void temp_path(char* path, size_t len, const char* name)
+{
+    snprintf(path, len, "/tmp/cardio_archive_%s_%d", name, (int) getpid());
+    unlink(path);
+}
+
+TEST(test_archive_round_trip)
+{
+    char path[128];
+    temp_path(path, sizeof(path), "round_trip");
+    ArchiveWriter* writer = archive_writer_create(path);
+    ASSERT(writer != NULL);
+
+    // Three rows a hand: 65536 is not a multiple, so the first chunk is cut early rather than split a hand
+    int appended = 0;
+    for (int h = 0; h < 30000; h++)
+    {
+        ArchiveRow rows[3];
+        for (int i = 0; i < 3; i++)
+        {
+            rows[i] = (ArchiveRow){.hand_key = h, .ended_ms = 5000 + h, .table_id = 9, .pot = h, .user_id = 100 + i,
+                                   .start_stack = 2000, .bet = i, .won = i == 0 ? h : 0, .seat = (uint8_t) i,
+                                   .flags = (uint8_t) i};
+        }
+        appended += archive_writer_append_hand(writer, rows, 3) == 0;
+    }
+    ASSERT(appended == 30000);
+    ASSERT(archive_writer_pending(writer) == 90000 - 65535);
+    ASSERT(archive_writer_close(writer) == 0);
+
+    ArchiveReader* reader = archive_open(path);
+    ASSERT(reader != NULL);
+    ASSERT(archive_num_chunks(reader) == 2);
+    ASSERT(archive_num_rows(reader) == 90000);
+    ASSERT(archive_verify(reader) == -1);
+
+    ArchiveChunk chunk;
+    archive_chunk(reader, 1, &chunk);
+    ASSERT(chunk.rows == 90000 - 65535);
+    ASSERT(((uintptr_t) chunk.user_id % ARCHIVE_ALIGN) == 0 && ((uintptr_t) chunk.hand_key % ARCHIVE_ALIGN) == 0);
+    ASSERT(chunk.hand_key[0] == 21845 && chunk.user_id[0] == 100 && chunk.pot[0] == 21845);
+    ASSERT(chunk.won[3] == 21846 && chunk.bet[5] == 2 && chunk.seat[5] == 2 && chunk.flags[4] == 1);
+    ASSERT(chunk.header->min[ARCHIVE_COL_HAND_KEY] == 21845 && chunk.header->max[ARCHIVE_COL_HAND_KEY] == 29999);
+    ASSERT(chunk.header->min[ARCHIVE_COL_USER_ID] == 100 && chunk.header->max[ARCHIVE_COL_USER_ID] == 102);
+
+    // A time range covering part of the second chunk only skips the first by its index
+    ArchiveFilter filter;
+    archive_filter_init(&filter);
+    archive_filter_range(&filter, ARCHIVE_COL_ENDED_MS, 5000 + 29000, 5000 + 40000);
+    ArchiveChunk first;
+    archive_chunk(reader, 0, &first);
+    ASSERT(!archive_chunk_may_match(first.header, &filter));
+    uint8_t* mask = malloc(ARCHIVE_CHUNK_ROWS);
+    ASSERT(archive_select(&chunk, &filter, mask) == 3000);
+    ASSERT(mask[0] == 0 && mask[chunk.rows - 1] == 1);
+    free(mask);
+
+    archive_close(reader);
+    unlink(path);
+}
+
+TEST(test_archive_torn_tail)
+{
+    char path[128];
+    temp_path(path, sizeof(path), "torn_tail");
+    ArchiveRow rows[6];
+    ArchiveWriter* writer = archive_writer_create(path);
+    rng_state = 42;
+    int total = 0;
+    for (int h = 0; h < 100; h++)
+    {
+        int n = make_hand(h, rows);
+        archive_writer_append_hand(writer, rows, n);
+        total += n;
+    }
+    ASSERT(archive_writer_flush(writer) == 0);
+
+    // Someone else appending to the same archive is refused while we hold it
+    ArchiveWriter* other = archive_writer_create(path);
+    archive_writer_append_hand(other, rows, 1);
+    ASSERT(archive_writer_flush(other) == -1);
+    ASSERT(archive_writer_pending(other) == 1);
+    archive_writer_close(other);
+    ASSERT(archive_writer_close(writer) == 0);
+
+    // A crash in the middle of the next chunk leaves its header and part of its data
+    FILE* file = fopen(path, "ab");
+    ArchiveChunkHeader torn = {.magic = ARCHIVE_CHUNK_MAGIC, .rows = 10, .size = 4096};
+    fwrite(&torn, sizeof(torn), 1, file);
+    fwrite(rows, sizeof(rows), 1, file);
+    fclose(file);
+
+    ArchiveReader* reader = archive_open(path);
+    ASSERT(reader != NULL);
+    ASSERT(archive_num_chunks(reader) == 1 && archive_num_rows(reader) == (uint64_t) total);
+    archive_close(reader);
+
+    // The next writer cuts it off and carries on after the last whole chunk
+    writer = archive_writer_create(path);
+    archive_writer_append_hand(writer, rows, 2);
+    ASSERT(archive_writer_close(writer) == 0);
+    reader = archive_open(path);
+    ASSERT(archive_num_chunks(reader) == 2 && archive_num_rows(reader) == (uint64_t) total + 2);
+    ASSERT(archive_verify(reader) == -1);
+    archive_close(reader);
+
+    // Not an archive: never appended to
+    file = fopen(path, "wb");
+    fputs("not an archive, but someone's file", file);
+    fclose(file);
+    ASSERT(archive_open(path) == NULL);
+    writer = archive_writer_create(path);
+    archive_writer_append_hand(writer, rows, 2);
+    ASSERT(archive_writer_close(writer) == -1);
+    unlink(path);
+}
+
+TEST(test_archive_queries)
+{
+    char path[128];
+    temp_path(path, sizeof(path), "queries");
+    enum { HANDS = 40000 };
+    ArchiveRow* all = malloc(sizeof(ArchiveRow) * HANDS * 6);
+    int num_rows = 0;
+    ArchiveWriter* writer = archive_writer_create(path);
+    rng_state = 7;
+    for (int h = 0; h < HANDS; h++)
+    {
+        int n = make_hand(h, &all[num_rows]);
+        archive_writer_append_hand(writer, &all[num_rows], n);
+        num_rows += n;
+    }
+    ASSERT(archive_writer_close(writer) == 0);
+    ArchiveReader* reader = archive_open(path);
+    ASSERT(archive_num_rows(reader) == (uint64_t) num_rows && archive_num_chunks(reader) > 1);
+
+    // Humans in the second half of the archive, on tables 2 to 4
+    ArchiveFilter filter;
+    archive_filter_init(&filter);
+    archive_filter_range(&filter, ARCHIVE_COL_ENDED_MS, 1700000000000LL + HANDS / 2 * 1000LL, INT64_MAX);
+    archive_filter_range(&filter, ARCHIVE_COL_TABLE_ID, 2, 4);
+    filter.flags_clear = ARCHIVE_FLAG_BOT;
+
+    ArchivePlayerStats expected[TEST_USERS + 1];
+    memset(expected, 0, sizeof(expected));
+    ArchivePot best = {0};
+    for (int i = 0; i < num_rows; i++)
+    {
+        const ArchiveRow* row = &all[i];
+        if (row->ended_ms < 1700000000000LL + HANDS / 2 * 1000LL || row->table_id < 2 || row->table_id > 4 ||
+            (row->flags & ARCHIVE_FLAG_BOT))
+        {
+            continue;
+        }
+        ArchivePlayerStats* s = &expected[row->user_id];
+        s->user_id = row->user_id;
+        s->hands++;
+        s->vpip += (row->flags & ARCHIVE_FLAG_VPIP) != 0;
+        s->pfr += (row->flags & ARCHIVE_FLAG_PFR) != 0;
+        s->hands_won += row->won > 0;
+        s->net += row->won - row->bet;
+        s->biggest_pot = row->pot > s->biggest_pot ? row->pot : s->biggest_pot;
+        if (row->pot > best.pot)
+        {
+            best = (ArchivePot){row->hand_key, row->ended_ms, row->table_id, row->pot};
+        }
+    }
+
+    // Counted in the hash table, then (with the humans' ids as a range too) in the dense arrays
+    for (int pass = 0; pass < 4; pass++)
+    {
+        int threads = pass % 2 ? 4 : 1;
+        if (pass == 2)
+        {
+            archive_filter_range(&filter, ARCHIVE_COL_USER_ID, 1, TEST_USERS);
+        }
+        ArchivePlayerStats* stats = NULL;
+        int count = archive_player_stats(reader, &filter, threads, &stats);
+        int players = 0;
+        bool same = true;
+        for (int u = 1; u <= TEST_USERS; u++)
+        {
+            players += expected[u].hands > 0;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            const ArchivePlayerStats* want = &expected[stats[i].user_id];
+            same &= stats[i].hands == want->hands && stats[i].vpip == want->vpip && stats[i].pfr == want->pfr &&
+                    stats[i].hands_won == want->hands_won && stats[i].net == want->net &&
+                    stats[i].biggest_pot == want->biggest_pot;
+            same &= i == 0 || stats[i - 1].hands >= stats[i].hands;
+        }
+        ASSERT(count == players && same);
+        free(stats);
+    }
+
+    ArchivePot pots[5];
+    int found = archive_top_pots(reader, &filter, 5, pots);
+    ASSERT(found == 5 && pots[0].pot == best.pot);
+    bool distinct = true;
+    for (int i = 1; i < found; i++)
+    {
+        distinct &= pots[i].hand_key != pots[i - 1].hand_key && pots[i].pot <= pots[i - 1].pot;
+    }
+    ASSERT(distinct);
+
+    // A user who never played matches nothing, and no chunk is scanned for them
+    archive_filter_range(&filter, ARCHIVE_COL_USER_ID, TEST_USERS + 1, TEST_USERS + 1);
+    ArchivePlayerStats* none = NULL;
+    ASSERT(archive_player_stats(reader, &filter, 2, &none) == 0);
+    free(none);
+    ASSERT(archive_top_pots(reader, &filter, 5, pots) == 0);
+
+    archive_close(reader);
+    free(all);
+    unlink(path);
+}
+
+int main()
+{
+    RUN_TEST(test_archive_round_trip);
+    RUN_TEST(test_archive_torn_tail);
+    RUN_TEST(test_archive_queries);
+    return failed;
+}
@@ -0,0 +1,228 @@
+// Query a hand-history archive written by the server (see archive.h).
+//
+//   ./Cardio_archive_query <archive> info
+//   ./Cardio_archive_query <archive> verify
+//   ./Cardio_archive_query <archive> stats [filters] [--limit N] [--threads N]
+//   ./Cardio_archive_query <archive> pots [filters] [--limit N]
+//
+// Filters: --user ID, --table ID, --since UNIX_SECONDS, --until UNIX_SECONDS, --min-pot CHIPS, --humans
+//
+// stats prints one line per player, most hands first: hands, VPIP and PFR as a share of hands, the share
+// of hands won, net chips and net chips per 100 hands (win rate), and the biggest pot played.
+// The scan time goes to stderr.
+#include "archive.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: Cardio_archive_query <archive> info|verify|stats|pots [--user ID] [--table ID]\n"
+                    "       [--since UNIX_SECONDS] [--until UNIX_SECONDS] [--min-pot CHIPS] [--humans]\n"
+                    "       [--limit N] [--threads N]\n");
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static double percent(uint64_t part, uint64_t whole)
+{
+    return whole ? 100.0 * (double) part / (double) whole : 0.0;
+}
+
+static void print_time(int64_t ms)
+{
+    time_t seconds = (time_t) (ms / 1000);
+    struct tm tm;
+    char text[32];
+    gmtime_r(&seconds, &tm);
+    strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm);
+    printf("%s", text);
+}
+
+static int info(const ArchiveReader* reader)
+{
+    int chunks = archive_num_chunks(reader);
+    printf("rows    %llu\n", (unsigned long long) archive_num_rows(reader));
+    printf("chunks  %d\n", chunks);
+    if (chunks > 0)
+    {
+        ArchiveChunk first;
+        ArchiveChunk last;
+        archive_chunk(reader, 0, &first);
+        archive_chunk(reader, chunks - 1, &last);
+        printf("from    ");
+        print_time(first.header->min[ARCHIVE_COL_ENDED_MS]);
+        printf(" UTC\nuntil   ");
+        print_time(last.header->max[ARCHIVE_COL_ENDED_MS]);
+        printf(" UTC\n");
+    }
+    return 0;
+}
+
+static int stats(const ArchiveReader* reader, const ArchiveFilter* filter, int limit, int threads)
+{
+    double start = now_s();
+    ArchivePlayerStats* players = NULL;
+    int count = archive_player_stats(reader, filter, threads, &players);
+    double elapsed = now_s() - start;
+    if (count < 0)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%10s %10s %6s %6s %6s %14s %10s %12s\n", "user_id", "hands", "vpip%", "pfr%", "won%", "net", "net/100",
+           "biggest_pot");
+    for (int i = 0; i < count && (limit <= 0 || i < limit); i++)
+    {
+        const ArchivePlayerStats* p = &players[i];
+        printf("%10d %10llu %6.1f %6.1f %6.1f %14lld %10.1f %12d\n", p->user_id, (unsigned long long) p->hands,
+               percent(p->vpip, p->hands), percent(p->pfr, p->hands), percent(p->hands_won, p->hands),
+               (long long) p->net, p->hands ? 100.0 * (double) p->net / (double) p->hands : 0.0, p->biggest_pot);
+    }
+    free(players);
+    fprintf(stderr, "%d players, %llu rows scanned in %.3f s\n", count, (unsigned long long) archive_num_rows(reader),
+            elapsed);
+    return 0;
+}
+
+static int pots(const ArchiveReader* reader, const ArchiveFilter* filter, int limit)
+{
+    limit = limit > 0 ? limit : 10;
+    ArchivePot* found = malloc(sizeof(ArchivePot) * (size_t) limit);
+    if (found == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    double start = now_s();
+    int count = archive_top_pots(reader, filter, limit, found);
+    double elapsed = now_s() - start;
+
+    printf("%12s %22s %10s %24s\n", "pot", "hand_key", "table_id", "ended (UTC)");
+    for (int i = 0; i < count; i++)
+    {
+        printf("%12d %22lld %10d     ", found[i].pot, (long long) found[i].hand_key, found[i].table_id);
+        print_time(found[i].ended_ms);
+        printf("\n");
+    }
+    free(found);
+    fprintf(stderr, "%d pots in %.3f s\n", count, elapsed);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        usage();
+        return 2;
+    }
+    const char* command = argv[2];
+
+    ArchiveFilter filter;
+    archive_filter_init(&filter);
+    int64_t since_ms = INT64_MIN;
+    int64_t until_ms = INT64_MAX;
+    int limit = 0;
+    int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 3; i < argc; i++)
+    {
+        const char* option = argv[i];
+        if (strcmp(option, "--humans") == 0)
+        {
+            filter.flags_clear |= ARCHIVE_FLAG_BOT;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 2;
+        }
+        long long value = atoll(argv[++i]);
+        if (strcmp(option, "--user") == 0)
+        {
+            archive_filter_range(&filter, ARCHIVE_COL_USER_ID, value, value);
+        }
+        else if (strcmp(option, "--table") == 0)
+        {
+            archive_filter_range(&filter, ARCHIVE_COL_TABLE_ID, value, value);
+        }
+        else if (strcmp(option, "--since") == 0)
+        {
+            since_ms = value * 1000;
+        }
+        else if (strcmp(option, "--until") == 0)
+        {
+            until_ms = value * 1000 + 999;
+        }
+        else if (strcmp(option, "--min-pot") == 0)
+        {
+            archive_filter_range(&filter, ARCHIVE_COL_POT, value, INT64_MAX);
+        }
+        else if (strcmp(option, "--limit") == 0)
+        {
+            limit = (int) value;
+        }
+        else if (strcmp(option, "--threads") == 0)
+        {
+            threads = (int) value;
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (since_ms != INT64_MIN || until_ms != INT64_MAX)
+    {
+        archive_filter_range(&filter, ARCHIVE_COL_ENDED_MS, since_ms, until_ms);
+    }
+
+    ArchiveReader* reader = archive_open(argv[1]);
+    if (reader == NULL)
+    {
+        fprintf(stderr, "%s: not a readable archive\n", argv[1]);
+        return 1;
+    }
+    int result;
+    if (strcmp(command, "info") == 0)
+    {
+        result = info(reader);
+    }
+    else if (strcmp(command, "verify") == 0)
+    {
+        int bad = archive_verify(reader);
+        if (bad >= 0)
+        {
+            printf("chunk %d is corrupt\n", bad);
+        }
+        else
+        {
+            printf("%d chunks ok\n", archive_num_chunks(reader));
+        }
+        result = bad >= 0;
+    }
+    else if (strcmp(command, "stats") == 0)
+    {
+        result = stats(reader, &filter, limit, threads);
+    }
+    else if (strcmp(command, "pots") == 0)
+    {
+        result = pots(reader, &filter, limit);
+    }
+    else
+    {
+        usage();
+        result = 2;
+    }
+    archive_close(reader);
+    return result;
+}
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_card.dir/src/card.c.o"
+  "CMakeFiles/Cardio_card.dir/src/card.c.o.d"
+  "CMakeFiles/Cardio_card.dir/src/deck.c.o"
+  "CMakeFiles/Cardio_card.dir/src/deck.c.o.d"
+  "libCardio_card.a"
+  "libCardio_card.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_card.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
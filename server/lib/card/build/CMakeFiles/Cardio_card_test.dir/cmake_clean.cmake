@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_card_test.dir/src/card.c.o"
+  "CMakeFiles/Cardio_card_test.dir/src/card.c.o.d"
+  "CMakeFiles/Cardio_card_test.dir/src/deck.c.o"
+  "CMakeFiles/Cardio_card_test.dir/src/deck.c.o.d"
+  "CMakeFiles/Cardio_card_test.dir/test/unit_tests.c.o"
+  "CMakeFiles/Cardio_card_test.dir/test/unit_tests.c.o.d"
+  "Cardio_card_test"
+  "Cardio_card_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_card_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -40,6 +40,8 @@ int swap_card(Deck* aDeckPtr, int s, int t);
 int deck_init(Deck* aDeckPtr);
 void deck_fill(Deck* aDeckPtr);
 void shuffle(Deck* aDeckPtr, int shuffles);
+// Fisher-Yates shuffle driven only by seed: a filled deck and the same seed always give the same order
+void shuffle_seeded(Deck* aDeckPtr, unsigned long long seed);
 void deck_destroy(Deck* aDeckPtr);
 void enqueue_deck(Deck* aDeckPtr);
 int remove_card(Deck* aDeckPtr, Card* card);
@@ -127,6 +127,22 @@ void shuffle(Deck* aDeckPtr, int shuffles)
     }
 }
 
+void shuffle_seeded(Deck* aDeckPtr, unsigned long long seed)
+{
+    /*xorshift64*, so the order depends on nothing but the seed (not on rand() or other users of it)*/
+    unsigned long long state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    for (int i = DECK_SIZE - 1; i > 0; i--)
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        int j = (int) ((state * 0x2545F4914F6CDD1DULL) % (unsigned long long) (i + 1));
+        Card* tmp = cards[i];
+        cards[i] = cards[j];
+        cards[j] = tmp;
+    }
+}
+
 // destroy the cards underlying the deck and the deck itself
 void deck_destroy(Deck* aDeckPtr)
 {
@@ -421,6 +421,44 @@ TEST(test_shuffle_preserves_all_cards)
     free(deck.cards);
 }
 
+TEST(test_shuffle_seeded_is_reproducible)
+{
+    Deck first;
+    Deck second;
+    deck_init(&first);
+    deck_init(&second);
+
+    // A journal replays a hand by shuffling with the seed it recorded
+    deck_fill(&first);
+    shuffle_seeded(&first, 12345);
+    shuffle(&second, 100);
+    deck_fill(&second);
+    shuffle_seeded(&second, 12345);
+    int same = 0;
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        same += first.cards[i]->suit == second.cards[i]->suit && first.cards[i]->rank == second.cards[i]->rank;
+    }
+    ASSERT(same == DECK_SIZE);
+
+    deck_fill(&second);
+    shuffle_seeded(&second, 54321);
+    same = 0;
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        same += first.cards[i]->suit == second.cards[i]->suit && first.cards[i]->rank == second.cards[i]->rank;
+    }
+    ASSERT(same < DECK_SIZE);
+
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        free(first.cards[i]);
+        free(second.cards[i]);
+    }
+    free(first.cards);
+    free(second.cards);
+}
+
 int main()
 {
     printf("Running Card Library Unit Tests\n");
@@ -455,6 +493,7 @@ int main()
     RUN_TEST(test_shuffle_changes_order);
     RUN_TEST(test_shuffle_maintains_card_count);
     RUN_TEST(test_shuffle_preserves_all_cards);
+    RUN_TEST(test_shuffle_seeded_is_reproducible);
 
     printf("\n================================\n");
     if (failed)
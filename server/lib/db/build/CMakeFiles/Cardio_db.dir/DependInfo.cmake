@@ -0,0 +1,25 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/server/lib/db/src/balance.c" "CMakeFiles/Cardio_db.dir/src/balance.c.o" "gcc" "CMakeFiles/Cardio_db.dir/src/balance.c.o.d"
+  "/root/repo/server/lib/db/src/friend.c" "CMakeFiles/Cardio_db.dir/src/friend.c.o" "gcc" "CMakeFiles/Cardio_db.dir/src/friend.c.o.d"
+  "/root/repo/server/lib/db/src/history.c" "CMakeFiles/Cardio_db.dir/src/history.c.o" "gcc" "CMakeFiles/Cardio_db.dir/src/history.c.o.d"
+  "/root/repo/server/lib/db/src/login.c" "CMakeFiles/Cardio_db.dir/src/login.c.o" "gcc" "CMakeFiles/Cardio_db.dir/src/login.c.o.d"
+  "/root/repo/server/lib/db/src/password_hash.c" "CMakeFiles/Cardio_db.dir/src/password_hash.c.o" "gcc" "CMakeFiles/Cardio_db.dir/src/password_hash.c.o.d"
+  "/root/repo/server/lib/db/src/signup.c" "CMakeFiles/Cardio_db.dir/src/signup.c.o" "gcc" "CMakeFiles/Cardio_db.dir/src/signup.c.o.d"
+  "/root/repo/server/lib/db/src/user.c" "CMakeFiles/Cardio_db.dir/src/user.c.o" "gcc" "CMakeFiles/Cardio_db.dir/src/user.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
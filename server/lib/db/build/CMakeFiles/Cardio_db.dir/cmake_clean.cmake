@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_db.dir/src/balance.c.o"
+  "CMakeFiles/Cardio_db.dir/src/balance.c.o.d"
+  "CMakeFiles/Cardio_db.dir/src/friend.c.o"
+  "CMakeFiles/Cardio_db.dir/src/friend.c.o.d"
+  "CMakeFiles/Cardio_db.dir/src/history.c.o"
+  "CMakeFiles/Cardio_db.dir/src/history.c.o.d"
+  "CMakeFiles/Cardio_db.dir/src/login.c.o"
+  "CMakeFiles/Cardio_db.dir/src/login.c.o.d"
+  "CMakeFiles/Cardio_db.dir/src/password_hash.c.o"
+  "CMakeFiles/Cardio_db.dir/src/password_hash.c.o.d"
+  "CMakeFiles/Cardio_db.dir/src/signup.c.o"
+  "CMakeFiles/Cardio_db.dir/src/signup.c.o.d"
+  "CMakeFiles/Cardio_db.dir/src/user.c.o"
+  "CMakeFiles/Cardio_db.dir/src/user.c.o.d"
+  "libCardio_db.a"
+  "libCardio_db.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_db.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
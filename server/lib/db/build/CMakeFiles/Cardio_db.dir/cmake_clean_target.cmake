@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libCardio_db.a"
+)
@@ -0,0 +1,25 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_db_bench.dir/src/balance.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/src/balance.c.o.d"
+  "CMakeFiles/Cardio_db_bench.dir/src/friend.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/src/friend.c.o.d"
+  "CMakeFiles/Cardio_db_bench.dir/src/history.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/src/history.c.o.d"
+  "CMakeFiles/Cardio_db_bench.dir/src/login.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/src/login.c.o.d"
+  "CMakeFiles/Cardio_db_bench.dir/src/password_hash.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/src/password_hash.c.o.d"
+  "CMakeFiles/Cardio_db_bench.dir/src/signup.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/src/signup.c.o.d"
+  "CMakeFiles/Cardio_db_bench.dir/src/user.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/src/user.c.o.d"
+  "CMakeFiles/Cardio_db_bench.dir/test/bench_friend.c.o"
+  "CMakeFiles/Cardio_db_bench.dir/test/bench_friend.c.o.d"
+  "Cardio_db_bench"
+  "Cardio_db_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_db_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,25 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_db_test.dir/src/balance.c.o"
+  "CMakeFiles/Cardio_db_test.dir/src/balance.c.o.d"
+  "CMakeFiles/Cardio_db_test.dir/src/friend.c.o"
+  "CMakeFiles/Cardio_db_test.dir/src/friend.c.o.d"
+  "CMakeFiles/Cardio_db_test.dir/src/history.c.o"
+  "CMakeFiles/Cardio_db_test.dir/src/history.c.o.d"
+  "CMakeFiles/Cardio_db_test.dir/src/login.c.o"
+  "CMakeFiles/Cardio_db_test.dir/src/login.c.o.d"
+  "CMakeFiles/Cardio_db_test.dir/src/password_hash.c.o"
+  "CMakeFiles/Cardio_db_test.dir/src/password_hash.c.o.d"
+  "CMakeFiles/Cardio_db_test.dir/src/signup.c.o"
+  "CMakeFiles/Cardio_db_test.dir/src/signup.c.o.d"
+  "CMakeFiles/Cardio_db_test.dir/src/user.c.o"
+  "CMakeFiles/Cardio_db_test.dir/src/user.c.o.d"
+  "CMakeFiles/Cardio_db_test.dir/test/unit_test.c.o"
+  "CMakeFiles/Cardio_db_test.dir/test/unit_test.c.o.d"
+  "Cardio_db_test"
+  "Cardio_db_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_db_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -38,6 +38,13 @@ typedef struct
     int size;
 } dbScoreboard;
 
+typedef struct
+{
+    int user_id;
+    int balance;
+    bool updated; // Set by dbUpdateBalances when the user's row was written
+} dbBalance;
+
 typedef struct
 {
     int user_id;
@@ -82,14 +89,19 @@ int dbCreateUser(PGconn* conn, struct dbUser* user);
 void dbDeleteUser(PGconn* conn, int user_id);
 // This function return the leaderboard or an error message if failed.
 dbScoreboard* dbGetScoreBoard(PGconn* conn);
+// This function return every user's balance (unordered), used to seed the server leaderboard.
+dbScoreboard* dbGetAllBalances(PGconn* conn);
 // This function return the friendlist of a player
 FriendList* dbGetFriendList(PGconn* conn, int user_id);
 
 // Friend management functions
 // Add a friend directly (mutual friendship)
 int dbAddFriend(PGconn* conn, int user_id, const char* friend_username);
+int dbAddFriendById(PGconn* conn, int user_id, int friend_id);
 // Send a friend invite
 int dbSendFriendInvite(PGconn* conn, int from_user_id, const char* to_username);
+// Same, for a known recipient; fills invite (if not NULL) with the stored invite on success
+int dbSendFriendInviteById(PGconn* conn, int from_user_id, int to_user_id, dbInvite* invite);
 // Accept a friend invite
 int dbAcceptFriendInvite(PGconn* conn, int user_id, int invite_id);
 // Reject a friend invite
@@ -110,6 +122,9 @@ int dbLogin(PGconn* conn, char* username, char* password);
 // Balance management functions
 // Update user balance to specific amount
 int dbUpdateBalance(PGconn* conn, int user_id, int new_balance);
+// Update many users' balances with one statement, all or none; marks each row written as updated.
+// Returns the number of users updated or DB_ERROR
+int dbUpdateBalances(PGconn* conn, dbBalance* balances, int count);
 // Add/subtract amount from user balance
 int dbAddToBalance(PGconn* conn, int user_id, int amount);
 // Get current user balance
@@ -117,6 +132,10 @@ int dbGetBalance(PGconn* conn, int user_id);
 // Transfer balance between users atomically
 int dbTransferBalance(PGconn* conn, int from_user_id, int to_user_id, int amount);
 
+// Hand history
+// Append finished hands: rows for hand_history and hand_players in COPY text format, written in one transaction
+int dbCopyHandHistory(PGconn* conn, const char* hands, size_t hands_len, const char* players, size_t players_len);
+
 // Password hashing utilities
 char* generate_salt();
 char* hash_password(const char* password, const char* salt);
@@ -39,6 +39,60 @@ int dbUpdateBalance(PGconn* conn, int user_id, int new_balance)
     return DB_OK;
 }
 
+/**
+ * Update several user balances in one statement (one round trip, one transaction)
+ * @param conn Database connection
+ * @param balances User IDs and their new balances; updated is set for each user whose row was written
+ * @param count Number of entries in balances
+ * @return Number of users updated on success, DB_ERROR on failure (nothing is updated)
+ */
+int dbUpdateBalances(PGconn* conn, dbBalance* balances, int count)
+{
+    if (!conn || !balances || count < 0) {
+        return DB_ERROR;
+    }
+    for (int i = 0; i < count; i++) {
+        balances[i].updated = false;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Two ints of at most 11 characters each, with "(,)," around them
+    size_t size = 160 + (size_t) count * 28;
+    char* query = malloc(size);
+    if (!query) {
+        return DB_ERROR;
+    }
+    size_t len = (size_t) snprintf(query, size, "UPDATE \"User\" AS u SET balance = v.balance FROM (VALUES ");
+    for (int i = 0; i < count; i++) {
+        len += (size_t) snprintf(query + len, size - len, "%s(%d,%d)", i ? "," : "",
+                                 balances[i].user_id, balances[i].balance);
+    }
+    snprintf(query + len, size - len, ") AS v(user_id, balance) WHERE u.user_id = v.user_id RETURNING u.user_id");
+
+    PGresult* res = PQexec(conn, query);
+    free(query);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        fprintf(stderr, "Update balances failed: %s", PQerrorMessage(conn));
+        PQclear(res);
+        return DB_ERROR;
+    }
+
+    // A user missing from "User" is not returned; the others were written
+    int rows_updated = PQntuples(res);
+    for (int r = 0; r < rows_updated; r++) {
+        int user_id = atoi(PQgetvalue(res, r, 0));
+        for (int i = 0; i < count; i++) {
+            if (balances[i].user_id == user_id) {
+                balances[i].updated = true;
+            }
+        }
+    }
+    PQclear(res);
+    return rows_updated;
+}
+
 /**
  * Add amount to user balance in database
  * @param conn Database connection
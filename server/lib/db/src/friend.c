@@ -33,255 +33,158 @@ int dbGetUserIdByUsername(PGconn* conn, const char* username)
     return user_id;
 }
 
-// Add a friend directly (creates mutual friendship)
-int dbAddFriend(PGconn* conn, int user_id, const char* friend_username)
+// Friend mutations are single statements: the lookups, the checks and the write run server-side in one
+// round-trip, and the primary/unique keys of friend and friend_invites settle concurrent requests.
+// Each statement returns a status column first: 0 on success, otherwise the function's error code.
+
+// The user a statement acts on, selected by name or by id as parameter $2
+#define FRIEND_TARGET_BY_NAME "target AS (SELECT user_id FROM \"User\" WHERE username = $2)"
+#define FRIEND_TARGET_BY_ID "target AS (SELECT user_id FROM \"User\" WHERE user_id = $2::int)"
+
+// Both directions of a friendship, inserted in key order so crossed requests cannot deadlock
+#define FRIEND_PAIR_INSERT(source, other_id, self_id)                                                            \
+    "INSERT INTO friend (u1, u2) "                                                                                 \
+    "SELECT pair.u1, pair.u2 FROM " source " "                                                                     \
+    "CROSS JOIN LATERAL (VALUES (" self_id ", " other_id "), (" other_id ", " self_id ")) AS pair(u1, u2) "        \
+    "WHERE " other_id " <> " self_id " "                                                                           \
+    "ORDER BY 1, 2 ON CONFLICT DO NOTHING "
+
+#define ADD_FRIEND_QUERY(target)                                                                                   \
+    "WITH " target ", "                                                                                            \
+    "added AS (" FRIEND_PAIR_INSERT("target t", "t.user_id", "$1::int") "RETURNING u1) "                           \
+    "SELECT CASE "                                                                                                 \
+    "WHEN NOT EXISTS (SELECT 1 FROM target) THEN -1 "                                                              \
+    "WHEN (SELECT user_id FROM target) = $1::int THEN -2 "                                                         \
+    "WHEN NOT EXISTS (SELECT 1 FROM added) THEN -3 "                                                               \
+    "ELSE 0 END"
+
+// A rejected invite is re-opened in place; a pending or accepted one is left alone
+#define SEND_INVITE_QUERY(target)                                                                                  \
+    "WITH " target ", "                                                                                            \
+    "befriended AS (SELECT 1 FROM friend f, target t "                                                             \
+    "WHERE (f.u1 = $1::int AND f.u2 = t.user_id) OR (f.u1 = t.user_id AND f.u2 = $1::int)), "                      \
+    "sent AS (INSERT INTO friend_invites (from_user_id, to_user_id, status) "                                      \
+    "SELECT $1::int, t.user_id, 'pending' FROM target t "                                                          \
+    "WHERE t.user_id <> $1::int AND NOT EXISTS (SELECT 1 FROM befriended) "                                        \
+    "ON CONFLICT (from_user_id, to_user_id) DO UPDATE "                                                            \
+    "SET status = 'pending', created_at = CURRENT_TIMESTAMP WHERE friend_invites.status = 'rejected' "             \
+    "RETURNING invite_id, created_at) "                                                                            \
+    "SELECT CASE "                                                                                                 \
+    "WHEN NOT EXISTS (SELECT 1 FROM target) THEN -1 "                                                              \
+    "WHEN (SELECT user_id FROM target) = $1::int THEN -2 "                                                         \
+    "WHEN EXISTS (SELECT 1 FROM befriended) THEN -3 "                                                              \
+    "WHEN EXISTS (SELECT 1 FROM sent) THEN 0 "                                                                     \
+    "WHEN EXISTS (SELECT 1 FROM friend_invites fi, target t WHERE fi.from_user_id = $1::int "                      \
+    "AND fi.to_user_id = t.user_id AND fi.status = 'accepted') THEN -3 "                                           \
+    "ELSE -4 END, "                                                                                                \
+    "(SELECT user_id FROM target), (SELECT invite_id FROM sent), (SELECT created_at FROM sent)"
+
+// Run a friend statement and decode its status column
+static int exec_friend_statement(PGconn* conn, const char* func, const char* query, int num_params,
+                                 const char* const* params, PGresult** out)
 {
-    // First, get the friend's user_id
-    int friend_id = dbGetUserIdByUsername(conn, friend_username);
-    if (friend_id < 0)
+    PGresult* res = PQexecParams(conn, query, num_params, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
     {
-        return -1; // User not found
+        fprintf(stderr, "%s failed: %s\n", func, PQerrorMessage(conn));
+        PQclear(res);
+        return DB_ERROR;
     }
 
-    if (friend_id == user_id)
+    int status = atoi(PQgetvalue(res, 0, 0));
+    if (out != NULL)
     {
-        return -2; // Cannot add yourself as friend
+        *out = res;
     }
+    else
+    {
+        PQclear(res);
+    }
+    return status == 0 ? DB_OK : status;
+}
 
-    // Check if friendship already exists
-    const char* check_query = "SELECT 1 FROM friend WHERE (u1 = $1 AND u2 = $2) OR (u1 = $2 AND u2 = $1) LIMIT 1";
+// Add a friend directly (creates mutual friendship)
+int dbAddFriend(PGconn* conn, int user_id, const char* friend_username)
+{
+    char user_id_str[16];
+    snprintf(user_id_str, sizeof(user_id_str), "%d", user_id);
+
+    const char* params[] = {user_id_str, friend_username};
+    return exec_friend_statement(conn, __func__, ADD_FRIEND_QUERY(FRIEND_TARGET_BY_NAME), 2, params, NULL);
+}
+
+// Add a friend whose user_id is already known
+int dbAddFriendById(PGconn* conn, int user_id, int friend_id)
+{
     char user_id_str[16];
     char friend_id_str[16];
     snprintf(user_id_str, sizeof(user_id_str), "%d", user_id);
     snprintf(friend_id_str, sizeof(friend_id_str), "%d", friend_id);
-    
-    const char* check_params[] = {user_id_str, friend_id_str};
-    PGresult* check_res = PQexecParams(conn, check_query, 2, NULL, check_params, NULL, NULL, 0);
 
-    if (PQresultStatus(check_res) != PGRES_TUPLES_OK)
-    {
-        fprintf(stderr, "dbAddFriend check failed: %s\n", PQerrorMessage(conn));
-        PQclear(check_res);
-        return DB_ERROR;
-    }
+    const char* params[] = {user_id_str, friend_id_str};
+    return exec_friend_statement(conn, __func__, ADD_FRIEND_QUERY(FRIEND_TARGET_BY_ID), 2, params, NULL);
+}
 
-    if (PQntuples(check_res) > 0)
+static int send_invite(PGconn* conn, const char* query, int from_user_id, const char* target, dbInvite* invite)
+{
+    char from_id_str[16];
+    snprintf(from_id_str, sizeof(from_id_str), "%d", from_user_id);
+
+    const char* params[] = {from_id_str, target};
+    PGresult* res = NULL;
+    int status = exec_friend_statement(conn, "dbSendFriendInvite", query, 2, params, &res);
+    if (res == NULL)
     {
-        // Friendship already exists
-        PQclear(check_res);
-        return -3;
+        return status;
     }
-    PQclear(check_res);
 
-    // Insert friendship (bidirectional)
-    const char* insert_query = "INSERT INTO friend (u1, u2) VALUES ($1, $2), ($2, $1)";
-    const char* insert_params[] = {user_id_str, friend_id_str};
-    
-    PGresult* res = PQexecParams(conn, insert_query, 2, NULL, insert_params, NULL, NULL, 0);
-
-    if (PQresultStatus(res) != PGRES_COMMAND_OK)
+    if (status == DB_OK && invite != NULL)
     {
-        fprintf(stderr, "dbAddFriend insert failed: %s\n", PQerrorMessage(conn));
-        PQclear(res);
-        return DB_ERROR;
+        memset(invite, 0, sizeof(dbInvite));
+        invite->from_user_id = from_user_id;
+        invite->to_user_id = atoi(PQgetvalue(res, 0, 1));
+        invite->invite_id = atoi(PQgetvalue(res, 0, 2));
+        strncpy(invite->status, "pending", sizeof(invite->status) - 1);
+        strncpy(invite->created_at, PQgetvalue(res, 0, 3), sizeof(invite->created_at) - 1);
     }
-
     PQclear(res);
-    return DB_OK;
+    return status;
 }
 
 // Send a friend invite
 int dbSendFriendInvite(PGconn* conn, int from_user_id, const char* to_username)
 {
-    // First, get the recipient's user_id
-    int to_user_id = dbGetUserIdByUsername(conn, to_username);
-    if (to_user_id < 0)
-    {
-        return -1; // User not found
-    }
-
-    if (to_user_id == from_user_id)
-    {
-        return -2; // Cannot invite yourself
-    }
+    return send_invite(conn, SEND_INVITE_QUERY(FRIEND_TARGET_BY_NAME), from_user_id, to_username, NULL);
+}
 
-    // Check if they're already friends
-    char from_id_str[16];
+// Send a friend invite to a known user_id. On success the stored invite is copied into invite (if given),
+// without from_username, which the caller already knows.
+int dbSendFriendInviteById(PGconn* conn, int from_user_id, int to_user_id, dbInvite* invite)
+{
     char to_id_str[16];
-    snprintf(from_id_str, sizeof(from_id_str), "%d", from_user_id);
     snprintf(to_id_str, sizeof(to_id_str), "%d", to_user_id);
-
-    const char* friend_check = "SELECT 1 FROM friend WHERE (u1 = $1 AND u2 = $2) OR (u1 = $2 AND u2 = $1) LIMIT 1";
-    const char* friend_params[] = {from_id_str, to_id_str};
-    PGresult* friend_res = PQexecParams(conn, friend_check, 2, NULL, friend_params, NULL, NULL, 0);
-
-    if (PQresultStatus(friend_res) != PGRES_TUPLES_OK)
-    {
-        fprintf(stderr, "dbSendFriendInvite friend check failed: %s\n", PQerrorMessage(conn));
-        PQclear(friend_res);
-        return DB_ERROR;
-    }
-
-    if (PQntuples(friend_res) > 0)
-    {
-        // Already friends
-        PQclear(friend_res);
-        return -3;
-    }
-    PQclear(friend_res);
-
-    // Check if invite already exists (any status)
-    const char* invite_check = "SELECT status FROM friend_invites WHERE from_user_id = $1 AND to_user_id = $2 LIMIT 1";
-    PGresult* invite_res = PQexecParams(conn, invite_check, 2, NULL, friend_params, NULL, NULL, 0);
-
-    if (PQresultStatus(invite_res) != PGRES_TUPLES_OK)
-    {
-        fprintf(stderr, "dbSendFriendInvite invite check failed: %s\n", PQerrorMessage(conn));
-        PQclear(invite_res);
-        return DB_ERROR;
-    }
-
-    if (PQntuples(invite_res) > 0)
-    {
-        const char* status = PQgetvalue(invite_res, 0, 0);
-        
-        if (strcmp(status, "pending") == 0)
-        {
-            // Invite already sent and pending
-            PQclear(invite_res);
-            return -4;
-        }
-        else if (strcmp(status, "rejected") == 0)
-        {
-            // Previous invite was rejected, update it to pending with new timestamp
-            PQclear(invite_res);
-            
-            const char* update_query = "UPDATE friend_invites SET status = 'pending', created_at = CURRENT_TIMESTAMP WHERE from_user_id = $1 AND to_user_id = $2";
-            PGresult* update_res = PQexecParams(conn, update_query, 2, NULL, friend_params, NULL, NULL, 0);
-            
-            if (PQresultStatus(update_res) != PGRES_COMMAND_OK)
-            {
-                fprintf(stderr, "dbSendFriendInvite update failed: %s\n", PQerrorMessage(conn));
-                PQclear(update_res);
-                return DB_ERROR;
-            }
-            
-            PQclear(update_res);
-            return DB_OK;
-        }
-        // If status is "accepted", this should have been caught by the friend check above
-        PQclear(invite_res);
-        return -3; // Already friends (shouldn't happen)
-    }
-    PQclear(invite_res);
-
-    // Create new invite
-    const char* insert_query = "INSERT INTO friend_invites (from_user_id, to_user_id, status) VALUES ($1, $2, 'pending')";
-    PGresult* res = PQexecParams(conn, insert_query, 2, NULL, friend_params, NULL, NULL, 0);
-
-    if (PQresultStatus(res) != PGRES_COMMAND_OK)
-    {
-        fprintf(stderr, "dbSendFriendInvite insert failed: %s\n", PQerrorMessage(conn));
-        PQclear(res);
-        return DB_ERROR;
-    }
-
-    PQclear(res);
-    return DB_OK;
+    return send_invite(conn, SEND_INVITE_QUERY(FRIEND_TARGET_BY_ID), from_user_id, to_id_str, invite);
 }
 
-// Accept a friend invite
+// Accept a friend invite. Only one of several concurrent accepts finds the invite still pending.
 int dbAcceptFriendInvite(PGconn* conn, int user_id, int invite_id)
 {
-    // Begin transaction
-    PGresult* begin_res = PQexec(conn, "BEGIN");
-    if (PQresultStatus(begin_res) != PGRES_COMMAND_OK)
-    {
-        fprintf(stderr, "BEGIN failed: %s\n", PQerrorMessage(conn));
-        PQclear(begin_res);
-        return DB_ERROR;
-    }
-    PQclear(begin_res);
-
-    // Get invite details and verify it's for this user
     char invite_id_str[16];
     char user_id_str[16];
     snprintf(invite_id_str, sizeof(invite_id_str), "%d", invite_id);
     snprintf(user_id_str, sizeof(user_id_str), "%d", user_id);
 
-    const char* get_query = "SELECT from_user_id, to_user_id, status FROM friend_invites WHERE invite_id = $1 AND to_user_id = $2";
-    const char* get_params[] = {invite_id_str, user_id_str};
-    PGresult* get_res = PQexecParams(conn, get_query, 2, NULL, get_params, NULL, NULL, 0);
-
-    if (PQresultStatus(get_res) != PGRES_TUPLES_OK)
-    {
-        fprintf(stderr, "dbAcceptFriendInvite get failed: %s\n", PQerrorMessage(conn));
-        PQclear(get_res);
-        PQexec(conn, "ROLLBACK");
-        return DB_ERROR;
-    }
-
-    if (PQntuples(get_res) == 0)
-    {
-        // Invite not found or not for this user
-        PQclear(get_res);
-        PQexec(conn, "ROLLBACK");
-        return -1;
-    }
-
-    const char* status = PQgetvalue(get_res, 0, 2);
-    if (strcmp(status, "pending") != 0)
-    {
-        // Invite already processed
-        PQclear(get_res);
-        PQexec(conn, "ROLLBACK");
-        return -2;
-    }
-
-    int from_user_id = atoi(PQgetvalue(get_res, 0, 0));
-    char from_user_id_str[16];
-    snprintf(from_user_id_str, sizeof(from_user_id_str), "%d", from_user_id);
-    PQclear(get_res);
-
-    // Update invite status
-    const char* update_query = "UPDATE friend_invites SET status = 'accepted' WHERE invite_id = $1";
-    const char* update_params[] = {invite_id_str};
-    PGresult* update_res = PQexecParams(conn, update_query, 1, NULL, update_params, NULL, NULL, 0);
-
-    if (PQresultStatus(update_res) != PGRES_COMMAND_OK)
-    {
-        fprintf(stderr, "dbAcceptFriendInvite update failed: %s\n", PQerrorMessage(conn));
-        PQclear(update_res);
-        PQexec(conn, "ROLLBACK");
-        return DB_ERROR;
-    }
-    PQclear(update_res);
-
-    // Add friendship (bidirectional)
-    const char* insert_query = "INSERT INTO friend (u1, u2) VALUES ($1, $2), ($2, $1)";
-    const char* insert_params[] = {user_id_str, from_user_id_str};
-    PGresult* insert_res = PQexecParams(conn, insert_query, 2, NULL, insert_params, NULL, NULL, 0);
-
-    if (PQresultStatus(insert_res) != PGRES_COMMAND_OK)
-    {
-        fprintf(stderr, "dbAcceptFriendInvite insert failed: %s\n", PQerrorMessage(conn));
-        PQclear(insert_res);
-        PQexec(conn, "ROLLBACK");
-        return DB_ERROR;
-    }
-    PQclear(insert_res);
-
-    // Commit transaction
-    PGresult* commit_res = PQexec(conn, "COMMIT");
-    if (PQresultStatus(commit_res) != PGRES_COMMAND_OK)
-    {
-        fprintf(stderr, "COMMIT failed: %s\n", PQerrorMessage(conn));
-        PQclear(commit_res);
-        return DB_ERROR;
-    }
-    PQclear(commit_res);
-
-    return DB_OK;
+    const char* query =
+        "WITH invite AS (SELECT 1 FROM friend_invites WHERE invite_id = $1::int AND to_user_id = $2::int), "
+        "accepted AS (UPDATE friend_invites SET status = 'accepted' "
+        "WHERE invite_id = $1::int AND to_user_id = $2::int AND status = 'pending' RETURNING from_user_id), "
+        "added AS (" FRIEND_PAIR_INSERT("accepted a", "a.from_user_id", "$2::int") ") "
+        "SELECT CASE "
+        "WHEN EXISTS (SELECT 1 FROM accepted) THEN 0 "
+        "WHEN NOT EXISTS (SELECT 1 FROM invite) THEN -1 "
+        "ELSE -2 END";
+    const char* params[] = {invite_id_str, user_id_str};
+    return exec_friend_statement(conn, __func__, query, 2, params, NULL);
 }
 
 // Reject a friend invite
@@ -292,48 +195,16 @@ int dbRejectFriendInvite(PGconn* conn, int user_id, int invite_id)
     snprintf(invite_id_str, sizeof(invite_id_str), "%d", invite_id);
     snprintf(user_id_str, sizeof(user_id_str), "%d", user_id);
 
-    // Verify invite exists and is for this user
-    const char* check_query = "SELECT status FROM friend_invites WHERE invite_id = $1 AND to_user_id = $2";
-    const char* check_params[] = {invite_id_str, user_id_str};
-    PGresult* check_res = PQexecParams(conn, check_query, 2, NULL, check_params, NULL, NULL, 0);
-
-    if (PQresultStatus(check_res) != PGRES_TUPLES_OK)
-    {
-        fprintf(stderr, "dbRejectFriendInvite check failed: %s\n", PQerrorMessage(conn));
-        PQclear(check_res);
-        return DB_ERROR;
-    }
-
-    if (PQntuples(check_res) == 0)
-    {
-        // Invite not found or not for this user
-        PQclear(check_res);
-        return -1;
-    }
-
-    const char* status = PQgetvalue(check_res, 0, 0);
-    if (strcmp(status, "pending") != 0)
-    {
-        // Invite already processed
-        PQclear(check_res);
-        return -2;
-    }
-    PQclear(check_res);
-
-    // Update invite status
-    const char* update_query = "UPDATE friend_invites SET status = 'rejected' WHERE invite_id = $1";
-    const char* update_params[] = {invite_id_str};
-    PGresult* res = PQexecParams(conn, update_query, 1, NULL, update_params, NULL, NULL, 0);
-
-    if (PQresultStatus(res) != PGRES_COMMAND_OK)
-    {
-        fprintf(stderr, "dbRejectFriendInvite update failed: %s\n", PQerrorMessage(conn));
-        PQclear(res);
-        return DB_ERROR;
-    }
-
-    PQclear(res);
-    return DB_OK;
+    const char* query =
+        "WITH invite AS (SELECT 1 FROM friend_invites WHERE invite_id = $1::int AND to_user_id = $2::int), "
+        "rejected AS (UPDATE friend_invites SET status = 'rejected' "
+        "WHERE invite_id = $1::int AND to_user_id = $2::int AND status = 'pending' RETURNING 1) "
+        "SELECT CASE "
+        "WHEN EXISTS (SELECT 1 FROM rejected) THEN 0 "
+        "WHEN NOT EXISTS (SELECT 1 FROM invite) THEN -1 "
+        "ELSE -2 END";
+    const char* params[] = {invite_id_str, user_id_str};
+    return exec_friend_statement(conn, __func__, query, 2, params, NULL);
 }
 
 // Get pending invites for a user
@@ -0,0 +1,73 @@
+#include "../include/db.h"
+
+#define COPY_CHUNK (1 << 20)
+
+// Stream len bytes of COPY text into the table named by copy_sql
+static int copy_in(PGconn* conn, const char* copy_sql, const char* data, size_t len)
+{
+    PGresult* res = PQexec(conn, copy_sql);
+    if (PQresultStatus(res) != PGRES_COPY_IN) {
+        fprintf(stderr, "Start copy failed: %s", PQerrorMessage(conn));
+        PQclear(res);
+        return DB_ERROR;
+    }
+    PQclear(res);
+
+    bool sent = true;
+    for (size_t offset = 0; offset < len && sent; offset += COPY_CHUNK) {
+        size_t chunk = len - offset < COPY_CHUNK ? len - offset : COPY_CHUNK;
+        sent = PQputCopyData(conn, data + offset, (int) chunk) == 1;
+    }
+    if (PQputCopyEnd(conn, sent ? NULL : "client failed to send rows") != 1) {
+        fprintf(stderr, "End copy failed: %s", PQerrorMessage(conn));
+        return DB_ERROR;
+    }
+
+    int result = DB_OK;
+    while ((res = PQgetResult(conn)) != NULL) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            fprintf(stderr, "Copy failed: %s", PQerrorMessage(conn));
+            result = DB_ERROR;
+        }
+        PQclear(res);
+    }
+    return sent ? result : DB_ERROR;
+}
+
+static int exec_command(PGconn* conn, const char* sql)
+{
+    PGresult* res = PQexec(conn, sql);
+    int result = PQresultStatus(res) == PGRES_COMMAND_OK ? DB_OK : DB_ERROR;
+    if (result != DB_OK) {
+        fprintf(stderr, "%s failed: %s", sql, PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return result;
+}
+
+/**
+ * Append a batch of finished hands with COPY, in one transaction
+ * @param conn Database connection
+ * @param hands Rows for hand_history in COPY text format
+ * @param players Rows for hand_players in COPY text format
+ * @return DB_OK on success, DB_ERROR on failure (nothing is written)
+ */
+int dbCopyHandHistory(PGconn* conn, const char* hands, size_t hands_len, const char* players, size_t players_len)
+{
+    if (!conn || PQstatus(conn) != CONNECTION_OK) {
+        return DB_ERROR;
+    }
+
+    if (exec_command(conn, "BEGIN") != DB_OK) {
+        return DB_ERROR;
+    }
+    if (copy_in(conn, "COPY hand_history (hand_key, table_id, hand_no, ended_at, board, pot, actions) FROM STDIN",
+                hands, hands_len) != DB_OK ||
+        copy_in(conn, "COPY hand_players (hand_key, seat, user_id, is_bot, hole_cards, start_stack, bet, won) FROM STDIN",
+                players, players_len) != DB_OK ||
+        exec_command(conn, "COMMIT") != DB_OK) {
+        exec_command(conn, "ROLLBACK");
+        return DB_ERROR;
+    }
+    return DB_OK;
+}
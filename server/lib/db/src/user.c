@@ -117,6 +117,32 @@ dbScoreboard* dbGetScoreBoard(PGconn* conn)
     return leaderboard;
 }
 
+// no need input
+// output is every user's balance, unordered, for seeding the in-memory leaderboard
+dbScoreboard* dbGetAllBalances(PGconn* conn)
+{
+    PGresult* res = PQexec(conn, "SELECT user_id, balance FROM \"User\"");
+    if (PQresultStatus(res) != PGRES_TUPLES_OK)
+    {
+        fprintf(stderr, "\nFailed to get balances: %s\n", PQerrorMessage(conn));
+        PQclear(res);
+        return NULL;
+    }
+
+    int numRow = PQntuples(res);
+    dbScoreboard* balances = malloc(sizeof(dbScoreboard));
+    balances->players = malloc((numRow > 0 ? numRow : 1) * sizeof(dbRanking));
+    balances->size = numRow;
+    for (int i = 0; i < numRow; i++)
+    {
+        balances->players[i].user_id = atoi(PQgetvalue(res, i, 0));
+        balances->players[i].balance = atoi(PQgetvalue(res, i, 1));
+    }
+
+    PQclear(res);
+    return balances;
+}
+
 FriendList* dbGetFriendList(PGconn* conn, int user_id)
 {
     char query[256];
@@ -0,0 +1,424 @@
+/*
+ * Friend Mutation Benchmark
+ *
+ * Compares the single-statement friend mutations in friend.c with the
+ * multi-query flows they replaced (kept below as legacy_*): operations per
+ * second for invite + accept cycles, and the outcome of many connections
+ * sending the same invite at once.
+ *
+ * Usage: Cardio_db_bench [cycles] [racers]
+ *
+ * Note: This benchmark requires a running PostgreSQL database. It creates
+ * two users (bench_friend_a, bench_friend_b) and removes them afterwards.
+ */
+
+#include "db.h"
+#include <pthread.h>
+#include <time.h>
+
+#define DEFAULT_CYCLES 500
+#define DEFAULT_RACERS 8
+#define MAX_RACERS 64
+
+// ===== Legacy flows (one round-trip per check) =====
+
+static int legacy_send_invite(PGconn* conn, int from_user_id, const char* to_username)
+{
+    // First, get the recipient's user_id
+    int to_user_id = dbGetUserIdByUsername(conn, to_username);
+    if (to_user_id < 0)
+    {
+        return -1; // User not found
+    }
+
+    if (to_user_id == from_user_id)
+    {
+        return -2; // Cannot invite yourself
+    }
+
+    // Check if they're already friends
+    char from_id_str[16];
+    char to_id_str[16];
+    snprintf(from_id_str, sizeof(from_id_str), "%d", from_user_id);
+    snprintf(to_id_str, sizeof(to_id_str), "%d", to_user_id);
+
+    const char* friend_check = "SELECT 1 FROM friend WHERE (u1 = $1 AND u2 = $2) OR (u1 = $2 AND u2 = $1) LIMIT 1";
+    const char* friend_params[] = {from_id_str, to_id_str};
+    PGresult* friend_res = PQexecParams(conn, friend_check, 2, NULL, friend_params, NULL, NULL, 0);
+
+    if (PQresultStatus(friend_res) != PGRES_TUPLES_OK)
+    {
+        fprintf(stderr, "legacy_send_invite friend check failed: %s\n", PQerrorMessage(conn));
+        PQclear(friend_res);
+        return DB_ERROR;
+    }
+
+    if (PQntuples(friend_res) > 0)
+    {
+        // Already friends
+        PQclear(friend_res);
+        return -3;
+    }
+    PQclear(friend_res);
+
+    // Check if invite already exists (any status)
+    const char* invite_check = "SELECT status FROM friend_invites WHERE from_user_id = $1 AND to_user_id = $2 LIMIT 1";
+    PGresult* invite_res = PQexecParams(conn, invite_check, 2, NULL, friend_params, NULL, NULL, 0);
+
+    if (PQresultStatus(invite_res) != PGRES_TUPLES_OK)
+    {
+        fprintf(stderr, "legacy_send_invite invite check failed: %s\n", PQerrorMessage(conn));
+        PQclear(invite_res);
+        return DB_ERROR;
+    }
+
+    if (PQntuples(invite_res) > 0)
+    {
+        const char* status = PQgetvalue(invite_res, 0, 0);
+        
+        if (strcmp(status, "pending") == 0)
+        {
+            // Invite already sent and pending
+            PQclear(invite_res);
+            return -4;
+        }
+        else if (strcmp(status, "rejected") == 0)
+        {
+            // Previous invite was rejected, update it to pending with new timestamp
+            PQclear(invite_res);
+            
+            const char* update_query = "UPDATE friend_invites SET status = 'pending', created_at = CURRENT_TIMESTAMP WHERE from_user_id = $1 AND to_user_id = $2";
+            PGresult* update_res = PQexecParams(conn, update_query, 2, NULL, friend_params, NULL, NULL, 0);
+            
+            if (PQresultStatus(update_res) != PGRES_COMMAND_OK)
+            {
+                fprintf(stderr, "legacy_send_invite update failed: %s\n", PQerrorMessage(conn));
+                PQclear(update_res);
+                return DB_ERROR;
+            }
+            
+            PQclear(update_res);
+            return DB_OK;
+        }
+        // If status is "accepted", this should have been caught by the friend check above
+        PQclear(invite_res);
+        return -3; // Already friends (shouldn't happen)
+    }
+    PQclear(invite_res);
+
+    // Create new invite
+    const char* insert_query = "INSERT INTO friend_invites (from_user_id, to_user_id, status) VALUES ($1, $2, 'pending')";
+    PGresult* res = PQexecParams(conn, insert_query, 2, NULL, friend_params, NULL, NULL, 0);
+
+    if (PQresultStatus(res) != PGRES_COMMAND_OK)
+    {
+        fprintf(stderr, "legacy_send_invite insert failed: %s\n", PQerrorMessage(conn));
+        PQclear(res);
+        return DB_ERROR;
+    }
+
+    PQclear(res);
+    return DB_OK;
+}
+
+static int legacy_accept_invite(PGconn* conn, int user_id, int invite_id)
+{
+    // Begin transaction
+    PGresult* begin_res = PQexec(conn, "BEGIN");
+    if (PQresultStatus(begin_res) != PGRES_COMMAND_OK)
+    {
+        fprintf(stderr, "BEGIN failed: %s\n", PQerrorMessage(conn));
+        PQclear(begin_res);
+        return DB_ERROR;
+    }
+    PQclear(begin_res);
+
+    // Get invite details and verify it's for this user
+    char invite_id_str[16];
+    char user_id_str[16];
+    snprintf(invite_id_str, sizeof(invite_id_str), "%d", invite_id);
+    snprintf(user_id_str, sizeof(user_id_str), "%d", user_id);
+
+    const char* get_query = "SELECT from_user_id, to_user_id, status FROM friend_invites WHERE invite_id = $1 AND to_user_id = $2";
+    const char* get_params[] = {invite_id_str, user_id_str};
+    PGresult* get_res = PQexecParams(conn, get_query, 2, NULL, get_params, NULL, NULL, 0);
+
+    if (PQresultStatus(get_res) != PGRES_TUPLES_OK)
+    {
+        fprintf(stderr, "legacy_accept_invite get failed: %s\n", PQerrorMessage(conn));
+        PQclear(get_res);
+        PQexec(conn, "ROLLBACK");
+        return DB_ERROR;
+    }
+
+    if (PQntuples(get_res) == 0)
+    {
+        // Invite not found or not for this user
+        PQclear(get_res);
+        PQexec(conn, "ROLLBACK");
+        return -1;
+    }
+
+    const char* status = PQgetvalue(get_res, 0, 2);
+    if (strcmp(status, "pending") != 0)
+    {
+        // Invite already processed
+        PQclear(get_res);
+        PQexec(conn, "ROLLBACK");
+        return -2;
+    }
+
+    int from_user_id = atoi(PQgetvalue(get_res, 0, 0));
+    char from_user_id_str[16];
+    snprintf(from_user_id_str, sizeof(from_user_id_str), "%d", from_user_id);
+    PQclear(get_res);
+
+    // Update invite status
+    const char* update_query = "UPDATE friend_invites SET status = 'accepted' WHERE invite_id = $1";
+    const char* update_params[] = {invite_id_str};
+    PGresult* update_res = PQexecParams(conn, update_query, 1, NULL, update_params, NULL, NULL, 0);
+
+    if (PQresultStatus(update_res) != PGRES_COMMAND_OK)
+    {
+        fprintf(stderr, "legacy_accept_invite update failed: %s\n", PQerrorMessage(conn));
+        PQclear(update_res);
+        PQexec(conn, "ROLLBACK");
+        return DB_ERROR;
+    }
+    PQclear(update_res);
+
+    // Add friendship (bidirectional)
+    const char* insert_query = "INSERT INTO friend (u1, u2) VALUES ($1, $2), ($2, $1)";
+    const char* insert_params[] = {user_id_str, from_user_id_str};
+    PGresult* insert_res = PQexecParams(conn, insert_query, 2, NULL, insert_params, NULL, NULL, 0);
+
+    if (PQresultStatus(insert_res) != PGRES_COMMAND_OK)
+    {
+        fprintf(stderr, "legacy_accept_invite insert failed: %s\n", PQerrorMessage(conn));
+        PQclear(insert_res);
+        PQexec(conn, "ROLLBACK");
+        return DB_ERROR;
+    }
+    PQclear(insert_res);
+
+    // Commit transaction
+    PGresult* commit_res = PQexec(conn, "COMMIT");
+    if (PQresultStatus(commit_res) != PGRES_COMMAND_OK)
+    {
+        fprintf(stderr, "COMMIT failed: %s\n", PQerrorMessage(conn));
+        PQclear(commit_res);
+        return DB_ERROR;
+    }
+    PQclear(commit_res);
+
+    return DB_OK;
+}
+
+// ===== Benchmark =====
+
+typedef int (*SendFn)(PGconn* conn, int from_user_id, const char* to_username);
+typedef int (*AcceptFn)(PGconn* conn, int user_id, int invite_id);
+
+static int user_a = -1;
+static int user_b = -1;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int exec_command(PGconn* conn, const char* query)
+{
+    PGresult* res = PQexec(conn, query);
+    int ok = PQresultStatus(res) == PGRES_COMMAND_OK || PQresultStatus(res) == PGRES_TUPLES_OK;
+    if (!ok)
+    {
+        fprintf(stderr, "Query failed: %s\n", PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return ok ? 0 : -1;
+}
+
+static void reset_pair(PGconn* conn)
+{
+    char query[256];
+    snprintf(query, sizeof(query), "DELETE FROM friend WHERE u1 IN (%d, %d) OR u2 IN (%d, %d)", user_a, user_b,
+             user_a, user_b);
+    exec_command(conn, query);
+    snprintf(query, sizeof(query), "DELETE FROM friend_invites WHERE from_user_id IN (%d, %d) OR to_user_id IN (%d, %d)",
+             user_a, user_b, user_a, user_b);
+    exec_command(conn, query);
+}
+
+static int setup_users(PGconn* conn)
+{
+    if (exec_command(conn, "INSERT INTO \"User\" (email, phone, dob, password, gender, username) VALUES "
+                           "('bench_friend_a@example.com', '0', '2000-01-01', 'x', 'Other', 'bench_friend_a'), "
+                           "('bench_friend_b@example.com', '0', '2000-01-01', 'x', 'Other', 'bench_friend_b') "
+                           "ON CONFLICT DO NOTHING") != 0)
+    {
+        return -1;
+    }
+    user_a = dbGetUserIdByUsername(conn, "bench_friend_a");
+    user_b = dbGetUserIdByUsername(conn, "bench_friend_b");
+    if (user_a < 0 || user_b < 0)
+    {
+        return -1;
+    }
+    reset_pair(conn);
+    return 0;
+}
+
+static void teardown_users(PGconn* conn)
+{
+    reset_pair(conn);
+    exec_command(conn, "DELETE FROM \"User\" WHERE username IN ('bench_friend_a', 'bench_friend_b')");
+}
+
+static int pending_invite_id(PGconn* conn)
+{
+    dbInviteList* invites = dbGetPendingInvites(conn, user_b);
+    int invite_id = -1;
+    if (invites != NULL)
+    {
+        if (invites->num > 0)
+        {
+            invite_id = invites->invites[0].invite_id;
+        }
+        free(invites->invites);
+        free(invites);
+    }
+    return invite_id;
+}
+
+// Time `cycles` rounds of A inviting B and B accepting. Resetting the pair between rounds is not timed.
+static void bench_cycles(PGconn* conn, const char* label, SendFn send, AcceptFn accept, int cycles)
+{
+    double send_time = 0.0;
+    double accept_time = 0.0;
+    int failures = 0;
+
+    for (int i = 0; i < cycles; i++)
+    {
+        reset_pair(conn);
+
+        double start = now_seconds();
+        int res = send(conn, user_a, "bench_friend_b");
+        send_time += now_seconds() - start;
+
+        int invite_id = pending_invite_id(conn);
+        start = now_seconds();
+        int accepted = invite_id < 0 ? DB_ERROR : accept(conn, user_b, invite_id);
+        accept_time += now_seconds() - start;
+
+        if (res != DB_OK || accepted != DB_OK)
+        {
+            failures++;
+        }
+    }
+
+    printf("%-18s send: %8.0f ops/s   accept: %8.0f ops/s   failures: %d/%d\n", label,
+           send_time > 0 ? cycles / send_time : 0.0, accept_time > 0 ? cycles / accept_time : 0.0, failures, cycles);
+}
+
+typedef struct
+{
+    SendFn send;
+    pthread_barrier_t* barrier;
+    int result;
+} Racer;
+
+static void* race_invite(void* arg)
+{
+    Racer* racer = arg;
+    PGconn* conn = PQconnectdb(conninfo);
+    pthread_barrier_wait(racer->barrier);
+    racer->result = PQstatus(conn) == CONNECTION_OK ? racer->send(conn, user_a, "bench_friend_b") : DB_ERROR;
+    PQfinish(conn);
+    return NULL;
+}
+
+// Every racer sends the same invite at once: exactly one should succeed and the rest see it pending
+static void bench_race(PGconn* conn, const char* label, SendFn send, int racers)
+{
+    reset_pair(conn);
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned)racers);
+    pthread_t threads[MAX_RACERS];
+    Racer state[MAX_RACERS];
+    for (int i = 0; i < racers; i++)
+    {
+        state[i].send = send;
+        state[i].barrier = &barrier;
+        state[i].result = 0;
+        pthread_create(&threads[i], NULL, race_invite, &state[i]);
+    }
+
+    int ok = 0;
+    int pending = 0;
+    int errors = 0;
+    for (int i = 0; i < racers; i++)
+    {
+        pthread_join(threads[i], NULL);
+        if (state[i].result == DB_OK)
+        {
+            ok++;
+        }
+        else if (state[i].result == -4)
+        {
+            pending++;
+        }
+        else
+        {
+            errors++;
+        }
+    }
+    pthread_barrier_destroy(&barrier);
+
+    printf("%-18s %d racers: %d sent, %d already pending, %d errors%s\n", label, racers, ok, pending, errors,
+           ok == 1 && errors == 0 ? "" : "  <- inconsistent");
+}
+
+int main(int argc, char* argv[])
+{
+    int cycles = argc > 1 ? atoi(argv[1]) : DEFAULT_CYCLES;
+    int racers = argc > 2 ? atoi(argv[2]) : DEFAULT_RACERS;
+    if (cycles <= 0)
+    {
+        cycles = DEFAULT_CYCLES;
+    }
+    if (racers < 2 || racers > MAX_RACERS)
+    {
+        racers = DEFAULT_RACERS;
+    }
+
+    PGconn* conn = PQconnectdb(conninfo);
+    if (PQstatus(conn) != CONNECTION_OK)
+    {
+        fprintf(stderr, "Connection to database failed: %s\n", PQerrorMessage(conn));
+        PQfinish(conn);
+        return 1;
+    }
+
+    if (setup_users(conn) != 0)
+    {
+        fprintf(stderr, "Failed to create benchmark users\n");
+        PQfinish(conn);
+        return 1;
+    }
+
+    printf("Invite + accept, %d cycles\n", cycles);
+    bench_cycles(conn, "legacy", legacy_send_invite, legacy_accept_invite, cycles);
+    bench_cycles(conn, "single statement", dbSendFriendInvite, dbAcceptFriendInvite, cycles);
+
+    printf("\nConcurrent identical invites\n");
+    bench_race(conn, "legacy", legacy_send_invite, racers);
+    bench_race(conn, "single statement", dbSendFriendInvite, racers);
+
+    teardown_users(conn);
+    PQfinish(conn);
+    return 0;
+}
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_jobs.dir/src/jobs.c.o"
+  "CMakeFiles/Cardio_jobs.dir/src/jobs.c.o.d"
+  "libCardio_jobs.a"
+  "libCardio_jobs.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_jobs.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
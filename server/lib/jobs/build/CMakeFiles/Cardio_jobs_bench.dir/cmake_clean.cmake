@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_jobs_bench.dir/src/jobs.c.o"
+  "CMakeFiles/Cardio_jobs_bench.dir/src/jobs.c.o.d"
+  "CMakeFiles/Cardio_jobs_bench.dir/test/bench_jobs.c.o"
+  "CMakeFiles/Cardio_jobs_bench.dir/test/bench_jobs.c.o.d"
+  "Cardio_jobs_bench"
+  "Cardio_jobs_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_jobs_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_jobs_test.dir/src/jobs.c.o"
+  "CMakeFiles/Cardio_jobs_test.dir/src/jobs.c.o.d"
+  "CMakeFiles/Cardio_jobs_test.dir/test/unit_tests.c.o"
+  "CMakeFiles/Cardio_jobs_test.dir/test/unit_tests.c.o.d"
+  "Cardio_jobs_test"
+  "Cardio_jobs_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_jobs_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
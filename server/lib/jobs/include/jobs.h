@@ -0,0 +1,60 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Work-stealing job pool for CPU-heavy side work (bot equity, password hashing, snapshot encoding).
+//
+// Every worker owns one Chase-Lev deque per priority. A job submitted from inside a job goes to the
+// worker's own deque, where it is popped LIFO while still cache-hot; idle workers steal the oldest
+// job from a random victim. Jobs submitted from other threads, such as the event loop, go to a
+// shared injection queue per priority. Workers always look for a JOB_PRIORITY_HIGH job anywhere
+// before taking a lower one, so a burst of background work never delays gameplay.
+//
+// A job may name a JobLoop: its completion callback then runs on the thread that drains that loop,
+// woken through an eventfd, instead of on the worker.
+#define JOBS_MAX_WORKERS 64
+#define JOBS_DEQUE_CAPACITY 4096 // Per worker and priority; jobs past this go to the injection queue
+
+typedef enum
+{
+    JOB_PRIORITY_HIGH = 0, // Gameplay: bot decisions, anything a player is waiting on
+    JOB_PRIORITY_NORMAL,   // Snapshots, hand-history serialization
+    JOB_PRIORITY_LOW,      // Password hashing and other work that may wait out a busy table
+    JOB_PRIORITY_COUNT
+} JobPriority;
+
+typedef void (*JobFn)(void* arg);
+
+typedef struct JobPool JobPool;
+typedef struct JobLoop JobLoop;
+
+typedef struct
+{
+    uint64_t submitted;
+    uint64_t executed;
+    uint64_t stolen;   // Taken from another worker's deque
+    uint64_t injected; // Submitted from outside the pool
+    int pending;       // Queued, not yet started
+} JobPoolStats;
+
+// Start num_workers threads. NULL on failure.
+JobPool* job_pool_create(int num_workers);
+// Run every queued job, then stop and free the pool. Completions already handed to a JobLoop stay there.
+void job_pool_destroy(JobPool* pool);
+int job_pool_workers(const JobPool* pool);
+
+// Run run(arg) on a worker. done(arg), if given, runs afterwards: on the thread that calls
+// job_loop_run(loop), or on the worker when loop is NULL. Safe from any thread, including jobs.
+// Returns 0 on success, -1 if memory ran out or the pool is stopping.
+int job_submit(JobPool* pool, JobPriority priority, JobFn run, JobFn done, void* arg, JobLoop* loop);
+
+void job_pool_stats(JobPool* pool, JobPoolStats* stats);
+// Jobs at priority queued and not yet started
+int job_pool_pending(JobPool* pool, JobPriority priority);
+
+// Completion queue for one event loop. Watch job_loop_fd() and call job_loop_run() when it is readable.
+JobLoop* job_loop_create(void);
+void job_loop_destroy(JobLoop* loop);
+int job_loop_fd(const JobLoop* loop);
+// Run every completion that has arrived. Returns how many ran.
+int job_loop_run(JobLoop* loop);
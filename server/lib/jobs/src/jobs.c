@@ -0,0 +1,538 @@
+#include "jobs.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+typedef struct Job
+{
+    JobFn run;
+    JobFn done;
+    void* arg;
+    JobLoop* loop;
+    struct Job* next; // Link in an injection queue or a loop's completion list
+} Job;
+
+// Chase-Lev deque with the C11 orderings from Lê, Pop, Cohen and Zappa Nardelli (PPoPP 2013).
+// The owner pushes and takes at bottom; thieves take from top. Fixed capacity: a full deque
+// refuses the push and the job goes to the injection queue instead.
+typedef struct
+{
+    atomic_llong top;
+    char pad[64 - sizeof(atomic_llong)]; // Thieves hammer top; keep it off the owner's line
+    atomic_llong bottom;
+    _Atomic(Job*) slots[JOBS_DEQUE_CAPACITY];
+} Deque;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    Job* head;
+    Job* tail;
+} Inbox;
+
+typedef struct
+{
+    JobPool* pool;
+    int index;
+    pthread_t thread;
+    uint64_t rng;
+    atomic_uint_fast64_t executed;
+    atomic_uint_fast64_t stolen;
+    Deque deques[JOB_PRIORITY_COUNT];
+} Worker;
+
+struct JobPool
+{
+    Worker* workers[JOBS_MAX_WORKERS];
+    int num_workers;
+    Inbox inboxes[JOB_PRIORITY_COUNT];
+    atomic_int pending[JOB_PRIORITY_COUNT];
+    atomic_int total_pending;
+    atomic_int sleepers;
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+    atomic_bool stopping;
+    atomic_uint_fast64_t submitted;
+    atomic_uint_fast64_t injected;
+};
+
+struct JobLoop
+{
+    _Atomic(Job*) completed; // Newest first
+    int event_fd;
+};
+
+static _Thread_local Worker* current_worker = NULL;
+
+// ===== Deque =====
+
+static bool deque_push(Deque* deque, Job* job)
+{
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (b - t >= JOBS_DEQUE_CAPACITY)
+    {
+        return false;
+    }
+    atomic_store_explicit(&deque->slots[b & (JOBS_DEQUE_CAPACITY - 1)], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+// Owner only: newest job first
+static Job* deque_take(Deque* deque)
+{
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b)
+    {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    Job* job = atomic_load_explicit(&deque->slots[b & (JOBS_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (t == b)
+    {
+        // Last job: race thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed))
+        {
+            job = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+// Any thread: oldest job first. NULL if empty or another thief won.
+static Job* deque_steal(Deque* deque)
+{
+    long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b)
+    {
+        return NULL;
+    }
+
+    Job* job = atomic_load_explicit(&deque->slots[t & (JOBS_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        return NULL;
+    }
+    return job;
+}
+
+// ===== Injection queues =====
+
+static void inbox_push(Inbox* inbox, Job* job)
+{
+    job->next = NULL;
+    pthread_mutex_lock(&inbox->lock);
+    if (inbox->tail != NULL)
+    {
+        inbox->tail->next = job;
+    }
+    else
+    {
+        inbox->head = job;
+    }
+    inbox->tail = job;
+    pthread_mutex_unlock(&inbox->lock);
+}
+
+static Job* inbox_pop(Inbox* inbox)
+{
+    // Unlocked peek: an empty inbox is the common case for a busy worker
+    if (__atomic_load_n(&inbox->head, __ATOMIC_RELAXED) == NULL)
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&inbox->lock);
+    Job* job = inbox->head;
+    if (job != NULL)
+    {
+        inbox->head = job->next;
+        if (inbox->head == NULL)
+        {
+            inbox->tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&inbox->lock);
+    return job;
+}
+
+// ===== Workers =====
+
+static uint64_t next_random(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static Job* steal_job(Worker* self, JobPriority priority)
+{
+    JobPool* pool = self->pool;
+    int start = (int) (next_random(&self->rng) % (uint64_t) pool->num_workers);
+    for (int i = 0; i < pool->num_workers; i++)
+    {
+        Worker* victim = pool->workers[(start + i) % pool->num_workers];
+        if (victim == self)
+        {
+            continue;
+        }
+        Job* job = deque_steal(&victim->deques[priority]);
+        if (job != NULL)
+        {
+            atomic_fetch_add_explicit(&self->stolen, 1, memory_order_relaxed);
+            return job;
+        }
+    }
+    return NULL;
+}
+
+// Highest priority first; within one, our own deque, then the injection queue, then other workers
+static Job* find_job(Worker* self)
+{
+    JobPool* pool = self->pool;
+    for (int priority = 0; priority < JOB_PRIORITY_COUNT; priority++)
+    {
+        if (atomic_load_explicit(&pool->pending[priority], memory_order_acquire) == 0)
+        {
+            continue;
+        }
+        Job* job = deque_take(&self->deques[priority]);
+        if (job == NULL)
+        {
+            job = inbox_pop(&pool->inboxes[priority]);
+        }
+        if (job == NULL)
+        {
+            job = steal_job(self, priority);
+        }
+        if (job != NULL)
+        {
+            atomic_fetch_sub_explicit(&pool->pending[priority], 1, memory_order_relaxed);
+            atomic_fetch_sub_explicit(&pool->total_pending, 1, memory_order_seq_cst);
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static void loop_push(JobLoop* loop, Job* job)
+{
+    Job* head = atomic_load_explicit(&loop->completed, memory_order_relaxed);
+    do
+    {
+        job->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&loop->completed, &head, job, memory_order_release,
+                                                    memory_order_relaxed));
+
+    uint64_t one = 1;
+    while (write(loop->event_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+    {
+    }
+}
+
+static void run_job(Worker* self, Job* job)
+{
+    job->run(job->arg);
+    atomic_fetch_add_explicit(&self->executed, 1, memory_order_relaxed);
+
+    if (job->loop != NULL && job->done != NULL)
+    {
+        loop_push(job->loop, job);
+        return;
+    }
+    if (job->done != NULL)
+    {
+        job->done(job->arg);
+    }
+    free(job);
+}
+
+static void* worker_main(void* arg)
+{
+    Worker* self = arg;
+    JobPool* pool = self->pool;
+    current_worker = self;
+
+    for (;;)
+    {
+        Job* job = find_job(self);
+        if (job != NULL)
+        {
+            run_job(self, job);
+            continue;
+        }
+
+        // Sleep until a submit sees us. sleepers goes up before pending is checked, and a submitter
+        // bumps pending before reading sleepers, so one of the two always notices the other.
+        pthread_mutex_lock(&pool->sleep_lock);
+        atomic_fetch_add_explicit(&pool->sleepers, 1, memory_order_seq_cst);
+        while (atomic_load_explicit(&pool->total_pending, memory_order_seq_cst) == 0 &&
+               !atomic_load_explicit(&pool->stopping, memory_order_relaxed))
+        {
+            pthread_cond_wait(&pool->wake, &pool->sleep_lock);
+        }
+        atomic_fetch_sub_explicit(&pool->sleepers, 1, memory_order_relaxed);
+        bool done = atomic_load_explicit(&pool->stopping, memory_order_relaxed) &&
+                    atomic_load_explicit(&pool->total_pending, memory_order_seq_cst) == 0;
+        pthread_mutex_unlock(&pool->sleep_lock);
+
+        if (done)
+        {
+            break;
+        }
+    }
+    current_worker = NULL;
+    return NULL;
+}
+
+// ===== Pool =====
+
+JobPool* job_pool_create(int num_workers)
+{
+    if (num_workers <= 0)
+    {
+        num_workers = 1;
+    }
+    if (num_workers > JOBS_MAX_WORKERS)
+    {
+        num_workers = JOBS_MAX_WORKERS;
+    }
+
+    JobPool* pool = calloc(1, sizeof(JobPool));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+    for (int i = 0; i < JOB_PRIORITY_COUNT; i++)
+    {
+        pthread_mutex_init(&pool->inboxes[i].lock, NULL);
+    }
+    pthread_mutex_init(&pool->sleep_lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    // Every worker is in place before any thread starts looking for victims
+    for (int i = 0; i < num_workers; i++)
+    {
+        Worker* worker = calloc(1, sizeof(Worker));
+        if (worker == NULL)
+        {
+            break;
+        }
+        worker->pool = pool;
+        worker->index = i;
+        worker->rng = 0x9E3779B97F4A7C15ULL * (uint64_t) (i + 1);
+        pool->workers[pool->num_workers++] = worker;
+    }
+
+    int started = 0;
+    for (; started < pool->num_workers; started++)
+    {
+        if (pthread_create(&pool->workers[started]->thread, NULL, worker_main, pool->workers[started]) != 0)
+        {
+            break;
+        }
+    }
+    if (started < pool->num_workers)
+    {
+        // Stop the ones that did start and report failure
+        atomic_store(&pool->stopping, true);
+        pthread_mutex_lock(&pool->sleep_lock);
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->sleep_lock);
+        for (int i = 0; i < started; i++)
+        {
+            pthread_join(pool->workers[i]->thread, NULL);
+        }
+        for (int i = 0; i < pool->num_workers; i++)
+        {
+            free(pool->workers[i]);
+        }
+        free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void job_pool_destroy(JobPool* pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->sleep_lock);
+    atomic_store(&pool->stopping, true);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->sleep_lock);
+
+    for (int i = 0; i < pool->num_workers; i++)
+    {
+        pthread_join(pool->workers[i]->thread, NULL);
+        free(pool->workers[i]);
+    }
+    for (int i = 0; i < JOB_PRIORITY_COUNT; i++)
+    {
+        pthread_mutex_destroy(&pool->inboxes[i].lock);
+    }
+    pthread_mutex_destroy(&pool->sleep_lock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool);
+}
+
+int job_pool_workers(const JobPool* pool)
+{
+    return pool->num_workers;
+}
+
+int job_submit(JobPool* pool, JobPriority priority, JobFn run, JobFn done, void* arg, JobLoop* loop)
+{
+    if (pool == NULL || run == NULL || priority < 0 || priority >= JOB_PRIORITY_COUNT)
+    {
+        return -1;
+    }
+
+    // Jobs may still fan out while the pool drains; nobody else may add work once it is stopping
+    Worker* self = current_worker != NULL && current_worker->pool == pool ? current_worker : NULL;
+    if (self == NULL && atomic_load_explicit(&pool->stopping, memory_order_relaxed))
+    {
+        return -1;
+    }
+
+    Job* job = malloc(sizeof(Job));
+    if (job == NULL)
+    {
+        return -1;
+    }
+    job->run = run;
+    job->done = done;
+    job->arg = arg;
+    job->loop = loop;
+    job->next = NULL;
+
+    atomic_fetch_add_explicit(&pool->pending[priority], 1, memory_order_release);
+    atomic_fetch_add_explicit(&pool->total_pending, 1, memory_order_seq_cst);
+    atomic_fetch_add_explicit(&pool->submitted, 1, memory_order_relaxed);
+
+    if (self == NULL || !deque_push(&self->deques[priority], job))
+    {
+        inbox_push(&pool->inboxes[priority], job);
+        if (self == NULL)
+        {
+            atomic_fetch_add_explicit(&pool->injected, 1, memory_order_relaxed);
+        }
+    }
+
+    if (atomic_load_explicit(&pool->sleepers, memory_order_seq_cst) > 0)
+    {
+        pthread_mutex_lock(&pool->sleep_lock);
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->sleep_lock);
+    }
+    return 0;
+}
+
+void job_pool_stats(JobPool* pool, JobPoolStats* stats)
+{
+    stats->submitted = atomic_load_explicit(&pool->submitted, memory_order_relaxed);
+    stats->injected = atomic_load_explicit(&pool->injected, memory_order_relaxed);
+    stats->executed = 0;
+    stats->stolen = 0;
+    for (int i = 0; i < pool->num_workers; i++)
+    {
+        stats->executed += atomic_load_explicit(&pool->workers[i]->executed, memory_order_relaxed);
+        stats->stolen += atomic_load_explicit(&pool->workers[i]->stolen, memory_order_relaxed);
+    }
+    stats->pending = atomic_load_explicit(&pool->total_pending, memory_order_relaxed);
+}
+
+int job_pool_pending(JobPool* pool, JobPriority priority)
+{
+    if (priority < 0 || priority >= JOB_PRIORITY_COUNT)
+    {
+        return 0;
+    }
+    return atomic_load_explicit(&pool->pending[priority], memory_order_relaxed);
+}
+
+// ===== Completion loops =====
+
+JobLoop* job_loop_create(void)
+{
+    JobLoop* loop = calloc(1, sizeof(JobLoop));
+    if (loop == NULL)
+    {
+        return NULL;
+    }
+    loop->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop->event_fd == -1)
+    {
+        free(loop);
+        return NULL;
+    }
+    atomic_init(&loop->completed, NULL);
+    return loop;
+}
+
+void job_loop_destroy(JobLoop* loop)
+{
+    if (loop == NULL)
+    {
+        return;
+    }
+    // Completions that already arrived still run, so their arguments are not leaked
+    job_loop_run(loop);
+    close(loop->event_fd);
+    free(loop);
+}
+
+int job_loop_fd(const JobLoop* loop)
+{
+    return loop->event_fd;
+}
+
+int job_loop_run(JobLoop* loop)
+{
+    uint64_t count;
+    while (read(loop->event_fd, &count, sizeof(count)) > 0)
+    {
+    }
+
+    Job* done = atomic_exchange_explicit(&loop->completed, NULL, memory_order_acquire);
+
+    // The list was built by prepending; run completions in the order jobs finished
+    Job* ordered = NULL;
+    while (done != NULL)
+    {
+        Job* next = done->next;
+        done->next = ordered;
+        ordered = done;
+        done = next;
+    }
+
+    int ran = 0;
+    while (ordered != NULL)
+    {
+        Job* next = ordered->next;
+        ordered->done(ordered->arg);
+        free(ordered);
+        ordered = next;
+        ran++;
+    }
+    return ran;
+}
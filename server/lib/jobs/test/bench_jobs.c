@@ -0,0 +1,199 @@
+// Job pool throughput and steal rates.
+//
+//   ./Cardio_jobs_bench [max_workers]
+//
+// inject:     the calling thread submits small jobs, the way the event loop hands off work
+// fork_join:  one job fans out into a binary tree; workers spread it by stealing
+// priority:   a flood of low priority jobs is queued, then high priority jobs are timed from submit
+//             to start; they should only wait for the jobs already running
+#include "jobs.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INJECT_JOBS 200000
+#define TREE_DEPTH 17
+#define FLOOD_JOBS 20000
+#define PROBE_JOBS 64
+#define WORK_ROUNDS 64 // xorshift rounds per job, roughly 100ns
+
+static atomic_long finished;
+static atomic_ulong sink;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void spin_work(int rounds)
+{
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < rounds; i++)
+    {
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+    }
+    atomic_fetch_add_explicit(&sink, x, memory_order_relaxed);
+}
+
+static void wait_for(long count)
+{
+    while (atomic_load_explicit(&finished, memory_order_acquire) < count)
+    {
+        sched_yield();
+    }
+}
+
+static void small_job(void* arg)
+{
+    (void) arg;
+    spin_work(WORK_ROUNDS);
+    atomic_fetch_add_explicit(&finished, 1, memory_order_release);
+}
+
+static void print_result(const char* name, int workers, long jobs, uint64_t elapsed_ns, JobPool* pool)
+{
+    JobPoolStats stats;
+    job_pool_stats(pool, &stats);
+    double seconds = (double) elapsed_ns / 1e9;
+    printf("%-10s workers=%-2d %10.0f jobs/s %8.1f ns/job   stolen %5.1f%%\n", name, workers, (double) jobs / seconds,
+           (double) elapsed_ns / (double) jobs, stats.executed ? 100.0 * (double) stats.stolen / stats.executed : 0.0);
+}
+
+static void bench_inject(int workers)
+{
+    JobPool* pool = job_pool_create(workers);
+    atomic_store(&finished, 0);
+    uint64_t start = now_ns();
+    for (long i = 0; i < INJECT_JOBS; i++)
+    {
+        job_submit(pool, JOB_PRIORITY_NORMAL, small_job, NULL, NULL, NULL);
+    }
+    wait_for(INJECT_JOBS);
+    print_result("inject", workers, INJECT_JOBS, now_ns() - start, pool);
+    job_pool_destroy(pool);
+}
+
+typedef struct
+{
+    JobPool* pool;
+    int depth;
+} Node;
+
+static Node nodes[1 << (TREE_DEPTH + 1)];
+
+// Node i has children 2i and 2i+1, so the tree needs no allocation while it runs
+static void tree_job(void* arg)
+{
+    Node* node = arg;
+    spin_work(WORK_ROUNDS);
+    if (node->depth > 0)
+    {
+        long index = node - nodes;
+        for (long child = 2 * index; child <= 2 * index + 1; child++)
+        {
+            nodes[child].pool = node->pool;
+            nodes[child].depth = node->depth - 1;
+            job_submit(node->pool, JOB_PRIORITY_HIGH, tree_job, NULL, &nodes[child], NULL);
+        }
+    }
+    atomic_fetch_add_explicit(&finished, 1, memory_order_release);
+}
+
+static void bench_fork_join(int workers)
+{
+    JobPool* pool = job_pool_create(workers);
+    long jobs = (1L << (TREE_DEPTH + 1)) - 1;
+    atomic_store(&finished, 0);
+    nodes[1].pool = pool;
+    nodes[1].depth = TREE_DEPTH;
+    uint64_t start = now_ns();
+    job_submit(pool, JOB_PRIORITY_HIGH, tree_job, NULL, &nodes[1], NULL);
+    wait_for(jobs);
+    print_result("fork_join", workers, jobs, now_ns() - start, pool);
+    job_pool_destroy(pool);
+}
+
+typedef struct
+{
+    uint64_t submitted_ns;
+    uint64_t started_ns;
+} Probe;
+
+static void flood_job(void* arg)
+{
+    (void) arg;
+    spin_work(WORK_ROUNDS * 16);
+    atomic_fetch_add_explicit(&finished, 1, memory_order_release);
+}
+
+static void probe_job(void* arg)
+{
+    Probe* probe = arg;
+    probe->started_ns = now_ns();
+    atomic_fetch_add_explicit(&finished, 1, memory_order_release);
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+static void bench_priority(int workers)
+{
+    JobPool* pool = job_pool_create(workers);
+    static Probe probes[PROBE_JOBS];
+    atomic_store(&finished, 0);
+
+    for (int i = 0; i < FLOOD_JOBS; i++)
+    {
+        job_submit(pool, JOB_PRIORITY_LOW, flood_job, NULL, NULL, NULL);
+    }
+    for (int i = 0; i < PROBE_JOBS; i++)
+    {
+        probes[i].submitted_ns = now_ns();
+        job_submit(pool, JOB_PRIORITY_HIGH, probe_job, NULL, &probes[i], NULL);
+    }
+    wait_for(FLOOD_JOBS + PROBE_JOBS);
+
+    uint64_t waits[PROBE_JOBS];
+    for (int i = 0; i < PROBE_JOBS; i++)
+    {
+        waits[i] = probes[i].started_ns - probes[i].submitted_ns;
+    }
+    qsort(waits, PROBE_JOBS, sizeof(uint64_t), compare_u64);
+    printf("%-10s workers=%-2d high priority wait p50 %8.1f us  max %8.1f us  behind %d low priority jobs\n",
+           "priority", workers, waits[PROBE_JOBS / 2] / 1e3, waits[PROBE_JOBS - 1] / 1e3, FLOOD_JOBS);
+    job_pool_destroy(pool);
+}
+
+int main(int argc, char** argv)
+{
+    int max_workers = argc > 1 ? atoi(argv[1]) : 8;
+    if (max_workers < 1 || max_workers > JOBS_MAX_WORKERS)
+    {
+        fprintf(stderr, "usage: %s [max_workers (1..%d)]\n", argv[0], JOBS_MAX_WORKERS);
+        return 1;
+    }
+
+    for (int workers = 1; workers <= max_workers; workers *= 2)
+    {
+        bench_inject(workers);
+    }
+    for (int workers = 1; workers <= max_workers; workers *= 2)
+    {
+        bench_fork_join(workers);
+    }
+    for (int workers = 1; workers <= max_workers; workers *= 2)
+    {
+        bench_priority(workers);
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "jobs.h"
+#include "testing.h"
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+static atomic_int job_runs;
+static atomic_int job_completions;
+static atomic_int completions_off_loop;
+static pthread_t loop_thread;
+
+static void count_run(void* arg)
+{
+    (void) arg;
+    atomic_fetch_add(&job_runs, 1);
+}
+
+static void count_done(void* arg)
+{
+    (void) arg;
+    if (!pthread_equal(pthread_self(), loop_thread))
+    {
+        atomic_fetch_add(&completions_off_loop, 1);
+    }
+    atomic_fetch_add(&job_completions, 1);
+}
+
+TEST(test_jobs_complete_on_loop)
+{
+    atomic_store(&job_runs, 0);
+    atomic_store(&job_completions, 0);
+    atomic_store(&completions_off_loop, 0);
+    loop_thread = pthread_self();
+
+    JobPool* pool = job_pool_create(4);
+    JobLoop* loop = job_loop_create();
+    ASSERT(pool != NULL && loop != NULL);
+
+    int rejected = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        rejected += job_submit(pool, JOB_PRIORITY_NORMAL, count_run, count_done, NULL, loop) != 0;
+    }
+    ASSERT(rejected == 0);
+
+    // Completions wait for this thread; the eventfd says when there are some
+    int completed = 0;
+    while (completed < 1000)
+    {
+        struct pollfd pfd = {.fd = job_loop_fd(loop), .events = POLLIN};
+        if (poll(&pfd, 1, 5000) != 1)
+        {
+            break;
+        }
+        completed += job_loop_run(loop);
+    }
+    ASSERT(completed == 1000);
+    ASSERT(atomic_load(&job_runs) == 1000);
+    ASSERT(atomic_load(&job_completions) == 1000);
+    ASSERT(atomic_load(&completions_off_loop) == 0);
+
+    JobPoolStats stats;
+    job_pool_stats(pool, &stats);
+    ASSERT(stats.submitted == 1000 && stats.executed == 1000 && stats.injected == 1000);
+    ASSERT(stats.pending == 0);
+
+    job_pool_destroy(pool);
+    job_loop_destroy(loop);
+}
+
+typedef struct
+{
+    JobPool* pool;
+    int depth;
+} TreeJob;
+
+static atomic_int tree_leaves;
+
+static void tree_run(void* arg)
+{
+    TreeJob* job = arg;
+    if (job->depth == 0)
+    {
+        atomic_fetch_add(&tree_leaves, 1);
+    }
+    else
+    {
+        // Children land on this worker's deque; idle workers steal them
+        for (int i = 0; i < 2; i++)
+        {
+            TreeJob* child = malloc(sizeof(TreeJob));
+            child->pool = job->pool;
+            child->depth = job->depth - 1;
+            job_submit(job->pool, JOB_PRIORITY_HIGH, tree_run, NULL, child, NULL);
+        }
+    }
+    free(job);
+}
+
+TEST(test_jobs_fork_join_drains_on_destroy)
+{
+    atomic_store(&tree_leaves, 0);
+    JobPool* pool = job_pool_create(4);
+    ASSERT(pool != NULL);
+
+    TreeJob* root = malloc(sizeof(TreeJob));
+    root->pool = pool;
+    root->depth = 12;
+    ASSERT(job_submit(pool, JOB_PRIORITY_HIGH, tree_run, NULL, root, NULL) == 0);
+
+    // Destroy waits for the whole tree, including jobs spawned while it was stopping
+    job_pool_destroy(pool);
+    ASSERT(atomic_load(&tree_leaves) == 1 << 12);
+}
+
+static atomic_bool gate_open;
+static int run_order[16];
+static atomic_int run_count;
+
+static void wait_at_gate(void* arg)
+{
+    (void) arg;
+    while (!atomic_load(&gate_open))
+    {
+    }
+}
+
+static void record_priority(void* arg)
+{
+    run_order[atomic_fetch_add(&run_count, 1)] = (int) (intptr_t) arg;
+}
+
+TEST(test_jobs_high_priority_first)
+{
+    atomic_store(&gate_open, false);
+    atomic_store(&run_count, 0);
+    JobPool* pool = job_pool_create(1);
+    ASSERT(pool != NULL);
+
+    // The only worker is busy while low priority work queues up ahead of gameplay work
+    job_submit(pool, JOB_PRIORITY_HIGH, wait_at_gate, NULL, NULL, NULL);
+    while (job_pool_pending(pool, JOB_PRIORITY_HIGH) != 0)
+    {
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        job_submit(pool, JOB_PRIORITY_LOW, record_priority, NULL, (void*) (intptr_t) JOB_PRIORITY_LOW, NULL);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        job_submit(pool, JOB_PRIORITY_HIGH, record_priority, NULL, (void*) (intptr_t) JOB_PRIORITY_HIGH, NULL);
+    }
+    ASSERT(job_pool_pending(pool, JOB_PRIORITY_LOW) == 4);
+    atomic_store(&gate_open, true);
+    job_pool_destroy(pool);
+
+    ASSERT(atomic_load(&run_count) == 8);
+    bool high_first = true;
+    for (int i = 0; i < 8; i++)
+    {
+        high_first &= run_order[i] == (i < 4 ? JOB_PRIORITY_HIGH : JOB_PRIORITY_LOW);
+    }
+    ASSERT(high_first);
+}
+
+int main()
+{
+    RUN_TEST(test_jobs_complete_on_loop);
+    RUN_TEST(test_jobs_fork_join_drains_on_destroy);
+    RUN_TEST(test_jobs_high_priority_first);
+    return failed;
+}
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_logger.dir/src/logger.c.o"
+  "CMakeFiles/Cardio_logger.dir/src/logger.c.o.d"
+  "libCardio_logger.a"
+  "libCardio_logger.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_logger.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
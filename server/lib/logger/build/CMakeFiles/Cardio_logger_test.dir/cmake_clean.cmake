@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_logger_test.dir/src/logger.c.o"
+  "CMakeFiles/Cardio_logger_test.dir/src/logger.c.o.d"
+  "CMakeFiles/Cardio_logger_test.dir/test/unit_tests.c.o"
+  "CMakeFiles/Cardio_logger_test.dir/test/unit_tests.c.o.d"
+  "Cardio_logger_test"
+  "Cardio_logger_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_logger_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_mpack.dir/src/mpack.c.o"
+  "CMakeFiles/Cardio_mpack.dir/src/mpack.c.o.d"
+  "libCardio_mpack.a"
+  "libCardio_mpack.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_mpack.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,26 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/server/lib/pokergame/src/game_engine.c" "CMakeFiles/Cardio_pokergame.dir/src/game_engine.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/game_engine.c.o.d"
+  "/root/repo/server/lib/pokergame/src/hand.c" "CMakeFiles/Cardio_pokergame.dir/src/hand.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/hand.c.o.d"
+  "/root/repo/server/lib/pokergame/src/hand_strength.c" "CMakeFiles/Cardio_pokergame.dir/src/hand_strength.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/hand_strength.c.o.d"
+  "/root/repo/server/lib/pokergame/src/mcadvisor.c" "CMakeFiles/Cardio_pokergame.dir/src/mcadvisor.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/mcadvisor.c.o.d"
+  "/root/repo/server/lib/pokergame/src/player.c" "CMakeFiles/Cardio_pokergame.dir/src/player.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/player.c.o.d"
+  "/root/repo/server/lib/pokergame/src/pokergame.c" "CMakeFiles/Cardio_pokergame.dir/src/pokergame.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/pokergame.c.o.d"
+  "/root/repo/server/lib/pokergame/src/replay.c" "CMakeFiles/Cardio_pokergame.dir/src/replay.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/replay.c.o.d"
+  "/root/repo/server/lib/pokergame/src/settlement.c" "CMakeFiles/Cardio_pokergame.dir/src/settlement.c.o" "gcc" "CMakeFiles/Cardio_pokergame.dir/src/settlement.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
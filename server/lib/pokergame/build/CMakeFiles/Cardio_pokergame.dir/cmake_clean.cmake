@@ -0,0 +1,25 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_pokergame.dir/src/game_engine.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/game_engine.c.o.d"
+  "CMakeFiles/Cardio_pokergame.dir/src/hand.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/hand.c.o.d"
+  "CMakeFiles/Cardio_pokergame.dir/src/hand_strength.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/hand_strength.c.o.d"
+  "CMakeFiles/Cardio_pokergame.dir/src/mcadvisor.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/mcadvisor.c.o.d"
+  "CMakeFiles/Cardio_pokergame.dir/src/player.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/player.c.o.d"
+  "CMakeFiles/Cardio_pokergame.dir/src/pokergame.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/pokergame.c.o.d"
+  "CMakeFiles/Cardio_pokergame.dir/src/replay.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/replay.c.o.d"
+  "CMakeFiles/Cardio_pokergame.dir/src/settlement.c.o"
+  "CMakeFiles/Cardio_pokergame.dir/src/settlement.c.o.d"
+  "libCardio_pokergame.a"
+  "libCardio_pokergame.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_pokergame.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
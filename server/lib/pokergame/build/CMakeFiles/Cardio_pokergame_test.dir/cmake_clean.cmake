@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_pokergame_test.dir/src/game_engine.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/game_engine.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/hand.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/hand.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/hand_strength.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/hand_strength.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/mcadvisor.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/mcadvisor.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/player.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/player.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/pokergame.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/pokergame.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/replay.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/replay.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/settlement.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/src/settlement.c.o.d"
+  "CMakeFiles/Cardio_pokergame_test.dir/test/unit_tests.c.o"
+  "CMakeFiles/Cardio_pokergame_test.dir/test/unit_tests.c.o.d"
+  "Cardio_pokergame_test"
+  "Cardio_pokergame_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_pokergame_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/Cardio_replay.dir/src/game_engine.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/game_engine.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/src/hand.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/hand.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/src/hand_strength.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/hand_strength.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/src/mcadvisor.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/mcadvisor.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/src/player.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/player.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/src/pokergame.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/pokergame.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/src/replay.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/replay.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/src/settlement.c.o"
+  "CMakeFiles/Cardio_replay.dir/src/settlement.c.o.d"
+  "CMakeFiles/Cardio_replay.dir/tool/replay.c.o"
+  "CMakeFiles/Cardio_replay.dir/tool/replay.c.o.d"
+  "Cardio_replay"
+  "Cardio_replay.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/Cardio_replay.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -8,6 +8,8 @@
 #define MAX_PLAYERS 9
 #define MAX_COMMUNITY_CARDS 5
 
+struct HandLog;
+
 // Player states
 typedef enum {
     PLAYER_STATE_EMPTY = 0,       // Seat is empty
@@ -44,6 +46,16 @@ typedef struct {
     int amount;      // Amount for bet/raise, 0 for fold/check/call
 } Action;
 
+// One applied action, kept so clients can animate moves that arrive coalesced
+typedef struct {
+    uint32_t seq;    // GameState.seq after the action was applied
+    int seat;
+    int player_id;
+    ActionType type;
+    int amount;      // Chips the action put in
+    BettingRound round; // Round the action was taken in
+} ActionRecord;
+
 // Available action with constraints
 typedef struct {
     ActionType type;
@@ -75,8 +87,30 @@ typedef struct {
     int amount;
     int player_ids[MAX_PLAYERS]; // Players eligible for this pot
     int num_players;
+    uint16_t eligible_seats;     // The same players as a bit per seat
 } Pot;
 
+// One seat's part in a settled hand
+typedef struct {
+    int seat;
+    int player_id;
+    int bet;                    // Chips put in this hand
+    int won;                    // Chips taken from the pots
+    int stack;                  // Money after the hand
+    uint32_t hand_value;        // game_evaluate_hand of the hand shown down, 0 if none
+} SettlementEntry;
+
+// How the last hand's pots were paid: one entry per seated player, ready to commit as a batch
+typedef struct {
+    uint32_t hand_id;
+    bool showdown;              // Hands were compared (else the last player in took the pots)
+    int num_pots;
+    int pot_amounts[MAX_PLAYERS];    // Main pot first, then the side pots
+    uint16_t pot_winners[MAX_PLAYERS]; // Bit per seat that won a share of each pot
+    int num_entries;
+    SettlementEntry entries[MAX_PLAYERS];
+} Settlement;
+
 // Game state structure
 typedef struct {
     // Game identification
@@ -108,6 +142,7 @@ typedef struct {
     Pot main_pot;
     Pot side_pots[MAX_PLAYERS]; // Side pots
     int num_side_pots;
+    Settlement settlement;      // Filled when the pots are paid
     
     // Betting state
     int current_bet;            // Current bet to match
@@ -117,6 +152,9 @@ typedef struct {
     
     // Deck
     Deck *deck;
+    uint64_t deck_seed;         // Seed the current hand was shuffled with
+    uint64_t next_deck_seed;    // Set before game_start_hand to pick the shuffle (0 = game_draw_seed)
+    struct HandLog *hand_log;   // While set, the engine records each hand here (see replay.h)
     
     // Game flags
     bool hand_in_progress;
@@ -137,6 +175,13 @@ typedef struct {
 GameState* game_state_create(int game_id, int max_players, int small_blind, int big_blind);
 void game_state_destroy(GameState *state);
 void game_state_reset_for_new_hand(GameState *state);
+// Copy everything but the deck allocation and hand_log: dst's cards point into its own deck
+void game_state_copy(GameState *dst, const GameState *src);
+GameState* game_state_clone(const GameState *src);
+// FNV-1a over everything the rules depend on (not names or timers); equal states hash equal
+uint64_t game_state_hash(const GameState *state);
+// A fresh nonzero deck seed from the kernel, never from rand()
+uint64_t game_draw_seed(void);
 
 // ===== Player Management =====
 int game_add_player(GameState *state, int player_id, const char *name, int seat, int buy_in);
@@ -166,15 +211,33 @@ ActionValidation game_validate_action(GameState *state, int player_id, Action *a
 int game_process_action(GameState *state, int player_id, Action *action);
 void game_get_available_actions(GameState *state, int player_id, AvailableAction *actions, int *num_actions);
 
-// ===== Pot Management =====
+// ===== Pot Management (settlement.c) =====
 void game_collect_bets_to_pot(GameState *state);
+// Rebuild main_pot and side_pots as layers of total_bet: one per all-in level, each eligible to the
+// players still in who put in at least that much. Folded and departed players' chips stay in.
 void game_calculate_side_pots(GameState *state);
+// Pay the pots to winning_seat as the last player in; a pot it cannot win is split among its players
 int game_distribute_pot(GameState *state, int winning_seat);
 
 // ===== Showdown =====
+// Rank the players still in and pay each pot to its best hands. A tie splits the pot, the odd chips
+// going one each to the winners nearest the dealer's left. Returns winner_seat (the main pot's).
 int game_determine_winner(GameState *state);
 void game_showdown(GameState *state);
 
+// ===== Hand Strength =====
+// Full-strength value of the best 5-card hand in 5-7 cards: category (0=High Card .. 8=Straight Flush,
+// same scale as winner_hand_rank) in bits 20-23 followed by up to five 4-bit tie-break ranks.
+#define HAND_VALUE_CATEGORY(value) ((int)((value) >> 20))
+uint32_t game_evaluate_hand(const Card *cards, int num_cards);
+// Monte Carlo win probability against num_opponents random hands. Stops after max_iterations samples or
+// once deadline_ms (game_now_ms clock, 0 = none) passes. Returns -1.0 if no sample could be taken.
+double game_estimate_equity(const Card hole[2], const Card *board, int num_board, int num_opponents,
+                            int max_iterations, uint64_t deadline_ms, uint64_t *rng_state, int *iterations_done);
+uint64_t game_now_ms(void);
+// xorshift64* - cheap generator on caller-owned state, so workers never touch the global rand() state
+uint64_t game_random(uint64_t *state);
+
 // ===== Utility Functions =====
 void game_set_dealer_button(GameState *state);
 void game_set_blinds_positions(GameState *state);
@@ -0,0 +1,103 @@
+#pragma once
+#include "game_engine.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Deterministic hand replay. A GameState with hand_log set records each hand it plays: the table as it
+// was before game_start_hand, the deck seed, and every event the engine applied until the hand was over
+// (actions in the order game_process_action accepted them, plus players joining, leaving or handed to a
+// bot mid-hand). The whole hand follows from that, so replaying it through game_start_hand and
+// game_process_action makes the same GameState, which the log's final_hash checks.
+//
+// Logs travel as compact records (hand_log_encode/decode): a magic, a length and the fields in
+// little-endian order, so a file of them can be appended to and read back after a torn write.
+// Cardio_replay replays such files: verifying each hand, seeking within one, or timing the engine.
+
+#define HAND_LOG_MAX_EVENTS 128 // A hand with more is not finished in its log
+#define HAND_LOG_MAGIC 0x474F4C48 // "HLOG"
+#define HAND_LOG_MAX_RECORD (64 + MAX_PLAYERS * 16 + HAND_LOG_MAX_EVENTS * 11)
+
+typedef enum {
+    HAND_EVENT_ACTION = 0, // game_process_action at seat
+    HAND_EVENT_JOIN,       // game_add_player at seat, amount = buy-in
+    HAND_EVENT_LEAVE,      // game_remove_player at seat
+    HAND_EVENT_BOT         // game_convert_player_to_bot at seat
+} HandEventType;
+
+typedef struct {
+    uint8_t type;          // HandEventType
+    uint8_t seat;
+    uint8_t action;        // ActionType, for HAND_EVENT_ACTION
+    int32_t amount;        // As submitted, before validation adjusted it
+    int32_t player_id;     // For HAND_EVENT_JOIN
+} HandEvent;
+
+typedef struct {
+    int32_t player_id;
+    uint8_t state;         // PlayerState
+    bool is_bot;
+    int32_t money;
+    int32_t original_user_id;
+} HandSeat;
+
+typedef struct HandLog {
+    // Table settings
+    int32_t game_id;
+    int32_t max_players;
+    int32_t small_blind;
+    int32_t big_blind;
+    int32_t min_buy_in;
+    int32_t max_buy_in;
+    // Before game_start_hand
+    uint32_t hand_id;
+    int32_t dealer_seat;
+    HandSeat seats[MAX_PLAYERS];
+    uint64_t deck_seed;
+    // The hand
+    int num_events;
+    bool recording;        // Between game_start_hand and the end of the hand
+    bool finished;         // The hand ended with every event kept; final_hash is set
+    uint64_t final_hash;   // game_state_hash when the hand ended
+    HandEvent events[HAND_LOG_MAX_EVENTS];
+} HandLog;
+
+// ===== Recording =====
+
+// Start recording state's hands. Returns 0 on success, -1 if memory ran out.
+int game_record_hands(GameState *state);
+// Called by the engine; no-ops while state->hand_log is NULL
+void hand_log_begin(GameState *state);
+void hand_log_event(GameState *state, HandEventType type, int seat, int action, int amount);
+void hand_log_finish(GameState *state);
+
+// ===== Records =====
+
+// Encode log into out (HAND_LOG_MAX_RECORD bytes is always enough). Returns the record's length.
+size_t hand_log_encode(const HandLog *log, unsigned char *out);
+// Decode the record at the start of data into log. Returns its length, 0 if data holds only part of
+// a record, -1 if it is not a hand log record.
+long hand_log_decode(const unsigned char *data, size_t len, HandLog *log);
+
+// ===== Replay =====
+
+// Seat log's table in state, which must come from game_state_create (its deck is reused), and deal the
+// hand. Returns game_start_hand's result.
+int replay_deal(GameState *state, const HandLog *log);
+// Apply one event. Returns the engine's result, 0 on success.
+int replay_apply(GameState *state, const HandEvent *event);
+// Deal and play all of log. Returns 0 if every event applied and, for a finished log, the state hashes
+// to final_hash; -1 if an event was rejected (*failed_event says which), -2 if the hash differs.
+int replay_hand(GameState *state, const HandLog *log, int *failed_event);
+
+// Random access within one hand: the hand is played once up front, keeping a copy of the state every
+// interval events, and seeking copies the nearest one back and applies fewer than interval events.
+typedef struct ReplayCursor ReplayCursor;
+
+ReplayCursor* replay_cursor_create(const HandLog *log, int interval);
+// State after the first event events of the hand (0 = just dealt), NULL if it cannot be reached.
+// The state belongs to the cursor and changes with the next seek.
+const GameState* replay_seek(ReplayCursor *cursor, int event);
+// Events the hand could be played to (less than num_events if one was rejected)
+int replay_cursor_events(const ReplayCursor *cursor);
+void replay_cursor_destroy(ReplayCursor *cursor);
@@ -1,5 +1,7 @@
 #include "game_engine.h"
+#include "replay.h"
 #include <string.h>
+#include <sys/random.h>
 #include <time.h>
 
 // ===== Game State Management =====
@@ -52,10 +54,121 @@ void game_state_destroy(GameState *state) {
     if (state->deck) {
         deck_destroy(state->deck);
     }
+    free(state->hand_log);
     
     free(state);
 }
 
+void game_state_copy(GameState *dst, const GameState *src) {
+    Deck *deck = dst->deck;
+    struct HandLog *hand_log = dst->hand_log;
+    *dst = *src;
+    dst->deck = deck;
+    dst->hand_log = hand_log;
+    for (int i = 0; i < DECK_SIZE; i++) {
+        *deck->cards[i] = *src->deck->cards[i];
+    }
+    deck->topcardindex = src->deck->topcardindex;
+    
+    // Dealt cards are pointers into the deck: point at the card in the same position of ours
+    Card **dealt[MAX_PLAYERS * 2 + MAX_COMMUNITY_CARDS];
+    int num_dealt = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        dealt[num_dealt++] = &dst->players[i].hole_cards[0];
+        dealt[num_dealt++] = &dst->players[i].hole_cards[1];
+    }
+    for (int i = 0; i < MAX_COMMUNITY_CARDS; i++) {
+        dealt[num_dealt++] = &dst->community_cards[i];
+    }
+    for (int d = 0; d < num_dealt; d++) {
+        Card *card = *dealt[d];
+        *dealt[d] = NULL;
+        for (int i = 0; card && i < DECK_SIZE; i++) {
+            if (src->deck->cards[i] == card) {
+                *dealt[d] = deck->cards[i];
+                break;
+            }
+        }
+    }
+}
+
+GameState* game_state_clone(const GameState *src) {
+    if (!src) return NULL;
+    GameState *state = game_state_create(src->game_id, src->max_players, src->small_blind, src->big_blind);
+    if (!state) return NULL;
+    game_state_copy(state, src);
+    return state;
+}
+
+static uint64_t hash_int(uint64_t hash, int64_t value) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (uint64_t)(value >> (i * 8)) & 0xFF;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static uint64_t hash_card(uint64_t hash, const Card *card) {
+    return hash_int(hash, card ? card->suit * 16 + card->rank : 0);
+}
+
+uint64_t game_state_hash(const GameState *state) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash = hash_int(hash, state->game_id);
+    hash = hash_int(hash, state->hand_id);
+    hash = hash_int(hash, state->seq);
+    hash = hash_int(hash, state->betting_round);
+    hash = hash_int(hash, state->dealer_seat);
+    hash = hash_int(hash, state->active_seat);
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        // What an empty seat still holds is left over from whoever sat there
+        const GamePlayer *p = &state->players[i];
+        hash = hash_int(hash, p->state);
+        if (p->state == PLAYER_STATE_EMPTY) continue;
+        hash = hash_int(hash, p->player_id);
+        hash = hash_int(hash, p->money);
+        hash = hash_int(hash, p->bet);
+        hash = hash_int(hash, p->total_bet);
+        hash = hash_card(hash, p->hole_cards[0]);
+        hash = hash_card(hash, p->hole_cards[1]);
+        hash = hash_int(hash, p->is_dealer | p->is_small_blind << 1 | p->is_big_blind << 2 | p->is_bot << 3);
+        hash = hash_int(hash, p->original_user_id);
+    }
+    for (int i = 0; i < state->num_community_cards; i++) {
+        hash = hash_card(hash, state->community_cards[i]);
+    }
+    hash = hash_int(hash, state->main_pot.amount);
+    for (int i = 0; i < state->num_side_pots; i++) {
+        hash = hash_int(hash, state->side_pots[i].amount);
+    }
+    hash = hash_int(hash, state->current_bet);
+    hash = hash_int(hash, state->min_raise);
+    hash = hash_int(hash, state->last_aggressor_seat);
+    hash = hash_int(hash, state->players_acted);
+    hash = hash_int(hash, state->deck_seed);
+    hash = hash_int(hash, state->deck->topcardindex);
+    hash = hash_int(hash, state->hand_in_progress);
+    hash = hash_int(hash, state->winner_seat);
+    hash = hash_int(hash, state->amount_won);
+    hash = hash_int(hash, state->winner_hand_rank);
+    return hash;
+}
+
+uint64_t game_draw_seed(void) {
+    uint64_t seed = 0;
+    if (getrandom(&seed, sizeof(seed), 0) != sizeof(seed)) {
+        // No entropy source: mix the clock through splitmix64 rather than fall back to rand()
+        static uint64_t counter = 0;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        seed = ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec) + (++counter * 0x9E3779B97F4A7C15ULL);
+        seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+        seed ^= seed >> 31;
+    }
+    return seed ? seed : 1;
+}
+
 void game_state_reset_for_new_hand(GameState *state) {
     if (!state) return;
     
@@ -68,7 +181,9 @@ void game_state_reset_for_new_hand(GameState *state) {
     // Reset pots
     state->main_pot.amount = 0;
     state->main_pot.num_players = 0;
+    state->main_pot.eligible_seats = 0;
     state->num_side_pots = 0;
+    memset(&state->settlement, 0, sizeof(state->settlement));
     
     // Reset betting state
     state->current_bet = 0;
@@ -76,27 +191,32 @@ void game_state_reset_for_new_hand(GameState *state) {
     state->last_aggressor_seat = -1;
     state->players_acted = 0;
     
-    // Reset player states
+    // Reset player states. Seats left mid-hand are cleared too: a blind flag left there would make
+    // the empty seat post the next blind.
     for (int i = 0; i < MAX_PLAYERS; i++) {
         if (state->players[i].state != PLAYER_STATE_EMPTY && 
             state->players[i].state != PLAYER_STATE_SITTING_OUT) {
             state->players[i].state = PLAYER_STATE_WAITING;
-            state->players[i].bet = 0;
-            state->players[i].total_bet = 0;
-            state->players[i].hole_cards[0] = NULL;
-            state->players[i].hole_cards[1] = NULL;
-            state->players[i].is_dealer = false;
-            state->players[i].is_small_blind = false;
-            state->players[i].is_big_blind = false;
         }
+        state->players[i].bet = 0;
+        state->players[i].total_bet = 0;
+        state->players[i].hole_cards[0] = NULL;
+        state->players[i].hole_cards[1] = NULL;
+        state->players[i].is_dealer = false;
+        state->players[i].is_small_blind = false;
+        state->players[i].is_big_blind = false;
     }
     
-    // Reset and shuffle deck
+    // Reset and shuffle deck. The whole deal follows from the seed, so a caller that records it can
+    // deal the same hand again.
     enqueue_deck(state->deck);
     deck_fill(state->deck);
-    // Re-seed random for additional randomness per hand
-    srand((unsigned int)(time(NULL) + state->hand_id * 1000));
-    shuffle(state->deck, 1000);
+    if (state->next_deck_seed == 0) {
+        state->next_deck_seed = game_draw_seed();
+    }
+    state->deck_seed = state->next_deck_seed;
+    state->next_deck_seed = 0;
+    shuffle_seeded(state->deck, state->deck_seed);
     
     state->hand_in_progress = false;
     state->betting_round = BETTING_ROUND_COMPLETE;
@@ -126,6 +246,7 @@ int game_add_player(GameState *state, int player_id, const char *name, int seat,
     state->players[seat].original_user_id = 0;
     
     state->num_players++;
+    hand_log_event(state, HAND_EVENT_JOIN, seat, 0, buy_in);
     
     // Check if we have enough players to start
     if (state->num_players >= 2) {
@@ -143,6 +264,7 @@ int game_remove_player(GameState *state, int seat) {
     state->players[seat].player_id = 0;
     state->players[seat].money = 0;
     state->num_players--;
+    hand_log_event(state, HAND_EVENT_LEAVE, seat, 0, 0);
     
     return 0;
 }
@@ -160,10 +282,11 @@ int game_convert_player_to_bot(GameState *state, int seat) {
     player->is_bot = true;
     strncpy(player->name, "Bot", 31);
     player->name[31] = '\0';
-    player->player_id = -1; // Use -1 to indicate bot (no real player_id)
+    player->player_id = -(seat + 1); // Negative ids mark bots; unique per seat so actions can be routed
     
     // Keep their current state (ACTIVE, FOLDED, ALL_IN, etc.) and chips
     // This allows the bot to continue playing the current hand
+    hand_log_event(state, HAND_EVENT_BOT, seat, 0, 0);
     
     return 0;
 }
@@ -222,8 +345,10 @@ int game_start_hand(GameState *state) {
     if (!state || state->hand_in_progress) return -1;
     if (state->num_players < 2) return -2;
     
-    // Reset for new hand
+    // Reset for new hand, noting the table as it was before for the hand log
+    hand_log_begin(state);
     game_state_reset_for_new_hand(state);
+    if (state->hand_log) state->hand_log->deck_seed = state->deck_seed;
     
     state->hand_id++;
     state->seq = 0;
@@ -356,7 +481,9 @@ int game_end_hand(GameState *state) {
     state->betting_round = BETTING_ROUND_COMPLETE;
     
     // Determine winner and distribute pot
+    game_collect_bets_to_pot(state);
     game_determine_winner(state);
+    hand_log_finish(state);
     
     return 0;
 }
@@ -431,7 +558,6 @@ int game_advance_betting_round(GameState *state) {
     // If only one player remains, they win immediately
     if (active_count + all_in_count <= 1 && last_active_seat >= 0) {
         game_distribute_pot(state, last_active_seat);
-        state->winner_seat = last_active_seat;
         state->betting_round = BETTING_ROUND_COMPLETE;
         state->hand_in_progress = false;
         state->active_seat = -1;
@@ -507,12 +633,14 @@ bool game_is_betting_round_complete(GameState *state) {
     if (!state) return false;
     
     int active_count = 0;
+    int can_act_count = 0;
     int all_matched = true;
     
     for (int i = 0; i < MAX_PLAYERS; i++) {
         GamePlayer *p = &state->players[i];
         if (p->state == PLAYER_STATE_ACTIVE) {
             active_count++;
+            can_act_count++;
             // Check if player has matched current bet or is all-in
             if (p->bet != state->current_bet && p->state != PLAYER_STATE_ALL_IN) {
                 all_matched = false;
@@ -529,14 +657,15 @@ bool game_is_betting_round_complete(GameState *state) {
     
     // Round is complete if:
     // 1. All active players have matched the current bet
-    // 2. AND either someone bet/raised (last_aggressor_seat != -1) OR everyone checked (current_bet == 0 && all acted)
+    // 2. AND either someone bet/raised (last_aggressor_seat != -1) OR everyone who can act has acted
+    //    (players_acted >= can_act_count)
     if (all_matched) {
         // If there was a bet/raise, round is complete when everyone matched
         if (state->last_aggressor_seat != -1) return true;
         
-        // If no bet/raise (everyone checking), need to ensure everyone has had a chance to act
-        // Check if we've gone around the table (active_seat returned to first player after dealer)
-        if (state->current_bet == 0 && state->players_acted >= active_count) {
+        // If no bet/raise (everyone checking, or limping to the big blind who then checks),
+        // need to ensure everyone who can still act has had a chance to act
+        if (state->players_acted >= can_act_count) {
             return true;
         }
     }
@@ -648,6 +777,7 @@ int game_process_action(GameState *state, int player_id, Action *action) {
     
     GamePlayer *player = game_get_player_by_id(state, player_id);
     if (!player) return -3;
+    hand_log_event(state, HAND_EVENT_ACTION, player->seat, action->type, action->amount);
     
     state->seq++; // Increment sequence number for this action
     state->players_acted++; // Increment players acted counter
@@ -712,6 +842,9 @@ int game_process_action(GameState *state, int player_id, Action *action) {
     } else {
         game_move_to_next_player(state);
     }
+    if (state->betting_round == BETTING_ROUND_COMPLETE) {
+        hand_log_finish(state);
+    }
     
     return 0;
 }
@@ -761,236 +894,8 @@ void game_get_available_actions(GameState *state, int player_id, AvailableAction
     }
 }
 
-// ===== Pot Management =====
-
-void game_collect_bets_to_pot(GameState *state) {
-    if (!state) return;
-    
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        if (state->players[i].state != PLAYER_STATE_EMPTY) {
-            state->main_pot.amount += state->players[i].bet;
-            state->players[i].bet = 0;
-        }
-    }
-    
-    // Calculate side pots if needed
-    game_calculate_side_pots(state);
-}
-
-void game_calculate_side_pots(GameState *state) {
-    if (!state) return;
-    
-    // TODO: Implement side pot calculation for all-in scenarios
-    // This is a complex algorithm that handles multiple all-ins
-    // For now, we'll use a simplified version with just main pot
-}
-
-int game_distribute_pot(GameState *state, int winning_seat) {
-    if (!state) return -1;
-    
-    GamePlayer *winner = game_get_player_by_seat(state, winning_seat);
-    if (!winner) return -2;
-    
-    int pot_amount = state->main_pot.amount;
-    winner->money += pot_amount;
-    state->amount_won = pot_amount;  // Store for clients
-    state->main_pot.amount = 0;
-    
-    return 0;
-}
-
 // ===== Showdown =====
 
-// Calculate best 5-card hand value from 7 cards (2 hole + 5 community)
-// Returns hand value using same scale as hand_value() function
-static int calculate_best_hand_value(Card* hole_cards[2], Card* community_cards[5], int num_community) {
-    if (!hole_cards[0] || !hole_cards[1]) return 0;
-    
-    // Collect all 7 cards
-    Card* all_cards[7];
-    int num_cards = 2;
-    all_cards[0] = hole_cards[0];
-    all_cards[1] = hole_cards[1];
-    
-    for (int i = 0; i < num_community && i < 5; i++) {
-        if (community_cards[i]) {
-            all_cards[num_cards++] = community_cards[i];
-        }
-    }
-    
-    if (num_cards < 5) return 0; // Need at least 5 cards
-    
-    int best_value = 0;
-    
-    // Try all combinations of 5 cards from 7 cards (C(7,5) = 21 combinations)
-    // For simplicity, we'll check all combinations
-    for (int c1 = 0; c1 < num_cards; c1++) {
-        for (int c2 = c1 + 1; c2 < num_cards; c2++) {
-            for (int c3 = c2 + 1; c3 < num_cards; c3++) {
-                for (int c4 = c3 + 1; c4 < num_cards; c4++) {
-                    for (int c5 = c4 + 1; c5 < num_cards; c5++) {
-                        // Count suits and ranks for this 5-card combination
-                        int suits[5] = {0};
-                        int ranks[15] = {0};
-                        int highcard = 0;
-                        
-                        Card* combo[5] = {all_cards[c1], all_cards[c2], all_cards[c3], all_cards[c4], all_cards[c5]};
-                        
-                        for (int i = 0; i < 5; i++) {
-                            int suit = combo[i]->suit;
-                            int rank = combo[i]->rank;
-                            if (rank == 1) rank = 14; // Ace high
-                            
-                            suits[suit]++;
-                            ranks[rank]++;
-                            if (rank > highcard) highcard = rank;
-                        }
-                        
-                        // Check for flush
-                        int flush = 0;
-                        int flush_suit = 0;
-                        for (int i = 1; i <= 4; i++) {
-                            if (suits[i] == 5) {
-                                flush = 1;
-                                flush_suit = i;
-                                break;
-                            }
-                        }
-                        
-                        // If flush, recalculate highcard as highest card in flush suit
-                        int flush_highcard = highcard;
-                        if (flush) {
-                            flush_highcard = 0;
-                            for (int i = 0; i < 5; i++) {
-                                int rank = combo[i]->rank;
-                                if (rank == 1) rank = 14; // Ace high
-                                if (combo[i]->suit == flush_suit && rank > flush_highcard) {
-                                    flush_highcard = rank;
-                                }
-                            }
-                        }
-                        
-                        // Check for straight
-                        int straight = 0;
-                        int consecutive = 0;
-                        int max_consecutive = 0;
-                        for (int i = 2; i < 15; i++) {
-                            if (ranks[i] > 0) {
-                                consecutive++;
-                                if (consecutive > max_consecutive) {
-                                    max_consecutive = consecutive;
-                                }
-                                if (consecutive >= 5) {
-                                    straight = 1;
-                                    highcard = i; // Update highcard to end of straight
-                                }
-                            } else {
-                                consecutive = 0;
-                            }
-                        }
-                        // Check for A-2-3-4-5 straight (wheel)
-                        if (!straight && ranks[14] > 0 && ranks[2] > 0 && ranks[3] > 0 && ranks[4] > 0 && ranks[5] > 0) {
-                            straight = 1;
-                            highcard = 5; // 5-high straight
-                        }
-                        
-                        // Check for four of a kind, three of a kind, pairs
-                        int four_kind = 0, three_kind = 0, pair_count = 0;
-                        int four_rank = 0, three_rank = 0, pair1_rank = 0, pair2_rank = 0;
-                        
-                        for (int i = 2; i < 15; i++) {
-                            if (ranks[i] == 4) {
-                                four_kind = 1;
-                                four_rank = i;
-                            } else if (ranks[i] == 3) {
-                                three_kind = 1;
-                                three_rank = i;
-                            } else if (ranks[i] == 2) {
-                                pair_count++;
-                                if (pair1_rank == 0) {
-                                    pair1_rank = i;
-                                } else {
-                                    pair2_rank = i;
-                                }
-                            }
-                        }
-                        
-                        // Calculate hand value (using same scale as hand_value function)
-                        int hand_val = 0;
-                        
-                        if (flush && straight) {
-                            // Straight flush
-                            hand_val = 13 * 8 + flush_highcard - 1; // SFLUSH = 8
-                        } else if (four_kind) {
-                            // Four of a kind
-                            hand_val = 13 * 7 + four_rank - 1; // FOURK = 7
-                        } else if (three_kind && pair_count >= 1) {
-                            // Full house
-                            hand_val = 13 * 6 + three_rank - 1; // FULLHOUSE = 6
-                        } else if (flush) {
-                            // Flush - use flush_highcard (highest card in flush suit)
-                            hand_val = 13 * 5 + flush_highcard - 1; // FLUSH = 5
-                        } else if (straight) {
-                            // Straight
-                            hand_val = 13 * 4 + highcard - 1; // STRAIGHT = 4
-                        } else if (three_kind) {
-                            // Three of a kind
-                            hand_val = 13 * 3 + three_rank - 1; // THREEK = 3
-                        } else if (pair_count >= 2) {
-                            // Two pair
-                            int higher_pair = (pair1_rank > pair2_rank) ? pair1_rank : pair2_rank;
-                            hand_val = 13 * 2 + higher_pair - 1; // TWOPAIR = 2
-                        } else if (pair_count == 1) {
-                            // Pair
-                            hand_val = 13 * 1 + pair1_rank - 1; // PAIR = 1
-                        } else {
-                            // High card
-                            hand_val = 13 * 0 + highcard - 1; // HIGHCARD = 0
-                        }
-                        
-                        if (hand_val > best_value) {
-                            best_value = hand_val;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    return best_value;
-}
-
-int game_determine_winner(GameState *state) {
-    if (!state) return -1;
-    
-    int best_seat = -1;
-    int best_value = -1;
-    
-    // Find active or all-in players and compare hands
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        GamePlayer *p = &state->players[i];
-        if (p->state == PLAYER_STATE_ACTIVE || p->state == PLAYER_STATE_ALL_IN) {
-            // Calculate best 5-card hand from 7 cards (2 hole + 5 community)
-            int hand_val = calculate_best_hand_value(p->hole_cards, state->community_cards, state->num_community_cards);
-            
-            if (hand_val > best_value) {
-                best_value = hand_val;
-                best_seat = i;
-            }
-        }
-    }
-    
-    if (best_seat >= 0) {
-        game_distribute_pot(state, best_seat);
-        state->winner_seat = best_seat;  // Store winner for clients
-        // Extract hand rank from hand value (hand_val = 13 * rank + highcard - 1)
-        // rank = 0 (High Card) to 8 (Straight Flush)
-        state->winner_hand_rank = best_value / 13;
-    }
-    
-    return best_seat;
-}
-
 void game_showdown(GameState *state) {
     if (!state) return;
     
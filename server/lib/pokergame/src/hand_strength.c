@@ -0,0 +1,207 @@
+#include "game_engine.h"
+#include <string.h>
+#include <time.h>
+
+// ===== Hand Evaluation =====
+
+#define HAND_VALUE(category, r1, r2, r3, r4, r5)                                                                   \
+    (((uint32_t)(category) << 20) | ((uint32_t)(r1) << 16) | ((uint32_t)(r2) << 12) | ((uint32_t)(r3) << 8) |      \
+     ((uint32_t)(r4) << 4) | (uint32_t)(r5))
+
+// Highest card of a straight contained in a rank bitmask (bit r set for rank r), 0 if none
+static int straight_high(uint16_t mask) {
+    if (mask & (1 << 14)) mask |= (1 << 1); // Ace plays low in the wheel
+    for (int high = 14; high >= 5; high--) {
+        uint16_t run = (uint16_t)(0x1F << (high - 4));
+        if ((mask & run) == run) return high;
+    }
+    return 0;
+}
+
+// Fill out[] with the n highest ranks in mask, skipping ranks in exclude
+static void top_ranks(uint16_t mask, uint16_t exclude, int *out, int n) {
+    int found = 0;
+    for (int r = 14; r >= 2 && found < n; r--) {
+        if ((mask & (1 << r)) && !(exclude & (1 << r))) {
+            out[found++] = r;
+        }
+    }
+    while (found < n) out[found++] = 0;
+}
+
+uint32_t game_evaluate_hand(const Card *cards, int num_cards) {
+    if (!cards || num_cards <= 0) return 0;
+
+    int counts[15] = {0};
+    int suit_count[5] = {0};
+    uint16_t suit_mask[5] = {0};
+    uint16_t rank_mask = 0;
+
+    for (int i = 0; i < num_cards; i++) {
+        int rank = cards[i].rank == 1 ? 14 : cards[i].rank;
+        int suit = cards[i].suit;
+        if (rank < 2 || rank > 14 || suit < 1 || suit > 4) continue;
+        counts[rank]++;
+        suit_count[suit]++;
+        suit_mask[suit] |= (uint16_t)(1 << rank);
+        rank_mask |= (uint16_t)(1 << rank);
+    }
+
+    // With at most 7 cards a flush excludes quads and full houses, so it can be checked first
+    for (int s = 1; s <= 4; s++) {
+        if (suit_count[s] >= 5) {
+            int high = straight_high(suit_mask[s]);
+            if (high) return HAND_VALUE(8, high, 0, 0, 0, 0);
+            int r[5];
+            top_ranks(suit_mask[s], 0, r, 5);
+            return HAND_VALUE(5, r[0], r[1], r[2], r[3], r[4]);
+        }
+    }
+
+    int quad = 0;
+    int trips[2] = {0};
+    int num_trips = 0;
+    int pairs[3] = {0};
+    int num_pairs = 0;
+    for (int r = 14; r >= 2; r--) {
+        if (counts[r] == 4) {
+            quad = r;
+        } else if (counts[r] == 3 && num_trips < 2) {
+            trips[num_trips++] = r;
+        } else if (counts[r] == 2 && num_pairs < 3) {
+            pairs[num_pairs++] = r;
+        }
+    }
+
+    int k[5];
+    if (quad) {
+        top_ranks(rank_mask, (uint16_t)(1 << quad), k, 1);
+        return HAND_VALUE(7, quad, k[0], 0, 0, 0);
+    }
+
+    if (num_trips > 0 && (num_pairs > 0 || num_trips > 1)) {
+        int pair = num_pairs > 0 ? pairs[0] : 0;
+        if (num_trips > 1 && trips[1] > pair) pair = trips[1];
+        return HAND_VALUE(6, trips[0], pair, 0, 0, 0);
+    }
+
+    int high = straight_high(rank_mask);
+    if (high) return HAND_VALUE(4, high, 0, 0, 0, 0);
+
+    if (num_trips > 0) {
+        top_ranks(rank_mask, (uint16_t)(1 << trips[0]), k, 2);
+        return HAND_VALUE(3, trips[0], k[0], k[1], 0, 0);
+    }
+
+    if (num_pairs >= 2) {
+        top_ranks(rank_mask, (uint16_t)((1 << pairs[0]) | (1 << pairs[1])), k, 1);
+        return HAND_VALUE(2, pairs[0], pairs[1], k[0], 0, 0);
+    }
+
+    if (num_pairs == 1) {
+        top_ranks(rank_mask, (uint16_t)(1 << pairs[0]), k, 3);
+        return HAND_VALUE(1, pairs[0], k[0], k[1], k[2], 0);
+    }
+
+    top_ranks(rank_mask, 0, k, 5);
+    return HAND_VALUE(0, k[0], k[1], k[2], k[3], k[4]);
+}
+
+// ===== Equity Estimation =====
+
+uint64_t game_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+uint64_t game_random(uint64_t *state) {
+    uint64_t x = *state ? *state : 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static bool same_card(const Card *a, const Card *b) {
+    int ra = a->rank == 1 ? 14 : a->rank;
+    int rb = b->rank == 1 ? 14 : b->rank;
+    return ra == rb && a->suit == b->suit;
+}
+
+double game_estimate_equity(const Card hole[2], const Card *board, int num_board, int num_opponents,
+                            int max_iterations, uint64_t deadline_ms, uint64_t *rng_state, int *iterations_done) {
+    if (iterations_done) *iterations_done = 0;
+    if (!hole || !rng_state || num_board < 0 || num_board > MAX_COMMUNITY_CARDS) return -1.0;
+    if (num_opponents <= 0) return 1.0;
+    if (num_opponents > MAX_PLAYERS - 1) num_opponents = MAX_PLAYERS - 1;
+
+    // Build the stub: every card not in our hand or on the board
+    Card stub[DECK_SIZE];
+    int stub_size = 0;
+    for (int suit = 1; suit <= 4; suit++) {
+        for (int rank = 2; rank <= 14; rank++) {
+            Card c = {suit, rank};
+            bool known = same_card(&c, &hole[0]) || same_card(&c, &hole[1]);
+            for (int i = 0; i < num_board && !known; i++) {
+                known = same_card(&c, &board[i]);
+            }
+            if (!known) stub[stub_size++] = c;
+        }
+    }
+
+    int board_missing = MAX_COMMUNITY_CARDS - num_board;
+    int needed = board_missing + 2 * num_opponents;
+    if (needed > stub_size) return -1.0;
+
+    Card hero[7];
+    Card villain[7];
+    hero[0] = hole[0];
+    hero[1] = hole[1];
+    for (int i = 0; i < num_board; i++) {
+        hero[2 + i] = board[i];
+        villain[2 + i] = board[i];
+    }
+
+    double score = 0.0;
+    int iterations = 0;
+    while (iterations < max_iterations) {
+        // Check the clock every 32 samples; the budget is coarse, the loop is not
+        if ((iterations & 31) == 0 && deadline_ms && game_now_ms() >= deadline_ms) break;
+
+        // Partial Fisher-Yates: the first `needed` stub entries become this sample's unseen cards
+        for (int i = 0; i < needed; i++) {
+            int j = i + (int)(game_random(rng_state) % (uint64_t)(stub_size - i));
+            Card tmp = stub[i];
+            stub[i] = stub[j];
+            stub[j] = tmp;
+        }
+
+        for (int i = 0; i < board_missing; i++) {
+            hero[2 + num_board + i] = stub[i];
+            villain[2 + num_board + i] = stub[i];
+        }
+        uint32_t hero_value = game_evaluate_hand(hero, 7);
+
+        bool lost = false;
+        int tied = 0;
+        for (int o = 0; o < num_opponents && !lost; o++) {
+            villain[0] = stub[board_missing + 2 * o];
+            villain[1] = stub[board_missing + 2 * o + 1];
+            uint32_t villain_value = game_evaluate_hand(villain, 7);
+            if (villain_value > hero_value) {
+                lost = true;
+            } else if (villain_value == hero_value) {
+                tied++;
+            }
+        }
+
+        if (!lost) score += 1.0 / (double)(tied + 1);
+        iterations++;
+    }
+
+    if (iterations_done) *iterations_done = iterations;
+    if (iterations == 0) return -1.0;
+    return score / (double)iterations;
+}
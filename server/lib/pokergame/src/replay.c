@@ -0,0 +1,338 @@
+#include "replay.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ===== Recording =====
+
+int game_record_hands(GameState *state) {
+    if (!state) return -1;
+    if (!state->hand_log) {
+        state->hand_log = (HandLog *)calloc(1, sizeof(HandLog));
+    }
+    return state->hand_log ? 0 : -1;
+}
+
+void hand_log_begin(GameState *state) {
+    HandLog *log = state->hand_log;
+    if (!log) return;
+
+    log->game_id = state->game_id;
+    log->max_players = state->max_players;
+    log->small_blind = state->small_blind;
+    log->big_blind = state->big_blind;
+    log->min_buy_in = state->min_buy_in;
+    log->max_buy_in = state->max_buy_in;
+    log->hand_id = state->hand_id;
+    log->dealer_seat = state->dealer_seat;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        const GamePlayer *p = &state->players[i];
+        log->seats[i] = (HandSeat){p->player_id, (uint8_t)p->state, p->is_bot, p->money, p->original_user_id};
+    }
+    log->deck_seed = 0;
+    log->num_events = 0;
+    log->recording = true;
+    log->finished = false;
+    log->final_hash = 0;
+}
+
+void hand_log_event(GameState *state, HandEventType type, int seat, int action, int amount) {
+    HandLog *log = state->hand_log;
+    if (!log || !log->recording) return;
+
+    if (log->num_events == HAND_LOG_MAX_EVENTS) {
+        log->recording = false; // Cannot be replayed any more; the log stays unfinished
+        return;
+    }
+    log->events[log->num_events++] = (HandEvent){
+        (uint8_t)type, (uint8_t)seat, (uint8_t)action, amount,
+        type == HAND_EVENT_JOIN ? state->players[seat].player_id : 0
+    };
+}
+
+void hand_log_finish(GameState *state) {
+    HandLog *log = state->hand_log;
+    if (!log || !log->recording) return;
+
+    log->recording = false;
+    log->finished = true;
+    log->final_hash = game_state_hash(state);
+}
+
+// ===== Records =====
+
+static void put_u8(unsigned char **p, uint8_t value) {
+    *(*p)++ = value;
+}
+
+static void put_u32(unsigned char **p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        *(*p)++ = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static void put_u64(unsigned char **p, uint64_t value) {
+    put_u32(p, (uint32_t)value);
+    put_u32(p, (uint32_t)(value >> 32));
+}
+
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+    bool ok;
+} Reader;
+
+static uint8_t get_u8(Reader *r) {
+    if (r->p + 1 > r->end) {
+        r->ok = false;
+        return 0;
+    }
+    return *r->p++;
+}
+
+static uint32_t get_u32(Reader *r) {
+    if (r->p + 4 > r->end) {
+        r->ok = false;
+        return 0;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)*r->p++ << (i * 8);
+    }
+    return value;
+}
+
+static uint64_t get_u64(Reader *r) {
+    uint64_t low = get_u32(r);
+    return low | (uint64_t)get_u32(r) << 32;
+}
+
+size_t hand_log_encode(const HandLog *log, unsigned char *out) {
+    unsigned char *p = out + 8; // Magic and length go in front once the length is known
+    put_u32(&p, (uint32_t)log->game_id);
+    put_u8(&p, (uint8_t)log->max_players);
+    put_u32(&p, (uint32_t)log->small_blind);
+    put_u32(&p, (uint32_t)log->big_blind);
+    put_u32(&p, (uint32_t)log->min_buy_in);
+    put_u32(&p, (uint32_t)log->max_buy_in);
+    put_u32(&p, log->hand_id);
+    put_u8(&p, (uint8_t)(log->dealer_seat + 1));
+    put_u64(&p, log->deck_seed);
+    put_u64(&p, log->final_hash);
+    put_u8(&p, log->finished);
+
+    int num_seats = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        num_seats += log->seats[i].state != PLAYER_STATE_EMPTY;
+    }
+    put_u8(&p, (uint8_t)num_seats);
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        const HandSeat *seat = &log->seats[i];
+        if (seat->state == PLAYER_STATE_EMPTY) continue;
+        put_u8(&p, (uint8_t)i);
+        put_u8(&p, seat->state);
+        put_u8(&p, seat->is_bot);
+        put_u32(&p, (uint32_t)seat->player_id);
+        put_u32(&p, (uint32_t)seat->money);
+        put_u32(&p, (uint32_t)seat->original_user_id);
+    }
+
+    put_u8(&p, (uint8_t)log->num_events);
+    for (int i = 0; i < log->num_events; i++) {
+        const HandEvent *event = &log->events[i];
+        put_u8(&p, event->type);
+        put_u8(&p, event->seat);
+        put_u8(&p, event->action);
+        put_u32(&p, (uint32_t)event->amount);
+        if (event->type == HAND_EVENT_JOIN) {
+            put_u32(&p, (uint32_t)event->player_id);
+        }
+    }
+
+    size_t len = (size_t)(p - out);
+    unsigned char *header = out;
+    put_u32(&header, HAND_LOG_MAGIC);
+    put_u32(&header, (uint32_t)(len - 8));
+    return len;
+}
+
+long hand_log_decode(const unsigned char *data, size_t len, HandLog *log) {
+    Reader r = {data, data + len, true};
+    uint32_t magic = get_u32(&r);
+    uint32_t payload = get_u32(&r);
+    if (!r.ok) return 0;
+    if (magic != HAND_LOG_MAGIC || payload > HAND_LOG_MAX_RECORD) return -1;
+    if (len - 8 < payload) return 0;
+    r.end = r.p + payload;
+
+    memset(log, 0, sizeof(*log));
+    log->game_id = (int32_t)get_u32(&r);
+    log->max_players = get_u8(&r);
+    log->small_blind = (int32_t)get_u32(&r);
+    log->big_blind = (int32_t)get_u32(&r);
+    log->min_buy_in = (int32_t)get_u32(&r);
+    log->max_buy_in = (int32_t)get_u32(&r);
+    log->hand_id = get_u32(&r);
+    log->dealer_seat = (int32_t)get_u8(&r) - 1;
+    log->deck_seed = get_u64(&r);
+    log->final_hash = get_u64(&r);
+    log->finished = get_u8(&r) != 0;
+
+    int num_seats = get_u8(&r);
+    for (int i = 0; i < num_seats && r.ok; i++) {
+        int index = get_u8(&r);
+        if (index >= MAX_PLAYERS) return -1;
+        HandSeat *seat = &log->seats[index];
+        seat->state = get_u8(&r);
+        seat->is_bot = get_u8(&r) != 0;
+        seat->player_id = (int32_t)get_u32(&r);
+        seat->money = (int32_t)get_u32(&r);
+        seat->original_user_id = (int32_t)get_u32(&r);
+        if (seat->state > PLAYER_STATE_SITTING_OUT) return -1;
+    }
+
+    log->num_events = get_u8(&r);
+    if (log->num_events > HAND_LOG_MAX_EVENTS) return -1;
+    for (int i = 0; i < log->num_events && r.ok; i++) {
+        HandEvent *event = &log->events[i];
+        event->type = get_u8(&r);
+        event->seat = get_u8(&r);
+        event->action = get_u8(&r);
+        event->amount = (int32_t)get_u32(&r);
+        if (event->type == HAND_EVENT_JOIN) {
+            event->player_id = (int32_t)get_u32(&r);
+        }
+        if (event->type > HAND_EVENT_BOT || event->seat >= MAX_PLAYERS || event->action > ACTION_ALL_IN) return -1;
+    }
+    if (!r.ok || r.p != r.end || log->max_players < 2 || log->max_players > MAX_PLAYERS) return -1;
+    return (long)(8 + payload);
+}
+
+// ===== Replay =====
+
+int replay_deal(GameState *state, const HandLog *log) {
+    // As game_state_create leaves a state, with the settings and seats of the log
+    Deck *deck = state->deck;
+    HandLog *hand_log = state->hand_log;
+    memset(state, 0, sizeof(*state));
+    state->deck = deck;
+    state->hand_log = hand_log;
+    state->game_id = log->game_id;
+    state->max_players = log->max_players;
+    state->small_blind = log->small_blind;
+    state->big_blind = log->big_blind;
+    state->min_buy_in = log->min_buy_in;
+    state->max_buy_in = log->max_buy_in;
+    state->hand_id = log->hand_id;
+    state->dealer_seat = log->dealer_seat;
+    state->active_seat = -1;
+    state->betting_round = BETTING_ROUND_COMPLETE;
+    state->winner_seat = -1;
+    state->winner_hand_rank = -1;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        const HandSeat *seat = &log->seats[i];
+        GamePlayer *p = &state->players[i];
+        p->seat = i;
+        p->state = (PlayerState)seat->state;
+        if (p->state == PLAYER_STATE_EMPTY) continue;
+        p->player_id = seat->player_id;
+        strcpy(p->name, seat->is_bot ? "Bot" : "Player");
+        p->money = seat->money;
+        p->is_bot = seat->is_bot;
+        p->original_user_id = seat->original_user_id;
+        state->num_players++;
+    }
+    state->waiting_for_players = state->num_players < 2;
+    state->next_deck_seed = log->deck_seed;
+    return game_start_hand(state);
+}
+
+int replay_apply(GameState *state, const HandEvent *event) {
+    switch (event->type) {
+        case HAND_EVENT_ACTION: {
+            Action action = {(ActionType)event->action, event->amount};
+            return game_process_action(state, state->players[event->seat].player_id, &action);
+        }
+        case HAND_EVENT_JOIN:
+            return game_add_player(state, event->player_id, "Player", event->seat, event->amount);
+        case HAND_EVENT_LEAVE:
+            return game_remove_player(state, event->seat);
+        case HAND_EVENT_BOT:
+            return game_convert_player_to_bot(state, event->seat);
+    }
+    return -1;
+}
+
+int replay_hand(GameState *state, const HandLog *log, int *failed_event) {
+    replay_deal(state, log);
+    for (int i = 0; i < log->num_events; i++) {
+        if (replay_apply(state, &log->events[i]) != 0) {
+            if (failed_event) *failed_event = i;
+            return -1;
+        }
+    }
+    if (log->finished && game_state_hash(state) != log->final_hash) return -2;
+    return 0;
+}
+
+// ===== Seeking =====
+
+struct ReplayCursor {
+    const HandLog *log;
+    int interval;
+    int num_events;         // Events that applied
+    int num_snapshots;
+    GameState **snapshots;  // snapshots[i]: state after i * interval events
+    GameState *state;
+};
+
+ReplayCursor* replay_cursor_create(const HandLog *log, int interval) {
+    ReplayCursor *cursor = (ReplayCursor *)calloc(1, sizeof(ReplayCursor));
+    if (!cursor) return NULL;
+    cursor->log = log;
+    cursor->interval = interval > 0 ? interval : 1;
+    cursor->snapshots = (GameState **)calloc((size_t)(log->num_events / cursor->interval + 1), sizeof(GameState *));
+    cursor->state = game_state_create(log->game_id, log->max_players, log->small_blind, log->big_blind);
+    if (!cursor->snapshots || !cursor->state) {
+        replay_cursor_destroy(cursor);
+        return NULL;
+    }
+
+    replay_deal(cursor->state, log);
+    for (int i = 0;; i++) {
+        if (i % cursor->interval == 0) {
+            GameState *snapshot = game_state_clone(cursor->state);
+            if (!snapshot) {
+                replay_cursor_destroy(cursor);
+                return NULL;
+            }
+            cursor->snapshots[cursor->num_snapshots++] = snapshot;
+        }
+        if (i == log->num_events || replay_apply(cursor->state, &log->events[i]) != 0) break;
+        cursor->num_events++;
+    }
+    return cursor;
+}
+
+const GameState* replay_seek(ReplayCursor *cursor, int event) {
+    if (event < 0 || event > cursor->num_events) return NULL;
+    int snapshot = event / cursor->interval;
+    game_state_copy(cursor->state, cursor->snapshots[snapshot]);
+    for (int i = snapshot * cursor->interval; i < event; i++) {
+        replay_apply(cursor->state, &cursor->log->events[i]);
+    }
+    return cursor->state;
+}
+
+int replay_cursor_events(const ReplayCursor *cursor) {
+    return cursor->num_events;
+}
+
+void replay_cursor_destroy(ReplayCursor *cursor) {
+    if (!cursor) return;
+    for (int i = 0; i < cursor->num_snapshots; i++) {
+        game_state_destroy(cursor->snapshots[i]);
+    }
+    free(cursor->snapshots);
+    game_state_destroy(cursor->state);
+    free(cursor);
+}
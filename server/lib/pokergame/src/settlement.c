@@ -0,0 +1,211 @@
+#include "game_engine.h"
+#include <string.h>
+
+// ===== Pot Management =====
+
+static bool in_hand(const GamePlayer *p) {
+    return p->state == PLAYER_STATE_ACTIVE || p->state == PLAYER_STATE_ALL_IN;
+}
+
+void game_collect_bets_to_pot(GameState *state) {
+    if (!state) return;
+
+    // A player who left mid-round still put their bet in
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        state->main_pot.amount += state->players[i].bet;
+        state->players[i].bet = 0;
+    }
+
+    // Calculate side pots if needed
+    game_calculate_side_pots(state);
+}
+
+static void set_eligible(const GameState *state, Pot *pot, uint16_t seats) {
+    pot->eligible_seats = seats;
+    pot->num_players = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (seats & (1 << i)) {
+            pot->player_ids[pot->num_players++] = state->players[i].player_id;
+        }
+    }
+}
+
+void game_calculate_side_pots(GameState *state) {
+    if (!state) return;
+
+    int total = game_get_pot_total(state);
+
+    // Seats that put chips in, by total_bet ascending
+    int order[MAX_PLAYERS];
+    int n = 0;
+    int layered = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        const GamePlayer *p = &state->players[i];
+        if (p->state == PLAYER_STATE_EMPTY || p->total_bet <= 0) continue;
+        int j = n++;
+        for (; j > 0 && state->players[order[j - 1]].total_bet > p->total_bet; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+        layered += p->total_bet;
+    }
+
+    // Each player still in closes a layer at their total_bet: everyone pays into it up to that level,
+    // and it is open to the players still in at or above it. Those below it were paid out of it.
+    Pot pots[MAX_PLAYERS];
+    int num_pots = 0;
+    uint16_t remaining = 0;
+    for (int k = 0; k < n; k++) {
+        if (in_hand(&state->players[order[k]])) remaining |= (uint16_t)(1 << order[k]);
+    }
+    int level = 0;
+    int amount = 0;
+    for (int k = 0; k < n; k++) {
+        int seat = order[k];
+        int bet = state->players[seat].total_bet;
+        amount += (bet - level) * (n - k);
+        level = bet;
+        if (!in_hand(&state->players[seat])) continue;
+        if (amount > 0) {
+            pots[num_pots].amount = amount;
+            set_eligible(state, &pots[num_pots], remaining);
+            num_pots++;
+            amount = 0;
+        }
+        remaining &= (uint16_t)~(1 << seat);
+    }
+
+    if (num_pots == 0) {
+        pots[0].amount = 0;
+        set_eligible(state, &pots[0], 0);
+        num_pots = 1;
+    }
+    // Folded chips above the last caller's level go to the top pot; chips of players who left and
+    // whose seat was taken since have no total_bet to layer, and stay in the main pot
+    pots[num_pots - 1].amount += amount;
+    pots[0].amount += total - layered;
+
+    state->main_pot = pots[0];
+    state->num_side_pots = num_pots - 1;
+    for (int i = 1; i < num_pots; i++) {
+        state->side_pots[i - 1] = pots[i];
+    }
+}
+
+// Pay each pot to its eligible players with the highest value, splitting ties. Every pot goes to
+// someone still in: one whose eligible players all left is paid as if anyone in could win it.
+static void settle(GameState *state, const uint32_t values[MAX_PLAYERS], bool showdown) {
+    Settlement *s = &state->settlement;
+    memset(s, 0, sizeof(*s));
+    s->hand_id = state->hand_id;
+    s->showdown = showdown;
+
+    uint16_t in = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (in_hand(&state->players[i])) in |= (uint16_t)(1 << i);
+    }
+
+    // Seats from the dealer's left: the order odd chips are handed out in
+    int order[MAX_PLAYERS];
+    int start = state->dealer_seat >= 0 ? state->dealer_seat + 1 : 0;
+    for (int k = 0; k < MAX_PLAYERS; k++) {
+        order[k] = (start + k) % MAX_PLAYERS;
+    }
+
+    int won[MAX_PLAYERS] = {0};
+    for (int p = 0; p <= state->num_side_pots; p++) {
+        Pot *pot = p == 0 ? &state->main_pot : &state->side_pots[p - 1];
+        uint16_t eligible = pot->eligible_seats & in;
+        if (!eligible) eligible = in;
+        if (!eligible || pot->amount <= 0) continue;
+
+        uint32_t best = 0;
+        int winners = 0;
+        uint16_t mask = 0;
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            if (!(eligible & (1 << i))) continue;
+            if (!mask || values[i] > best) {
+                best = values[i];
+                mask = 0;
+                winners = 0;
+            }
+            if (values[i] == best) {
+                mask |= (uint16_t)(1 << i);
+                winners++;
+            }
+        }
+
+        int share = pot->amount / winners;
+        int odd = pot->amount % winners;
+        for (int k = 0; k < MAX_PLAYERS; k++) {
+            if (mask & (1 << order[k])) {
+                won[order[k]] += share + (odd-- > 0 ? 1 : 0);
+            }
+        }
+        s->pot_amounts[s->num_pots] = pot->amount;
+        s->pot_winners[s->num_pots] = mask;
+        s->num_pots++;
+        pot->amount = 0;
+    }
+    state->main_pot.amount = 0;
+    state->num_side_pots = 0;
+
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        GamePlayer *p = &state->players[i];
+        if (p->state == PLAYER_STATE_EMPTY) continue;
+        p->money += won[i];
+        s->entries[s->num_entries++] = (SettlementEntry){
+            i, p->player_id, p->total_bet, won[i], p->money, showdown && (in & (1 << i)) ? values[i] : 0};
+    }
+
+    // Clients are shown one winner: the main pot's, first from the dealer's left on a split
+    state->winner_seat = -1;
+    for (int k = 0; s->num_pots > 0 && k < MAX_PLAYERS; k++) {
+        if (s->pot_winners[0] & (1 << order[k])) {
+            state->winner_seat = order[k];
+            break;
+        }
+    }
+    if (state->winner_seat >= 0) {
+        state->amount_won = won[state->winner_seat];
+        if (showdown) {
+            state->winner_hand_rank = HAND_VALUE_CATEGORY(values[state->winner_seat]);
+        }
+    }
+}
+
+int game_distribute_pot(GameState *state, int winning_seat) {
+    if (!state) return -1;
+    if (!game_get_player_by_seat(state, winning_seat)) return -2;
+
+    uint32_t values[MAX_PLAYERS] = {0};
+    values[winning_seat] = 1;
+    settle(state, values, false);
+
+    return 0;
+}
+
+// ===== Showdown =====
+
+int game_determine_winner(GameState *state) {
+    if (!state) return -1;
+
+    // Each hand is ranked once, by its full value, for every pot it is in
+    uint32_t values[MAX_PLAYERS] = {0};
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        GamePlayer *p = &state->players[i];
+        if (!in_hand(p) || !p->hole_cards[0] || !p->hole_cards[1]) continue;
+
+        Card cards[2 + MAX_COMMUNITY_CARDS];
+        int num_cards = 0;
+        cards[num_cards++] = *p->hole_cards[0];
+        cards[num_cards++] = *p->hole_cards[1];
+        for (int c = 0; c < state->num_community_cards; c++) {
+            if (state->community_cards[c]) cards[num_cards++] = *state->community_cards[c];
+        }
+        values[i] = game_evaluate_hand(cards, num_cards);
+    }
+
+    settle(state, values, true);
+    return state->winner_seat;
+}
@@ -1,4 +1,6 @@
+#include "game_engine.h"
 #include "pokergame.h"
+#include "replay.h"
 #include "testing.h"
 #include <string.h>
 
@@ -32,8 +34,223 @@ TEST(test_hand_toString)
     ASSERT(res == 0);
 }
 
+TEST(test_evaluate_hand_ordering)
+{
+    Card straight_flush[7] = {{1, 9}, {1, 10}, {1, 11}, {1, 12}, {1, 13}, {2, 2}, {3, 3}};
+    Card quads[7] = {{1, 9}, {2, 9}, {3, 9}, {4, 9}, {1, 13}, {2, 2}, {3, 3}};
+    Card full_house[7] = {{1, 9}, {2, 9}, {3, 9}, {4, 5}, {1, 5}, {2, 2}, {3, 3}};
+    Card wheel[7] = {{1, 14}, {2, 2}, {3, 3}, {4, 4}, {1, 5}, {2, 9}, {3, 11}};
+    Card pair_ace_kicker[7] = {{1, 8}, {2, 8}, {3, 14}, {4, 4}, {1, 6}, {2, 10}, {3, 11}};
+    Card pair_king_kicker[7] = {{1, 8}, {2, 8}, {3, 13}, {4, 4}, {1, 6}, {2, 10}, {3, 11}};
+
+    ASSERT(HAND_VALUE_CATEGORY(game_evaluate_hand(straight_flush, 7)) == 8);
+    ASSERT(HAND_VALUE_CATEGORY(game_evaluate_hand(quads, 7)) == 7);
+    ASSERT(HAND_VALUE_CATEGORY(game_evaluate_hand(full_house, 7)) == 6);
+    ASSERT(HAND_VALUE_CATEGORY(game_evaluate_hand(wheel, 7)) == 4);
+    ASSERT(game_evaluate_hand(quads, 7) > game_evaluate_hand(full_house, 7));
+    // Same pair, the kicker decides
+    ASSERT(game_evaluate_hand(pair_ace_kicker, 7) > game_evaluate_hand(pair_king_kicker, 7));
+}
+
+TEST(test_estimate_equity)
+{
+    Card aces[2] = {{1, 14}, {2, 14}};
+    Card trash[2] = {{1, 7}, {2, 2}};
+    uint64_t rng = 12345;
+    int iterations = 0;
+
+    double strong = game_estimate_equity(aces, NULL, 0, 1, 2000, 0, &rng, &iterations);
+    ASSERT(iterations == 2000);
+    ASSERT(strong > 0.75 && strong < 0.92);
+
+    double weak = game_estimate_equity(trash, NULL, 0, 1, 2000, 0, &rng, &iterations);
+    ASSERT(weak < strong);
+
+    // A deadline in the past yields no samples
+    double expired = game_estimate_equity(aces, NULL, 0, 1, 2000, 1, &rng, &iterations);
+    ASSERT(expired < 0 && iterations == 0);
+}
+
+static int players_with_chips(const GameState *state)
+{
+    int count = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        count += state->players[i].state != PLAYER_STATE_EMPTY && state->players[i].money > 0;
+    }
+    return count;
+}
+
+// A recorded hand replays to the same state: whole, through an encoded record, and event by event
+TEST(test_replay_hands)
+{
+    GameState *state = game_state_create(7, 6, 10, 20);
+    ASSERT(game_record_hands(state) == 0);
+    game_add_player(state, 101, "Alice", 0, 2000);
+    game_add_player(state, 102, "Bob", 2, 1500);
+    game_add_player(state, 103, "Carol", 3, 1000);
+    GameState *replayed = game_state_create(0, 2, 1, 2);
+    uint64_t rng = 99;
+    int finished = 0;
+    bool recorded = true, replays = true, seeks = true, diverges = true;
+
+    for (int hand = 0; hand < 30 && players_with_chips(state) >= 2; hand++) {
+        game_start_hand(state);
+        uint64_t hashes[HAND_LOG_MAX_EVENTS + 1];
+        hashes[0] = game_state_hash(state);
+        while (state->betting_round != BETTING_ROUND_COMPLETE && state->hand_log->num_events < 40) {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            GamePlayer *p = &state->players[state->active_seat];
+            if (hand % 5 == 4 && state->hand_log->num_events == 2 && !p->is_bot) {
+                game_convert_player_to_bot(state, p->seat);
+            } else {
+                AvailableAction available[6];
+                int num_available = 0;
+                game_get_available_actions(state, p->player_id, available, &num_available);
+                AvailableAction *pick = &available[(rng >> 33) % (uint64_t)num_available];
+                pick = pick->type == ACTION_ALL_IN && hand % 10 != 9 ? &available[0] : pick; // Mostly keep everyone in
+                Action action = {pick->type, pick->min_amount};
+                recorded &= game_process_action(state, p->player_id, &action) == 0;
+            }
+            hashes[state->hand_log->num_events] = game_state_hash(state);
+        }
+        HandLog *log = state->hand_log;
+        recorded &= log->finished == (state->betting_round == BETTING_ROUND_COMPLETE);
+        recorded &= !log->finished || log->final_hash == game_state_hash(state);
+        state->hand_in_progress = false;
+        if (!log->finished) {
+            continue;
+        }
+        finished++;
+
+        unsigned char record[HAND_LOG_MAX_RECORD];
+        size_t len = hand_log_encode(log, record);
+        HandLog decoded;
+        replays &= hand_log_decode(record, len - 1, &decoded) == 0;
+        replays &= hand_log_decode(record, len, &decoded) == (long)len;
+        replays &= replay_hand(replayed, &decoded, NULL) == 0 && game_state_hash(replayed) == log->final_hash;
+
+        ReplayCursor *cursor = replay_cursor_create(&decoded, 3);
+        seeks &= replay_cursor_events(cursor) == decoded.num_events;
+        for (int i = decoded.num_events; i >= 0; i--) {
+            seeks &= game_state_hash(replay_seek(cursor, i)) == hashes[i];
+        }
+        seeks &= replay_seek(cursor, decoded.num_events + 1) == NULL;
+        replay_cursor_destroy(cursor);
+
+        // Another deck deals other cards: the same actions no longer end in the same state
+        decoded.deck_seed ^= 1;
+        diverges &= replay_hand(replayed, &decoded, NULL) != 0;
+    }
+    ASSERT(finished >= 10);
+    ASSERT(recorded);
+    ASSERT(replays);
+    ASSERT(seeks);
+    ASSERT(diverges);
+
+    unsigned char junk[16] = {'n', 'o', 't', ' ', 'a', ' ', 'l', 'o', 'g'};
+    HandLog ignored;
+    ASSERT(hand_log_decode(junk, sizeof(junk), &ignored) == -1);
+    game_state_destroy(replayed);
+    game_state_destroy(state);
+}
+
+// Seat a player who has put bet into the pot this round, in state, with the given hole cards
+static void put_in(GameState *state, int seat, PlayerState player_state, int bet, Card *hole)
+{
+    GamePlayer *p = &state->players[seat];
+    game_add_player(state, 100 + seat, "Player", seat, state->min_buy_in);
+    p->state = player_state;
+    p->money = player_state == PLAYER_STATE_ALL_IN ? 0 : state->min_buy_in;
+    p->bet = bet;
+    p->total_bet = bet;
+    p->hole_cards[0] = &hole[0];
+    p->hole_cards[1] = &hole[1];
+}
+
+static void deal_board(GameState *state, Card *board)
+{
+    for (int i = 0; i < 5; i++) {
+        state->community_cards[i] = &board[i];
+    }
+    state->num_community_cards = 5;
+}
+
+// Three all-ins for different amounts and a folded player: each all-in only wins what it covered
+TEST(test_settle_side_pots)
+{
+    GameState *state = game_state_create(1, 9, 10, 20);
+    Card board[5] = {{2, 9}, {3, 9}, {4, 2}, {1, 5}, {3, 13}};
+    Card quads[2] = {{1, 9}, {4, 9}}, kings[2] = {{2, 13}, {1, 13}}, pair[2] = {{4, 3}, {3, 4}}, aces[2] = {{2, 14}, {3, 14}};
+    state->dealer_seat = 3;
+    put_in(state, 0, PLAYER_STATE_ALL_IN, 100, quads);
+    put_in(state, 1, PLAYER_STATE_ALL_IN, 300, kings);
+    put_in(state, 2, PLAYER_STATE_ACTIVE, 500, pair);
+    put_in(state, 3, PLAYER_STATE_FOLDED, 50, aces);
+    deal_board(state, board);
+
+    game_collect_bets_to_pot(state);
+    ASSERT(state->main_pot.amount == 350 && state->main_pot.eligible_seats == 0x7 && state->main_pot.num_players == 3);
+    ASSERT(state->num_side_pots == 2 && state->side_pots[0].amount == 400 && state->side_pots[1].amount == 200);
+    ASSERT(state->side_pots[1].num_players == 1 && state->side_pots[1].player_ids[0] == 102);
+    ASSERT(game_get_pot_total(state) == 950);
+
+    ASSERT(game_determine_winner(state) == 0);
+    ASSERT(state->amount_won == 350 && state->winner_hand_rank == 7);
+    ASSERT(state->players[0].money == 350 && state->players[1].money == 400);
+    ASSERT(state->players[2].money == state->min_buy_in + 200 && game_get_pot_total(state) == 0);
+
+    const Settlement *s = &state->settlement;
+    ASSERT(s->showdown && s->num_pots == 3 && s->pot_winners[0] == 0x1 && s->pot_winners[2] == 0x4);
+    ASSERT(s->num_entries == 4 && s->entries[1].bet == 300 && s->entries[1].won == 400 && s->entries[1].stack == 400);
+    ASSERT(s->entries[3].won == 0 && s->entries[3].hand_value == 0 && s->entries[0].hand_value > s->entries[1].hand_value);
+    game_state_destroy(state);
+}
+
+// A tie splits the pot; the odd chip goes to the first winner from the dealer's left
+TEST(test_settle_split_pot)
+{
+    GameState *state = game_state_create(1, 9, 10, 20);
+    Card board[5] = {{1, 14}, {2, 13}, {3, 12}, {4, 11}, {1, 10}};
+    Card low[2] = {{2, 2}, {3, 3}}, other_low[2] = {{4, 2}, {1, 4}}, folded[2] = {{2, 5}, {3, 6}};
+    state->dealer_seat = 4;
+    put_in(state, 1, PLAYER_STATE_ACTIVE, 101, low);
+    put_in(state, 4, PLAYER_STATE_ACTIVE, 101, other_low);
+    put_in(state, 6, PLAYER_STATE_FOLDED, 1, folded);
+    deal_board(state, board);
+
+    game_collect_bets_to_pot(state);
+    ASSERT(state->main_pot.amount == 203 && state->num_side_pots == 0);
+    ASSERT(game_determine_winner(state) == 1);
+    ASSERT(state->players[1].money == state->min_buy_in + 102 && state->players[4].money == state->min_buy_in + 101);
+    ASSERT(state->settlement.pot_winners[0] == ((1 << 1) | (1 << 4)) && state->winner_hand_rank == 4);
+    game_state_destroy(state);
+}
+
+// The last player in takes what they can win; a side pot they were not in goes back to its player
+TEST(test_settle_uncontested)
+{
+    GameState *state = game_state_create(1, 9, 10, 20);
+    Card hole[2][2] = {{{1, 2}, {2, 7}}, {{3, 2}, {4, 7}}};
+    put_in(state, 0, PLAYER_STATE_ALL_IN, 50, hole[0]);
+    put_in(state, 1, PLAYER_STATE_ACTIVE, 200, hole[1]);
+
+    game_collect_bets_to_pot(state);
+    ASSERT(state->main_pot.amount == 100 && state->side_pots[0].amount == 150);
+    ASSERT(game_distribute_pot(state, 0) == 0);
+    ASSERT(state->winner_seat == 0 && state->amount_won == 100 && !state->settlement.showdown);
+    ASSERT(state->players[1].money == state->min_buy_in + 150);
+    ASSERT(game_distribute_pot(state, 5) == -2);
+    game_state_destroy(state);
+}
+
 int main()
 {
     RUN_TEST(test_hand_toString);
+    RUN_TEST(test_evaluate_hand_ordering);
+    RUN_TEST(test_estimate_equity);
+    RUN_TEST(test_replay_hands);
+    RUN_TEST(test_settle_side_pots);
+    RUN_TEST(test_settle_split_pot);
+    RUN_TEST(test_settle_uncontested);
     return failed;
 }
\ No newline at end of file
@@ -0,0 +1,304 @@
+// Replay hand logs written by the server (see replay.h) through the engine.
+//
+//   ./Cardio_replay <log> verify
+//   ./Cardio_replay <log> bench [rounds]
+//   ./Cardio_replay <log> show TABLE HAND [EVENT]
+//
+// verify plays every hand and checks it ends in the state the server hashed; a hand that does not is
+// printed with the event the engine rejected, if any.
+// bench plays the whole log rounds times (default 5), as a regression benchmark for the engine: a day
+// of logged traffic is a realistic mix of hands. Decoding is timed on its own and left out of the rate.
+// show prints a hand's events and the table after EVENT of them (default: all), seeking from the
+// nearest of the snapshots kept every SNAPSHOT_INTERVAL events.
+#define _GNU_SOURCE // memmem
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SNAPSHOT_INTERVAL 8
+
+static const char* ROUNDS[] = {"preflop", "flop", "turn", "river", "showdown", "complete"};
+static const char* ACTIONS[] = {"fold", "check", "call", "bet", "raise", "all-in"};
+static const char* STATES[] = {"empty", "waiting", "active", "folded", "all-in", "sitting out"};
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: Cardio_replay <log> verify | bench [rounds] | show TABLE HAND [EVENT]\n");
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static unsigned char* read_file(const char* path, size_t* len)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = size >= 0 ? malloc((size_t) size + 1) : NULL;
+    if (data != NULL && fread(data, 1, (size_t) size, file) != (size_t) size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *len = (size_t) size;
+    return data;
+}
+
+// Walks the records of a log. A record torn by a crash is skipped up to the next record's magic.
+typedef struct
+{
+    const unsigned char* data;
+    size_t len;
+    size_t offset;
+    bool quiet;
+} LogReader;
+
+static bool next_hand(LogReader* reader, HandLog* log)
+{
+    while (reader->offset < reader->len)
+    {
+        long used = hand_log_decode(reader->data + reader->offset, reader->len - reader->offset, log);
+        if (used > 0)
+        {
+            reader->offset += (size_t) used;
+            return true;
+        }
+
+        size_t skipped = reader->offset;
+        const unsigned char magic[4] = {HAND_LOG_MAGIC & 0xFF, (HAND_LOG_MAGIC >> 8) & 0xFF,
+                                        (HAND_LOG_MAGIC >> 16) & 0xFF, HAND_LOG_MAGIC >> 24};
+        const unsigned char* next = NULL;
+        if (reader->len - reader->offset > 4)
+        {
+            next = memmem(reader->data + reader->offset + 1, reader->len - reader->offset - 1, magic, sizeof(magic));
+        }
+        reader->offset = next != NULL ? (size_t) (next - reader->data) : reader->len;
+        if (!reader->quiet)
+        {
+            fprintf(stderr, "skipped %zu bytes of a torn record at byte %zu\n", reader->offset - skipped, skipped);
+        }
+    }
+    return false;
+}
+
+static void card_text(const Card* card, char* out)
+{
+    if (card == NULL)
+    {
+        strcpy(out, "--");
+        return;
+    }
+    out[0] = "23456789TJQKA"[(card->rank == 1 ? 14 : card->rank) - 2];
+    out[1] = "shdc"[card->suit - 1];
+    out[2] = '\0';
+}
+
+static int verify(const unsigned char* data, size_t len)
+{
+    GameState* state = game_state_create(0, MAX_PLAYERS, 1, 2);
+    HandLog log;
+    LogReader reader = {data, len, 0, false};
+    long hands = 0;
+    long unfinished = 0;
+    long bad = 0;
+    double start = now_s();
+    while (next_hand(&reader, &log))
+    {
+        hands++;
+        unfinished += !log.finished;
+        int failed_event = -1;
+        int result = replay_hand(state, &log, &failed_event);
+        if (result == -1)
+        {
+            printf("table %d hand %u: event %d was rejected\n", log.game_id, log.hand_id + 1, failed_event);
+        }
+        else if (result == -2)
+        {
+            printf("table %d hand %u: final state differs\n", log.game_id, log.hand_id + 1);
+        }
+        bad += result != 0;
+    }
+    double elapsed = now_s() - start;
+    printf("%ld hands, %ld not finished (not checked), %ld differ; %.3f s\n", hands, unfinished, bad, elapsed);
+    game_state_destroy(state);
+    return bad > 0;
+}
+
+static int bench(const unsigned char* data, size_t len, int rounds)
+{
+    GameState* state = game_state_create(0, MAX_PLAYERS, 1, 2);
+    HandLog log;
+    long hands = 0;
+    long events = 0;
+    double decode = 0;
+    double total = 0;
+    for (int round = 0; round < rounds; round++)
+    {
+        LogReader reader = {data, len, 0, round > 0};
+        double start = now_s();
+        while (next_hand(&reader, &log))
+        {
+            hands += round == 0;
+            events += round == 0 ? log.num_events : 0;
+        }
+        decode += now_s() - start;
+
+        reader.offset = 0;
+        reader.quiet = true;
+        start = now_s();
+        while (next_hand(&reader, &log))
+        {
+            replay_hand(state, &log, NULL);
+        }
+        total += now_s() - start;
+    }
+    double replay = (total - decode) / rounds;
+    if (hands == 0 || replay <= 0)
+    {
+        printf("no hands to replay\n");
+        game_state_destroy(state);
+        return 1;
+    }
+    printf("%ld hands, %ld events, %d rounds\n", hands, events, rounds);
+    printf("decode   %8.3f s/round\n", decode / rounds);
+    printf("replay   %8.3f s/round  %10.0f hands/s  %10.0f events/s  %6.0f ns/hand\n", replay,
+           (double) hands / replay, (double) events / replay, replay * 1e9 / (double) hands);
+    game_state_destroy(state);
+    return 0;
+}
+
+static void print_state(const GameState* state)
+{
+    char board[MAX_COMMUNITY_CARDS * 3 + 1] = "";
+    for (int i = 0; i < state->num_community_cards; i++)
+    {
+        card_text(state->community_cards[i], board + i * 3);
+        board[i * 3 + 2] = ' ';
+        board[i * 3 + 3] = '\0';
+    }
+    printf("round %s, seq %u, board [%s], pot %d, to act: seat %d, hash %016llx\n",
+           ROUNDS[state->betting_round], state->seq, board, game_get_pot_total((GameState*) state),
+           state->active_seat, (unsigned long long) game_state_hash(state));
+    for (int i = 0; i < MAX_PLAYERS; i++)
+    {
+        const GamePlayer* p = &state->players[i];
+        if (p->state == PLAYER_STATE_EMPTY)
+        {
+            continue;
+        }
+        char hole[2][3];
+        card_text(p->hole_cards[0], hole[0]);
+        card_text(p->hole_cards[1], hole[1]);
+        printf("  seat %d  player %-8d %s %s  %-11s stack %-8d bet %-6d in pot %-6d%s%s\n", i, p->player_id, hole[0],
+               hole[1], STATES[p->state], p->money, p->bet, p->total_bet, p->is_dealer ? " dealer" : "",
+               p->is_bot ? " bot" : "");
+    }
+}
+
+static int show(const unsigned char* data, size_t len, int table, int hand, int event)
+{
+    HandLog log;
+    LogReader reader = {data, len, 0, true};
+    bool found = false;
+    while (!found && next_hand(&reader, &log))
+    {
+        found = log.game_id == table && log.hand_id + 1 == (uint32_t) hand;
+    }
+    if (!found)
+    {
+        fprintf(stderr, "table %d hand %d is not in the log\n", table, hand);
+        return 1;
+    }
+
+    ReplayCursor* cursor = replay_cursor_create(&log, SNAPSHOT_INTERVAL);
+    if (cursor == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    int reached = replay_cursor_events(cursor);
+    event = event < 0 || event > reached ? reached : event;
+    printf("table %d hand %d, deck seed %016llx, %d events%s\n", table, hand, (unsigned long long) log.deck_seed,
+           log.num_events, log.finished ? "" : " (not finished)");
+    for (int i = 0; i < log.num_events; i++)
+    {
+        const HandEvent* e = &log.events[i];
+        printf("%c %3d  seat %d  ", i == event ? '>' : ' ', i + 1, e->seat);
+        switch (e->type)
+        {
+        case HAND_EVENT_ACTION:
+            printf("%s %d", ACTIONS[e->action], e->amount);
+            break;
+        case HAND_EVENT_JOIN:
+            printf("player %d sits down with %d", e->player_id, e->amount);
+            break;
+        case HAND_EVENT_LEAVE:
+            printf("leaves");
+            break;
+        case HAND_EVENT_BOT:
+            printf("handed to a bot");
+            break;
+        }
+        printf("%s\n", i >= reached ? "  (rejected)" : "");
+    }
+
+    const GameState* state = replay_seek(cursor, event);
+    printf("\nafter %d events: ", event);
+    print_state(state);
+    if (event == log.num_events && log.finished)
+    {
+        printf("%s the hash the server recorded\n",
+               game_state_hash(state) == log.final_hash ? "matches" : "DIFFERS from");
+    }
+    replay_cursor_destroy(cursor);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        usage();
+        return 2;
+    }
+    size_t len = 0;
+    unsigned char* data = read_file(argv[1], &len);
+    if (data == NULL)
+    {
+        fprintf(stderr, "%s: cannot read\n", argv[1]);
+        return 1;
+    }
+
+    int result;
+    if (strcmp(argv[2], "verify") == 0)
+    {
+        result = verify(data, len);
+    }
+    else if (strcmp(argv[2], "bench") == 0)
+    {
+        result = bench(data, len, argc > 3 && atoi(argv[3]) > 0 ? atoi(argv[3]) : 5);
+    }
+    else if (strcmp(argv[2], "show") == 0 && argc >= 5)
+    {
+        result = show(data, len, atoi(argv[3]), atoi(argv[4]), argc > 5 ? atoi(argv[5]) : -1);
+    }
+    else
+    {
+        usage();
+        result = 2;
+    }
+    free(data);
+    return result;
+}
@@ -0,0 +1,291 @@
+#include "admin.h"
+#include "main.h"
+#include <malloc.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+typedef struct
+{
+    char* data;
+    size_t len;
+    size_t capacity;
+    bool failed; // Out of memory; the snapshot is dropped
+} TextBuffer;
+
+static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+static const char* quantile_labels[] = {"0.5", "0.9", "0.99", "0.999"};
+
+static int admin_fd = -1;
+static char socket_path[sizeof(((struct sockaddr_un*) 0)->sun_path)];
+static uint64_t started_ns = 0;
+
+// ===== Text =====
+
+static void append(TextBuffer* text, const char* format, ...)
+{
+    if (text->failed)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        va_list args;
+        va_start(args, format);
+        int needed = vsnprintf(text->data + text->len, text->capacity - text->len, format, args);
+        va_end(args);
+        if (needed < 0)
+        {
+            text->failed = true;
+            return;
+        }
+        if (text->len + (size_t) needed < text->capacity)
+        {
+            text->len += (size_t) needed;
+            return;
+        }
+
+        size_t capacity = text->capacity * 2 + (size_t) needed;
+        char* grown = realloc(text->data, capacity);
+        if (grown == NULL)
+        {
+            text->failed = true;
+            return;
+        }
+        text->data = grown;
+        text->capacity = capacity;
+    }
+}
+
+static void append_histogram(TextBuffer* text, const char* metric, const char* label, const char* value,
+                             const MetricsHistogram* histogram)
+{
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++)
+    {
+        append(text, "%s_ns{%s=\"%s\",quantile=\"%s\"} %llu\n", metric, label, value, quantile_labels[i],
+               (unsigned long long) metrics_percentile(histogram, quantiles[i]));
+    }
+    append(text, "%s_max_ns{%s=\"%s\"} %llu\n", metric, label, value, (unsigned long long) histogram->max_ns);
+    append(text, "%s_sum_ns{%s=\"%s\"} %llu\n", metric, label, value, (unsigned long long) histogram->sum_ns);
+    append(text, "%s_count{%s=\"%s\"} %llu\n", metric, label, value, (unsigned long long) histogram->count);
+}
+
+// ===== Snapshot =====
+
+static void render_metrics(TextBuffer* text)
+{
+    append(text, "# counters\n");
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++)
+    {
+        append(text, "cardio_%s_total %llu\n", metrics_counter_name((MetricCounter) i),
+               (unsigned long long) metrics_counter((MetricCounter) i));
+    }
+
+    // Large enough that it should not live on the stack; the snapshot only runs on the event loop
+    static MetricsHistogram histogram;
+    append(text, "# latencies\n");
+    for (int i = 0; i < METRIC_LATENCY_COUNT; i++)
+    {
+        metrics_latency((MetricLatency) i, &histogram);
+        append_histogram(text, "cardio_latency", "name", metrics_latency_name((MetricLatency) i), &histogram);
+    }
+
+    append(text, "# request handling per packet type\n");
+    for (int slot = 0; slot < METRICS_PACKET_SLOTS; slot++)
+    {
+        if (metrics_packet_latency(slot, &histogram))
+        {
+            char type[16];
+            snprintf(type, sizeof(type), "%d", slot * 10);
+            append_histogram(text, "cardio_packet_latency", "type", type, &histogram);
+        }
+    }
+}
+
+static void render_state(TextBuffer* text, TableList* table_list)
+{
+    int watchers, blocked, delayed_frames;
+    spectator_stats(&watchers, &blocked, &delayed_frames);
+    int backlogged;
+    size_t backlog_bytes;
+    outbox_stats(&backlogged, &backlog_bytes);
+
+    append(text, "# connections\n");
+    append(text, "cardio_connections %llu\n",
+           (unsigned long long) (metrics_counter(METRIC_CONNECTIONS_OPENED) -
+                                 metrics_counter(METRIC_CONNECTIONS_CLOSED)));
+    append(text, "cardio_users_online %d\n", presence_online_count());
+    append(text, "cardio_sessions_parked %d\n", session_parked_count());
+    append(text, "cardio_lobby_subscribers %d\n", lobby_subscriber_count());
+    append(text, "cardio_spectators %d\n", watchers);
+    append(text, "cardio_social_cache_entries %d\n", social_cache_size());
+
+    append(text, "# queue depths\n");
+    append(text, "cardio_queue_depth{queue=\"bot_decisions\"} %d\n", bot_queue_depth());
+    append(text, "cardio_queue_depth{queue=\"table_commands\"} %d\n", table_actors_pending());
+    append(text, "cardio_queue_depth{queue=\"presence_changes\"} %d\n", presence_pending_count());
+    append(text, "cardio_queue_depth{queue=\"spectator_blocked\"} %d\n", blocked);
+    append(text, "cardio_queue_depth{queue=\"spectator_delayed_frames\"} %d\n", delayed_frames);
+    append(text, "cardio_queue_depth{queue=\"output_bytes\"} %zu\n", backlog_bytes);
+    append(text, "cardio_queue_depth{queue=\"history_bytes\"} %zu\n", history_queued_bytes());
+    append(text, "cardio_output_backlogged_connections %d\n", backlogged);
+
+    append(text, "# tables\n");
+    append(text, "cardio_tables %zu\n", table_list ? table_list->size : (size_t) 0);
+    for (size_t i = 0; table_list != NULL && i < table_list->size; i++)
+    {
+        Table* table = &table_list->tables[i];
+        GameState* gs = table->game_state;
+        append(text, "cardio_table_players{table=\"%d\"} %d\n", table->id, table->current_player);
+        append(text, "cardio_table_max_players{table=\"%d\"} %d\n", table->id, table->max_player);
+        append(text, "cardio_table_spectators{table=\"%d\"} %d\n", table->id, spectator_count(table->id));
+        append(text, "cardio_table_started{table=\"%d\"} %d\n", table->id, table->game_started ? 1 : 0);
+        append(text, "cardio_table_pending_actions{table=\"%d\"} %d\n", table->id, table->num_pending_actions);
+        append(text, "cardio_table_bot_pending{table=\"%d\"} %d\n", table->id, table->bot_ticket != 0 ? 1 : 0);
+        if (gs != NULL)
+        {
+            append(text, "cardio_table_hand{table=\"%d\"} %u\n", table->id, gs->hand_id);
+            append(text, "cardio_table_round{table=\"%d\"} %d\n", table->id, (int) gs->betting_round);
+            append(text, "cardio_table_pot{table=\"%d\"} %d\n", table->id, game_get_pot_total(gs));
+        }
+    }
+}
+
+static void render_allocator(TextBuffer* text)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    append(text, "# allocator (glibc malloc)\n");
+    append(text, "cardio_malloc_bytes{kind=\"arena\"} %zu\n", info.arena);
+    append(text, "cardio_malloc_bytes{kind=\"mmap\"} %zu\n", info.hblkhd);
+    append(text, "cardio_malloc_bytes{kind=\"in_use\"} %zu\n", info.uordblks);
+    append(text, "cardio_malloc_bytes{kind=\"free\"} %zu\n", info.fordblks);
+    append(text, "cardio_malloc_bytes{kind=\"releasable\"} %zu\n", info.keepcost);
+    append(text, "cardio_malloc_chunks{kind=\"free\"} %zu\n", info.ordblks);
+    append(text, "cardio_malloc_chunks{kind=\"mmap\"} %zu\n", info.hblks);
+#else
+    (void) text;
+#endif
+}
+
+size_t admin_render(TableList* table_list, char** out)
+{
+    TextBuffer text = {0};
+    text.capacity = 16384;
+    text.data = malloc(text.capacity);
+    if (text.data == NULL)
+    {
+        return 0;
+    }
+
+    uint64_t now = metrics_now_ns();
+    append(&text, "# Cardio admin snapshot\n");
+    append(&text, "cardio_uptime_seconds %llu\n",
+           (unsigned long long) (started_ns ? (now - started_ns) / 1000000000ull : 0));
+    render_metrics(&text);
+    render_state(&text, table_list);
+    render_allocator(&text);
+    append(&text, "# EOF\n");
+
+    if (text.failed)
+    {
+        free(text.data);
+        return 0;
+    }
+    *out = text.data;
+    return text.len;
+}
+
+// ===== Socket =====
+
+int admin_init(const char* path)
+{
+    if (path == NULL)
+    {
+        path = getenv("CARDIO_ADMIN_SOCKET");
+    }
+    if (path == NULL || path[0] == '\0')
+    {
+        path = ADMIN_SOCKET_PATH;
+    }
+    if (strlen(path) >= sizeof(socket_path))
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Admin socket path is too long", 1);
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot create admin socket", 1);
+        return -1;
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // A socket file left by a previous run would make bind fail
+    unlink(path);
+    if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) == -1 || chmod(path, 0600) == -1 ||
+        listen(fd, ADMIN_MAX_ACCEPTS) == -1 || set_nonblocking(fd) == -1)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Cannot listen on admin socket %s: %s", path, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        close(fd);
+        return -1;
+    }
+
+    strcpy(socket_path, path);
+    admin_fd = fd;
+    started_ns = metrics_now_ns();
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Admin socket listening on %s", path);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    return fd;
+}
+
+void admin_accept(int listen_fd, TableList* table_list)
+{
+    for (int i = 0; i < ADMIN_MAX_ACCEPTS; i++)
+    {
+        int client_fd = accept(listen_fd, NULL, NULL);
+        if (client_fd == -1)
+        {
+            return; // EAGAIN: nobody else is waiting
+        }
+
+        // Never wait on a slow reader: the snapshot goes into the socket buffer in one nonblocking send
+        int buffer_size = ADMIN_SEND_BUFFER;
+        setsockopt(client_fd, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+        set_nonblocking(client_fd);
+
+        char* snapshot = NULL;
+        size_t len = admin_render(table_list, &snapshot);
+        if (len > 0)
+        {
+            ssize_t sent = send(client_fd, snapshot, len, MSG_NOSIGNAL);
+            if (sent < (ssize_t) len)
+            {
+                char log_msg[256];
+                snprintf(log_msg, sizeof(log_msg), "Admin snapshot cut short: %zd of %zu bytes sent", sent, len);
+                logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+            }
+            free(snapshot);
+        }
+        close(client_fd);
+    }
+}
+
+void admin_shutdown(void)
+{
+    if (admin_fd != -1)
+    {
+        close(admin_fd);
+        unlink(socket_path);
+        admin_fd = -1;
+    }
+}
@@ -0,0 +1,250 @@
+#include "main.h"
+#include <stdint.h>
+
+// A decision request. Everything the worker needs is copied in, so workers never read live table state.
+typedef struct BotJob
+{
+    uint64_t ticket;      // Matches Table.bot_ticket while the decision is still wanted
+    int table_id;
+    uint32_t hand_id;
+    uint32_t seq;
+    int seat;
+    Card hole[2];
+    Card board[MAX_COMMUNITY_CARDS];
+    int num_board;
+    int num_opponents;
+    int pot;              // Pot plus all bets on the table
+    int to_call;
+    int stack;
+    int bet;
+    int current_bet;
+    int min_raise;
+    int big_blind;
+    uint64_t deadline_ms;
+    uint64_t rng_state;
+
+    // Filled in by the worker
+    Action action;
+    double equity;
+    int samples;
+
+    TableActor* actor;    // Referenced until the decision is posted to it
+    TableCommand command; // Posted to the table's mailbox once decided
+} BotJob;
+
+static JobPool* bot_jobs = NULL;
+static uint64_t bot_next_ticket = 1;
+
+// Cheap strength estimate used when the budget ran out before any equity sample was taken
+static double bot_quick_strength(const BotJob* job)
+{
+    if (job->num_board >= 3) {
+        Card cards[7];
+        cards[0] = job->hole[0];
+        cards[1] = job->hole[1];
+        memcpy(&cards[2], job->board, job->num_board * sizeof(Card));
+        int category = HAND_VALUE_CATEGORY(game_evaluate_hand(cards, 2 + job->num_board));
+        double strength = 0.25 + 0.12 * category;
+        return strength > 0.95 ? 0.95 : strength;
+    }
+
+    int r0 = job->hole[0].rank == 1 ? 14 : job->hole[0].rank;
+    int r1 = job->hole[1].rank == 1 ? 14 : job->hole[1].rank;
+    if (r0 == r1) return 0.5 + r0 / 40.0;
+    double strength = (r0 + r1) / 32.0;
+    if (job->hole[0].suit == job->hole[1].suit) strength += 0.04;
+    return strength;
+}
+
+// Turn an equity estimate into a legal-looking action. Final legality is checked again on the loop thread.
+static Action bot_choose_action(BotJob* job)
+{
+    Action action = {0};
+    double equity = job->equity;
+    double roll = (double)(game_random(&job->rng_state) % 1000) / 1000.0;
+    double pot_odds = job->to_call > 0 ? (double)job->to_call / (double)(job->pot + job->to_call) : 0.0;
+
+    // Pressure scales with strength: half pot for good hands, three quarters for very strong ones
+    int size = (int)(job->pot * (equity >= 0.8 ? 0.75 : 0.5));
+    if (size < job->big_blind) size = job->big_blind;
+
+    bool wants_to_bet = equity >= 0.65 || (equity >= 0.45 && roll < 0.10);
+
+    if (job->to_call <= 0) {
+        if (!wants_to_bet) {
+            action.type = ACTION_CHECK;
+        } else if (job->current_bet == 0) {
+            action.type = size >= job->stack ? ACTION_ALL_IN : ACTION_BET;
+            action.amount = size;
+        } else {
+            // Big blind option preflop: nothing to call but a bet is live, so this is a raise
+            int raise_by = size > job->min_raise ? size : job->min_raise;
+            int target = job->current_bet + raise_by;
+            action.type = target >= job->stack + job->bet ? ACTION_ALL_IN : ACTION_RAISE;
+            action.amount = target;
+        }
+        return action;
+    }
+
+    if (equity >= 0.8) {
+        int raise_by = size > job->min_raise ? size : job->min_raise;
+        int target = job->current_bet + raise_by;
+        action.type = target >= job->stack + job->bet ? ACTION_ALL_IN : ACTION_RAISE;
+        action.amount = target;
+    } else if (equity >= pot_odds + 0.05) {
+        action.type = ACTION_CALL;
+    } else {
+        action.type = ACTION_FOLD;
+    }
+    return action;
+}
+
+static void bot_decide(BotJob* job)
+{
+    job->equity = game_estimate_equity(job->hole, job->board, job->num_board, job->num_opponents, BOT_MAX_SAMPLES,
+                                       job->deadline_ms, &job->rng_state, &job->samples);
+    if (job->equity < 0) {
+        job->equity = bot_quick_strength(job);
+    }
+    job->action = bot_choose_action(job);
+}
+
+// Runs on a job pool worker
+static void bot_run_job(void* arg)
+{
+    BotJob* job = arg;
+    uint64_t started_ns = metrics_now_ns();
+    bot_decide(job);
+    metrics_record(METRIC_LATENCY_BOT_DECISION, metrics_now_ns() - started_ns);
+
+    // The job now belongs to the mailbox and may be freed at any moment
+    TableActor* actor = job->actor;
+    job->command.type = TABLE_CMD_BOT_DECISION;
+    job->command.job = job;
+    table_actor_post(actor, &job->command);
+    table_actor_release(actor);
+}
+
+int bot_init(JobPool* pool)
+{
+    if (!pool) return -1;
+    bot_jobs = pool;
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Bot decisions run on the job pool (%d workers)", job_pool_workers(pool));
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    return 0;
+}
+
+int bot_queue_depth(void)
+{
+    return bot_jobs ? job_pool_pending(bot_jobs, JOB_PRIORITY_HIGH) : 0;
+}
+
+int bot_schedule_decision(Table* table)
+{
+    if (!bot_jobs || !table || !table->game_state || !table->actor) return -1;
+
+    GameState* gs = table->game_state;
+    if (gs->active_seat < 0 || gs->active_seat >= MAX_PLAYERS) return -1;
+
+    GamePlayer* bot = &gs->players[gs->active_seat];
+    if (!bot->is_bot || bot->state != PLAYER_STATE_ACTIVE) return -1;
+    if (table->bot_ticket != 0) return 0;
+
+    BotJob* job = calloc(1, sizeof(BotJob));
+    if (!job) return -1;
+
+    job->ticket = bot_next_ticket++;
+    job->table_id = table->id;
+    job->hand_id = gs->hand_id;
+    job->seq = gs->seq;
+    job->seat = gs->active_seat;
+    for (int i = 0; i < 2; i++) {
+        if (bot->hole_cards[i]) job->hole[i] = *bot->hole_cards[i];
+    }
+    for (int i = 0; i < gs->num_community_cards && i < MAX_COMMUNITY_CARDS; i++) {
+        if (gs->community_cards[i]) job->board[job->num_board++] = *gs->community_cards[i];
+    }
+
+    job->pot = game_get_pot_total(gs);
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        GamePlayer* p = &gs->players[i];
+        if (p->state == PLAYER_STATE_EMPTY) continue;
+        job->pot += p->bet;
+        if (i != job->seat && (p->state == PLAYER_STATE_ACTIVE || p->state == PLAYER_STATE_ALL_IN)) {
+            job->num_opponents++;
+        }
+    }
+    job->to_call = gs->current_bet - bot->bet;
+    job->stack = bot->money;
+    job->bet = bot->bet;
+    job->current_bet = gs->current_bet;
+    job->min_raise = gs->min_raise;
+    job->big_blind = gs->big_blind;
+    job->deadline_ms = game_now_ms() + BOT_DECISION_BUDGET_MS;
+    job->rng_state = ((uint64_t) rand() << 32) ^ (uint64_t) rand() ^ job->ticket;
+
+    job->actor = table->actor;
+    table_actor_retain(job->actor);
+
+    // A player is waiting on this turn, so it goes ahead of background work
+    if (job_submit(bot_jobs, JOB_PRIORITY_HIGH, bot_run_job, NULL, job, NULL) != 0) {
+        table_actor_release(job->actor);
+        free(job);
+        return -1;
+    }
+    table->bot_ticket = job->ticket;
+
+    return 1;
+}
+
+bool bot_apply_decision(Table* table, const BotJob* job)
+{
+    char log_msg[256];
+
+    if (table->bot_ticket != job->ticket) return false; // Superseded
+    table->bot_ticket = 0;
+
+    GameState* gs = table->game_state;
+    if (!gs || !gs->hand_in_progress || gs->hand_id != job->hand_id || gs->seq != job->seq ||
+        gs->active_seat != job->seat) {
+        return false; // The hand moved on without us
+    }
+
+    GamePlayer* bot = &gs->players[job->seat];
+    if (!bot->is_bot || bot->state != PLAYER_STATE_ACTIVE) return false;
+
+    Action action = job->action;
+    if (!game_validate_action(gs, bot->player_id, &action).is_valid) {
+        action.type = (gs->current_bet - bot->bet) > 0 ? ACTION_FOLD : ACTION_CHECK;
+        action.amount = 0;
+    }
+
+    snprintf(log_msg, sizeof(log_msg), "Bot at seat %d table %d: action=%d amount=%d equity=%.2f samples=%d",
+             job->seat, table->id, action.type, action.amount, job->equity, job->samples);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    int player_id = bot->player_id;
+    int total_bet_before = bot->total_bet;
+    BettingRound round = gs->betting_round;
+    int result = game_process_action(gs, player_id, &action);
+    if (result != 0) {
+        snprintf(log_msg, sizeof(log_msg), "Bot action failed: result=%d", result);
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        return false;
+    }
+
+    ActionRecord record = {
+        .seq = gs->seq,
+        .seat = job->seat,
+        .player_id = player_id,
+        .type = action.type,
+        .amount = gs->players[job->seat].total_bet - total_bet_before,
+        .round = round,
+    };
+    table_record_action(table, &record);
+    journal_action(table, job->seat, &action);
+    table->active_seat = gs->active_seat;
+    return true;
+}
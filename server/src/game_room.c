@@ -18,9 +18,8 @@ TableList* init_table_list(size_t capacity)
     table_list->capacity = capacity;
     return table_list;
 }
-int add_table(TableList* table_list, char* table_name, int max_player, int min_bet)
+static int init_table(TableList* table_list, int id, char* table_name, int max_player, int min_bet)
 {
-
     if (table_list->size == table_list->capacity)
     {
         TableList* new_table_list = realloc(table_list->tables, 2 * table_list->capacity * sizeof(Table));
@@ -33,11 +32,6 @@ int add_table(TableList* table_list, char* table_name, int max_player, int min_b
         table_list->capacity *= 2;
     }
 
-    int id = table_list->size + 1;
-    while (find_table_by_id(table_list, id) != -1)
-    {
-        id++;
-    }
     table_list->tables[table_list->size].id = id;
     strncpy(table_list->tables[table_list->size].name, table_name, 32);
     table_list->tables[table_list->size].max_player = max_player;
@@ -48,20 +42,60 @@ int add_table(TableList* table_list, char* table_name, int max_player, int min_b
     int small_blind = min_bet / 2;
     int big_blind = min_bet;
     table_list->tables[table_list->size].game_state = game_state_create(id, max_player, small_blind, big_blind);
+    replay_log_table(&table_list->tables[table_list->size]);
     
     // Initialize connection tracking
     for (int i = 0; i < MAX_PLAYERS; i++) {
         table_list->tables[table_list->size].connections[i] = NULL;
         table_list->tables[table_list->size].seat_to_conn_idx[i] = -1;
+        table_list->tables[table_list->size].hand_start_stacks[i] = -1;
+        table_list->tables[table_list->size].hand_flags[i] = 0;
     }
     
     // Initialize game tracking fields
     table_list->tables[table_list->size].active_seat = -1;
     table_list->tables[table_list->size].game_started = false;
+    table_list->tables[table_list->size].bot_ticket = 0;
+    table_list->tables[table_list->size].num_pending_actions = 0;
+    memset(table_list->tables[table_list->size].history, 0, sizeof(table_list->tables[table_list->size].history));
+    table_list->tables[table_list->size].journal_hand = NULL;
+    
+    // Actions and bot decisions for this table are queued here and applied by its owner
+    table_list->tables[table_list->size].actor = table_actor_create(id);
+    if (table_list->tables[table_list->size].actor == NULL)
+    {
+        logger(MAIN_LOG, "Error", "add_table: Cannot allocate table actor");
+        game_state_destroy(table_list->tables[table_list->size].game_state);
+        return -1;
+    }
     
     table_list->size++;
+    metrics_add(METRIC_TABLES_CREATED, 1);
+    lobby_table_added(&table_list->tables[table_list->size - 1]);
     return id;
 }
+int add_table(TableList* table_list, char* table_name, int max_player, int min_bet)
+{
+    int id = table_list->size + 1;
+    while (find_table_by_id(table_list, id) != -1)
+    {
+        id++;
+    }
+    if (init_table(table_list, id, table_name, max_player, min_bet) == -1)
+    {
+        return -1;
+    }
+    journal_table_created(&table_list->tables[table_list->size - 1]);
+    return id;
+}
+int restore_table(TableList* table_list, int id, char* table_name, int max_player, int min_bet)
+{
+    if (id <= 0 || find_table_by_id(table_list, id) != -1)
+    {
+        return -1;
+    }
+    return init_table(table_list, id, table_name, max_player, min_bet);
+}
 int find_table_by_id(TableList* table_list, int id)
 {
     for (int i = 0; i < table_list->size; i++)
@@ -80,11 +114,17 @@ int remove_table(TableList* table_list, int id)
     {
         return -1;
     }
+    journal_table_removed(&table_list->tables[index]);
+    // Queued commands for the table are dropped once nothing else holds the actor
+    table_actor_release(table_list->tables[index].actor);
     for (int i = index; i < table_list->size - 1; i++)
     {
         table_list->tables[i] = table_list->tables[i + 1];
     }
     table_list->size--;
+    metrics_add(METRIC_TABLES_REMOVED, 1);
+    lobby_table_removed(id);
+    spectator_table_removed(id);
     return 0;
 }
 int join_table(conn_data_t* conn_data, TableList* table_list, int table_id)
@@ -130,17 +170,18 @@ int join_table(conn_data_t* conn_data, TableList* table_list, int table_id)
     }
     
     // Deduct buy-in from database balance
-    PGconn* db_conn = PQconnectdb(dbconninfo);
+    PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
     if (PQstatus(db_conn) == CONNECTION_OK) {
-        int db_result = dbAddToBalance(db_conn, conn_data->user_id, -buy_in);
+        int db_result = METRICS_DB_QUERY(dbAddToBalance(db_conn, conn_data->user_id, -buy_in));
         if (db_result != DB_OK) {
             logger(MAIN_LOG, "Error", "join_table: Failed to deduct buy-in from database");
             PQfinish(db_conn);
             return -5;
         }
+        leaderboard_add_balance(conn_data->user_id, -buy_in);
         
         // Get updated balance from database to ensure consistency
-        int new_balance = dbGetBalance(db_conn, conn_data->user_id);
+        int new_balance = METRICS_DB_QUERY(dbGetBalance(db_conn, conn_data->user_id));
         if (new_balance >= 0) {
             conn_data->balance = new_balance;
             char log_msg[256];
@@ -173,9 +214,11 @@ int join_table(conn_data_t* conn_data, TableList* table_list, int table_id)
     if (result != 0) {
         logger(MAIN_LOG, "Error", "join_table: Failed to add player to game state");
         // Refund the buy-in if player add failed
-        db_conn = PQconnectdb(dbconninfo);
+        db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
         if (PQstatus(db_conn) == CONNECTION_OK) {
-            dbAddToBalance(db_conn, conn_data->user_id, buy_in);
+            if (METRICS_DB_QUERY(dbAddToBalance(db_conn, conn_data->user_id, buy_in)) == DB_OK) {
+                leaderboard_add_balance(conn_data->user_id, buy_in);
+            }
             conn_data->balance += buy_in;
             PQfinish(db_conn);
         }
@@ -186,9 +229,13 @@ int join_table(conn_data_t* conn_data, TableList* table_list, int table_id)
     table->connections[table->current_player] = conn_data;
     table->seat_to_conn_idx[seat] = table->current_player;
     table->current_player++;
+    journal_seat(table, seat);
+    lobby_table_seats_changed(table);
+    spectator_remove(conn_data->fd);
     
     conn_data->table_id = table_id;
     conn_data->seat = seat;
+    presence_refresh(conn_data);
 
     char msg[256];
     sprintf(msg, "join_table: Player %s (id=%d) joined table %d at seat %d", 
@@ -248,10 +295,11 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
         // Return chips to database immediately when player leaves
         // Bot will continue playing with the table's copy of chips
         if (player && player->money > 0) {
-            PGconn* db_conn = PQconnectdb(dbconninfo);
+            PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
             if (PQstatus(db_conn) == CONNECTION_OK) {
-                int db_result = dbAddToBalance(db_conn, conn_data->user_id, player->money);
+                int db_result = METRICS_DB_QUERY(dbAddToBalance(db_conn, conn_data->user_id, player->money));
                 if (db_result == DB_OK) {
+                    leaderboard_add_balance(conn_data->user_id, player->money);
                     snprintf(log_msg, sizeof(log_msg), 
                             "Player %s leaving - returned %d chips to database (user_id=%d)", 
                             conn_data->username, player->money, conn_data->user_id);
@@ -278,6 +326,7 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
         if (bot_player) {
             bot_player->original_user_id = 0;
         }
+        journal_seat(table, player_seat);
         
         // Remove from connection tracking and compact array
         int conn_idx = table->seat_to_conn_idx[conn_data->seat];
@@ -302,6 +351,7 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
         // Clear user's table assignment
         conn_data->table_id = 0;
         conn_data->seat = -1;
+        presence_refresh(conn_data);
         
         snprintf(log_msg, sizeof(log_msg), 
                 "leave_table: Player converted to bot, will be removed after hand completes");
@@ -333,13 +383,14 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
         // Return remaining chips to player's database balance
         GamePlayer* player = game_get_player_by_seat(table->game_state, conn_data->seat);
         if (player && player->money > 0) {
-            PGconn* db_conn = PQconnectdb(dbconninfo);
+            PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
             if (PQstatus(db_conn) == CONNECTION_OK) {
                 // Return the player's remaining table chips to database
-                int result = dbAddToBalance(db_conn, conn_data->user_id, player->money);
+                int result = METRICS_DB_QUERY(dbAddToBalance(db_conn, conn_data->user_id, player->money));
                 if (result == DB_OK) {
+                    leaderboard_add_balance(conn_data->user_id, player->money);
                     // Get the updated total balance from database
-                    int new_balance = dbGetBalance(db_conn, conn_data->user_id);
+                    int new_balance = METRICS_DB_QUERY(dbGetBalance(db_conn, conn_data->user_id));
                     if (new_balance >= 0) {
                         conn_data->balance = new_balance;
                         char log_msg[256];
@@ -373,9 +424,9 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
             }
         } else {
             // Player has no chips left, just update their balance from database to be sure
-            PGconn* db_conn = PQconnectdb(dbconninfo);
+            PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
             if (PQstatus(db_conn) == CONNECTION_OK) {
-                int new_balance = dbGetBalance(db_conn, conn_data->user_id);
+                int new_balance = METRICS_DB_QUERY(dbGetBalance(db_conn, conn_data->user_id));
                 if (new_balance >= 0) {
                     conn_data->balance = new_balance;
                     char log_msg[256];
@@ -407,6 +458,7 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
         logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
         
         game_remove_player(table->game_state, conn_data->seat);
+        journal_seat(table, conn_data->seat);
         
         // Remove from connection tracking and compact array (same as bot path)
         int conn_idx = table->seat_to_conn_idx[conn_data->seat];
@@ -435,6 +487,7 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
         }
     }
     
+    lobby_table_seats_changed(table);
     snprintf(log_msg, sizeof(log_msg), 
             "leave_table: Player count is now %d", table->current_player);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
@@ -500,6 +553,7 @@ int leave_table(conn_data_t* conn_data, TableList* table_list)
     
     conn_data->table_id = 0;
     conn_data->seat = -1;
+    presence_refresh(conn_data);
     
     snprintf(log_msg, sizeof(log_msg), 
             "leave_table: SUCCESS - Cleared user's table_id and seat (now table_id=%d seat=%d)", 
@@ -516,9 +570,12 @@ void free_table_list(TableList* table_list)
         if (table_list->tables[i].game_state) {
             game_state_destroy(table_list->tables[i].game_state);
         }
+        spectator_table_removed(table_list->tables[i].id);
+        table_actor_release(table_list->tables[i].actor);
     }
     free(table_list->tables);
     free(table_list);
+    lobby_cache_free();
 }
 
 // Broadcast a message to all players at a table
@@ -545,7 +602,76 @@ void broadcast_to_table(int table_id, TableList* table_list, char* data, int len
     }
 }
 
+// Queue an automatic action for the next broadcast instead of sending a frame per action.
+// A full queue is flushed first so no action is ever dropped.
+void table_record_action(Table* table, const ActionRecord* record)
+{
+    if (!table || !record) {
+        return;
+    }
+    
+    if (table->num_pending_actions >= TABLE_MAX_PENDING_ACTIONS) {
+        broadcast_game_state_to_table(table);
+    }
+    table->pending_actions[table->num_pending_actions++] = *record;
+    table_remember_action(table, record);
+}
+
+// Keep an applied action for clients that resume mid-hand. GameState.seq restarts at every hand and
+// grows by one per action, so the slot follows from seq and older hands are simply overwritten.
+void table_remember_action(Table* table, const ActionRecord* record)
+{
+    if (!table || !record || record->seq == 0) {
+        return;
+    }
+    table->history[(record->seq - 1) % TABLE_HISTORY_ACTIONS] = *record;
+    history_action(table, record);
+}
+
+// Bring a resumed client up to date. If it last saw this hand at seq and the history still holds every
+// action since, it gets those actions in one UPDATE_BUNDLE; otherwise a plain UPDATE_GAMESTATE.
+void table_send_catch_up(Table* table, conn_data_t* conn_data, uint32_t hand_id, uint32_t seq)
+{
+    if (!table || !table->game_state || !conn_data) {
+        return;
+    }
+    
+    GameState* gs = table->game_state;
+    ActionRecord missed[TABLE_HISTORY_ACTIONS];
+    int num_missed = 0;
+    bool covered = hand_id == gs->hand_id && seq <= gs->seq && gs->seq - seq <= TABLE_HISTORY_ACTIONS;
+    for (uint32_t s = seq + 1; covered && s <= gs->seq; s++) {
+        const ActionRecord* record = &table->history[(s - 1) % TABLE_HISTORY_ACTIONS];
+        covered = record->seq == s;
+        missed[num_missed++] = *record;
+    }
+    if (!covered) {
+        num_missed = 0;
+    }
+    
+    RawBytes* state = encode_game_state_with_actions(gs, conn_data->user_id, missed, num_missed);
+    if (!state) {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Failed to encode game state", 1);
+        return;
+    }
+    uint16_t packet_type = num_missed > 0 ? PACKET_UPDATE_BUNDLE : PACKET_UPDATE_GAMESTATE;
+    RawBytes* packet = encode_packet(PROTOCOL_V1, packet_type, state->data, state->len);
+    if (packet) {
+        sendall(conn_data->fd, packet->data, (int*)&packet->len);
+        free(packet->data);
+        free(packet);
+    }
+    
+    char msg[256];
+    snprintf(msg, sizeof(msg), "Catch-up for user_id=%u at table %d: client at hand=%u seq=%u, table at hand=%u seq=%u, %d missed actions",
+             conn_data->user_id, table->id, hand_id, seq, gs->hand_id, gs->seq, num_missed);
+    logger_ex(MAIN_LOG, "INFO", __func__, msg, 1);
+    free(state->data);
+    free(state);
+}
+
 // Broadcast game state to all players at a table
+// Pending automatic actions are sent along as one UPDATE_BUNDLE, otherwise a plain UPDATE_GAMESTATE
 // Returns the number of successful broadcasts
 int broadcast_game_state_to_table(Table* table)
 {
@@ -554,13 +680,16 @@ int broadcast_game_state_to_table(Table* table)
         return -1;
     }
     
+    uint64_t started_ns = metrics_now_ns();
     GameState* gs = table->game_state;
     int successful_broadcasts = 0;
     int failed_broadcasts = 0;
+    int num_actions = table->num_pending_actions;
+    uint16_t packet_type = num_actions > 0 ? PACKET_UPDATE_BUNDLE : PACKET_UPDATE_GAMESTATE;
     
     char msg[256];
-    snprintf(msg, sizeof(msg), "Broadcasting game state (hand=%u, seq=%u) to %d players at table %d", 
-             gs->hand_id, gs->seq, table->current_player, table->id);
+    snprintf(msg, sizeof(msg), "Broadcasting game state (hand=%u, seq=%u, actions=%d) to %d players at table %d", 
+             gs->hand_id, gs->seq, num_actions, table->current_player, table->id);
     logger(MAIN_LOG, "Info", msg);
     
     for (int i = 0; i < table->current_player; i++) {
@@ -573,7 +702,8 @@ int broadcast_game_state_to_table(Table* table)
         conn_data_t* conn = table->connections[i];
         
         // Encode game state for this specific player
-        RawBytes* game_state_data = encode_game_state(gs, conn->user_id);
+        RawBytes* game_state_data = encode_game_state_with_actions(gs, conn->user_id, table->pending_actions,
+                                                                   num_actions);
         if (!game_state_data) {
             snprintf(msg, sizeof(msg), "Failed to encode game state for user_id=%d fd=%d", 
                      conn->user_id, conn->fd);
@@ -583,7 +713,7 @@ int broadcast_game_state_to_table(Table* table)
         }
         
         // Wrap in packet
-        RawBytes* broadcast_packet = encode_packet(PROTOCOL_V1, PACKET_UPDATE_GAMESTATE, 
+        RawBytes* broadcast_packet = encode_packet(PROTOCOL_V1, packet_type, 
                                                    game_state_data->data, game_state_data->len);
         if (!broadcast_packet) {
             snprintf(msg, sizeof(msg), "Failed to encode packet for user_id=%d fd=%d", 
@@ -618,6 +748,10 @@ int broadcast_game_state_to_table(Table* table)
         free(game_state_data);
     }
     
+    // Every viewer has seen the coalesced actions now
+    table->num_pending_actions = 0;
+    spectator_state_changed(table);
+    
     if (failed_broadcasts > 0) {
         snprintf(msg, sizeof(msg), "Broadcast complete: %d successful, %d failed", 
                  successful_broadcasts, failed_broadcasts);
@@ -627,6 +761,7 @@ int broadcast_game_state_to_table(Table* table)
         logger(MAIN_LOG, "Info", msg);
     }
     
+    metrics_record(METRIC_LATENCY_BROADCAST, metrics_now_ns() - started_ns);
     return successful_broadcasts;
 }
 
@@ -655,10 +790,11 @@ void start_game_if_ready(Table* table)
                 
                 // Return remaining chips to original player who disconnected
                 if (p->money > 0 && p->original_user_id > 0) {
-                    PGconn* db_conn = PQconnectdb(dbconninfo);
+                    PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
                     if (PQstatus(db_conn) == CONNECTION_OK) {
-                        int result = dbAddToBalance(db_conn, p->original_user_id, p->money);
+                        int result = METRICS_DB_QUERY(dbAddToBalance(db_conn, p->original_user_id, p->money));
                         if (result == DB_OK) {
+                            leaderboard_add_balance(p->original_user_id, p->money);
                             snprintf(msg, sizeof(msg), 
                                     "Returned %d chips from bot to user_id=%d", 
                                     p->money, p->original_user_id);
@@ -669,6 +805,7 @@ void start_game_if_ready(Table* table)
                 }
                 
                 game_remove_player(gs, i);
+                journal_seat(table, i);
             }
             // Remove players with no money
             else if (p->money <= 0) {
@@ -676,6 +813,7 @@ void start_game_if_ready(Table* table)
                          p->name, i, p->money);
                 logger(MAIN_LOG, "Info", msg);
                 game_remove_player(gs, i);
+                journal_seat(table, i);
                 
                 // Remove from connection tracking and compact array
                 int conn_idx = table->seat_to_conn_idx[i];
@@ -683,6 +821,7 @@ void start_game_if_ready(Table* table)
                     if (table->connections[conn_idx] != NULL) {
                         table->connections[conn_idx]->table_id = 0;
                         table->connections[conn_idx]->seat = -1;
+                        presence_refresh(table->connections[conn_idx]);
                     }
                     
                     // Shift connections down
@@ -695,6 +834,7 @@ void start_game_if_ready(Table* table)
                     table->connections[table->current_player - 1] = NULL;
                     table->seat_to_conn_idx[i] = -1;
                     table->current_player--;
+                    lobby_table_seats_changed(table);
                 }
             }
         }
@@ -722,6 +862,8 @@ void start_game_if_ready(Table* table)
              gs->hand_id + 1, table->id, active_count);
     logger(MAIN_LOG, "Info", msg);
     
+    journal_hand_start(table);
+    history_hand_start(table);
     int result = game_start_hand(gs);
     if (result != 0) {
         snprintf(msg, sizeof(msg), "start_game_if_ready: Failed to start hand (result=%d) at table %d", 
@@ -1,12 +1,12 @@
 #include "main.h"
 
-void handle_login_request(conn_data_t* conn_data, char* data, size_t data_len)
+void handle_login_request(int epoll_fd, conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
 {
     char log_msg[256];
     snprintf(log_msg, sizeof(log_msg), "Login request from fd=%d, data_len=%zu", conn_data->fd, data_len);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
     
-    PGconn* conn = PQconnectdb(dbconninfo);
+    PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
     Packet* packet = decode_packet(data, data_len);
     if (packet->header->packet_type != 100)
     {
@@ -22,32 +22,69 @@ void handle_login_request(conn_data_t* conn_data, char* data, size_t data_len)
     snprintf(log_msg, sizeof(log_msg), "Attempting login for user='%s'", login_request->username);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
     
-    int user_id = dbLogin(conn, login_request->username, login_request->password);
+    int user_id = METRICS_DB_QUERY(dbLogin(conn, login_request->username, login_request->password));
     snprintf(log_msg, sizeof(log_msg), "dbLogin returned user_id=%d for user='%s'", user_id, login_request->username);
     logger_ex(MAIN_LOG, "DEBUG", __func__, log_msg, 1);
     
     if (user_id > 0)
     {
-        struct dbUser user_info = dbGetUserInfo(conn, user_id);
+        struct dbUser user_info = METRICS_DB_QUERY(dbGetUserInfo(conn, user_id));
         snprintf(log_msg, sizeof(log_msg), "dbGetUserInfo returned: user_id=%d username='%s' balance=%d", 
                  user_info.user_id, user_info.username, user_info.balance);
         logger_ex(MAIN_LOG, "DEBUG", __func__, log_msg, 1);
         
-        RawBytes* raw_bytes = encode_login_success_response(&user_info);
-        RawBytes* response = encode_packet(PROTOCOL_V1, 100, raw_bytes->data, raw_bytes->len);
-        sendall(conn_data->fd, response->data, (int*) &(response->len));
+        // A seat still held for this user (a dropped socket, or a restart replayed from the journal) is
+        // taken back the way PACKET_RESUME would: the socket moves onto the parked connection
+        char session_token[SESSION_TOKEN_LEN + 1];
+        conn_data_t* parked = conn_data->user_id == 0 ? session_find_parked((unsigned int) user_id) : NULL;
+        if (parked != NULL && session_issue(parked, session_token) == 0 &&
+            resume_connection(epoll_fd, conn_data, parked) == 0)
+        {
+            conn_data = parked;
+        }
+        else
+        {
+            parked = NULL;
+        }
 
+        if (parked == NULL && conn_data->user_id != 0)
+        {
+            unregister_connection(conn_data);
+        }
+        if (conn_data->social_ref && conn_data->user_id != (unsigned int) user_id)
+        {
+            social_cache_release(conn_data->user_id);
+            conn_data->social_ref = false;
+        }
         strncpy(conn_data->username, user_info.username, 32);
         conn_data->username[31] = '\0';
         conn_data->user_id = user_id;
         conn_data->is_active = true;
         conn_data->balance = user_info.balance;
+        leaderboard_set_balance(user_id, user_info.balance);
         
         // Register connection in global map after successful login
         register_connection(conn_data);
 
+        // Friends and invites are served from memory while the user is online. Every connection holds
+        // one reference; one restored from the journal takes its reference here.
+        if (!conn_data->social_ref)
+        {
+            conn_data->social_ref = social_cache_load(conn, user_id) == 0;
+            if (!conn_data->social_ref)
+            {
+                logger_ex(MAIN_LOG, "WARN", __func__, "Failed to load friends and invites, serving them from database", 1);
+            }
+        }
+
         PQfinish(conn);
 
+        // The token lets a dropped client take this connection back with PACKET_RESUME
+        bool has_token = parked != NULL || session_issue(conn_data, session_token) == 0;
+        RawBytes* raw_bytes = encode_login_success_response(&user_info, has_token ? session_token : NULL);
+        RawBytes* response = encode_packet(PROTOCOL_V1, 100, raw_bytes->data, raw_bytes->len);
+        sendall(conn_data->fd, response->data, (int*) &(response->len));
+
         free(response->data);
         free(response);
         free(raw_bytes->data);
@@ -57,6 +94,12 @@ void handle_login_request(conn_data_t* conn_data, char* data, size_t data_len)
         snprintf(log_msg, sizeof(log_msg), "Login SUCCESS: user='%s' (id=%d) fd=%d balance=%d", 
                  user_info.username, user_id, conn_data->fd, user_info.balance);
         logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+        int index = parked != NULL && conn_data->table_id > 0 ? find_table_by_id(table_list, conn_data->table_id) : -1;
+        if (index != -1)
+        {
+            table_send_catch_up(&table_list->tables[index], conn_data, 0, 0);
+        }
         return;
     }
 
@@ -78,66 +121,75 @@ void handle_login_request(conn_data_t* conn_data, char* data, size_t data_len)
     free(login_request);
 }
 
-// Helper function to process bot actions automatically
-void process_bot_actions(Table* table) {
-    if (!table || !table->game_state) return;
-    
-    GameState* gs = table->game_state;
+// Move this socket onto the session named by the token instead of logging in again: no password check,
+// no database. The client then gets the actions it missed at its table, or the full state if too many.
+void handle_resume_request(int epoll_fd, conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
+{
     char log_msg[256];
-    
-    // Keep processing while the active player is a bot
-    int max_iterations = 10; // Prevent infinite loops
-    int iterations = 0;
-    
-    while (iterations < max_iterations && 
-           gs->active_seat >= 0 && 
-           gs->betting_round != BETTING_ROUND_COMPLETE) {
-        
-        GamePlayer* active_player = &gs->players[gs->active_seat];
-        
-        if (!active_player || active_player->state != PLAYER_STATE_ACTIVE || !active_player->is_bot) {
-            // Active player is not a bot, stop
-            break;
-        }
-        
-        snprintf(log_msg, sizeof(log_msg), "Bot '%s' at seat %d is active - processing auto-action (iteration %d)", 
-                 active_player->name, gs->active_seat, iterations + 1);
-        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-        
-        // Bot logic: check if possible, otherwise fold
-        Action bot_action = {0};
-        int amount_to_call = gs->current_bet - active_player->bet;
-        
-        if (amount_to_call == 0) {
-            // No bet to call - check
-            bot_action.type = ACTION_CHECK;
-            snprintf(log_msg, sizeof(log_msg), "Bot checking");
-            logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-        } else {
-            // There's a bet - fold
-            bot_action.type = ACTION_FOLD;
-            snprintf(log_msg, sizeof(log_msg), "Bot folding (bet=%d)", amount_to_call);
-            logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-        }
-        
-        // Process bot action
-        int bot_result = game_process_action(gs, active_player->player_id, &bot_action);
-        if (bot_result != 0) {
-            snprintf(log_msg, sizeof(log_msg), "Bot action failed: result=%d", bot_result);
-            logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
-            break;
-        }
-        
-        // Broadcast updated state after bot action
-        broadcast_game_state_to_table(table);
-        table->active_seat = gs->active_seat;
-        
-        iterations++;
+    Packet* packet = decode_packet(data, data_len);
+    if (!packet || packet->header->packet_type != PACKET_RESUME)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Invalid packet", 1);
+        if (packet) free_packet(packet);
+        return;
     }
-    
-    if (iterations >= max_iterations) {
-        snprintf(log_msg, sizeof(log_msg), "WARNING: Bot action loop hit max iterations (%d)", max_iterations);
+
+    ResumeRequest request;
+    conn_data_t* session_conn = NULL;
+    if (conn_data->user_id == 0 &&
+        decode_resume_request(packet->data, packet->header->packet_len - sizeof(Header), &request) == 0)
+    {
+        session_conn = session_find(request.token);
+    }
+    free_packet(packet);
+
+    char session_token[SESSION_TOKEN_LEN + 1];
+    if (session_conn == NULL || session_issue(session_conn, session_token) == -1 ||
+        resume_connection(epoll_fd, conn_data, session_conn) == -1)
+    {
+        snprintf(log_msg, sizeof(log_msg), "Resume REJECTED on fd=%d", conn_data->fd);
         logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+
+        RawBytes* raw_bytes = encode_response(R_RESUME_NOT_OK);
+        RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_RESUME, raw_bytes->data, raw_bytes->len);
+        sendall(conn_data->fd, response->data, (int*) &(response->len));
+        free(response->data);
+        free(response);
+        free(raw_bytes->data);
+        free(raw_bytes);
+        return;
+    }
+
+    // conn_data is gone; the socket now belongs to session_conn
+    snprintf(log_msg, sizeof(log_msg), "Resume SUCCESS: user='%s' (id=%u) fd=%d table=%d seat=%d",
+             session_conn->username, session_conn->user_id, session_conn->fd, session_conn->table_id, session_conn->seat);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    // A seat restored from the journal holds no friends and invites yet; the database is only needed
+    // when no other connection of the user has them loaded
+    if (!session_conn->social_ref)
+    {
+        PGconn* conn = social_cache_has((int) session_conn->user_id) ? NULL
+                                                                     : METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        session_conn->social_ref = social_cache_load(conn, (int) session_conn->user_id) == 0;
+        if (conn != NULL)
+        {
+            PQfinish(conn);
+        }
+    }
+
+    RawBytes* raw_bytes = encode_resume_success_response(session_conn, session_token);
+    RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_RESUME, raw_bytes->data, raw_bytes->len);
+    sendall(session_conn->fd, response->data, (int*) &(response->len));
+    free(response->data);
+    free(response);
+    free(raw_bytes->data);
+    free(raw_bytes);
+
+    int index = session_conn->table_id > 0 ? find_table_by_id(table_list, session_conn->table_id) : -1;
+    if (index != -1)
+    {
+        table_send_catch_up(&table_list->tables[index], session_conn, request.hand_id, request.seq);
     }
 }
 
@@ -147,7 +199,7 @@ void handle_signup_request(conn_data_t* conn_data, char* data, size_t data_len)
     snprintf(log_msg, sizeof(log_msg), "Signup request from fd=%d", conn_data->fd);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
     
-    PGconn* conn = PQconnectdb(dbconninfo);
+    PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
     Packet* packet = decode_packet(data, data_len);
     if (packet->header->packet_type != 200)
     {
@@ -182,7 +234,7 @@ void handle_signup_request(conn_data_t* conn_data, char* data, size_t data_len)
              signup_request->username, signup_request->email, strlen(user->password));
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
     
-    int res = dbSignup(conn, user);
+    int res = METRICS_DB_QUERY(dbSignup(conn, user));
 
     if (res == DB_OK)
     {
@@ -312,6 +364,41 @@ void handle_create_table_request(conn_data_t* conn_data, char* data, size_t data
     free(create_table_request);
 }
 
+// Filtered, paginated lobby listing answered from the lobby index
+static void handle_tables_query(conn_data_t* conn_data, char* payload, size_t payload_len)
+{
+    TablesQuery query;
+    TablesQuery next;
+    bool has_more = false;
+    TableSummary page[TABLES_PAGE_MAX];
+    int count = 0;
+
+    if (decode_tables_query(payload, payload_len, &query) == 0)
+    {
+        count = lobby_query_tables(&query, page, &next, &has_more);
+    }
+    else
+    {
+        logger(MAIN_LOG, "Error", "Handle get all tables: invalid query, answering with an empty page");
+    }
+
+    RawBytes* raw_bytes = encode_tables_page_response(page, count, has_more ? &next : NULL);
+    if (raw_bytes == NULL)
+    {
+        return;
+    }
+    RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_TABLES, raw_bytes->data, raw_bytes->len);
+    if (sendall(conn_data->fd, response->data, (int*) &(response->len)) == -1)
+    {
+        logger(MAIN_LOG, "Error", "Handle get all tables: Cannot send response");
+    }
+
+    free(response->data);
+    free(response);
+    free(raw_bytes->data);
+    free(raw_bytes);
+}
+
 void handle_get_all_tables_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
 {
     Packet* packet = decode_packet(data, data_len);
@@ -326,19 +413,79 @@ void handle_get_all_tables_request(conn_data_t* conn_data, char* data, size_t da
         logger(MAIN_LOG, "Error", "Handle get all tables: invalid packet length");
     }
 
-    RawBytes* raw_bytes = encode_full_tables_response(table_list);
-    RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_TABLES, raw_bytes->data, raw_bytes->len);
-    if (sendall(conn_data->fd, response->data, (int*) &(response->len)) == -1)
+    size_t payload_len = packet->header->packet_len >= sizeof(Header) ? packet->header->packet_len - sizeof(Header) : 0;
+    if (payload_len > 0)
+    {
+        handle_tables_query(conn_data, packet->data, payload_len);
+        free_packet(packet);
+        return;
+    }
+
+    // Shared snapshot: sendall writes the sent count back, so hand it a copy of the length
+    const RawBytes* response = lobby_tables_packet(table_list);
+    if (response == NULL)
+    {
+        logger(MAIN_LOG, "Error", "Handle get all tables: Cannot encode response");
+        free_packet(packet);
+        return;
+    }
+    int len = (int) response->len;
+    if (sendall(conn_data->fd, response->data, &len) == -1)
     {
         logger(MAIN_LOG, "Error", "Handle get all tables: Cannot send response");
     }
 
-    free(response->data);
-    free(response);
-    free(raw_bytes->data);
-    free(raw_bytes);
     free_packet(packet);
 }
+void handle_lobby_subscribe_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
+{
+    char log_msg[256];
+    Packet* packet = decode_packet(data, data_len);
+    if (!packet || packet->header->packet_type != PACKET_LOBBY_SUBSCRIBE) {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Invalid packet", 1);
+        if (packet) free_packet(packet);
+        return;
+    }
+
+    int subscribe = decode_lobby_subscribe_request(packet->data, packet->header->packet_len - sizeof(Header));
+    int res = 0;
+    if (subscribe == 1) {
+        if (lobby_subscribe(conn_data->fd, table_list) == 0) {
+            // The snapshot is the starting point deltas apply to
+            const RawBytes* snapshot = lobby_tables_packet(table_list);
+            if (snapshot != NULL) {
+                int len = (int) snapshot->len;
+                sendall(conn_data->fd, snapshot->data, &len);
+            }
+        } else {
+            res = R_LOBBY_SUBSCRIBE_NOT_OK;
+        }
+    } else if (subscribe == 0) {
+        lobby_unsubscribe(conn_data->fd);
+        res = R_LOBBY_UNSUBSCRIBE_OK;
+    } else {
+        res = R_LOBBY_SUBSCRIBE_NOT_OK;
+    }
+
+    presence_refresh(conn_data);
+
+    snprintf(log_msg, sizeof(log_msg), "Lobby %s from fd=%d (res=%d, subscribers=%d)",
+             subscribe == 0 ? "unsubscribe" : "subscribe", conn_data->fd, res, lobby_subscriber_count());
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    if (res != 0) {
+        RawBytes* raw_bytes = encode_response(res);
+        RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_LOBBY_SUBSCRIBE, raw_bytes->data, raw_bytes->len);
+        sendall(conn_data->fd, response->data, (int*)&response->len);
+        free(response->data);
+        free(response);
+        free(raw_bytes->data);
+        free(raw_bytes);
+    }
+
+    free_packet(packet);
+}
+
 void handle_join_table_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
 {
     char log_msg[256];
@@ -430,8 +577,8 @@ void handle_join_table_request(conn_data_t* conn_data, char* data, size_t data_l
                     if (gs && gs->hand_in_progress && gs->betting_round != BETTING_ROUND_COMPLETE) {
                         broadcast_game_state_to_table(table);
                         
-                        // Process bot actions if any bots are active
-                        process_bot_actions(table);
+                        // Hand the turn to the bot pool if a bot acts first
+                        process_all_bot_actions(table);
                     }
                 }
                 
@@ -504,6 +651,8 @@ void handle_join_table_request(conn_data_t* conn_data, char* data, size_t data_l
                      gs->hand_id + 1, table->id, gs->num_players);
             logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
             
+            journal_hand_start(table);
+            history_hand_start(table);
             int start_result = game_start_hand(gs);
             if (start_result == 0) {
                 table->game_started = true;
@@ -661,7 +810,6 @@ void handle_unknown_request(conn_data_t* conn_data, char* data, size_t data_len)
 
 void handle_get_scoreboard(conn_data_t* conn_data, char* data, size_t data_len)
 {
-    PGconn* conn = PQconnectdb(dbconninfo);
     Packet* packet = decode_packet(data, data_len);
 
     if (packet->header->packet_type != PACKET_SCOREBOARD)
@@ -669,26 +817,29 @@ void handle_get_scoreboard(conn_data_t* conn_data, char* data, size_t data_len)
         logger(MAIN_LOG, "Error", "Handle get scoreboard: invalid packet type");
     }
 
-    dbScoreboard* scoreboard = dbGetScoreBoard(conn);
+    // Served from the in-memory leaderboard; the database is only touched if startup seeding failed
+    if (!leaderboard_is_seeded())
+    {
+        PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        if (PQstatus(conn) == CONNECTION_OK)
+        {
+            leaderboard_seed(conn);
+        }
+        PQfinish(conn);
+    }
 
-    RawBytes* raw_bytes = encode_scoreboard_response(scoreboard);
-    RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_SCOREBOARD, raw_bytes->data, raw_bytes->len);
-    if (sendall(conn_data->fd, response->data, (int*) &(response->len)) == -1)
+    const RawBytes* response = leaderboard_packet();
+    int len = response != NULL ? (int) response->len : 0;
+    if (response == NULL || sendall(conn_data->fd, response->data, &len) == -1)
     {
         logger(MAIN_LOG, "Error", "Handle get scoreboard: Cannot send response");
     }
 
-    free(response->data);
-    free(response);
-    free(raw_bytes->data);
-    free(raw_bytes);
     free_packet(packet);
-    PQfinish(conn);
 }
 
 void handle_get_friendlist(conn_data_t* conn_data, char* data, size_t data_len)
 {
-    PGconn* conn = PQconnectdb(dbconninfo);
     Packet* packet = decode_packet(data, data_len);
 
     if (packet->header->packet_type != PACKET_FRIENDLIST)
@@ -706,7 +857,14 @@ void handle_get_friendlist(conn_data_t* conn_data, char* data, size_t data_len)
         logger(MAIN_LOG, "Error", "Handle get friendlist: User not logged in");
     }
 
-    FriendList* friendlist = dbGetFriendList(conn, conn_data->user_id);
+    FriendList* friendlist = social_cache_friends(conn_data->user_id);
+    bool cached = friendlist != NULL;
+    if (!cached)
+    {
+        PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        friendlist = METRICS_DB_QUERY(dbGetFriendList(conn, conn_data->user_id));
+        PQfinish(conn);
+    }
 
     RawBytes* raw_bytes = encode_friendlist_response(friendlist);
     RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_FRIENDLIST, raw_bytes->data, raw_bytes->len);
@@ -719,8 +877,12 @@ void handle_get_friendlist(conn_data_t* conn_data, char* data, size_t data_len)
     free(response);
     free(raw_bytes->data);
     free(raw_bytes);
+    if (!cached && friendlist)
+    {
+        free(friendlist->friends);
+        free(friendlist);
+    }
     free_packet(packet);
-    PQfinish(conn);
 }
 
 void handle_leave_table_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
@@ -777,102 +939,312 @@ void handle_leave_table_request(conn_data_t* conn_data, char* data, size_t data_
     free_packet(packet);
 }
 
-// Helper function to process all consecutive bot actions
+// Hand the active bot's turn to the bot worker pool (see bot.c). The decision is applied on the
+// event loop once it is ready, and that in turn schedules the next bot, so consecutive bots chain.
 // Returns true if game ended (all players became bots)
 bool process_all_bot_actions(Table* table) {
     if (!table || !table->game_state) return false;
     
     GameState* gs = table->game_state;
     char log_msg[256];
-    int max_iterations = 100; // Prevent infinite loops
-    int iteration = 0;
     
-    while (iteration++ < max_iterations) {
-        // Check if game is still in progress
-        if (gs->betting_round == BETTING_ROUND_COMPLETE || !gs->hand_in_progress) {
-            break;
-        }
-        
-        // Check if active player is a bot
-        if (gs->active_seat < 0 || gs->active_seat >= MAX_PLAYERS) {
-            break;
-        }
-        
-        GamePlayer* active_player = &gs->players[gs->active_seat];
-        if (!active_player || active_player->state != PLAYER_STATE_ACTIVE || !active_player->is_bot) {
-            break; // Not a bot's turn
+    // Check if game is still in progress
+    if (gs->betting_round == BETTING_ROUND_COMPLETE || !gs->hand_in_progress) {
+        return false;
+    }
+    
+    // Check if active player is a bot
+    if (gs->active_seat < 0 || gs->active_seat >= MAX_PLAYERS) {
+        return false;
+    }
+    
+    GamePlayer* active_player = &gs->players[gs->active_seat];
+    if (active_player->state != PLAYER_STATE_ACTIVE || !active_player->is_bot) {
+        return false; // Not a bot's turn
+    }
+    
+    // Check if ALL remaining active players are bots (no real players left)
+    int real_players = 0;
+    int bot_players = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        GamePlayer* p = &gs->players[i];
+        if (p->state == PLAYER_STATE_ACTIVE || p->state == PLAYER_STATE_ALL_IN) {
+            if (p->is_bot) {
+                bot_players++;
+            } else {
+                real_players++;
+            }
         }
+    }
+    
+    if (real_players == 0 && bot_players > 0) {
+        snprintf(log_msg, sizeof(log_msg), 
+                "All remaining players are bots at table %d - ending hand", table->id);
+        logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
         
-        // Check if ALL remaining active players are bots (no real players left)
-        int real_players = 0;
-        int bot_players = 0;
+        // Force hand to complete - award the pots the first bot can win to it
         for (int i = 0; i < MAX_PLAYERS; i++) {
-            GamePlayer* p = &gs->players[i];
-            if (p->state == PLAYER_STATE_ACTIVE || p->state == PLAYER_STATE_ALL_IN) {
-                if (p->is_bot) {
-                    bot_players++;
-                } else {
-                    real_players++;
+            if (gs->players[i].is_bot && 
+                (gs->players[i].state == PLAYER_STATE_ACTIVE || 
+                 gs->players[i].state == PLAYER_STATE_ALL_IN)) {
+                game_collect_bets_to_pot(gs);
+                game_distribute_pot(gs, i);
+                gs->betting_round = BETTING_ROUND_COMPLETE;
+                gs->hand_in_progress = false;
+                break;
+            }
+        }
+        table->bot_ticket = 0;
+        return true; // Game ended
+    }
+    
+    if (bot_schedule_decision(table) < 0) {
+        snprintf(log_msg, sizeof(log_msg), "Failed to schedule bot decision at table %d seat %d", 
+                table->id, gs->active_seat);
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+    }
+    
+    return false;
+}
+
+// Settle a finished hand: drop bots, remove busted players, then either close the table
+// (winner cleaned it out) or sync balances to the database and wait for the next hand
+void handle_hand_complete(Table* table, TableList* table_list) {
+    if (!table || !table->game_state || table->game_state->betting_round != BETTING_ROUND_COMPLETE) {
+        return;
+    }
+    
+    char log_msg[256];
+    table->active_seat = -1;
+    metrics_add(METRIC_HANDS_COMPLETED, 1);
+    history_hand_end(table);
+    replay_log_hand_end(table);
+    
+    // Remove bots after hand completes (they replaced disconnected players)
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        GamePlayer* p = &table->game_state->players[i];
+        if (p->state != PLAYER_STATE_EMPTY && p->is_bot) {
+            snprintf(log_msg, sizeof(log_msg), "Bot at seat %d removed after hand complete", i);
+            logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+            
+            // Return remaining chips to original player who disconnected
+            if (p->money > 0 && p->original_user_id > 0) {
+                PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+                if (PQstatus(db_conn) == CONNECTION_OK) {
+                    int result = METRICS_DB_QUERY(dbAddToBalance(db_conn, p->original_user_id, p->money));
+                    if (result == DB_OK) {
+                        leaderboard_add_balance(p->original_user_id, p->money);
+                        snprintf(log_msg, sizeof(log_msg), 
+                                "Returned %d chips from bot to user_id=%d", 
+                                p->money, p->original_user_id);
+                        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+                    }
+                    PQfinish(db_conn);
                 }
             }
+            
+            // Remove bot from game state
+            game_remove_player(table->game_state, i);
+            
+            // No connection to clean up since bots don't have connections
         }
-        
-        if (real_players == 0 && bot_players > 0) {
-            snprintf(log_msg, sizeof(log_msg), 
-                    "All remaining players are bots at table %d - ending hand", table->id);
-            logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+    }
+    
+    // Remove players who have no money left (busted out)
+    // Only remove after hand is complete, not during play
+    // Iterate backwards to safely remove multiple players
+    for (int i = table->current_player - 1; i >= 0; i--) {
+        if (table->connections[i] != NULL && table->connections[i]->seat >= 0) {
+            int seat = table->connections[i]->seat;
+            GamePlayer* p = &table->game_state->players[seat];
             
-            // Force hand to complete - award pot to first bot
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                if (gs->players[i].is_bot && 
-                    (gs->players[i].state == PLAYER_STATE_ACTIVE || 
-                     gs->players[i].state == PLAYER_STATE_ALL_IN)) {
-                    game_distribute_pot(gs, i);
-                    gs->winner_seat = i;
-                    gs->betting_round = BETTING_ROUND_COMPLETE;
-                    gs->hand_in_progress = false;
-                    break;
+            // Only remove if player has no money left and is not already empty
+            if (p->money == 0 && p->state != PLAYER_STATE_EMPTY) {
+                snprintf(log_msg, sizeof(log_msg), "Player %s (seat %d) busted out at table %d (money=0), removing from table", 
+                         table->connections[i]->username, seat, table->id);
+                logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+                
+                // Remove player from game state
+                game_remove_player(table->game_state, seat);
+                
+                // Remove from connection tracking
+                table->seat_to_conn_idx[seat] = -1;
+                
+                // Mark connection as leaving
+                table->connections[i]->table_id = 0;
+                table->connections[i]->seat = -1;
+                presence_refresh(table->connections[i]);
+                table->connections[i] = NULL;
+                
+                // Shift connections array to remove gap
+                for (int j = i; j < table->current_player - 1; j++) {
+                    table->connections[j] = table->connections[j + 1];
+                    if (table->connections[j] != NULL && table->connections[j]->seat >= 0) {
+                        table->seat_to_conn_idx[table->connections[j]->seat] = j;
+                    }
                 }
+                table->connections[table->current_player - 1] = NULL;
+                
+                // Decrease current_player count
+                if (table->current_player > 0) {
+                    table->current_player--;
+                }
+                lobby_table_seats_changed(table);
             }
-            return true; // Game ended
         }
+    }
+    
+    // Check if winner cleaned out the lobby
+    // Count players who are not folded and have money > 0 (can continue playing)
+    int players_with_money = 0;
+    int winner_seat = table->game_state->winner_seat;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        GamePlayer* p = &table->game_state->players[i];
+        if (p->state != PLAYER_STATE_EMPTY && 
+            p->state != PLAYER_STATE_FOLDED && 
+            p->money > 0) {
+            players_with_money++;
+        }
+    }
+    
+    // If only winner has money (or no one has money but there's a winner), remove table
+    if (players_with_money <= 1 && winner_seat >= 0) {
+        snprintf(log_msg, sizeof(log_msg), "Table %d cleaned out by winner (seat %d, players_with_money=%d, current_player=%d), removing table", 
+                 table->id, winner_seat, players_with_money, table->current_player);
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
         
-        // Bot logic: check if possible, otherwise fold
-        Action bot_action = {0};
-        int amount_to_call = gs->current_bet - active_player->bet;
+        // Mark all connections as leaving the table
+        for (int i = 0; i < table->current_player; i++) {
+            if (table->connections[i] != NULL) {
+                table->connections[i]->table_id = 0;
+                table->connections[i]->seat = -1;
+                presence_refresh(table->connections[i]);
+            }
+        }
         
-        if (amount_to_call == 0) {
-            bot_action.type = ACTION_CHECK;
-            snprintf(log_msg, sizeof(log_msg), "Bot at seat %d checking", gs->active_seat);
-        } else {
-            bot_action.type = ACTION_FOLD;
-            snprintf(log_msg, sizeof(log_msg), "Bot at seat %d folding (bet=%d)", 
-                    gs->active_seat, amount_to_call);
+        // Clean up game state
+        if (table->game_state) {
+            game_state_destroy(table->game_state);
+            table->game_state = NULL;
         }
+        
+        // Remove table from list
+        remove_table(table_list, table->id);
+    } else {
+        snprintf(log_msg, sizeof(log_msg), "Hand completed at table %d (players_with_money=%d, current_player=%d), preparing for next hand", 
+                 table->id, players_with_money, table->current_player);
         logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
         
-        // Process bot action
-        int result = game_process_action(gs, active_player->player_id, &bot_action);
-        if (result != 0) {
-            snprintf(log_msg, sizeof(log_msg), "Bot action failed: result=%d", result);
-            logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
-            break;
+        // Sync player balances to database after hand completion: the hand's settlement lists every
+        // seated player's stack, committed in one statement. Players who busted or left since are
+        // no longer in their seat and are skipped, and a settlement left from an earlier hand is ignored.
+        const Settlement* settlement = &table->game_state->settlement;
+        int num_entries = settlement->hand_id == table->game_state->hand_id ? settlement->num_entries : 0;
+        dbBalance balances[MAX_PLAYERS];
+        int num_balances = 0;
+        for (int i = 0; i < num_entries; i++) {
+            const SettlementEntry* entry = &settlement->entries[i];
+            GamePlayer* player = &table->game_state->players[entry->seat];
+            if (entry->player_id > 0 && player->state != PLAYER_STATE_EMPTY && player->player_id == entry->player_id) {
+                balances[num_balances++] = (dbBalance){entry->player_id, player->money, false};
+            }
+        }
+        if (num_balances > 0) {
+            PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+            if (PQstatus(db_conn) == CONNECTION_OK) {
+                int updated = METRICS_DB_QUERY(dbUpdateBalances(db_conn, balances, num_balances));
+                // Every row the statement committed is mirrored in memory, even if some user was missing
+                for (int i = 0; i < num_balances; i++) {
+                    if (balances[i].updated) {
+                        leaderboard_set_balance(balances[i].user_id, balances[i].balance);
+                        // Update connection data balances to match game state
+                        for (int j = 0; j < table->current_player; j++) {
+                            if (table->connections[j] && table->connections[j]->user_id == (unsigned int) balances[i].user_id) {
+                                table->connections[j]->balance = balances[i].balance;
+                                break;
+                            }
+                        }
+                    }
+                }
+                if (updated == num_balances) {
+                    snprintf(log_msg, sizeof(log_msg), "Successfully synced %d player balances to database for table %d", 
+                            num_balances, table->id);
+                    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+                } else {
+                    snprintf(log_msg, sizeof(log_msg), "Synced %d of %d balances for table %d", 
+                            updated == DB_ERROR ? 0 : updated, num_balances, table->id);
+                    logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+                }
+            } else {
+                logger_ex(MAIN_LOG, "ERROR", __func__, "Failed to connect to database for balance sync", 1);
+            }
+            PQfinish(db_conn);
         }
         
-        // Broadcast updated state after bot action
-        broadcast_game_state_to_table(table);
-        table->active_seat = gs->active_seat;
+        // Reset player states to WAITING so they can participate in next hand
+        // This is needed because players might be in FOLDED or ALL_IN state after hand complete
+        int reset_count = 0;
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            GamePlayer* p = &table->game_state->players[i];
+            if (p->state != PLAYER_STATE_EMPTY && 
+                p->state != PLAYER_STATE_SITTING_OUT &&
+                p->money > 0) {
+                p->state = PLAYER_STATE_WAITING;
+                p->bet = 0;
+                p->total_bet = 0;
+                p->hole_cards[0] = NULL;
+                p->hole_cards[1] = NULL;
+                p->is_dealer = false;
+                p->is_small_blind = false;
+                p->is_big_blind = false;
+                reset_count++;
+            }
+        }
+        
+        // Ensure hand_in_progress is false before logging and starting new hand
+        table->game_state->hand_in_progress = false;
+        journal_hand_settled(table);
+        
+        snprintf(log_msg, sizeof(log_msg), "Reset %d players to WAITING state at table %d (hand_in_progress=%d, betting_round=%d)", 
+                 reset_count, table->id, table->game_state->hand_in_progress, table->game_state->betting_round);
+        logger_ex(MAIN_LOG, "DEBUG", __func__, log_msg, 1);
+        
+        // Don't start next hand immediately - give clients time to display HandResult
+        // The next hand will start automatically when a player sends their first action
+        // after the hand completes (handled in handle_action_request when betting_round is COMPLETE)
+        snprintf(log_msg, sizeof(log_msg), "Hand complete at table %d - waiting for player action to start next hand", table->id);
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+        
+        // Don't call start_game_if_ready here - let it start when player acts
+        // This gives clients time to show HandResult before new hand begins
     }
-    
-    if (iteration >= max_iterations) {
-        snprintf(log_msg, sizeof(log_msg), "WARNING: Bot action loop hit max iterations at table %d", 
-                table->id);
-        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+}
+
+static void send_action_result(conn_data_t* conn_data, int code, uint32_t client_seq, const char* reason)
+{
+    ActionResult result = {
+        .result = code,
+        .client_seq = client_seq,
+    };
+    if (reason) {
+        strncpy(result.reason, reason, sizeof(result.reason) - 1);
     }
     
-    return false;
+    RawBytes* result_bytes = encode_action_result(&result);
+    if (result_bytes) {
+        RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_ACTION_RESULT, 
+                                          result_bytes->data, result_bytes->len);
+        if (response) {
+            sendall(conn_data->fd, response->data, (int*)&response->len);
+            free(response->data);
+            free(response);
+        }
+        free(result_bytes->data);
+        free(result_bytes);
+    }
 }
 
+// Decode the request and queue it on the table's mailbox; apply_player_action runs it on the table's owner
 void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
 {
     char log_msg[256];
@@ -882,24 +1254,7 @@ void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len,
     
     // Validate user is logged in and at a table
     if (conn_data->user_id == 0 || conn_data->table_id == 0) {
-        ActionResult result = {
-            .result = 403,
-            .client_seq = 0,
-        };
-        strncpy(result.reason, "Not logged in or not at a table", sizeof(result.reason) - 1);
-        
-        RawBytes* result_bytes = encode_action_result(&result);
-        if (result_bytes) {
-            RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_ACTION_RESULT, 
-                                              result_bytes->data, result_bytes->len);
-            if (response) {
-                sendall(conn_data->fd, response->data, (int*)&response->len);
-                free(response->data);
-                free(response);
-            }
-            free(result_bytes->data);
-            free(result_bytes);
-        }
+        send_action_result(conn_data, 403, 0, "Not logged in or not at a table");
         return;
     }
     
@@ -911,12 +1266,6 @@ void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len,
     }
     
     Table* table = &table_list->tables[table_idx];
-    GameState* gs = table->game_state;
-    
-    if (!gs) {
-        logger_ex(MAIN_LOG, "ERROR", __func__, "Game state not found", 1);
-        return;
-    }
     
     // Decode action request
     Packet* packet = decode_packet(data, data_len);
@@ -928,41 +1277,15 @@ void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len,
     
     ActionRequest* action_req = decode_action_request(packet->data);
     if (!action_req) {
-        logger_ex(MAIN_LOG, "ERROR", __func__, "Failed to decode action request", 1);
-        free_packet(packet);
-        return;
-    }
-    
-    snprintf(log_msg, sizeof(log_msg), "Action from user='%s': type='%s' amount=%d", 
-             conn_data->username, action_req->action_type, action_req->amount);
-    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-    
-    // Validate it's the player's turn
-    if (gs->active_seat < 0 || gs->players[gs->active_seat].player_id != conn_data->user_id) {
-        ActionResult result = {
-            .result = 403,
-            .client_seq = action_req->client_seq,
-        };
-        strncpy(result.reason, "Not your turn", sizeof(result.reason) - 1);
-        
-        RawBytes* result_bytes = encode_action_result(&result);
-        if (result_bytes) {
-            RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_ACTION_RESULT, 
-                                              result_bytes->data, result_bytes->len);
-            if (response) {
-                sendall(conn_data->fd, response->data, (int*)&response->len);
-                free(response->data);
-                free(response);
-            }
-            free(result_bytes->data);
-            free(result_bytes);
-        }
-        
-        free(action_req);
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Failed to decode action request", 1);
         free_packet(packet);
         return;
     }
     
+    snprintf(log_msg, sizeof(log_msg), "Action from user='%s': type='%s' amount=%d", 
+             conn_data->username, action_req->action_type, action_req->amount);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    
     // Convert action type string to ActionType enum
     Action action = {0};
     if (strcmp(action_req->action_type, "fold") == 0) {
@@ -980,29 +1303,59 @@ void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len,
     } else if (strcmp(action_req->action_type, "all_in") == 0) {
         action.type = ACTION_ALL_IN;
     } else {
-        ActionResult result = {
-            .result = 400,
-            .client_seq = action_req->client_seq,
-        };
-        strncpy(result.reason, "Invalid action type", sizeof(result.reason) - 1);
-        
-        RawBytes* result_bytes = encode_action_result(&result);
-        if (result_bytes) {
-            RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_ACTION_RESULT, 
-                                              result_bytes->data, result_bytes->len);
-            if (response) {
-                sendall(conn_data->fd, response->data, (int*)&response->len);
-                free(response->data);
-                free(response);
-            }
-            free(result_bytes->data);
-            free(result_bytes);
-        }
-        
+        send_action_result(conn_data, 400, action_req->client_seq, "Invalid action type");
+        free(action_req);
+        free_packet(packet);
+        return;
+    }
+    
+    TableCommand* cmd = calloc(1, sizeof(TableCommand));
+    if (!cmd || !table->actor) {
+        send_action_result(conn_data, 500, action_req->client_seq, "Failed to process action");
+        free(cmd);
         free(action_req);
         free_packet(packet);
         return;
     }
+    cmd->type = TABLE_CMD_ACTION;
+    cmd->user_id = conn_data->user_id;
+    cmd->client_seq = action_req->client_seq;
+    cmd->action = action;
+    table_actor_post(table->actor, cmd);
+    
+    free(action_req);
+    free_packet(packet);
+}
+
+// Run a queued player action against the table. Broadcasting and bot follow-ups are left to the
+// caller, which does them once for the whole batch. Returns true if the action changed the hand.
+bool apply_player_action(Table* table, const TableCommand* cmd)
+{
+    char log_msg[256];
+    
+    // The player may have left between posting and now
+    conn_data_t* conn_data = NULL;
+    for (int i = 0; i < table->current_player; i++) {
+        if (table->connections[i] != NULL && (int) table->connections[i]->user_id == cmd->user_id) {
+            conn_data = table->connections[i];
+            break;
+        }
+    }
+    if (!conn_data) {
+        snprintf(log_msg, sizeof(log_msg), "Dropping action from user_id=%d, no longer at table %d", 
+                 cmd->user_id, table->id);
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+        return false;
+    }
+    
+    GameState* gs = table->game_state;
+    Action action = cmd->action;
+    
+    // Validate it's the player's turn
+    if (gs->active_seat < 0 || gs->players[gs->active_seat].player_id != conn_data->user_id) {
+        send_action_result(conn_data, 403, cmd->client_seq, "Not your turn");
+        return false;
+    }
     
     // If hand is complete and player sends an action, start new hand first
     if (gs->betting_round == BETTING_ROUND_COMPLETE) {
@@ -1033,9 +1386,7 @@ void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len,
         if (!gs) {
             snprintf(log_msg, sizeof(log_msg), "Error: Game state is NULL after starting new hand");
             logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
-            free(action_req);
-            free_packet(packet);
-            return;
+            return false;
         }
         
         // Broadcast new hand state to all players
@@ -1045,315 +1396,53 @@ void handle_action_request(conn_data_t* conn_data, char* data, size_t data_len,
         bool game_ended = process_all_bot_actions(table);
         if (game_ended) {
             logger_ex(MAIN_LOG, "WARN", __func__, "All players were bots, game ended", 1);
-            return;
+            return false;
         }
         
         // If new hand started, return early - don't process the action from previous hand
         if (gs->hand_in_progress && gs->betting_round != BETTING_ROUND_COMPLETE) {
             snprintf(log_msg, sizeof(log_msg), "New hand started, ignoring action from previous hand");
             logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-            free(action_req);
-            free_packet(packet);
-            return;
+            return false;
         }
     }
     
     // Validate action
     ActionValidation validation = game_validate_action(gs, conn_data->user_id, &action);
     if (!validation.is_valid) {
-        ActionResult result = {
-            .result = 409,
-            .client_seq = action_req->client_seq,
-        };
-        strncpy(result.reason, validation.error_message ? validation.error_message : "Invalid action", 
-                sizeof(result.reason) - 1);
-        
-        RawBytes* result_bytes = encode_action_result(&result);
-        if (result_bytes) {
-            RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_ACTION_RESULT, 
-                                              result_bytes->data, result_bytes->len);
-            if (response) {
-                sendall(conn_data->fd, response->data, (int*)&response->len);
-                free(response->data);
-                free(response);
-            }
-            free(result_bytes->data);
-            free(result_bytes);
-        }
-        
-        free(action_req);
-        free_packet(packet);
-        return;
+        send_action_result(conn_data, 409, cmd->client_seq, 
+                           validation.error_message ? validation.error_message : "Invalid action");
+        return false;
     }
     
     // Process the action
+    int seat = gs->active_seat;
+    int total_bet_before = gs->players[seat].total_bet;
+    BettingRound round = gs->betting_round;
     int process_result = game_process_action(gs, conn_data->user_id, &action);
     if (process_result != 0) {
-        ActionResult result = {
-            .result = 500,
-            .client_seq = action_req->client_seq,
-        };
-        strncpy(result.reason, "Failed to process action", sizeof(result.reason) - 1);
-        
-        RawBytes* result_bytes = encode_action_result(&result);
-        if (result_bytes) {
-            RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_ACTION_RESULT, 
-                                              result_bytes->data, result_bytes->len);
-            if (response) {
-                sendall(conn_data->fd, response->data, (int*)&response->len);
-                free(response->data);
-                free(response);
-            }
-            free(result_bytes->data);
-            free(result_bytes);
-        }
-        
-        free(action_req);
-        free_packet(packet);
-        return;
-    }
-    
-    // Action processed successfully
-    ActionResult result = {
-        .result = 0,
-        .client_seq = action_req->client_seq,
+        send_action_result(conn_data, 500, cmd->client_seq, "Failed to process action");
+        return false;
+    }
+    
+    // Kept so a player who drops and resumes sees this action replayed
+    ActionRecord record = {
+        .seq = gs->seq,
+        .seat = seat,
+        .player_id = conn_data->user_id,
+        .type = action.type,
+        .amount = gs->players[seat].total_bet - total_bet_before,
+        .round = round,
     };
+    table_remember_action(table, &record);
+    journal_action(table, seat, &action);
     
-    RawBytes* result_bytes = encode_action_result(&result);
-    if (result_bytes) {
-        RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_ACTION_RESULT, 
-                                          result_bytes->data, result_bytes->len);
-        if (response) {
-            sendall(conn_data->fd, response->data, (int*)&response->len);
-            free(response->data);
-            free(response);
-        }
-        free(result_bytes->data);
-        free(result_bytes);
-    }
-    
-    // Broadcast updated game state to all players at the table
-    int broadcast_count = broadcast_game_state_to_table(table);
-    if (broadcast_count <= 0) {
-        snprintf(log_msg, sizeof(log_msg), "Warning: Failed to broadcast game state after action from user='%s'", 
-                 conn_data->username);
-        logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
-    } else {
-        // Update table's active_seat tracker after broadcasting
-        table->active_seat = table->game_state->active_seat;
-        
-        // Process all consecutive bot actions (handles multiple bots in a row)
-        bool all_bots = process_all_bot_actions(table);
-        if (all_bots) {
-            snprintf(log_msg, sizeof(log_msg), 
-                    "All players became bots at table %d - hand force-completed", table->id);
-            logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
-        }
-        
-        // Check if hand is complete (showdown finished)
-        if (table->game_state->betting_round == BETTING_ROUND_COMPLETE) {
-            table->active_seat = -1;
-            
-            // Remove bots after hand completes (they replaced disconnected players)
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                GamePlayer* p = &table->game_state->players[i];
-                if (p->state != PLAYER_STATE_EMPTY && p->is_bot) {
-                    snprintf(log_msg, sizeof(log_msg), "Bot at seat %d removed after hand complete", i);
-                    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-                    
-                    // Return remaining chips to original player who disconnected
-                    if (p->money > 0 && p->original_user_id > 0) {
-                        PGconn* db_conn = PQconnectdb(dbconninfo);
-                        if (PQstatus(db_conn) == CONNECTION_OK) {
-                            int result = dbAddToBalance(db_conn, p->original_user_id, p->money);
-                            if (result == DB_OK) {
-                                snprintf(log_msg, sizeof(log_msg), 
-                                        "Returned %d chips from bot to user_id=%d", 
-                                        p->money, p->original_user_id);
-                                logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-                            }
-                            PQfinish(db_conn);
-                        }
-                    }
-                    
-                    // Remove bot from game state
-                    game_remove_player(table->game_state, i);
-                    
-                    // No connection to clean up since bots don't have connections
-                }
-            }
-            
-            // Remove players who have no money left (busted out)
-            // Only remove after hand is complete, not during play
-            // Iterate backwards to safely remove multiple players
-            for (int i = table->current_player - 1; i >= 0; i--) {
-                if (table->connections[i] != NULL && table->connections[i]->seat >= 0) {
-                    int seat = table->connections[i]->seat;
-                    GamePlayer* p = &table->game_state->players[seat];
-                    
-                    // Only remove if player has no money left and is not already empty
-                    if (p->money == 0 && p->state != PLAYER_STATE_EMPTY) {
-                        snprintf(log_msg, sizeof(log_msg), "Player %s (seat %d) busted out at table %d (money=0), removing from table", 
-                                 table->connections[i]->username, seat, table->id);
-                        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-                        
-                        // Remove player from game state
-                        game_remove_player(table->game_state, seat);
-                        
-                        // Remove from connection tracking
-                        table->seat_to_conn_idx[seat] = -1;
-                        
-                        // Mark connection as leaving
-                        table->connections[i]->table_id = 0;
-                        table->connections[i]->seat = -1;
-                        table->connections[i] = NULL;
-                        
-                        // Shift connections array to remove gap
-                        for (int j = i; j < table->current_player - 1; j++) {
-                            table->connections[j] = table->connections[j + 1];
-                            if (table->connections[j] != NULL && table->connections[j]->seat >= 0) {
-                                table->seat_to_conn_idx[table->connections[j]->seat] = j;
-                            }
-                        }
-                        table->connections[table->current_player - 1] = NULL;
-                        
-                        // Decrease current_player count
-                        if (table->current_player > 0) {
-                            table->current_player--;
-                        }
-                    }
-                }
-            }
-            
-            // Check if winner cleaned out the lobby
-            // Count players who are not folded and have money > 0 (can continue playing)
-            int players_with_money = 0;
-            int winner_seat = table->game_state->winner_seat;
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                GamePlayer* p = &table->game_state->players[i];
-                if (p->state != PLAYER_STATE_EMPTY && 
-                    p->state != PLAYER_STATE_FOLDED && 
-                    p->money > 0) {
-                    players_with_money++;
-                }
-            }
-            
-            // If only winner has money (or no one has money but there's a winner), remove table
-            if (players_with_money <= 1 && winner_seat >= 0) {
-                snprintf(log_msg, sizeof(log_msg), "Table %d cleaned out by winner (seat %d, players_with_money=%d, current_player=%d), removing table", 
-                         table->id, winner_seat, players_with_money, table->current_player);
-                logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-                
-                // Mark all connections as leaving the table
-                for (int i = 0; i < table->current_player; i++) {
-                    if (table->connections[i] != NULL) {
-                        table->connections[i]->table_id = 0;
-                        table->connections[i]->seat = -1;
-                    }
-                }
-                
-                // Clean up game state
-                if (table->game_state) {
-                    game_state_destroy(table->game_state);
-                    table->game_state = NULL;
-                }
-                
-                // Remove table from list
-                remove_table(table_list, table->id);
-            } else {
-                snprintf(log_msg, sizeof(log_msg), "Hand completed at table %d (players_with_money=%d, current_player=%d), preparing for next hand", 
-                         table->id, players_with_money, table->current_player);
-                logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-                
-                // Sync player balances to database after hand completion
-                PGconn* db_conn = PQconnectdb(dbconninfo);
-                if (PQstatus(db_conn) == CONNECTION_OK) {
-                    int successful_updates = 0;
-                    int failed_updates = 0;
-                    
-                    // Update database balance for each player based on their current money in the game
-                    for (int i = 0; i < MAX_PLAYERS; i++) {
-                        GamePlayer *player = &table->game_state->players[i];
-                        if (player->state != PLAYER_STATE_EMPTY && player->player_id > 0) {
-                            int result = dbUpdateBalance(db_conn, player->player_id, player->money);
-                            if (result == DB_OK) {
-                                successful_updates++;
-                                // Update connection data balances to match game state
-                                for (int j = 0; j < table->current_player; j++) {
-                                    if (table->connections[j] && 
-                                        table->connections[j]->user_id == player->player_id) {
-                                        table->connections[j]->balance = player->money;
-                                        break;
-                                    }
-                                }
-                            } else {
-                                failed_updates++;
-                                snprintf(log_msg, sizeof(log_msg), 
-                                        "Failed to update balance for player %d (user_id=%d) to %d", 
-                                        i, player->player_id, player->money);
-                                logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
-                            }
-                        }
-                    }
-                    
-                    if (failed_updates == 0) {
-                        snprintf(log_msg, sizeof(log_msg), "Successfully synced %d player balances to database for table %d", 
-                                successful_updates, table->id);
-                        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-                    } else {
-                        snprintf(log_msg, sizeof(log_msg), "Synced %d balances, failed %d for table %d", 
-                                successful_updates, failed_updates, table->id);
-                        logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
-                    }
-                    PQfinish(db_conn);
-                } else {
-                    logger_ex(MAIN_LOG, "ERROR", __func__, "Failed to connect to database for balance sync", 1);
-                }
-                
-                // Reset player states to WAITING so they can participate in next hand
-                // This is needed because players might be in FOLDED or ALL_IN state after hand complete
-                int reset_count = 0;
-                for (int i = 0; i < MAX_PLAYERS; i++) {
-                    GamePlayer* p = &table->game_state->players[i];
-                    if (p->state != PLAYER_STATE_EMPTY && 
-                        p->state != PLAYER_STATE_SITTING_OUT &&
-                        p->money > 0) {
-                        p->state = PLAYER_STATE_WAITING;
-                        p->bet = 0;
-                        p->total_bet = 0;
-                        p->hole_cards[0] = NULL;
-                        p->hole_cards[1] = NULL;
-                        p->is_dealer = false;
-                        p->is_small_blind = false;
-                        p->is_big_blind = false;
-                        reset_count++;
-                    }
-                }
-                
-                // Ensure hand_in_progress is false before logging and starting new hand
-                table->game_state->hand_in_progress = false;
-                
-                snprintf(log_msg, sizeof(log_msg), "Reset %d players to WAITING state at table %d (hand_in_progress=%d, betting_round=%d)", 
-                         reset_count, table->id, table->game_state->hand_in_progress, table->game_state->betting_round);
-                logger_ex(MAIN_LOG, "DEBUG", __func__, log_msg, 1);
-                
-                // Don't start next hand immediately - give clients time to display HandResult
-                // The next hand will start automatically when a player sends their first action
-                // after the hand completes (handled in handle_action_request when betting_round is COMPLETE)
-                snprintf(log_msg, sizeof(log_msg), "Hand complete at table %d - waiting for player action to start next hand", table->id);
-                logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-                
-                // Don't call start_game_if_ready here - let it start when player acts
-                // This gives clients time to show HandResult before new hand begins
-            }
-        }
-    }
+    // Action processed successfully
+    send_action_result(conn_data, 0, cmd->client_seq, NULL);
     
     snprintf(log_msg, sizeof(log_msg), "Action processed successfully for user='%s'", conn_data->username);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
-    
-    free(action_req);
-    free_packet(packet);
+    return true;
 }
 // ===== Friend Management Handlers =====
 
@@ -1397,9 +1486,35 @@ void handle_add_friend_request(conn_data_t* conn_data, char* data, size_t data_l
              conn_data->username, request->username);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
 
-    PGconn* conn = PQconnectdb(dbconninfo);
-    int res = dbAddFriend(conn, conn_data->user_id, request->username);
-    PQfinish(conn);
+    // Online users and known friends are resolved from memory; the database is only asked what it must answer
+    conn_data_t* target_conn = find_connection_by_username(request->username, 0);
+    bool online = target_conn != NULL;
+    int friend_id = online ? (int) target_conn->user_id : -1;
+    int res;
+    if (online && target_conn->user_id == conn_data->user_id)
+    {
+        res = -2;
+    }
+    else if (online && social_cache_is_friend(conn_data->user_id, friend_id) == 1)
+    {
+        res = -3;
+    }
+    else
+    {
+        PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        if (!online)
+        {
+            friend_id = METRICS_DB_QUERY(dbGetUserIdByUsername(conn, request->username));
+        }
+        res = friend_id < 0 ? -1 : METRICS_DB_QUERY(dbAddFriendById(conn, conn_data->user_id, friend_id));
+        PQfinish(conn);
+    }
+
+    if (res == DB_OK)
+    {
+        social_cache_friendship_added(conn_data->user_id, conn_data->username, friend_id, request->username);
+        presence_friendship_added(conn_data->user_id, friend_id);
+    }
 
     RawBytes* raw_bytes;
     if (res == DB_OK)
@@ -1485,9 +1600,40 @@ void handle_invite_friend_request(conn_data_t* conn_data, char* data, size_t dat
              conn_data->username, request->username);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
 
-    PGconn* conn = PQconnectdb(dbconninfo);
-    int res = dbSendFriendInvite(conn, conn_data->user_id, request->username);
-    PQfinish(conn);
+    conn_data_t* target_conn = find_connection_by_username(request->username, 0);
+    bool online = target_conn != NULL;
+    int to_user_id = online ? (int) target_conn->user_id : -1;
+    int res;
+    if (online && target_conn->user_id == conn_data->user_id)
+    {
+        res = -2;
+    }
+    else if (online && social_cache_is_friend(conn_data->user_id, to_user_id) == 1)
+    {
+        res = -3;
+    }
+    else if (online && social_cache_has_invite_from(to_user_id, conn_data->user_id) == 1)
+    {
+        res = -4;
+    }
+    else
+    {
+        PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        if (!online)
+        {
+            to_user_id = METRICS_DB_QUERY(dbGetUserIdByUsername(conn, request->username));
+        }
+        dbInvite invite;
+        res = to_user_id < 0 ? -1 : METRICS_DB_QUERY(dbSendFriendInviteById(conn, conn_data->user_id, to_user_id, &invite));
+        PQfinish(conn);
+
+        if (res == DB_OK)
+        {
+            strncpy(invite.from_username, conn_data->username, sizeof(invite.from_username) - 1);
+            invite.from_username[sizeof(invite.from_username) - 1] = '\0';
+            social_cache_invite_sent(&invite);
+        }
+    }
 
     RawBytes* raw_bytes;
     if (res == DB_OK)
@@ -1581,8 +1727,26 @@ void handle_accept_invite_request(conn_data_t* conn_data, char* data, size_t dat
              conn_data->username, request->invite_id);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
 
-    PGconn* conn = PQconnectdb(dbconninfo);
-    int res = dbAcceptFriendInvite(conn, conn_data->user_id, request->invite_id);
+    dbInvite invite;
+    bool invite_cached = social_cache_get_invite(conn_data->user_id, request->invite_id, &invite) == 0;
+
+    PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+    int res = METRICS_DB_QUERY(dbAcceptFriendInvite(conn, conn_data->user_id, request->invite_id));
+    if (res == DB_OK)
+    {
+        if (invite_cached)
+        {
+            social_cache_invite_removed(conn_data->user_id, request->invite_id);
+            social_cache_friendship_added(conn_data->user_id, conn_data->username, invite.from_user_id,
+                                          invite.from_username);
+            presence_friendship_added(conn_data->user_id, invite.from_user_id);
+        }
+        else
+        {
+            // The cache did not know this invite, so it cannot be patched; read the lists again
+            social_cache_refresh(conn, conn_data->user_id);
+        }
+    }
     PQfinish(conn);
 
     RawBytes* raw_bytes;
@@ -1665,10 +1829,15 @@ void handle_reject_invite_request(conn_data_t* conn_data, char* data, size_t dat
              conn_data->username, request->invite_id);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
 
-    PGconn* conn = PQconnectdb(dbconninfo);
-    int res = dbRejectFriendInvite(conn, conn_data->user_id, request->invite_id);
+    PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+    int res = METRICS_DB_QUERY(dbRejectFriendInvite(conn, conn_data->user_id, request->invite_id));
     PQfinish(conn);
 
+    if (res == DB_OK)
+    {
+        social_cache_invite_removed(conn_data->user_id, request->invite_id);
+    }
+
     RawBytes* raw_bytes;
     if (res == DB_OK)
     {
@@ -1737,9 +1906,14 @@ void handle_get_invites_request(conn_data_t* conn_data, char* data, size_t data_
         return;
     }
 
-    PGconn* conn = PQconnectdb(dbconninfo);
-    dbInviteList* invites = dbGetPendingInvites(conn, conn_data->user_id);
-    PQfinish(conn);
+    dbInviteList* invites = social_cache_invites(conn_data->user_id);
+    bool cached = invites != NULL;
+    if (!cached)
+    {
+        PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        invites = METRICS_DB_QUERY(dbGetPendingInvites(conn, conn_data->user_id));
+        PQfinish(conn);
+    }
 
     if (!invites)
     {
@@ -1767,8 +1941,11 @@ void handle_get_invites_request(conn_data_t* conn_data, char* data, size_t data_
     free(response);
     free(raw_bytes->data);
     free(raw_bytes);
-    free(invites->invites);
-    free(invites);
+    if (!cached)
+    {
+        free(invites->invites);
+        free(invites);
+    }
     free_packet(packet);
 }
 
@@ -1800,9 +1977,14 @@ void handle_get_friend_list_request(conn_data_t* conn_data, char* data, size_t d
         return;
     }
 
-    PGconn* conn = PQconnectdb(dbconninfo);
-    dbFriendList* friends = dbGetFriendList(conn, conn_data->user_id);
-    PQfinish(conn);
+    dbFriendList* friends = social_cache_friends(conn_data->user_id);
+    bool cached = friends != NULL;
+    if (!cached)
+    {
+        PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        friends = METRICS_DB_QUERY(dbGetFriendList(conn, conn_data->user_id));
+        PQfinish(conn);
+    }
 
     if (!friends)
     {
@@ -1830,13 +2012,57 @@ void handle_get_friend_list_request(conn_data_t* conn_data, char* data, size_t d
     free(response);
     free(raw_bytes->data);
     free(raw_bytes);
-    free(friends->friends);
-    free(friends);
+    if (!cached)
+    {
+        free(friends->friends);
+        free(friends);
+    }
     free_packet(packet);
 }
 
 // ===== Table Invite Handler =====
 
+void handle_spectate_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
+{
+    char log_msg[256];
+    Packet* packet = decode_packet(data, data_len);
+    if (!packet || packet->header->packet_type != PACKET_SPECTATE) {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Invalid packet", 1);
+        if (packet) free_packet(packet);
+        return;
+    }
+
+    int table_id = 0;
+    bool watch = true;
+    int res = R_SPECTATE_NOT_OK;
+    if (decode_spectate_request(packet->data, packet->header->packet_len - sizeof(Header), &table_id, &watch) == 0) {
+        if (!watch) {
+            spectator_remove(conn_data->fd);
+            res = R_SPECTATE_OK;
+        } else {
+            int index = find_table_by_id(table_list, table_id);
+            // Seated players already get their own view of the table
+            if (conn_data->user_id != 0 && index != -1 && conn_data->table_id != table_id &&
+                spectator_add(conn_data->fd, &table_list->tables[index]) == 0) {
+                res = R_SPECTATE_OK;
+            }
+        }
+    }
+
+    snprintf(log_msg, sizeof(log_msg), "Spectate %s table %d from user='%s' fd=%d: res=%d (watchers=%d)",
+             watch ? "start" : "stop", table_id, conn_data->username, conn_data->fd, res, spectator_count(table_id));
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    RawBytes* raw_bytes = encode_response(res);
+    RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_SPECTATE, raw_bytes->data, raw_bytes->len);
+    sendall(conn_data->fd, response->data, (int*)&response->len);
+    free(response->data);
+    free(response);
+    free(raw_bytes->data);
+    free(raw_bytes);
+    free_packet(packet);
+}
+
 void handle_invite_to_table_request(conn_data_t* conn_data, char* data, size_t data_len, TableList* table_list)
 {
     char log_msg[256];
@@ -1885,51 +2111,56 @@ void handle_invite_to_table_request(conn_data_t* conn_data, char* data, size_t d
              conn_data->username, request->friend_username, request->table_id);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
     
-    // Connect to database
-    PGconn* conn = PQconnectdb(dbconninfo);
-    
-    // Get friend's user ID
-    int friend_id = dbGetUserIdByUsername(conn, request->friend_username);
-    if (friend_id < 0)
+    // A friend of an online user is found in the social cache; the database is only asked on a miss
+    int friend_id = social_cache_friend_id(conn_data->user_id, request->friend_username);
+    if (friend_id <= 0)
     {
-        RawBytes* raw_bytes = encode_response_msg(R_INVITE_TO_TABLE_NOT_OK, "Friend not found");
-        RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_INVITE_TO_TABLE, raw_bytes->data, raw_bytes->len);
-        sendall(conn_data->fd, response->data, (int*) &(response->len));
-        free(response->data);
-        free(response);
-        free(raw_bytes->data);
-        free(raw_bytes);
-        PQfinish(conn);
-        free(request);
-        free_packet(packet);
-        logger_ex(MAIN_LOG, "ERROR", __func__, "Friend not found", 1);
-        return;
-    }
+        PGconn* conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+        
+        // Get friend's user ID
+        friend_id = METRICS_DB_QUERY(dbGetUserIdByUsername(conn, request->friend_username));
+        if (friend_id < 0)
+        {
+            RawBytes* raw_bytes = encode_response_msg(R_INVITE_TO_TABLE_NOT_OK, "Friend not found");
+            RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_INVITE_TO_TABLE, raw_bytes->data, raw_bytes->len);
+            sendall(conn_data->fd, response->data, (int*) &(response->len));
+            free(response->data);
+            free(response);
+            free(raw_bytes->data);
+            free(raw_bytes);
+            PQfinish(conn);
+            free(request);
+            free_packet(packet);
+            logger_ex(MAIN_LOG, "ERROR", __func__, "Friend not found", 1);
+            return;
+        }
     
-    // Check if they are friends
-    char check_query[256];
-    snprintf(check_query, sizeof(check_query),
-             "SELECT 1 FROM friend WHERE (u1 = %d AND u2 = %d) OR (u1 = %d AND u2 = %d) LIMIT 1",
-             conn_data->user_id, friend_id, friend_id, conn_data->user_id);
+        // Check if they are friends
+        char check_query[256];
+        snprintf(check_query, sizeof(check_query),
+                 "SELECT 1 FROM friend WHERE (u1 = %d AND u2 = %d) OR (u1 = %d AND u2 = %d) LIMIT 1",
+                 conn_data->user_id, friend_id, friend_id, conn_data->user_id);
     
-    PGresult* check_res = PQexec(conn, check_query);
-    if (PQresultStatus(check_res) != PGRES_TUPLES_OK || PQntuples(check_res) == 0)
-    {
-        RawBytes* raw_bytes = encode_response_msg(R_INVITE_TO_TABLE_NOT_FRIENDS, "Not friends with this user");
-        RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_INVITE_TO_TABLE, raw_bytes->data, raw_bytes->len);
-        sendall(conn_data->fd, response->data, (int*) &(response->len));
-        free(response->data);
-        free(response);
-        free(raw_bytes->data);
-        free(raw_bytes);
+        PGresult* check_res = PQexec(conn, check_query);
+        if (PQresultStatus(check_res) != PGRES_TUPLES_OK || PQntuples(check_res) == 0)
+        {
+            RawBytes* raw_bytes = encode_response_msg(R_INVITE_TO_TABLE_NOT_FRIENDS, "Not friends with this user");
+            RawBytes* response = encode_packet(PROTOCOL_V1, PACKET_INVITE_TO_TABLE, raw_bytes->data, raw_bytes->len);
+            sendall(conn_data->fd, response->data, (int*) &(response->len));
+            free(response->data);
+            free(response);
+            free(raw_bytes->data);
+            free(raw_bytes);
+            PQclear(check_res);
+            PQfinish(conn);
+            free(request);
+            free_packet(packet);
+            logger_ex(MAIN_LOG, "WARN", __func__, "Not friends with target user", 1);
+            return;
+        }
         PQclear(check_res);
         PQfinish(conn);
-        free(request);
-        free_packet(packet);
-        logger_ex(MAIN_LOG, "WARN", __func__, "Not friends with target user", 1);
-        return;
     }
-    PQclear(check_res);
     
     // Verify table exists
     int table_index = find_table_by_id(table_list, request->table_id);
@@ -1942,7 +2173,6 @@ void handle_invite_to_table_request(conn_data_t* conn_data, char* data, size_t d
         free(response);
         free(raw_bytes->data);
         free(raw_bytes);
-        PQfinish(conn);
         free(request);
         free_packet(packet);
         logger_ex(MAIN_LOG, "ERROR", __func__, "Table not found", 1);
@@ -1961,7 +2191,6 @@ void handle_invite_to_table_request(conn_data_t* conn_data, char* data, size_t d
         free(response);
         free(raw_bytes->data);
         free(raw_bytes);
-        PQfinish(conn);
         free(request);
         free_packet(packet);
         logger_ex(MAIN_LOG, "WARN", __func__, "Table is full", 1);
@@ -2042,7 +2271,6 @@ void handle_invite_to_table_request(conn_data_t* conn_data, char* data, size_t d
         logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
     }
     
-    PQfinish(conn);
     free(request);
     free_packet(packet);
 }
@@ -0,0 +1,661 @@
+#define _GNU_SOURCE // accept4, struct ucred
+#include "handoff.h"
+#include "main.h"
+#include <limits.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define HANDOFF_MAGIC 0x43524448u // "CRDH"
+#define HANDOFF_MAX_CONNS (1 << 20)
+
+enum
+{
+    HANDOFF_HELLO = 1, // New to old: take me over
+    HANDOFF_BEGIN,     // Old to new: the session key and connection count, with the listener
+    HANDOFF_CONNS,     // Old to new: up to HANDOFF_FDS_PER_MESSAGE connections, with their sockets
+    HANDOFF_READY,     // New to old: the journal is replayed
+    HANDOFF_GO,        // Old to new: it is all yours
+};
+
+#define HANDOFF_HAS_SOCKET 0x01
+#define HANDOFF_LOBBY 0x02 // Subscribed to lobby deltas
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t count; // Connections in the handoff (BEGIN) or in this message (CONNS)
+} HandoffHeader;
+
+typedef struct
+{
+    uint64_t session_id;
+    uint32_t user_id;
+    uint32_t balance;
+    uint16_t table_id;
+    uint16_t spectating; // Table watched as a spectator, 0 if none
+    uint8_t flags;
+    uint8_t reserved[3];
+    char username[32];
+} HandoffConn;
+
+typedef struct
+{
+    HandoffHeader header;
+    unsigned char key[SESSION_KEY_LEN];
+} HandoffBegin;
+
+typedef struct
+{
+    HandoffHeader header;
+    HandoffConn conns[HANDOFF_FDS_PER_MESSAGE];
+} HandoffBatch;
+
+typedef union
+{
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int) * HANDOFF_FDS_PER_MESSAGE)];
+} HandoffControl;
+
+static char socket_path[sizeof(((struct sockaddr_un*) 0)->sun_path)];
+
+// State received by the new process, until handoff_adopt takes it in
+static int peer_fd = -1;
+static bool received = false;
+static unsigned char received_key[SESSION_KEY_LEN];
+static HandoffConn* received_conns = NULL;
+static int* received_fds = NULL; // -1 for parked connections
+static int num_received = 0;
+
+// ===== Messages =====
+
+static const char* resolve_path(void)
+{
+    const char* path = getenv("CARDIO_HANDOFF_SOCKET");
+    return path != NULL && path[0] != '\0' ? path : HANDOFF_SOCKET_PATH;
+}
+
+static void set_timeout(int fd, int timeout_ms)
+{
+    struct timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+static HandoffHeader make_header(uint16_t type, uint32_t count)
+{
+    return (HandoffHeader){HANDOFF_MAGIC, HANDOFF_VERSION, type, count};
+}
+
+static int send_message(int peer, const void* data, size_t len, const int* fds, int num_fds)
+{
+    struct iovec iov = {(void*) data, len};
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    HandoffControl control;
+    if (num_fds > 0)
+    {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * num_fds);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * num_fds);
+    }
+
+    ssize_t sent;
+    do
+    {
+        sent = sendmsg(peer, &msg, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+    return sent == (ssize_t) len ? 0 : -1;
+}
+
+// Receive one message of type into data. Returns its length, -1 on failure; the sockets that came
+// with it are stored in fds and counted in *num_fds, and closed if the message is rejected.
+static ssize_t recv_message(int peer, uint16_t type, void* data, size_t len, int* fds, int* num_fds)
+{
+    struct iovec iov = {data, len};
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    HandoffControl control;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t got;
+    do
+    {
+        got = recvmsg(peer, &msg, MSG_CMSG_CLOEXEC);
+    } while (got == -1 && errno == EINTR);
+
+    *num_fds = 0;
+    for (struct cmsghdr* cmsg = got > 0 ? CMSG_FIRSTHDR(&msg) : NULL; cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            int n = (int) ((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            memcpy(fds + *num_fds, CMSG_DATA(cmsg), sizeof(int) * n);
+            *num_fds += n;
+        }
+    }
+
+    const HandoffHeader* header = data;
+    if (got < (ssize_t) sizeof(HandoffHeader) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) ||
+        header->magic != HANDOFF_MAGIC || header->version != HANDOFF_VERSION || header->type != type)
+    {
+        for (int i = 0; i < *num_fds; i++)
+        {
+            close(fds[i]);
+        }
+        *num_fds = 0;
+        return -1;
+    }
+    return got;
+}
+
+static int recv_plain(int peer, uint16_t type)
+{
+    HandoffHeader header;
+    int fds[HANDOFF_FDS_PER_MESSAGE];
+    int num_fds;
+    if (recv_message(peer, type, &header, sizeof(header), fds, &num_fds) == -1)
+    {
+        return -1;
+    }
+    for (int i = 0; i < num_fds; i++)
+    {
+        close(fds[i]);
+    }
+    return 0;
+}
+
+static int send_plain(int peer, uint16_t type)
+{
+    HandoffHeader header = make_header(type, 0);
+    return send_message(peer, &header, sizeof(header), NULL, 0);
+}
+
+// ===== Old process =====
+
+int handoff_init(void)
+{
+    const char* path = resolve_path();
+    if (strlen(path) >= sizeof(socket_path))
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Handoff socket path is too long", 1);
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot create handoff socket", 1);
+        return -1;
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // A socket file left by a previous run, or by the process we took over from, would make bind fail
+    unlink(path);
+    if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) == -1 || chmod(path, 0600) == -1 || listen(fd, 1) == -1 ||
+        set_nonblocking(fd) == -1)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Cannot listen on handoff socket %s: %s", path, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        close(fd);
+        return -1;
+    }
+
+    strcpy(socket_path, path);
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Handoff socket listening on %s", path);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    return fd;
+}
+
+int handoff_send_state(int peer, int listener)
+{
+    int count = 0;
+    for (conn_data_t* conn = registered_connections(); conn != NULL; conn = conn->next)
+    {
+        count++;
+    }
+
+    HandoffBegin begin = {make_header(HANDOFF_BEGIN, (uint32_t) count), {0}};
+    session_export_key(begin.key);
+    if (send_message(peer, &begin, sizeof(begin), &listener, 1) == -1)
+    {
+        return -1;
+    }
+
+    HandoffBatch batch;
+    int fds[HANDOFF_FDS_PER_MESSAGE];
+    int n = 0;
+    int num_fds = 0;
+    for (conn_data_t* conn = registered_connections(); conn != NULL; conn = conn->next)
+    {
+        HandoffConn* out = &batch.conns[n++];
+        memset(out, 0, sizeof(*out));
+        out->session_id = session_id_of(conn);
+        out->user_id = conn->user_id;
+        out->balance = conn->balance;
+        out->table_id = conn->table_id;
+        memcpy(out->username, conn->username, sizeof(out->username));
+        if (conn->fd >= 0)
+        {
+            out->flags |= HANDOFF_HAS_SOCKET;
+            out->flags |= lobby_is_subscribed(conn->fd) ? HANDOFF_LOBBY : 0;
+            out->spectating = (uint16_t) spectator_table_of(conn->fd);
+            fds[num_fds++] = conn->fd;
+        }
+
+        if (n == HANDOFF_FDS_PER_MESSAGE || conn->next == NULL)
+        {
+            batch.header = make_header(HANDOFF_CONNS, (uint32_t) n);
+            size_t len = sizeof(HandoffHeader) + sizeof(HandoffConn) * n;
+            if (send_message(peer, &batch, len, fds, num_fds) == -1)
+            {
+                return -1;
+            }
+            n = 0;
+            num_fds = 0;
+        }
+    }
+    return 0;
+}
+
+// Write out everything queued for logged-in clients; what stays queued would be lost with this process
+static bool drain_outboxes(uint64_t deadline_ms)
+{
+    for (;;)
+    {
+        bool drained = true;
+        for (conn_data_t* conn = registered_connections(); conn != NULL; conn = conn->next)
+        {
+            if (conn->fd >= 0 && !outbox_drain(conn->fd))
+            {
+                drained = false;
+            }
+        }
+        if (drained)
+        {
+            return true;
+        }
+        if (game_now_ms() >= deadline_ms)
+        {
+            return false;
+        }
+        poll(NULL, 0, 10);
+    }
+}
+
+// Refuse or abandon a handoff. Returns false, for the caller to return.
+static bool decline(const char* reason)
+{
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Hot upgrade declined: %s", reason);
+    logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+    return false;
+}
+
+static bool hand_over(int peer, int listener, TableList* table_list)
+{
+    struct ucred cred;
+    socklen_t cred_len = sizeof(cred);
+    if (getsockopt(peer, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == -1 || cred.uid != getuid())
+    {
+        return decline("peer runs as another user");
+    }
+    set_timeout(peer, HANDOFF_TIMEOUT_MS);
+    if (recv_plain(peer, HANDOFF_HELLO) == -1)
+    {
+        return decline("no valid HELLO");
+    }
+    if (uring_enabled())
+    {
+        return decline("the io_uring backend cannot hand off");
+    }
+    if (!journal_enabled())
+    {
+        return decline("the table journal is disabled");
+    }
+
+    // Finish this iteration's work the way the loop would, so nothing queued is left behind
+    table_actors_run(table_list);
+    journal_flush(table_list);
+    outbox_flush();
+    if (!drain_outboxes(game_now_ms() + HANDOFF_TIMEOUT_MS))
+    {
+        return decline("clients are not reading");
+    }
+    if (journal_checkpoint(table_list) == -1)
+    {
+        return decline("cannot checkpoint the journal");
+    }
+    if (handoff_send_state(peer, listener) == -1)
+    {
+        return decline("cannot send state");
+    }
+
+    set_timeout(peer, HANDOFF_READY_TIMEOUT_MS);
+    if (recv_plain(peer, HANDOFF_READY) == -1)
+    {
+        return decline("the new process did not become ready");
+    }
+    return true;
+}
+
+void handoff_accept(int listen_fd, int listener, TableList* table_list)
+{
+    int peer = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (peer == -1)
+    {
+        return;
+    }
+
+    logger_ex(MAIN_LOG, "INFO", __func__, "Hot upgrade requested", 1);
+    uint64_t started_ms = game_now_ms();
+    if (hand_over(peer, listener, table_list))
+    {
+        char log_msg[128];
+        snprintf(log_msg, sizeof(log_msg), "Handed over to the new process in %llu ms, exiting",
+                 (unsigned long long) (game_now_ms() - started_ms));
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+        if (send_plain(peer, HANDOFF_GO) == 0)
+        {
+            // Hands already finished here are ours to write
+            history_shutdown();
+            replay_log_close();
+            exit(0);
+        }
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot send GO, carrying on", 1);
+    }
+    close(peer);
+
+    // The new process may have replayed and checkpointed the journal: our descriptor could point
+    // at a file that was renamed over. Start afresh from what we hold.
+    if (journal_enabled())
+    {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s", journal_file());
+        journal_close();
+        if (journal_open(path) == -1 || journal_checkpoint(table_list) == -1)
+        {
+            logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot reopen the table journal", 1);
+        }
+    }
+}
+
+// ===== New process =====
+
+bool handoff_requested(void)
+{
+    const char* takeover = getenv("CARDIO_TAKEOVER");
+    return takeover != NULL && strcmp(takeover, "1") == 0;
+}
+
+static void discard_received(void)
+{
+    for (int i = 0; i < num_received; i++)
+    {
+        if (received_fds[i] != -1)
+        {
+            close(received_fds[i]);
+        }
+    }
+    free(received_conns);
+    free(received_fds);
+    received_conns = NULL;
+    received_fds = NULL;
+    num_received = 0;
+    received = false;
+}
+
+int handoff_recv_state(int peer)
+{
+    HandoffBegin begin;
+    int listener;
+    int num_fds;
+    if (recv_message(peer, HANDOFF_BEGIN, &begin, sizeof(begin), &listener, &num_fds) != (ssize_t) sizeof(begin) ||
+        num_fds != 1 || begin.header.count > HANDOFF_MAX_CONNS)
+    {
+        if (num_fds == 1)
+        {
+            close(listener);
+        }
+        return -1;
+    }
+
+    int count = (int) begin.header.count;
+    received_conns = calloc(count > 0 ? count : 1, sizeof(HandoffConn));
+    received_fds = calloc(count > 0 ? count : 1, sizeof(int));
+    if (received_conns == NULL || received_fds == NULL)
+    {
+        discard_received();
+        close(listener);
+        return -1;
+    }
+    memcpy(received_key, begin.key, sizeof(received_key));
+
+    HandoffBatch batch;
+    int fds[HANDOFF_FDS_PER_MESSAGE];
+    while (num_received < count)
+    {
+        ssize_t len = recv_message(peer, HANDOFF_CONNS, &batch, sizeof(batch), fds, &num_fds);
+        int n = len >= (ssize_t) sizeof(HandoffHeader) ? (int) batch.header.count : 0;
+        int with_socket = 0;
+        for (int i = 0; i < n && n <= HANDOFF_FDS_PER_MESSAGE; i++)
+        {
+            with_socket += (batch.conns[i].flags & HANDOFF_HAS_SOCKET) != 0;
+        }
+        if (len == -1 || n == 0 || n > HANDOFF_FDS_PER_MESSAGE || n > count - num_received ||
+            (size_t) len != sizeof(HandoffHeader) + sizeof(HandoffConn) * n || with_socket != num_fds)
+        {
+            for (int i = 0; i < num_fds; i++)
+            {
+                close(fds[i]);
+            }
+            discard_received();
+            close(listener);
+            return -1;
+        }
+
+        int next_fd = 0;
+        for (int i = 0; i < n; i++)
+        {
+            HandoffConn* conn = &received_conns[num_received];
+            *conn = batch.conns[i];
+            conn->username[sizeof(conn->username) - 1] = '\0';
+            received_fds[num_received++] = (conn->flags & HANDOFF_HAS_SOCKET) ? fds[next_fd++] : -1;
+        }
+    }
+
+    received = true;
+    return listener;
+}
+
+int handoff_receive(void)
+{
+    const char* path = resolve_path();
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Handoff socket path is too long", 1);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int peer = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (peer == -1 || connect(peer, (struct sockaddr*) &addr, sizeof(addr)) == -1)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Cannot reach a running server on %s: %s", path, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        if (peer != -1)
+        {
+            close(peer);
+        }
+        return -1;
+    }
+
+    set_timeout(peer, HANDOFF_TIMEOUT_MS);
+    int listener = send_plain(peer, HANDOFF_HELLO) == 0 ? handoff_recv_state(peer) : -1;
+    if (listener == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "The running server did not hand over", 1);
+        close(peer);
+        return -1;
+    }
+
+    peer_fd = peer;
+    char log_msg[128];
+    snprintf(log_msg, sizeof(log_msg), "Received the listener and %d connections", num_received);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    return listener;
+}
+
+int handoff_confirm(void)
+{
+    if (peer_fd == -1)
+    {
+        return -1;
+    }
+
+    int result = send_plain(peer_fd, HANDOFF_READY) == 0 ? recv_plain(peer_fd, HANDOFF_GO) : -1;
+    close(peer_fd);
+    peer_fd = -1;
+    logger_ex(MAIN_LOG, result == 0 ? "INFO" : "ERROR", __func__,
+              result == 0 ? "The old process let go" : "The old process did not let go", 1);
+    return result;
+}
+
+// Clear O_NONBLOCK, which the sockets bring from the epoll process: io_uring waits on them itself
+static void set_blocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags != -1)
+    {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+}
+
+// Friends and invites are served from memory, with a reference held by every connection of the user.
+// One database connection, opened on first need, loads the users nobody else has loaded.
+static void hold_social_cache(conn_data_t* conn, PGconn** db_conn)
+{
+    if (conn->social_ref)
+    {
+        return;
+    }
+    if (*db_conn == NULL && !social_cache_has((int) conn->user_id))
+    {
+        *db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+    }
+    conn->social_ref = social_cache_load(*db_conn, (int) conn->user_id) == 0;
+    if (!conn->social_ref)
+    {
+        logger_ex(MAIN_LOG, "WARN", __func__, "Cannot load social cache for handed-over user", 1);
+    }
+}
+
+// A received connection with a socket, on its own in the lobby
+static void adopt_in_lobby(conn_data_t* conn, const HandoffConn* state)
+{
+    memcpy(conn->username, state->username, sizeof(conn->username));
+    conn->user_id = state->user_id;
+    conn->is_active = true;
+    register_connection(conn);
+}
+
+void handoff_adopt(int epoll_fd, TableList* table_list)
+{
+    if (!received)
+    {
+        return;
+    }
+    session_import_key(received_key);
+
+    PGconn* db_conn = NULL;
+    int adopted = 0;
+    for (int i = 0; i < num_received; i++)
+    {
+        const HandoffConn* state = &received_conns[i];
+        int fd = received_fds[i];
+        received_fds[i] = -1;
+
+        conn_data_t* conn = NULL;
+        if (fd != -1)
+        {
+            if (uring_enabled())
+            {
+                set_blocking(fd);
+            }
+            conn = uring_enabled() ? uring_add_connection(fd) : add_connection_to_epoll(epoll_fd, fd);
+            if (conn == NULL)
+            {
+                continue;
+            }
+        }
+
+        // The journal brought seated players back parked; the socket takes the seat back
+        conn_data_t* seated = state->table_id != 0 ? session_find_parked(state->user_id) : NULL;
+        if (seated != NULL)
+        {
+            if (conn != NULL && resume_connection(epoll_fd, conn, seated) == -1)
+            {
+                close_connection(epoll_fd, conn);
+                continue;
+            }
+            conn = seated;
+        }
+        else if (conn != NULL)
+        {
+            adopt_in_lobby(conn, state);
+        }
+        else
+        {
+            continue; // Parked in the lobby: nothing to come back to, and its token ends here
+        }
+        if (conn->fd >= 0)
+        {
+            hold_social_cache(conn, &db_conn);
+        }
+
+        conn->balance = state->balance;
+        if (session_restore(conn, state->session_id) == -1)
+        {
+            logger_ex(MAIN_LOG, "WARN", __func__, "Cannot restore session of handed-over connection", 1);
+        }
+        if (conn->fd >= 0 && (state->flags & HANDOFF_LOBBY))
+        {
+            lobby_subscribe(conn->fd, table_list);
+        }
+        int index = state->spectating != 0 && conn->fd >= 0 ? find_table_by_id(table_list, state->spectating) : -1;
+        if (index != -1)
+        {
+            spectator_add(conn->fd, &table_list->tables[index]);
+        }
+        adopted++;
+    }
+    if (db_conn != NULL)
+    {
+        PQfinish(db_conn);
+    }
+
+    char log_msg[128];
+    snprintf(log_msg, sizeof(log_msg), "Adopted %d of %d handed-over connections", adopted, num_received);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    discard_received();
+}
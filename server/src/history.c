@@ -0,0 +1,662 @@
+#include "history.h"
+#include "main.h"
+#include <pthread.h>
+#include <time.h>
+
+#define NO_CARD 0xFF
+
+// Binary record of one hand: [u32 length][HandRecord][HandPlayer * num_players][HandAction * num_actions]
+typedef struct
+{
+    uint64_t key;
+    uint64_t ended_ms; // Unix time
+    uint32_t hand_no;
+    int32_t table_id;
+    int32_t pot;
+    uint8_t board[MAX_COMMUNITY_CARDS];
+    uint8_t num_board;
+    uint8_t num_players;
+    uint8_t num_actions;
+} HandRecord;
+
+typedef struct
+{
+    int32_t user_id;
+    int32_t start_stack;
+    int32_t bet;
+    int32_t won;
+    uint8_t seat;
+    uint8_t hole[2];
+    uint8_t flags; // ARCHIVE_FLAG_*
+} HandPlayer;
+
+typedef struct
+{
+    int32_t amount;
+    uint8_t seat;
+    uint8_t type;
+} HandAction;
+
+typedef struct
+{
+    char* data;
+    size_t len;
+    size_t capacity;
+    int hands;
+} HistoryBuffer;
+
+// Event loop only
+static HistoryBuffer local = {0};
+static uint64_t last_key = 0;
+static bool dropping = false;
+
+// Shared with the writer
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static HistoryBuffer queued = {0};
+static bool stopping = false;
+static bool writer_running = false;
+static pthread_t writer;
+
+// Writer only
+static ArchiveWriter* archive = NULL;
+static bool archive_failing = false;
+
+// ===== Buffers =====
+
+static bool reserve(HistoryBuffer* buffer, size_t extra)
+{
+    if (buffer->len + extra <= buffer->capacity)
+    {
+        return true;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 64 * 1024;
+    while (capacity < buffer->len + extra)
+    {
+        capacity *= 2;
+    }
+    char* grown = realloc(buffer->data, capacity);
+    if (grown == NULL)
+    {
+        return false;
+    }
+    buffer->data = grown;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static void append(HistoryBuffer* buffer, const void* data, size_t len)
+{
+    memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+}
+
+// Rows are written with these rather than snprintf: rendering is the writer's hot loop. The caller
+// reserves room first.
+static void put_char(HistoryBuffer* buffer, char c)
+{
+    buffer->data[buffer->len++] = c;
+}
+
+static void put_str(HistoryBuffer* buffer, const char* str)
+{
+    append(buffer, str, strlen(str));
+}
+
+static void put_int(HistoryBuffer* buffer, long long value)
+{
+    char digits[24];
+    int n = 0;
+    unsigned long long magnitude = value < 0 ? 0ull - (unsigned long long) value : (unsigned long long) value;
+    do
+    {
+        digits[n++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0)
+    {
+        put_char(buffer, '-');
+    }
+    while (n > 0)
+    {
+        put_char(buffer, digits[--n]);
+    }
+}
+
+// ===== Event loop =====
+
+// Code (suit - 1) * 13 + (rank - 2), ranks 2-14 with the ace stored as 14 by the deck or 1 by older code
+static uint8_t card_code(const Card* card)
+{
+    if (card == NULL || card->suit < SUIT_SPADE || card->suit > SUIT_CLUB || card->rank < 1 || card->rank > 14)
+    {
+        return NO_CARD;
+    }
+    int rank = card->rank == 1 ? 14 : card->rank;
+    return (uint8_t) ((card->suit - SUIT_SPADE) * RANKS + (rank - 2));
+}
+
+// Unix milliseconds in the top bits keep keys unique across restarts; the counter covers hands in the same millisecond
+static uint64_t next_key(uint64_t now_ms)
+{
+    uint64_t key = now_ms << 20;
+    last_key = key > last_key ? key : last_key + 1;
+    return last_key;
+}
+
+void history_hand_start(Table* table)
+{
+    GameState* gs = table->game_state;
+    for (int seat = 0; seat < MAX_PLAYERS; seat++)
+    {
+        GamePlayer* p = &gs->players[seat];
+        table->hand_start_stacks[seat] = p->state != PLAYER_STATE_EMPTY ? p->money : -1;
+        table->hand_flags[seat] = 0;
+    }
+}
+
+void history_action(Table* table, const ActionRecord* record)
+{
+    if (record->round != BETTING_ROUND_PREFLOP || record->seat < 0 || record->seat >= MAX_PLAYERS ||
+        record->amount <= 0)
+    {
+        return;
+    }
+    // Blinds are posted by the engine, not as actions, so any chips put in here are voluntary.
+    // An all-in counts as a raise even when it only calls.
+    table->hand_flags[record->seat] |= ARCHIVE_FLAG_VPIP;
+    if (record->type == ACTION_BET || record->type == ACTION_RAISE || record->type == ACTION_ALL_IN)
+    {
+        table->hand_flags[record->seat] |= ARCHIVE_FLAG_PFR;
+    }
+}
+
+void history_hand_end(Table* table)
+{
+    GameState* gs = table->game_state;
+    HandRecord record = {0};
+    HandPlayer players[MAX_PLAYERS];
+    bool known = true;
+    for (int seat = 0; seat < MAX_PLAYERS; seat++)
+    {
+        GamePlayer* p = &gs->players[seat];
+        if (p->state == PLAYER_STATE_EMPTY || p->hole_cards[0] == NULL)
+        {
+            continue;
+        }
+        // Dealt before this process knew the table (restored from the journal)
+        int start = table->hand_start_stacks[seat];
+        known &= start >= 0;
+
+        HandPlayer* out = &players[record.num_players++];
+        out->user_id = p->is_bot ? p->original_user_id : p->player_id;
+        out->start_stack = start;
+        out->bet = p->total_bet;
+        out->won = p->money - (start - p->total_bet);
+        out->seat = (uint8_t) seat;
+        out->hole[0] = card_code(p->hole_cards[0]);
+        out->hole[1] = card_code(p->hole_cards[1]);
+        out->flags = (uint8_t) (table->hand_flags[seat] | (p->is_bot ? ARCHIVE_FLAG_BOT : 0));
+        record.pot += p->total_bet;
+    }
+    for (int seat = 0; seat < MAX_PLAYERS; seat++)
+    {
+        table->hand_start_stacks[seat] = -1;
+        table->hand_flags[seat] = 0;
+    }
+    if (!known || record.num_players == 0)
+    {
+        return;
+    }
+
+    // The table's action ring holds the hand's actions by seq; a longer hand keeps its last ones
+    HandAction actions[TABLE_HISTORY_ACTIONS];
+    uint32_t first = gs->seq > TABLE_HISTORY_ACTIONS ? gs->seq - TABLE_HISTORY_ACTIONS + 1 : 1;
+    for (uint32_t seq = first; seq <= gs->seq; seq++)
+    {
+        const ActionRecord* action = &table->history[(seq - 1) % TABLE_HISTORY_ACTIONS];
+        if (action->seq == seq)
+        {
+            actions[record.num_actions++] = (HandAction){action->amount, (uint8_t) action->seat, (uint8_t) action->type};
+        }
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    record.ended_ms = (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+    record.key = next_key(record.ended_ms);
+    record.hand_no = gs->hand_id;
+    record.table_id = table->id;
+    record.num_board = (uint8_t) gs->num_community_cards;
+    for (int i = 0; i < MAX_COMMUNITY_CARDS; i++)
+    {
+        record.board[i] = i < gs->num_community_cards ? card_code(gs->community_cards[i]) : NO_CARD;
+    }
+
+    uint32_t len = (uint32_t) (sizeof(record) + sizeof(HandPlayer) * record.num_players +
+                               sizeof(HandAction) * record.num_actions);
+    if (!reserve(&local, sizeof(len) + len))
+    {
+        metrics_add(METRIC_HISTORY_HANDS_DROPPED, 1);
+        return;
+    }
+    append(&local, &len, sizeof(len));
+    append(&local, &record, sizeof(record));
+    append(&local, players, sizeof(HandPlayer) * record.num_players);
+    append(&local, actions, sizeof(HandAction) * record.num_actions);
+    local.hands++;
+}
+
+void history_flush(void)
+{
+    if (local.hands == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    bool accepted = queued.len + local.len <= HISTORY_MAX_QUEUED_BYTES;
+    if (accepted && queued.len == 0)
+    {
+        // The usual case: the writer took everything, so the buffers just trade places
+        HistoryBuffer spare = queued;
+        queued = local;
+        local = spare;
+    }
+    else if (accepted && reserve(&queued, local.len))
+    {
+        append(&queued, local.data, local.len);
+        queued.hands += local.hands;
+    }
+    else
+    {
+        accepted = false;
+    }
+    bool full = queued.hands >= HISTORY_BATCH_HANDS;
+    if (full)
+    {
+        pthread_cond_signal(&wake);
+    }
+    pthread_mutex_unlock(&lock);
+
+    if (!accepted)
+    {
+        metrics_add(METRIC_HISTORY_HANDS_DROPPED, (uint64_t) local.hands);
+        if (!dropping)
+        {
+            logger_ex(MAIN_LOG, "WARN", __func__, "Hand history queue is full, dropping finished hands", 1);
+        }
+    }
+    dropping = !accepted;
+    local.len = 0;
+    local.hands = 0;
+}
+
+// ===== Writer =====
+
+size_t history_queued_bytes(void)
+{
+    pthread_mutex_lock(&lock);
+    size_t len = queued.len;
+    pthread_mutex_unlock(&lock);
+    return len;
+}
+
+static void card_text(uint8_t code, char* out)
+{
+    if (code == NO_CARD)
+    {
+        out[0] = '\0';
+        return;
+    }
+    out[0] = "23456789TJQKA"[code % RANKS];
+    out[1] = "shdc"[code / RANKS];
+    out[2] = '\0';
+}
+
+// COPY text rows for one record; everything printed is plain ASCII without tabs or backslashes.
+// Returns false if memory ran out.
+static bool render(const char* data, HistoryBuffer* hands, HistoryBuffer* players)
+{
+    static const char action_codes[] = {'f', 'x', 'c', 'b', 'r', 'a'};
+    // Hands end in bursts within the same second, so its text is kept (only the writer renders)
+    static time_t cached_second = -1;
+    static char cached_date[24];
+
+    HandRecord record;
+    memcpy(&record, data, sizeof(record));
+    const char* player_data = data + sizeof(record);
+    const char* action_data = player_data + sizeof(HandPlayer) * record.num_players;
+    if (!reserve(hands, 128 + 16 * (size_t) record.num_actions) || !reserve(players, 96 * (size_t) record.num_players))
+    {
+        return false;
+    }
+
+    time_t second = (time_t) (record.ended_ms / 1000);
+    if (second != cached_second)
+    {
+        struct tm tm;
+        gmtime_r(&second, &tm);
+        strftime(cached_date, sizeof(cached_date), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_second = second;
+    }
+    char millis[8];
+    snprintf(millis, sizeof(millis), ".%03u", (unsigned) (record.ended_ms % 1000));
+
+    put_int(hands, (long long) record.key);
+    put_char(hands, '\t');
+    put_int(hands, record.table_id);
+    put_char(hands, '\t');
+    put_int(hands, record.hand_no);
+    put_char(hands, '\t');
+    put_str(hands, cached_date);
+    put_str(hands, millis);
+    put_str(hands, "+00\t");
+    char card[3];
+    for (int i = 0; i < record.num_board && i < MAX_COMMUNITY_CARDS; i++)
+    {
+        card_text(record.board[i], card);
+        put_str(hands, card);
+    }
+    put_char(hands, '\t');
+    put_int(hands, record.pot);
+    put_char(hands, '\t');
+    for (int i = 0; i < record.num_actions; i++)
+    {
+        HandAction action;
+        memcpy(&action, action_data + sizeof(HandAction) * i, sizeof(action));
+        if (i > 0)
+        {
+            put_char(hands, ' ');
+        }
+        put_int(hands, action.seat);
+        put_char(hands, action.type < sizeof(action_codes) ? action_codes[action.type] : '?');
+        if (action.amount > 0)
+        {
+            put_int(hands, action.amount);
+        }
+    }
+    put_char(hands, '\n');
+
+    for (int i = 0; i < record.num_players; i++)
+    {
+        HandPlayer player;
+        memcpy(&player, player_data + sizeof(HandPlayer) * i, sizeof(player));
+        put_int(players, (long long) record.key);
+        put_char(players, '\t');
+        put_int(players, player.seat);
+        put_char(players, '\t');
+        put_int(players, player.user_id);
+        put_str(players, (player.flags & ARCHIVE_FLAG_BOT) ? "\tt\t" : "\tf\t");
+        card_text(player.hole[0], card);
+        put_str(players, card);
+        card_text(player.hole[1], card);
+        put_str(players, card);
+        put_char(players, '\t');
+        put_int(players, player.start_stack);
+        put_char(players, '\t');
+        put_int(players, player.bet);
+        put_char(players, '\t');
+        put_int(players, player.won);
+        put_char(players, '\n');
+    }
+    return true;
+}
+
+// Add one record's players to the archive
+static void archive_hand(const char* data)
+{
+    HandRecord record;
+    memcpy(&record, data, sizeof(record));
+    ArchiveRow rows[MAX_PLAYERS];
+    for (int i = 0; i < record.num_players; i++)
+    {
+        HandPlayer player;
+        memcpy(&player, data + sizeof(record) + sizeof(HandPlayer) * i, sizeof(player));
+        rows[i] = (ArchiveRow){
+            .hand_key = (int64_t) record.key,
+            .ended_ms = (int64_t) record.ended_ms,
+            .table_id = record.table_id,
+            .pot = record.pot,
+            .user_id = player.user_id,
+            .start_stack = player.start_stack,
+            .bet = player.bet,
+            .won = player.won,
+            .seat = player.seat,
+            .flags = player.flags,
+        };
+    }
+
+    bool added = archive_writer_append_hand(archive, rows, record.num_players) == 0;
+    if (!added)
+    {
+        metrics_add(METRIC_HISTORY_ARCHIVE_DROPPED, 1);
+        if (!archive_failing)
+        {
+            logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot write the hand archive, leaving hands out of it", 1);
+        }
+    }
+    archive_failing = !added;
+}
+
+int history_take_batch(int max_hands, char** hands_out, size_t* hands_len, char** players_out, size_t* players_len)
+{
+    // Cut the batch off the front of the queue, then render it without holding the lock
+    pthread_mutex_lock(&lock);
+    size_t cut = 0;
+    int count = 0;
+    while (count < max_hands && cut < queued.len)
+    {
+        uint32_t len;
+        memcpy(&len, queued.data + cut, sizeof(len));
+        cut += sizeof(len) + len;
+        count++;
+    }
+    char* batch = count > 0 ? malloc(cut) : NULL;
+    if (batch != NULL)
+    {
+        memcpy(batch, queued.data, cut);
+        memmove(queued.data, queued.data + cut, queued.len - cut);
+        queued.len -= cut;
+        queued.hands -= count;
+    }
+    pthread_mutex_unlock(&lock);
+    if (count == 0)
+    {
+        return 0;
+    }
+    if (batch == NULL)
+    {
+        return -1;
+    }
+
+    HistoryBuffer hands = {0};
+    HistoryBuffer players = {0};
+    bool failed = false;
+    for (size_t offset = 0; offset < cut && !failed;)
+    {
+        uint32_t len;
+        memcpy(&len, batch + offset, sizeof(len));
+        failed = !render(batch + offset + sizeof(len), &hands, &players);
+        if (archive != NULL)
+        {
+            archive_hand(batch + offset + sizeof(len));
+        }
+        offset += sizeof(len) + len;
+    }
+    free(batch);
+    if (failed)
+    {
+        free(hands.data);
+        free(players.data);
+        metrics_add(METRIC_HISTORY_HANDS_DROPPED, (uint64_t) count);
+        return -1;
+    }
+
+    *hands_out = hands.data;
+    *hands_len = hands.len;
+    *players_out = players.data;
+    *players_len = players.len;
+    return count;
+}
+
+static bool write_batch(PGconn** conn, const char* hands, size_t hands_len, const char* players, size_t players_len)
+{
+    if (*conn == NULL || PQstatus(*conn) != CONNECTION_OK)
+    {
+        PQfinish(*conn);
+        *conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+    }
+    if (METRICS_TIME(METRIC_LATENCY_HISTORY_COPY, dbCopyHandHistory(*conn, hands, hands_len, players, players_len)) == DB_OK)
+    {
+        return true;
+    }
+    PQfinish(*conn);
+    *conn = NULL;
+    return false;
+}
+
+static void* writer_main(void* arg)
+{
+    (void) arg;
+    PGconn* conn = NULL;
+    char* hands = NULL;
+    char* players = NULL;
+    size_t hands_len = 0;
+    size_t players_len = 0;
+    int held = 0; // Hands rendered and not written yet
+    bool failing = false;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    time_t archive_flushed = now.tv_sec;
+
+    for (;;)
+    {
+        // A full batch wakes us early; otherwise partial batches go every HISTORY_FLUSH_MS and a failed
+        // write is retried after HISTORY_RETRY_MS
+        pthread_mutex_lock(&lock);
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        long wait_ms = held > 0 ? HISTORY_RETRY_MS : HISTORY_FLUSH_MS;
+        until.tv_sec += wait_ms / 1000;
+        until.tv_nsec += (wait_ms % 1000) * 1000000L;
+        if (until.tv_nsec >= 1000000000L)
+        {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        while (!stopping && (held > 0 || queued.hands < HISTORY_BATCH_HANDS) &&
+               pthread_cond_timedwait(&wake, &lock, &until) == 0)
+        {
+        }
+        bool stop = stopping;
+        pthread_mutex_unlock(&lock);
+
+        for (;;)
+        {
+            if (held == 0)
+            {
+                held = history_take_batch(HISTORY_BATCH_HANDS, &hands, &hands_len, &players, &players_len);
+                if (held <= 0)
+                {
+                    held = 0;
+                    break;
+                }
+            }
+            if (!write_batch(&conn, hands, hands_len, players, players_len))
+            {
+                if (!failing)
+                {
+                    logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot write hand history, retrying", 1);
+                }
+                failing = true;
+                break;
+            }
+            metrics_add(METRIC_HISTORY_HANDS_WRITTEN, (uint64_t) held);
+            free(hands);
+            free(players);
+            held = 0;
+            failing = false;
+        }
+
+        // Full chunks go to the archive as they fill; a quiet server still writes what it has now and then
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (archive != NULL && archive_writer_pending(archive) > 0 &&
+            (now.tv_sec - archive_flushed) * 1000 >= HISTORY_ARCHIVE_FLUSH_MS)
+        {
+            bool flushed = archive_writer_flush(archive) == 0;
+            if (!flushed && !archive_failing)
+            {
+                logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot write the hand archive, retrying", 1);
+            }
+            archive_failing = !flushed;
+            archive_flushed = now.tv_sec;
+        }
+
+        if (stop && (held == 0 || failing))
+        {
+            break;
+        }
+    }
+
+    // The database is gone and we are stopping: what is left is lost
+    pthread_mutex_lock(&lock);
+    metrics_add(METRIC_HISTORY_HANDS_DROPPED, (uint64_t) (held + queued.hands));
+    queued.len = 0;
+    queued.hands = 0;
+    pthread_mutex_unlock(&lock);
+    if (held > 0)
+    {
+        free(hands);
+        free(players);
+    }
+    PQfinish(conn);
+    if (archive != NULL && archive_writer_close(archive) != 0)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot write the last rows of the hand archive", 1);
+    }
+    archive = NULL;
+    return NULL;
+}
+
+int history_init(void)
+{
+    if (writer_running)
+    {
+        return 0;
+    }
+
+    stopping = false;
+    const char* archive_path = getenv("CARDIO_ARCHIVE");
+    archive_path = archive_path != NULL ? archive_path : HISTORY_ARCHIVE_PATH;
+    archive = archive_path[0] != '\0' ? archive_writer_create(archive_path) : NULL;
+    if (archive_path[0] != '\0' && archive == NULL)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot set up the hand archive, running without it", 1);
+    }
+    if (pthread_create(&writer, NULL, writer_main, NULL) != 0)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot start hand history writer", 1);
+        archive_writer_close(archive);
+        archive = NULL;
+        return -1;
+    }
+    writer_running = true;
+    return 0;
+}
+
+void history_shutdown(void)
+{
+    history_flush();
+    if (!writer_running)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+    pthread_join(writer, NULL);
+    writer_running = false;
+}
@@ -0,0 +1,792 @@
+#include "main.h"
+#include <sys/stat.h>
+
+#define HEADER_LEN 8 // Length of the body, then CRC-32 of the body; both little-endian
+#define SEAT_LEN 47  // seat, state, is_bot, player id, original user id, money, name[32]
+
+// The body of every record starts with its type and table id
+typedef enum
+{
+    JOURNAL_TABLE = 1,     // max players, minimum bet, name
+    JOURNAL_TABLE_REMOVED, // (nothing)
+    JOURNAL_SEAT,          // one seat
+    JOURNAL_HAND,          // hand id and dealer before the deal, deck seed, every seat
+    JOURNAL_ACTION,        // seat, action type, amount, GameState.seq after it
+    JOURNAL_SETTLE         // hand id, dealer, every seat
+} JournalRecordType;
+
+// Records of the hand a table is playing, rewritten into every checkpoint until it settles
+struct JournalBuffer
+{
+    unsigned char* data;
+    size_t len;
+    size_t cap;
+};
+
+static int journal_fd = -1;
+static char journal_path[256];
+static off_t file_size = 0;
+static JournalBuffer pending = {0}; // Appended this loop iteration, written by journal_flush
+static bool replaying = false;
+
+static uint32_t crc_table[256];
+
+static uint32_t crc32(const unsigned char* data, size_t len)
+{
+    if (crc_table[1] == 0)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+            {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            crc_table[i] = c;
+        }
+    }
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static int buffer_append(JournalBuffer* buffer, const unsigned char* data, size_t len)
+{
+    if (buffer->len + len > buffer->cap)
+    {
+        size_t new_cap = buffer->cap ? buffer->cap : 4096;
+        while (new_cap < buffer->len + len)
+        {
+            new_cap *= 2;
+        }
+        unsigned char* grown = realloc(buffer->data, new_cap);
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        buffer->data = grown;
+        buffer->cap = new_cap;
+    }
+    memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+    return 0;
+}
+
+// ===== Encoding =====
+
+static void put_u8(unsigned char** p, unsigned int value)
+{
+    *(*p)++ = (unsigned char) value;
+}
+
+static void put_u16(unsigned char** p, unsigned int value)
+{
+    put_u8(p, value);
+    put_u8(p, value >> 8);
+}
+
+static void put_u32(unsigned char** p, uint32_t value)
+{
+    put_u16(p, value & 0xFFFF);
+    put_u16(p, value >> 16);
+}
+
+static void put_u64(unsigned char** p, uint64_t value)
+{
+    put_u32(p, (uint32_t) value);
+    put_u32(p, (uint32_t) (value >> 32));
+}
+
+static unsigned char* begin_record(unsigned char* record, JournalRecordType type, int table_id)
+{
+    unsigned char* p = record + HEADER_LEN;
+    put_u8(&p, type);
+    put_u16(&p, (unsigned int) table_id);
+    return p;
+}
+
+// Fill in the header; returns the length of the whole record
+static size_t end_record(unsigned char* record, unsigned char* end)
+{
+    uint32_t len = (uint32_t) (end - record - HEADER_LEN);
+    unsigned char* p = record;
+    put_u32(&p, len);
+    put_u32(&p, crc32(record + HEADER_LEN, len));
+    return HEADER_LEN + len;
+}
+
+static void put_seat(unsigned char** p, const GamePlayer* player, int seat)
+{
+    put_u8(p, (unsigned int) seat);
+    put_u8(p, player->state);
+    put_u8(p, player->is_bot);
+    put_u32(p, (uint32_t) player->player_id);
+    put_u32(p, (uint32_t) player->original_user_id);
+    put_u32(p, (uint32_t) player->money);
+    memcpy(*p, player->name, sizeof(player->name));
+    *p += sizeof(player->name);
+}
+
+static size_t encode_table(const Table* table, unsigned char* record)
+{
+    unsigned char* p = begin_record(record, JOURNAL_TABLE, table->id);
+    put_u8(&p, (unsigned int) table->max_player);
+    put_u32(&p, (uint32_t) table->min_bet);
+    memcpy(p, table->name, sizeof(table->name));
+    p += sizeof(table->name);
+    return end_record(record, p);
+}
+
+static size_t encode_settle(const Table* table, unsigned char* record)
+{
+    const GameState* gs = table->game_state;
+    unsigned char* p = begin_record(record, JOURNAL_SETTLE, table->id);
+    put_u32(&p, gs->hand_id);
+    put_u32(&p, (uint32_t) gs->dealer_seat);
+    for (int seat = 0; seat < MAX_PLAYERS; seat++)
+    {
+        put_seat(&p, &gs->players[seat], seat);
+    }
+    return end_record(record, p);
+}
+
+// ===== Decoding =====
+
+typedef struct
+{
+    const unsigned char* p;
+    const unsigned char* end;
+    bool ok; // Cleared by a read past the end
+} Reader;
+
+static unsigned int get_u8(Reader* reader)
+{
+    if (reader->p >= reader->end)
+    {
+        reader->ok = false;
+        return 0;
+    }
+    return *reader->p++;
+}
+
+static unsigned int get_u16(Reader* reader)
+{
+    unsigned int low = get_u8(reader);
+    return low | get_u8(reader) << 8;
+}
+
+static uint32_t get_u32(Reader* reader)
+{
+    uint32_t low = get_u16(reader);
+    return low | (uint32_t) get_u16(reader) << 16;
+}
+
+static uint64_t get_u64(Reader* reader)
+{
+    uint64_t low = get_u32(reader);
+    return low | (uint64_t) get_u32(reader) << 32;
+}
+
+static void get_bytes(Reader* reader, void* out, size_t len)
+{
+    if ((size_t) (reader->end - reader->p) < len)
+    {
+        reader->ok = false;
+        memset(out, 0, len);
+        return;
+    }
+    memcpy(out, reader->p, len);
+    reader->p += len;
+}
+
+// Put one encoded seat back, keeping num_players in step the way game_add_player and game_remove_player do
+static void restore_seat(GameState* gs, Reader* reader)
+{
+    int seat = (int) get_u8(reader);
+    PlayerState state = (PlayerState) get_u8(reader);
+    bool is_bot = get_u8(reader) != 0;
+    int player_id = (int) get_u32(reader);
+    int original_user_id = (int) get_u32(reader);
+    int money = (int) get_u32(reader);
+    char name[32];
+    get_bytes(reader, name, sizeof(name));
+    name[31] = '\0';
+    if (!reader->ok || seat >= gs->max_players)
+    {
+        return;
+    }
+
+    GamePlayer* player = &gs->players[seat];
+    if (state == PLAYER_STATE_EMPTY)
+    {
+        if (player->state != PLAYER_STATE_EMPTY)
+        {
+            game_remove_player(gs, seat);
+        }
+        return;
+    }
+    if (player->state == PLAYER_STATE_EMPTY && game_add_player(gs, player_id, name, seat, gs->min_buy_in) != 0)
+    {
+        return;
+    }
+    player->player_id = player_id;
+    strncpy(player->name, name, sizeof(player->name));
+    player->state = state;
+    player->money = money;
+    player->is_bot = is_bot;
+    player->original_user_id = original_user_id;
+}
+
+// ===== Appending =====
+
+static bool hand_open(const Table* table)
+{
+    return table->journal_hand != NULL && table->journal_hand->len > 0;
+}
+
+// Keep the records of a hand in progress so a checkpoint can carry them over
+static void track(Table* table, JournalRecordType type, const unsigned char* record, size_t len)
+{
+    if (type == JOURNAL_HAND || type == JOURNAL_SETTLE)
+    {
+        if (table->journal_hand == NULL)
+        {
+            table->journal_hand = calloc(1, sizeof(JournalBuffer));
+            if (table->journal_hand == NULL)
+            {
+                return;
+            }
+        }
+        table->journal_hand->len = 0;
+    }
+    if (type == JOURNAL_HAND || ((type == JOURNAL_ACTION || type == JOURNAL_SEAT) && hand_open(table)))
+    {
+        buffer_append(table->journal_hand, record, len);
+    }
+}
+
+static void append(const unsigned char* record, size_t len)
+{
+    if (journal_fd == -1 || replaying)
+    {
+        return;
+    }
+    if (buffer_append(&pending, record, len) == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot buffer journal record", 1);
+    }
+}
+
+static int write_all(int fd, const unsigned char* data, size_t len)
+{
+    size_t written = 0;
+    while (written < len)
+    {
+        ssize_t n = write(fd, data + written, len - written);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        written += (size_t) n;
+    }
+    return 0;
+}
+
+// Write what is pending and wait for it to reach the disk
+static void commit(void)
+{
+    if (journal_fd == -1 || pending.len == 0)
+    {
+        return;
+    }
+
+    uint64_t started_ns = metrics_now_ns();
+    if (write_all(journal_fd, pending.data, pending.len) == -1 || fdatasync(journal_fd) == -1)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Cannot write %zu bytes to journal: %s", pending.len, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+    }
+    else
+    {
+        file_size += (off_t) pending.len;
+    }
+    pending.len = 0;
+    metrics_record(METRIC_LATENCY_JOURNAL_SYNC, metrics_now_ns() - started_ns);
+}
+
+void journal_table_created(const Table* table)
+{
+    unsigned char record[JOURNAL_MAX_RECORD];
+    append(record, encode_table(table, record));
+}
+
+void journal_table_removed(Table* table)
+{
+    if (table->journal_hand != NULL)
+    {
+        free(table->journal_hand->data);
+        free(table->journal_hand);
+        table->journal_hand = NULL;
+    }
+
+    unsigned char record[JOURNAL_MAX_RECORD];
+    unsigned char* p = begin_record(record, JOURNAL_TABLE_REMOVED, table->id);
+    append(record, end_record(record, p));
+}
+
+void journal_seat(const Table* table, int seat)
+{
+    if (journal_fd == -1 || seat < 0 || seat >= MAX_PLAYERS)
+    {
+        return;
+    }
+
+    unsigned char record[JOURNAL_MAX_RECORD];
+    unsigned char* p = begin_record(record, JOURNAL_SEAT, table->id);
+    put_seat(&p, &table->game_state->players[seat], seat);
+    size_t len = end_record(record, p);
+    track((Table*) table, JOURNAL_SEAT, record, len);
+    append(record, len);
+    commit();
+}
+
+void journal_hand_start(Table* table)
+{
+    if (journal_fd == -1)
+    {
+        return; // The engine draws a seed of its own
+    }
+
+    GameState* gs = table->game_state;
+    gs->next_deck_seed = game_draw_seed();
+
+    unsigned char record[JOURNAL_MAX_RECORD];
+    unsigned char* p = begin_record(record, JOURNAL_HAND, table->id);
+    put_u32(&p, gs->hand_id);
+    put_u32(&p, (uint32_t) gs->dealer_seat);
+    put_u64(&p, gs->next_deck_seed);
+    for (int seat = 0; seat < MAX_PLAYERS; seat++)
+    {
+        put_seat(&p, &gs->players[seat], seat);
+    }
+    size_t len = end_record(record, p);
+    track(table, JOURNAL_HAND, record, len);
+    append(record, len);
+}
+
+void journal_action(Table* table, int seat, const Action* action)
+{
+    if (journal_fd == -1)
+    {
+        return;
+    }
+
+    unsigned char record[JOURNAL_MAX_RECORD];
+    unsigned char* p = begin_record(record, JOURNAL_ACTION, table->id);
+    put_u8(&p, (unsigned int) seat);
+    put_u8(&p, action->type);
+    put_u32(&p, (uint32_t) action->amount);
+    put_u32(&p, table->game_state->seq);
+    size_t len = end_record(record, p);
+    track(table, JOURNAL_ACTION, record, len);
+    append(record, len);
+}
+
+void journal_hand_settled(Table* table)
+{
+    if (journal_fd == -1)
+    {
+        return;
+    }
+
+    // Settling wrote balances to the database; the record of it goes out with them
+    unsigned char record[JOURNAL_MAX_RECORD];
+    size_t len = encode_settle(table, record);
+    track(table, JOURNAL_SETTLE, record, len);
+    append(record, len);
+    commit();
+}
+
+// ===== File =====
+
+int journal_open(const char* path)
+{
+    if (path == NULL || path[0] == '\0' || strlen(path) >= sizeof(journal_path) - 4)
+    {
+        return -1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        char log_msg[512];
+        snprintf(log_msg, sizeof(log_msg), "Cannot open journal '%s': %s", path, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        return -1;
+    }
+
+    struct stat st;
+    file_size = fstat(fd, &st) == 0 ? st.st_size : 0;
+    strcpy(journal_path, path);
+    journal_fd = fd;
+    pending.len = 0;
+    return 0;
+}
+
+void journal_close(void)
+{
+    if (journal_fd == -1)
+    {
+        return;
+    }
+    commit();
+    close(journal_fd);
+    journal_fd = -1;
+    free(pending.data);
+    pending = (JournalBuffer){0};
+}
+
+bool journal_enabled(void)
+{
+    return journal_fd != -1;
+}
+
+const char* journal_file(void)
+{
+    return journal_path;
+}
+
+// A rename is only durable once the directory holding it is synced
+static void sync_directory(const char* path)
+{
+    char dir[sizeof(journal_path)];
+    strcpy(dir, path);
+    char* slash = strrchr(dir, '/');
+    if (slash == NULL)
+    {
+        strcpy(dir, ".");
+    }
+    else if (slash == dir)
+    {
+        dir[1] = '\0';
+    }
+    else
+    {
+        *slash = '\0';
+    }
+
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+int journal_checkpoint(TableList* table_list)
+{
+    if (journal_fd == -1)
+    {
+        return 0;
+    }
+
+    JournalBuffer snapshot = {0};
+    unsigned char record[JOURNAL_MAX_RECORD];
+    int failed = 0;
+    for (size_t i = 0; i < table_list->size; i++)
+    {
+        Table* table = &table_list->tables[i];
+        if (table->game_state == NULL)
+        {
+            continue;
+        }
+        failed |= buffer_append(&snapshot, record, encode_table(table, record));
+        if (hand_open(table))
+        {
+            failed |= buffer_append(&snapshot, table->journal_hand->data, table->journal_hand->len);
+        }
+        else
+        {
+            failed |= buffer_append(&snapshot, record, encode_settle(table, record));
+        }
+    }
+
+    char tmp_path[sizeof(journal_path) + 4];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", journal_path);
+    int fd = failed ? -1 : open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1 || write_all(fd, snapshot.data, snapshot.len) == -1 || fdatasync(fd) == -1 ||
+        rename(tmp_path, journal_path) == -1)
+    {
+        char log_msg[512];
+        snprintf(log_msg, sizeof(log_msg), "Cannot write journal checkpoint '%s': %s", tmp_path, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        if (fd != -1)
+        {
+            close(fd);
+            unlink(tmp_path);
+        }
+        free(snapshot.data);
+        return -1;
+    }
+    sync_directory(journal_path);
+
+    // The checkpoint already holds everything still pending
+    close(journal_fd);
+    journal_fd = fd;
+    file_size = (off_t) snapshot.len;
+    pending.len = 0;
+    free(snapshot.data);
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Journal checkpoint: %zu tables, %lld bytes", table_list->size,
+             (long long) file_size);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    return 0;
+}
+
+void journal_flush(TableList* table_list)
+{
+    commit();
+    if (file_size > JOURNAL_CHECKPOINT_BYTES)
+    {
+        journal_checkpoint(table_list);
+    }
+}
+
+// ===== Replay =====
+
+static void apply_action(Table* table, Reader* reader)
+{
+    GameState* gs = table->game_state;
+    int seat = (int) get_u8(reader);
+    Action action = {.type = (ActionType) get_u8(reader)};
+    action.amount = (int) get_u32(reader);
+    uint32_t seq = get_u32(reader);
+    if (!reader->ok || seat >= MAX_PLAYERS)
+    {
+        return;
+    }
+
+    // By seat: a player handed to a bot mid-hand acted under a different id before the handover
+    int result = game_process_action(gs, gs->players[seat].player_id, &action);
+    if (result != 0 || gs->seq != seq)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Replay diverged at table %d hand %u: action at seat %d gave %d, seq %u (journal %u)",
+                 table->id, gs->hand_id, seat, result, gs->seq, seq);
+        logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+    }
+    table->active_seat = gs->active_seat;
+}
+
+static void apply_record(TableList* table_list, const unsigned char* body, size_t len)
+{
+    Reader reader = {body, body + len, true};
+    JournalRecordType type = (JournalRecordType) get_u8(&reader);
+    int table_id = (int) get_u16(&reader);
+
+    if (type == JOURNAL_TABLE)
+    {
+        int max_player = (int) get_u8(&reader);
+        int min_bet = (int) get_u32(&reader);
+        char name[32];
+        get_bytes(&reader, name, sizeof(name));
+        name[31] = '\0';
+        if (reader.ok)
+        {
+            restore_table(table_list, table_id, name, max_player, min_bet);
+        }
+        return;
+    }
+
+    int index = find_table_by_id(table_list, table_id);
+    if (index == -1)
+    {
+        return;
+    }
+    Table* table = &table_list->tables[index];
+    GameState* gs = table->game_state;
+
+    switch (type)
+    {
+    case JOURNAL_TABLE_REMOVED:
+        game_state_destroy(gs);
+        table->game_state = NULL;
+        remove_table(table_list, table_id);
+        return;
+
+    case JOURNAL_SEAT:
+        restore_seat(gs, &reader);
+        break;
+
+    case JOURNAL_HAND:
+    {
+        uint32_t hand_id = get_u32(&reader);
+        int dealer_seat = (int) get_u32(&reader);
+        uint64_t seed = get_u64(&reader);
+        for (int seat = 0; seat < MAX_PLAYERS; seat++)
+        {
+            restore_seat(gs, &reader);
+        }
+        gs->hand_id = hand_id;
+        gs->dealer_seat = dealer_seat;
+        gs->hand_in_progress = false;
+        gs->next_deck_seed = seed;
+        game_start_hand(gs);
+        table->game_started = true;
+        table->active_seat = gs->active_seat;
+        break;
+    }
+
+    case JOURNAL_ACTION:
+        apply_action(table, &reader);
+        break;
+
+    case JOURNAL_SETTLE:
+        gs->hand_id = get_u32(&reader);
+        gs->dealer_seat = (int) get_u32(&reader);
+        for (int seat = 0; seat < MAX_PLAYERS; seat++)
+        {
+            restore_seat(gs, &reader);
+            GamePlayer* player = &gs->players[seat];
+            player->bet = 0;
+            player->total_bet = 0;
+            player->hole_cards[0] = NULL;
+            player->hole_cards[1] = NULL;
+        }
+        gs->hand_in_progress = false;
+        gs->betting_round = BETTING_ROUND_COMPLETE;
+        gs->active_seat = -1;
+        table->active_seat = -1;
+        table->game_started = gs->hand_id > 0;
+        break;
+
+    default:
+        return;
+    }
+    track(table, type, body - HEADER_LEN, len + HEADER_LEN);
+}
+
+// Seated players become parked sessions, and tables carry on with what they were doing when the
+// server stopped: the next bot acts, a finished hand is settled, an empty table goes away
+static void resume_tables(TableList* table_list)
+{
+    for (int i = (int) table_list->size - 1; i >= 0; i--)
+    {
+        Table* table = &table_list->tables[i];
+        GameState* gs = table->game_state;
+        for (int seat = 0; seat < MAX_PLAYERS; seat++)
+        {
+            GamePlayer* player = &gs->players[seat];
+            if (player->state != PLAYER_STATE_EMPTY && !player->is_bot && player->player_id > 0)
+            {
+                restore_connection(table, seat);
+            }
+        }
+
+        if (hand_open(table))
+        {
+            bool hand_ended = gs->betting_round == BETTING_ROUND_COMPLETE || process_all_bot_actions(table);
+            if (hand_ended)
+            {
+                handle_hand_complete(table, table_list);
+            }
+        }
+        else if (table->current_player == 0)
+        {
+            game_state_destroy(gs);
+            table->game_state = NULL;
+            remove_table(table_list, table->id);
+        }
+    }
+}
+
+int journal_replay(TableList* table_list)
+{
+    if (journal_fd == -1)
+    {
+        return 0;
+    }
+
+    int fd = open(journal_path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot read journal", 1);
+        if (fd != -1)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size_t size = (size_t) st.st_size;
+    unsigned char* data = malloc(size ? size : 1);
+    size_t filled = 0;
+    while (data != NULL && filled < size)
+    {
+        ssize_t n = read(fd, data + filled, size - filled);
+        if (n <= 0)
+        {
+            if (n == -1 && errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        filled += (size_t) n;
+    }
+    close(fd);
+    if (data == NULL)
+    {
+        return -1;
+    }
+
+    // Stop at the first record that is cut short or fails its CRC: the crash happened while writing it
+    uint64_t started_ns = metrics_now_ns();
+    int applied = 0;
+    size_t offset = 0;
+    replaying = true;
+    while (offset + HEADER_LEN <= filled)
+    {
+        Reader header = {data + offset, data + offset + HEADER_LEN, true};
+        uint32_t len = get_u32(&header);
+        uint32_t crc = get_u32(&header);
+        if (len < 3 || len > JOURNAL_MAX_RECORD || offset + HEADER_LEN + len > filled ||
+            crc32(data + offset + HEADER_LEN, len) != crc)
+        {
+            break;
+        }
+        apply_record(table_list, data + offset + HEADER_LEN, len);
+        offset += HEADER_LEN + len;
+        applied++;
+    }
+    replaying = false;
+    free(data);
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Replayed %d journal records into %zu tables in %llu us, dropped %zu torn bytes",
+             applied, table_list->size, (unsigned long long) ((metrics_now_ns() - started_ns) / 1000), filled - offset);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    resume_tables(table_list);
+
+    // The checkpoint also cuts off a torn tail; if it cannot be written, cut it off in place
+    if (journal_checkpoint(table_list) == -1 && offset < filled)
+    {
+        if (truncate(journal_path, (off_t) offset) == 0)
+        {
+            file_size = (off_t) offset;
+        }
+    }
+    return applied;
+}
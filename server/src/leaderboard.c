@@ -0,0 +1,330 @@
+#include "leaderboard.h"
+#include "main.h"
+
+#define LEADERBOARD_MAX_LEVEL 24
+
+typedef struct LeaderNode
+{
+    int user_id;
+    int balance;
+    int level;
+    struct LeaderNode* next[]; // next[i] is the following node on level i
+} LeaderNode;
+
+static LeaderNode* head = NULL; // Sentinel with LEADERBOARD_MAX_LEVEL levels
+static int level = 1;           // Levels currently in use
+static int num_users = 0;
+static bool seeded = false;
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+// user_id -> node, open addressing with linear probing. Nodes are never removed, only moved.
+static LeaderNode** user_slots = NULL;
+static int slot_capacity = 0;
+
+static RawBytes* cached_packet = NULL;
+
+// ===== Skiplist =====
+
+// Leaders first: higher balance, then lower user id
+static bool ranks_before(const LeaderNode* node, int balance, int user_id)
+{
+    return node->balance > balance || (node->balance == balance && node->user_id < user_id);
+}
+
+static int random_level(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    uint64_t bits = rng_state;
+    int lvl = 1;
+    while (lvl < LEADERBOARD_MAX_LEVEL && (bits & 3) == 0)
+    {
+        lvl++;
+        bits >>= 2;
+    }
+    return lvl;
+}
+
+static int ensure_head(void)
+{
+    if (head == NULL)
+    {
+        head = calloc(1, sizeof(LeaderNode) + LEADERBOARD_MAX_LEVEL * sizeof(LeaderNode*));
+        if (head == NULL)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Fill update[] with the last node on each level that ranks before (balance, user_id)
+static void find_predecessors(int balance, int user_id, LeaderNode** update)
+{
+    LeaderNode* node = head;
+    for (int i = level - 1; i >= 0; i--)
+    {
+        while (node->next[i] != NULL && ranks_before(node->next[i], balance, user_id))
+        {
+            node = node->next[i];
+        }
+        update[i] = node;
+    }
+}
+
+static void link_node(LeaderNode* node)
+{
+    LeaderNode* update[LEADERBOARD_MAX_LEVEL];
+    if (node->level > level)
+    {
+        for (int i = level; i < node->level; i++)
+        {
+            head->next[i] = NULL;
+        }
+        level = node->level;
+    }
+    find_predecessors(node->balance, node->user_id, update);
+    for (int i = 0; i < node->level; i++)
+    {
+        node->next[i] = update[i]->next[i];
+        update[i]->next[i] = node;
+    }
+}
+
+static void unlink_node(LeaderNode* node)
+{
+    LeaderNode* update[LEADERBOARD_MAX_LEVEL];
+    find_predecessors(node->balance, node->user_id, update);
+    for (int i = 0; i < node->level; i++)
+    {
+        if (update[i]->next[i] == node)
+        {
+            update[i]->next[i] = node->next[i];
+        }
+    }
+    while (level > 1 && head->next[level - 1] == NULL)
+    {
+        level--;
+    }
+}
+
+// Whether the node is currently among the first LEADERBOARD_SIZE entries
+static bool in_top(const LeaderNode* node)
+{
+    const LeaderNode* cursor = head->next[0];
+    for (int i = 0; i < LEADERBOARD_SIZE && cursor != NULL; i++, cursor = cursor->next[0])
+    {
+        if (cursor == node)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ===== User Index =====
+
+static LeaderNode** find_slot(int user_id)
+{
+    unsigned int hash = (unsigned int) user_id * 2654435761u;
+    int mask = slot_capacity - 1;
+    int i = (int) (hash & (unsigned int) mask);
+    while (user_slots[i] != NULL && user_slots[i]->user_id != user_id)
+    {
+        i = (i + 1) & mask;
+    }
+    return &user_slots[i];
+}
+
+static int grow_slots(void)
+{
+    int old_capacity = slot_capacity;
+    LeaderNode** old_slots = user_slots;
+    int capacity = old_capacity > 0 ? old_capacity * 2 : 1024;
+
+    user_slots = calloc(capacity, sizeof(LeaderNode*));
+    if (user_slots == NULL)
+    {
+        user_slots = old_slots;
+        return -1;
+    }
+    slot_capacity = capacity;
+    for (int i = 0; i < old_capacity; i++)
+    {
+        if (old_slots[i] != NULL)
+        {
+            *find_slot(old_slots[i]->user_id) = old_slots[i];
+        }
+    }
+    free(old_slots);
+    return 0;
+}
+
+static LeaderNode* find_user(int user_id)
+{
+    if (slot_capacity == 0)
+    {
+        return NULL;
+    }
+    return *find_slot(user_id);
+}
+
+// ===== Public API =====
+
+static void invalidate_packet(void)
+{
+    if (cached_packet != NULL)
+    {
+        free(cached_packet->data);
+        free(cached_packet);
+        cached_packet = NULL;
+    }
+}
+
+void leaderboard_set_balance(int user_id, int balance)
+{
+    if (user_id <= 0 || ensure_head() == -1)
+    {
+        return;
+    }
+
+    LeaderNode* node = find_user(user_id);
+    if (node == NULL)
+    {
+        // Keep the load factor at or below one half
+        if ((num_users + 1) * 2 > slot_capacity && grow_slots() == -1)
+        {
+            return;
+        }
+        int lvl = random_level();
+        node = malloc(sizeof(LeaderNode) + lvl * sizeof(LeaderNode*));
+        if (node == NULL)
+        {
+            return;
+        }
+        node->user_id = user_id;
+        node->balance = balance;
+        node->level = lvl;
+        *find_slot(user_id) = node;
+        num_users++;
+        link_node(node);
+        if (in_top(node))
+        {
+            invalidate_packet();
+        }
+        return;
+    }
+
+    if (node->balance == balance)
+    {
+        return;
+    }
+
+    bool was_top = in_top(node);
+    unlink_node(node);
+    node->balance = balance;
+    link_node(node);
+    if (was_top || in_top(node))
+    {
+        invalidate_packet();
+    }
+}
+
+void leaderboard_add_balance(int user_id, int amount)
+{
+    LeaderNode* node = find_user(user_id);
+    if (node != NULL)
+    {
+        leaderboard_set_balance(user_id, node->balance + amount);
+    }
+}
+
+int leaderboard_seed(PGconn* conn)
+{
+    dbScoreboard* balances = METRICS_DB_QUERY(dbGetAllBalances(conn));
+    if (balances == NULL)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot load balances", 1);
+        return -1;
+    }
+
+    for (int i = 0; i < balances->size; i++)
+    {
+        leaderboard_set_balance(balances->players[i].user_id, balances->players[i].balance);
+    }
+    seeded = true;
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Leaderboard seeded with %d users", balances->size);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    free(balances->players);
+    free(balances);
+    return 0;
+}
+
+bool leaderboard_is_seeded(void)
+{
+    return seeded;
+}
+
+int leaderboard_top(dbRanking* out, int k)
+{
+    int count = 0;
+    for (LeaderNode* node = head != NULL ? head->next[0] : NULL; node != NULL && count < k; node = node->next[0])
+    {
+        out[count].user_id = node->user_id;
+        out[count].balance = node->balance;
+        count++;
+    }
+    return count;
+}
+
+int leaderboard_size(void)
+{
+    return num_users;
+}
+
+const RawBytes* leaderboard_packet(void)
+{
+    if (cached_packet != NULL)
+    {
+        return cached_packet;
+    }
+
+    dbRanking leaders[LEADERBOARD_SIZE];
+    dbScoreboard scoreboard = {leaders, leaderboard_top(leaders, LEADERBOARD_SIZE)};
+    RawBytes* payload = encode_scoreboard_response(&scoreboard);
+    if (payload == NULL)
+    {
+        return NULL;
+    }
+    cached_packet = encode_packet(PROTOCOL_V1, PACKET_SCOREBOARD, payload->data, payload->len);
+    free(payload->data);
+    free(payload);
+    return cached_packet;
+}
+
+void leaderboard_free(void)
+{
+    invalidate_packet();
+    if (head != NULL)
+    {
+        LeaderNode* node = head->next[0];
+        while (node != NULL)
+        {
+            LeaderNode* next = node->next[0];
+            free(node);
+            node = next;
+        }
+        free(head);
+        head = NULL;
+    }
+    free(user_slots);
+    user_slots = NULL;
+    slot_capacity = 0;
+    num_users = 0;
+    level = 1;
+    seeded = false;
+}
@@ -0,0 +1,662 @@
+#include "lobby.h"
+#include "main.h"
+#include <limits.h>
+#include <strings.h>
+#include <sys/timerfd.h>
+
+static RawBytes* cached_packet = NULL;
+static uint64_t current_version = 1;
+static uint64_t cached_version = 0; // Version cached_packet was encoded at, 0 if none
+
+// Subscription state. published[] is the lobby as subscribers last saw it, sorted by table id.
+static int timer_fd = -1;
+static bool timer_armed = false;
+static int subscribers[LOBBY_MAX_SUBSCRIBERS];
+static int num_subscribers = 0;
+static TableSummary* published = NULL;
+static int num_published = 0;
+static uint64_t published_version = 0;
+
+int lobby_init(void)
+{
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot create lobby tick timer", 1);
+    }
+    return timer_fd;
+}
+
+static void arm_tick(void)
+{
+    if (timer_fd == -1 || timer_armed)
+    {
+        return;
+    }
+
+    struct itimerspec spec = {0};
+    spec.it_value.tv_sec = LOBBY_TICK_MS / 1000;
+    spec.it_value.tv_nsec = (long) (LOBBY_TICK_MS % 1000) * 1000000L;
+    if (timerfd_settime(timer_fd, 0, &spec, NULL) == 0)
+    {
+        timer_armed = true;
+    }
+}
+
+void lobby_invalidate(void)
+{
+    current_version++;
+    if (num_subscribers > 0)
+    {
+        arm_tick();
+    }
+}
+
+uint64_t lobby_version(void)
+{
+    return current_version;
+}
+
+static void free_cached_packet(void)
+{
+    if (cached_packet != NULL)
+    {
+        free(cached_packet->data);
+        free(cached_packet);
+        cached_packet = NULL;
+    }
+    cached_version = 0;
+}
+
+const RawBytes* lobby_tables_packet(TableList* table_list)
+{
+    if (cached_packet != NULL && cached_version == current_version)
+    {
+        return cached_packet;
+    }
+
+    free_cached_packet();
+
+    RawBytes* payload = encode_full_tables_response(table_list);
+    if (payload == NULL)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot encode table list", 1);
+        return NULL;
+    }
+
+    cached_packet = encode_packet(PROTOCOL_V1, PACKET_TABLES, payload->data, payload->len);
+    free(payload->data);
+    free(payload);
+    if (cached_packet == NULL)
+    {
+        return NULL;
+    }
+    cached_version = current_version;
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Lobby snapshot v%llu encoded (%zu tables, %zu bytes)",
+             (unsigned long long) current_version, table_list->size, cached_packet->len);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    return cached_packet;
+}
+
+// ===== Lobby Index =====
+
+// index_by_id[id] holds the lobby view of table id (id 0 marks a free slot). Table ids are
+// handed out densely from 1, so a flat array doubles as the id lookup.
+static TableSummary* index_by_id = NULL;
+static int id_capacity = 0;
+static int* sorted[3] = {NULL, NULL, NULL}; // Table ids ordered by TABLES_SORT_* key, then id
+static int num_indexed = 0;
+static int sorted_capacity = 0;
+
+static int sort_key(int sort, const TableSummary* table)
+{
+    return sort == TABLES_SORT_FREE_SEATS ? table->max_player - table->current_player : table->min_bet;
+}
+
+// Order of an indexed table relative to the probe (key or name, id) under the given sort
+static int compare_to_probe(int sort, const TableSummary* table, int key, const char* name, int id)
+{
+    int c;
+    if (sort == TABLES_SORT_NAME)
+    {
+        c = strcasecmp(table->name, name);
+    }
+    else
+    {
+        int table_key = sort_key(sort, table);
+        c = (table_key > key) - (table_key < key);
+    }
+    return c != 0 ? c : (table->id > id) - (table->id < id);
+}
+
+// First position in sorted[sort] not ordered before the probe
+static int lower_bound(int sort, int key, const char* name, int id)
+{
+    int lo = 0;
+    int hi = num_indexed;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (compare_to_probe(sort, &index_by_id[sorted[sort][mid]], key, name, id) < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void index_insert(int sort, const TableSummary* table)
+{
+    int pos = lower_bound(sort, sort_key(sort, table), table->name, table->id);
+    memmove(&sorted[sort][pos + 1], &sorted[sort][pos], (num_indexed - pos) * sizeof(int));
+    sorted[sort][pos] = table->id;
+}
+
+static void index_erase(int sort, const TableSummary* table)
+{
+    int pos = lower_bound(sort, sort_key(sort, table), table->name, table->id);
+    if (pos < num_indexed && sorted[sort][pos] == table->id)
+    {
+        memmove(&sorted[sort][pos], &sorted[sort][pos + 1], (num_indexed - pos - 1) * sizeof(int));
+    }
+}
+
+static int reserve_index(int table_id)
+{
+    if (table_id >= id_capacity)
+    {
+        int capacity = id_capacity > 0 ? id_capacity : 64;
+        while (capacity <= table_id)
+        {
+            capacity *= 2;
+        }
+        TableSummary* grown = realloc(index_by_id, capacity * sizeof(TableSummary));
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        memset(&grown[id_capacity], 0, (capacity - id_capacity) * sizeof(TableSummary));
+        index_by_id = grown;
+        id_capacity = capacity;
+    }
+
+    if (num_indexed == sorted_capacity)
+    {
+        int capacity = sorted_capacity > 0 ? sorted_capacity * 2 : 64;
+        for (int sort = 0; sort < 3; sort++)
+        {
+            int* grown = realloc(sorted[sort], capacity * sizeof(int));
+            if (grown == NULL)
+            {
+                return -1;
+            }
+            sorted[sort] = grown;
+        }
+        sorted_capacity = capacity;
+    }
+    return 0;
+}
+
+void lobby_table_removed(int table_id)
+{
+    lobby_invalidate();
+    if (table_id <= 0 || table_id >= id_capacity || index_by_id[table_id].id == 0)
+    {
+        return;
+    }
+
+    for (int sort = 0; sort < 3; sort++)
+    {
+        index_erase(sort, &index_by_id[table_id]);
+    }
+    num_indexed--;
+    index_by_id[table_id].id = 0;
+}
+
+void lobby_table_added(const Table* table)
+{
+    // A stale entry under a reused id is replaced
+    lobby_table_removed(table->id);
+
+    if (table->id <= 0 || reserve_index(table->id) == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot grow lobby index", 1);
+        return;
+    }
+
+    TableSummary* entry = &index_by_id[table->id];
+    entry->id = table->id;
+    strncpy(entry->name, table->name, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
+    entry->max_player = table->max_player;
+    entry->min_bet = table->min_bet;
+    entry->current_player = table->current_player;
+
+    for (int sort = 0; sort < 3; sort++)
+    {
+        index_insert(sort, entry);
+    }
+    num_indexed++;
+}
+
+void lobby_table_seats_changed(const Table* table)
+{
+    lobby_invalidate();
+    if (table->id <= 0 || table->id >= id_capacity || index_by_id[table->id].id == 0)
+    {
+        return;
+    }
+
+    // Only the free-seat order depends on occupancy
+    TableSummary* entry = &index_by_id[table->id];
+    index_erase(TABLES_SORT_FREE_SEATS, entry);
+    num_indexed--;
+    entry->current_player = table->current_player;
+    index_insert(TABLES_SORT_FREE_SEATS, entry);
+    num_indexed++;
+}
+
+static bool matches_query(const TablesQuery* query, const TableSummary* table)
+{
+    if (query->min_bet >= 0 && table->min_bet < query->min_bet)
+    {
+        return false;
+    }
+    if (query->max_bet >= 0 && table->min_bet > query->max_bet)
+    {
+        return false;
+    }
+    if (table->max_player - table->current_player < query->min_free_seats)
+    {
+        return false;
+    }
+    size_t prefix_len = strlen(query->name_prefix);
+    return prefix_len == 0 || strncasecmp(table->name, query->name_prefix, prefix_len) == 0;
+}
+
+int lobby_query_tables(const TablesQuery* query, TableSummary* out, TablesQuery* next, bool* has_more)
+{
+    int sort = query->sort;
+    if (sort < TABLES_SORT_STAKES || sort > TABLES_SORT_NAME)
+    {
+        sort = TABLES_SORT_STAKES;
+    }
+    int limit = query->limit > 0 && query->limit <= TABLES_PAGE_MAX ? query->limit : TABLES_PAGE_DEFAULT;
+    *next = *query;
+    *has_more = false;
+
+    // Narrow [lo, hi) with whatever the filter says about the sort key itself
+    int lo = 0;
+    int hi = num_indexed;
+    if (sort == TABLES_SORT_STAKES)
+    {
+        if (query->min_bet >= 0)
+        {
+            lo = lower_bound(sort, query->min_bet, NULL, INT_MIN);
+        }
+        if (query->max_bet >= 0)
+        {
+            hi = lower_bound(sort, query->max_bet, NULL, INT_MAX);
+        }
+    }
+    else if (sort == TABLES_SORT_FREE_SEATS)
+    {
+        lo = lower_bound(sort, query->min_free_seats, NULL, INT_MIN);
+    }
+    else if (query->name_prefix[0] != '\0')
+    {
+        // Names sharing a prefix are contiguous; hi is the first name that sorts past them
+        size_t prefix_len = strlen(query->name_prefix);
+        lo = lower_bound(sort, 0, query->name_prefix, INT_MIN);
+        int end = num_indexed;
+        hi = lo;
+        while (hi < end)
+        {
+            int mid = hi + (end - hi) / 2;
+            if (strncasecmp(index_by_id[sorted[sort][mid]].name, query->name_prefix, prefix_len) > 0)
+            {
+                end = mid;
+            }
+            else
+            {
+                hi = mid + 1;
+            }
+        }
+    }
+
+    // Resume strictly after the cursor in the requested direction
+    if (query->has_cursor)
+    {
+        int pos = lower_bound(sort, query->cursor_key, query->cursor_name, query->cursor_id);
+        if (query->desc)
+        {
+            hi = pos < hi ? pos : hi;
+        }
+        else
+        {
+            if (pos < num_indexed && sorted[sort][pos] == query->cursor_id &&
+                compare_to_probe(sort, &index_by_id[query->cursor_id], query->cursor_key, query->cursor_name,
+                                 query->cursor_id) == 0)
+            {
+                pos++;
+            }
+            lo = pos > lo ? pos : lo;
+        }
+    }
+
+    int count = 0;
+    int pos = query->desc ? hi - 1 : lo;
+    while (count < limit && pos >= lo && pos < hi)
+    {
+        const TableSummary* table = &index_by_id[sorted[sort][pos]];
+        if (matches_query(query, table))
+        {
+            out[count++] = *table;
+        }
+        pos += query->desc ? -1 : 1;
+    }
+
+    if (count == limit && pos >= lo && pos < hi)
+    {
+        const TableSummary* last = &out[count - 1];
+        next->sort = sort;
+        next->has_cursor = true;
+        next->cursor_id = last->id;
+        next->cursor_key = sort_key(sort, last);
+        strncpy(next->cursor_name, last->name, sizeof(next->cursor_name));
+        *has_more = true;
+    }
+    return count;
+}
+
+// ===== Subscriptions =====
+
+static int compare_summary_id(const void* a, const void* b)
+{
+    return ((const TableSummary*) a)->id - ((const TableSummary*) b)->id;
+}
+
+// Current lobby as a malloc'd array sorted by table id. Returns -1 on allocation failure.
+static int snapshot_tables(TableList* table_list, TableSummary** out)
+{
+    *out = NULL;
+    if (table_list->size == 0)
+    {
+        return 0;
+    }
+
+    TableSummary* tables = malloc(table_list->size * sizeof(TableSummary));
+    if (tables == NULL)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < table_list->size; i++)
+    {
+        Table* table = &table_list->tables[i];
+        tables[i].id = table->id;
+        strncpy(tables[i].name, table->name, sizeof(tables[i].name) - 1);
+        tables[i].name[sizeof(tables[i].name) - 1] = '\0';
+        tables[i].max_player = table->max_player;
+        tables[i].min_bet = table->min_bet;
+        tables[i].current_player = table->current_player;
+    }
+    qsort(tables, table_list->size, sizeof(TableSummary), compare_summary_id);
+    *out = tables;
+    return (int) table_list->size;
+}
+
+static void set_published(TableSummary* tables, int num_tables)
+{
+    free(published);
+    published = tables;
+    num_published = num_tables;
+    published_version = current_version;
+}
+
+static void send_to_subscribers(const RawBytes* packet)
+{
+    for (int i = 0; i < num_subscribers; i++)
+    {
+        int len = (int) packet->len;
+        if (sendall(subscribers[i], packet->data, &len) == -1)
+        {
+            char log_msg[256];
+            snprintf(log_msg, sizeof(log_msg), "Cannot push lobby update to fd=%d", subscribers[i]);
+            logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+        }
+    }
+}
+
+int lobby_subscribe(int fd, TableList* table_list)
+{
+    for (int i = 0; i < num_subscribers; i++)
+    {
+        if (subscribers[i] == fd)
+        {
+            return 0;
+        }
+    }
+    if (num_subscribers == LOBBY_MAX_SUBSCRIBERS)
+    {
+        return -1;
+    }
+
+    // Nobody was tracking deltas, so the baseline restarts at the lobby as it is now
+    if (num_subscribers == 0)
+    {
+        TableSummary* tables;
+        int num_tables = snapshot_tables(table_list, &tables);
+        if (num_tables < 0)
+        {
+            return -1;
+        }
+        set_published(tables, num_tables);
+    }
+    // The new subscriber's snapshot is the lobby as it is now, so the others get the pending delta
+    // first: the next one is then computed from the state both were given
+    else if (published_version != current_version)
+    {
+        lobby_flush(table_list);
+        if (published_version != current_version)
+        {
+            return -1;
+        }
+    }
+
+    subscribers[num_subscribers++] = fd;
+    return 0;
+}
+
+void lobby_unsubscribe(int fd)
+{
+    for (int i = 0; i < num_subscribers; i++)
+    {
+        if (subscribers[i] == fd)
+        {
+            subscribers[i] = subscribers[--num_subscribers];
+            return;
+        }
+    }
+}
+
+bool lobby_is_subscribed(int fd)
+{
+    for (int i = 0; i < num_subscribers; i++)
+    {
+        if (subscribers[i] == fd)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int lobby_subscriber_count(void)
+{
+    return num_subscribers;
+}
+
+void lobby_flush(TableList* table_list)
+{
+    if (timer_fd != -1)
+    {
+        uint64_t expirations;
+        while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+        {
+        }
+    }
+    timer_armed = false;
+
+    if (num_subscribers == 0 || published_version == current_version)
+    {
+        return;
+    }
+
+    TableSummary* tables;
+    int num_tables = snapshot_tables(table_list, &tables);
+    if (num_tables < 0)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot snapshot lobby", 1);
+        arm_tick();
+        return;
+    }
+
+    // Merge the two id-sorted lists. A reused id whose fixed fields differ is a removal plus an addition.
+    int max_changes = num_tables + num_published;
+    int* removed = malloc((max_changes + 1) * sizeof(int));
+    TableSummary* added = malloc((num_tables + 1) * sizeof(TableSummary));
+    TableSummary* updated = malloc((num_tables + 1) * sizeof(TableSummary));
+    int num_removed = 0;
+    int num_added = 0;
+    int num_updated = 0;
+    if (removed == NULL || added == NULL || updated == NULL)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot allocate lobby delta", 1);
+        free(removed);
+        free(added);
+        free(updated);
+        free(tables);
+        arm_tick();
+        return;
+    }
+
+    int i = 0;
+    int j = 0;
+    while (i < num_published || j < num_tables)
+    {
+        if (j == num_tables || (i < num_published && published[i].id < tables[j].id))
+        {
+            removed[num_removed++] = published[i++].id;
+        }
+        else if (i == num_published || tables[j].id < published[i].id)
+        {
+            added[num_added++] = tables[j++];
+        }
+        else
+        {
+            const TableSummary* before = &published[i++];
+            const TableSummary* now = &tables[j++];
+            if (before->max_player != now->max_player || before->min_bet != now->min_bet ||
+                strcmp(before->name, now->name) != 0)
+            {
+                removed[num_removed++] = now->id;
+                added[num_added++] = *now;
+            }
+            else if (before->current_player != now->current_player)
+            {
+                updated[num_updated++] = *now;
+            }
+        }
+    }
+
+    // Large deltas go out in several packets, each within the header's length. Entries keep their
+    // order across packets (removals first), so a reused id is removed before it is added again.
+    int total = num_removed + num_added + num_updated;
+    int num_packets = 0;
+    bool sent = true;
+    for (int start = 0; start < total; start += LOBBY_DELTA_MAX_ENTRIES)
+    {
+        int end = start + LOBBY_DELTA_MAX_ENTRIES < total ? start + LOBBY_DELTA_MAX_ENTRIES : total;
+        int r0 = start < num_removed ? start : num_removed;
+        int r1 = end < num_removed ? end : num_removed;
+        int a0 = start - r0 < num_added ? start - r0 : num_added;
+        int a1 = end - r1 < num_added ? end - r1 : num_added;
+        int u0 = start - r0 - a0;
+        int u1 = end - r1 - a1;
+
+        RawBytes* packet = NULL;
+        RawBytes* payload = encode_update_tables_response(current_version, removed + r0, r1 - r0, added + a0,
+                                                          a1 - a0, updated + u0, u1 - u0);
+        if (payload != NULL && payload->len + sizeof(Header) <= UINT16_MAX)
+        {
+            packet = encode_packet(PROTOCOL_V1, PACKET_LOBBY_DELTA, payload->data, payload->len);
+        }
+        if (payload != NULL)
+        {
+            free(payload->data);
+            free(payload);
+        }
+        if (packet == NULL)
+        {
+            sent = false;
+            break;
+        }
+        send_to_subscribers(packet);
+        free(packet->data);
+        free(packet);
+        num_packets++;
+    }
+
+    if (!sent)
+    {
+        // Subscribers keep the state they were last sent: the whole delta is resent on the next tick,
+        // and entries they already applied are applied again harmlessly
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot encode lobby delta", 1);
+        free(removed);
+        free(added);
+        free(updated);
+        free(tables);
+        arm_tick();
+        return;
+    }
+    if (total > 0)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Lobby delta v%llu pushed to %d subscribers in %d packets (+%d -%d ~%d)",
+                 (unsigned long long) current_version, num_subscribers, num_packets, num_added, num_removed,
+                 num_updated);
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    }
+
+    set_published(tables, num_tables);
+    free(removed);
+    free(added);
+    free(updated);
+}
+
+void lobby_cache_free(void)
+{
+    free_cached_packet();
+    free(index_by_id);
+    index_by_id = NULL;
+    id_capacity = 0;
+    for (int sort = 0; sort < 3; sort++)
+    {
+        free(sorted[sort]);
+        sorted[sort] = NULL;
+    }
+    num_indexed = 0;
+    sorted_capacity = 0;
+    free(published);
+    published = NULL;
+    num_published = 0;
+    published_version = 0;
+    num_subscribers = 0;
+}
@@ -0,0 +1,77 @@
+#include "mailbox.h"
+#include <sched.h>
+#include <stddef.h>
+
+void mailbox_init(Mailbox* mailbox)
+{
+    atomic_store_explicit(&mailbox->stub.next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&mailbox->head, &mailbox->stub, memory_order_relaxed);
+    mailbox->tail = &mailbox->stub;
+}
+
+void mailbox_push(Mailbox* mailbox, MailboxNode* node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    MailboxNode* prev = atomic_exchange_explicit(&mailbox->head, node, memory_order_acq_rel);
+    // Between the exchange and this store the queue is briefly unlinked; mailbox_pop waits it out
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+// Wait for a producer that has swapped itself into head but not yet linked its predecessor.
+// The window is two instructions wide, so this almost never spins more than once.
+static MailboxNode* wait_for_link(MailboxNode* node)
+{
+    MailboxNode* next;
+    while ((next = atomic_load_explicit(&node->next, memory_order_acquire)) == NULL)
+    {
+        sched_yield();
+    }
+    return next;
+}
+
+MailboxNode* mailbox_pop(Mailbox* mailbox)
+{
+    MailboxNode* tail = mailbox->tail;
+    MailboxNode* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if (tail == &mailbox->stub)
+    {
+        if (next == NULL)
+        {
+            if (atomic_load_explicit(&mailbox->head, memory_order_acquire) == tail)
+            {
+                return NULL;
+            }
+            next = wait_for_link(tail);
+        }
+        // Skip the stub
+        mailbox->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+
+    if (next != NULL)
+    {
+        mailbox->tail = next;
+        return tail;
+    }
+
+    // tail is the last linked node. Unless a push is in progress, put the stub behind it so tail
+    // can be handed out without leaving the queue empty of nodes.
+    if (atomic_load_explicit(&mailbox->head, memory_order_acquire) != tail)
+    {
+        next = wait_for_link(tail);
+        mailbox->tail = next;
+        return tail;
+    }
+    mailbox_push(mailbox, &mailbox->stub);
+    next = wait_for_link(tail);
+    mailbox->tail = next;
+    return tail;
+}
+
+bool mailbox_empty(Mailbox* mailbox)
+{
+    MailboxNode* tail = mailbox->tail;
+    return tail == &mailbox->stub && atomic_load_explicit(&mailbox->head, memory_order_acquire) == tail;
+}
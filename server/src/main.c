@@ -2,18 +2,240 @@
 #include <stdlib.h>
 #include <time.h>
 
-int main(void)
+// Descriptors the event loop services besides client connections
+typedef struct
 {
-    // Seed random number generator for deck shuffling
-    srand((unsigned int)time(NULL));
+    int listener;
+    int tables; // Commands posted to table mailboxes from other threads
+    int lobby;
+    int spectator;
+    int presence;
+    int metrics;
+    int sessions; // Expiry sweep for parked sessions
+    int handoff; // -1 if the handoff socket could not be opened
+    int admin; // -1 if the admin socket could not be opened
+} ServiceFds;
+
+// Run the work behind a readable timer, eventfd, handoff or admin listener. Returns false if fd is none of them.
+static bool handle_service_fd(const ServiceFds* fds, int fd, TableList* table_list)
+{
+    if (fd == fds->tables)
+    {
+        table_actors_run(table_list);
+    }
+    else if (fd == fds->lobby)
+    {
+        lobby_flush(table_list);
+    }
+    else if (fd == fds->spectator)
+    {
+        spectator_flush(table_list);
+    }
+    else if (fd == fds->presence)
+    {
+        presence_flush();
+    }
+    else if (fd == fds->metrics)
+    {
+        metrics_report();
+    }
+    else if (fd == fds->sessions)
+    {
+        session_expire(table_list);
+    }
+    else if (fds->handoff != -1 && fd == fds->handoff)
+    {
+        // Returns only if the new process could not take over
+        handoff_accept(fds->handoff, fds->listener, table_list);
+    }
+    else if (fds->admin != -1 && fd == fds->admin)
+    {
+        admin_accept(fds->admin, table_list);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+// Handle one received packet. epoll_fd is -1 under the io_uring backend.
+static void handle_packet(int epoll_fd, conn_data_t* conn_data, char* buf, int nbytes, TableList* table_list)
+{
+    metrics_add(METRIC_BYTES_IN, (uint64_t)nbytes);
+    metrics_add(METRIC_PACKETS_IN, 1);
+
+    // Handle handshake first (4 bytes: length=2, protocol_version=2)
+    if (nbytes == 4 && conn_data->user_id == 0)
+    {
+        uint16_t handshake_len = ntohs(*(uint16_t*)&buf[0]);
+        uint16_t protocol_ver = ntohs(*(uint16_t*)&buf[2]);
+        
+        char log_msg[128];
+        snprintf(log_msg, sizeof(log_msg), "Handshake from fd=%d: len=%d, ver=%d", 
+                 conn_data->fd, handshake_len, protocol_ver);
+        logger(MAIN_LOG, "Info", log_msg);
+        
+        // Handshake response: [length:2, code:1]
+        char response[3];
+        uint16_t resp_len = htons(1);  // 1 byte follows
+        memcpy(response, &resp_len, 2);
+        
+        if (protocol_ver == 0x0001 && handshake_len == 2)
+        {
+            response[2] = 0x00;  // HANDSHAKE_OK
+            logger(MAIN_LOG, "Info", "Handshake OK");
+        }
+        else
+        {
+            response[2] = 0x01;  // PROTOCOL_NOT_SUPPORTED
+            logger(MAIN_LOG, "Warn", "Handshake failed - unsupported protocol");
+        }
+        
+        int response_len = 3;
+        sendall(conn_data->fd, response, &response_len);
+        return;
+    }
     
-    int listener = get_listener_socket("0.0.0.0", "8080", 100);
+    Header* header = decode_header(buf);
 
-    if (listener == -1)
+    if (header == NULL)
     {
-        return 1;
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Cannot decode header, received %d bytes", nbytes);
+        logger(MAIN_LOG, "Error", log_msg);
+        printf("Unknown request, received %d bytes\n", nbytes);
+        close_connection(epoll_fd, conn_data);
+        return;
+    }
+
+    uint64_t started_ns = metrics_now_ns();
+    switch (header->packet_type)
+    {
+    case PACKET_PING:
+        // Respond to PING with PONG
+        {
+            char log_msg[128];
+            snprintf(log_msg, sizeof(log_msg), "PING received from fd=%d, sending PONG", conn_data->fd);
+            logger(MAIN_LOG, "Debug", log_msg);
+            
+            RawBytes* pong_packet = encode_packet(PROTOCOL_V1, PACKET_PONG, NULL, 0);
+            int pong_len = (int)pong_packet->len;
+            sendall(conn_data->fd, pong_packet->data, &pong_len);
+            free(pong_packet->data);
+            free(pong_packet);
+        }
+        break;
+
+    case PACKET_LOGIN:
+        // May move the socket onto the user's parked connection, freeing conn_data
+        logger(MAIN_LOG, "Info", "Login request from client");
+        handle_login_request(epoll_fd, conn_data, buf, nbytes, table_list);
+        break;
+
+    case PACKET_RESUME:
+        // On success conn_data is freed and the socket belongs to the resumed connection
+        logger(MAIN_LOG, "Info", "Resume request from client");
+        handle_resume_request(epoll_fd, conn_data, buf, nbytes, table_list);
+        break;
+
+    case PACKET_SIGNUP:
+        logger(MAIN_LOG, "Info", "Signup request from client");
+        handle_signup_request(conn_data, buf, nbytes);
+        break;
+
+    case PACKET_CREATE_TABLE:
+        logger(MAIN_LOG, "Info", "Create table request from client");
+        handle_create_table_request(conn_data, buf, nbytes, table_list);
+        break;
+
+    case PACKET_TABLES:
+        logger(MAIN_LOG, "Info", "Get all tables request from client");
+        handle_get_all_tables_request(conn_data, buf, nbytes, table_list);
+        break;
+
+    case PACKET_LOBBY_SUBSCRIBE:
+        logger(MAIN_LOG, "Info", "Lobby subscribe request from client");
+        handle_lobby_subscribe_request(conn_data, buf, nbytes, table_list);
+        break;
+
+    case PACKET_JOIN_TABLE:
+        logger(MAIN_LOG, "Info", "Join table request from client");
+        handle_join_table_request(conn_data, buf, nbytes, table_list);
+        break;
+
+    case PACKET_SCOREBOARD:
+        logger(MAIN_LOG, "Info", "Get scoreboard request from client");
+        handle_get_scoreboard(conn_data, buf, nbytes);
+        break;
+
+    case PACKET_FRIENDLIST:
+        logger(MAIN_LOG, "Info", "Get friendlist request from client");
+        handle_get_friendlist(conn_data, buf, nbytes);
+        break;
+    
+    case PACKET_ADD_FRIEND:
+        logger(MAIN_LOG, "Info", "Add friend request from client");
+        handle_add_friend_request(conn_data, buf, nbytes);
+        break;
+    
+    case PACKET_INVITE_FRIEND:
+        logger(MAIN_LOG, "Info", "Invite friend request from client");
+        handle_invite_friend_request(conn_data, buf, nbytes);
+        break;
+    
+    case PACKET_ACCEPT_INVITE:
+        logger(MAIN_LOG, "Info", "Accept invite request from client");
+        handle_accept_invite_request(conn_data, buf, nbytes);
+        break;
+    
+    case PACKET_REJECT_INVITE:
+        logger(MAIN_LOG, "Info", "Reject invite request from client");
+        handle_reject_invite_request(conn_data, buf, nbytes);
+        break;
+    
+    case PACKET_GET_INVITES:
+        logger(MAIN_LOG, "Info", "Get invites request from client");
+        handle_get_invites_request(conn_data, buf, nbytes);
+        break;
+    
+    case PACKET_GET_FRIEND_LIST:
+        logger(MAIN_LOG, "Info", "Get friend list request from client");
+        handle_get_friend_list_request(conn_data, buf, nbytes);
+        break;
+    
+    case PACKET_INVITE_TO_TABLE:
+        logger(MAIN_LOG, "Info", "Invite to table request from client");
+        handle_invite_to_table_request(conn_data, buf, nbytes, table_list);
+        break;
+    
+    case PACKET_SPECTATE:
+        logger(MAIN_LOG, "Info", "Spectate request from client");
+        handle_spectate_request(conn_data, buf, nbytes, table_list);
+        break;
+
+    case PACKET_LEAVE_TABLE:
+        logger(MAIN_LOG, "Info", "Leave table request from client");
+        handle_leave_table_request(conn_data, buf, nbytes, table_list);
+        break;
+    
+    case PACKET_ACTION_REQUEST:
+        logger(MAIN_LOG, "Info", "Action request from client");
+        handle_action_request(conn_data, buf, nbytes, table_list);
+        break;
+
+    default:
+        handle_unknown_request(conn_data, buf, nbytes);
+        fprintf(stderr, "Header: %d\n", header->packet_type);
+        break;
     }
+    metrics_record_packet(header->packet_type, metrics_now_ns() - started_ns);
+
+    free(header);
+}
 
+static int run_epoll_loop(const ServiceFds* fds, TableList* table_list)
+{
     int epoll_fd = epoll_create1(0);
 
     if (epoll_fd == -1)
@@ -22,23 +244,35 @@ int main(void)
         return 1;
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.fd = listener;
-
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listener, &event) == -1)
+    if (set_nonblocking(fds->listener) == -1)
     {
-        perror("epoll_ctl");
+        logger(MAIN_LOG, "Error", "Cannot set nonblocking");
         return 1;
     }
 
-    if (set_nonblocking(listener) == -1)
+    int watched[] = {fds->listener, fds->tables, fds->lobby, fds->spectator, fds->presence, fds->metrics, fds->sessions, fds->handoff, fds->admin};
+    for (size_t i = 0; i < sizeof(watched) / sizeof(watched[0]); i++)
     {
-        logger(MAIN_LOG, "Error", "Cannot set nonblocking");
-        return 1;
+        if (watched[i] == -1)
+        {
+            continue;
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = watched[i];
+
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, watched[i], &event) == -1)
+        {
+            perror("epoll_ctl");
+            return 1;
+        }
     }
 
-    struct epoll_event* events = calloc(MAXEVENTS, sizeof(event));
+    // Clients handed over by the server we took over from, if any
+    handoff_adopt(epoll_fd, table_list);
+
+    struct epoll_event* events = calloc(MAXEVENTS, sizeof(struct epoll_event));
 
     if (events == NULL)
     {
@@ -46,7 +280,8 @@ int main(void)
         return 1;
     }
 
-    TableList* table_list = init_table_list(1000);
+    // Replies, broadcasts and notifications are written once per connection at the end of each iteration
+    outbox_enable();
 
     for (;;)
     {
@@ -54,9 +289,9 @@ int main(void)
 
         for (int i = 0; i < n; i++)
         {
-            if (events[i].data.fd == listener)
+            if (events[i].data.fd == fds->listener)
             {
-                int client_fd = accept_connection(listener);
+                int client_fd = accept_connection(fds->listener);
 
                 if (client_fd == -1)
                 {
@@ -69,13 +304,13 @@ int main(void)
                     return 1;
                 }
 
-                if (add_connection_to_epoll(epoll_fd, client_fd) == -1)
+                if (add_connection_to_epoll(epoll_fd, client_fd) == NULL)
                 {
                     logger(MAIN_LOG, "Error", "Cannot add connection to epoll");
                     return 1;
                 }
             }
-            else
+            else if (!handle_service_fd(fds, events[i].data.fd, table_list))
             {
                 conn_data_t* conn_data = events[i].data.ptr;
                 if (!conn_data || conn_data->fd <= 0)
@@ -84,6 +319,15 @@ int main(void)
                     continue;
                 }
 
+                if (events[i].events & EPOLLOUT)
+                {
+                    outbox_writable(conn_data->fd);
+                }
+                if (!(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                {
+                    continue;
+                }
+
                 char buf[MAXLINE];
                 memset(buf, 0, MAXLINE);
 
@@ -99,172 +343,213 @@ int main(void)
                             continue;
                         }
                         logger(MAIN_LOG, "Error", "Cannot receive data");
-                        close_connection(epoll_fd, conn_data);
+                        drop_connection(epoll_fd, conn_data, table_list);
                         continue;
                     }
                     logger(MAIN_LOG, "Error", "Cannot receive data");
-                    close_connection(epoll_fd, conn_data);
+                    drop_connection(epoll_fd, conn_data, table_list);
                     continue;
                 }
                 else if (nbytes == 0)
                 {
                     logger(MAIN_LOG, "Info", "Client disconnected");
-                    if (conn_data->table_id > 0)
-                    {
-                        leave_table(conn_data, table_list);
-                    }
-                    close_connection(epoll_fd, conn_data);
+                    drop_connection(epoll_fd, conn_data, table_list);
                     continue;
                 }
 
-                // Handle handshake first (4 bytes: length=2, protocol_version=2)
-                if (nbytes == 4 && conn_data->user_id == 0)
-                {
-                    uint16_t handshake_len = ntohs(*(uint16_t*)&buf[0]);
-                    uint16_t protocol_ver = ntohs(*(uint16_t*)&buf[2]);
-                    
-                    char log_msg[128];
-                    snprintf(log_msg, sizeof(log_msg), "Handshake from fd=%d: len=%d, ver=%d", 
-                             conn_data->fd, handshake_len, protocol_ver);
-                    logger(MAIN_LOG, "Info", log_msg);
-                    
-                    // Handshake response: [length:2, code:1]
-                    char response[3];
-                    uint16_t resp_len = htons(1);  // 1 byte follows
-                    memcpy(response, &resp_len, 2);
-                    
-                    if (protocol_ver == 0x0001 && handshake_len == 2)
-                    {
-                        response[2] = 0x00;  // HANDSHAKE_OK
-                        logger(MAIN_LOG, "Info", "Handshake OK");
-                    }
-                    else
-                    {
-                        response[2] = 0x01;  // PROTOCOL_NOT_SUPPORTED
-                        logger(MAIN_LOG, "Warn", "Handshake failed - unsupported protocol");
-                    }
-                    
-                    send(conn_data->fd, response, 3, 0);
-                    continue;
-                }
-                
-                Header* header = decode_header(buf);
+                handle_packet(epoll_fd, conn_data, buf, nbytes, table_list);
+                memset(buf, 0, MAXLINE);
+            }
+        }
 
-                if (header == NULL)
-                {
-                    char log_msg[256];
-                    snprintf(log_msg, sizeof(log_msg), "Cannot decode header, received %d bytes", nbytes);
-                    logger(MAIN_LOG, "Error", log_msg);
-                    printf("Unknown request, received %d bytes\n", nbytes);
-                    close_connection(epoll_fd, conn_data);
-                    continue;
-                }
+        // Actions received this iteration are applied per table and committed to the journal, then
+        // everything they produced goes out
+        table_actors_run(table_list);
+        journal_flush(table_list);
+        history_flush();
+        replay_log_flush();
+        outbox_flush();
+    }
+}
 
-                switch (header->packet_type)
-                {
-                case PACKET_PING:
-                    // Respond to PING with PONG
-                    {
-                        char log_msg[128];
-                        snprintf(log_msg, sizeof(log_msg), "PING received from fd=%d, sending PONG", conn_data->fd);
-                        logger(MAIN_LOG, "Debug", log_msg);
-                        
-                        RawBytes* pong_packet = encode_packet(PROTOCOL_V1, PACKET_PONG, NULL, 0);
-                        send(conn_data->fd, pong_packet->data, pong_packet->len, 0);
-                        free(pong_packet->data);
-                        free(pong_packet);
-                    }
-                    break;
-
-                case PACKET_LOGIN:
-                    logger(MAIN_LOG, "Info", "Login request from client");
-                    handle_login_request(conn_data, buf, nbytes);
-                    break;
-
-                case PACKET_SIGNUP:
-                    logger(MAIN_LOG, "Info", "Signup request from client");
-                    handle_signup_request(conn_data, buf, nbytes);
-                    break;
-
-                case PACKET_CREATE_TABLE:
-                    logger(MAIN_LOG, "Info", "Create table request from client");
-                    handle_create_table_request(conn_data, buf, nbytes, table_list);
-                    break;
-
-                case PACKET_TABLES:
-                    logger(MAIN_LOG, "Info", "Get all tables request from client");
-                    handle_get_all_tables_request(conn_data, buf, nbytes, table_list);
-                    break;
-
-                case PACKET_JOIN_TABLE:
-                    logger(MAIN_LOG, "Info", "Join table request from client");
-                    handle_join_table_request(conn_data, buf, nbytes, table_list);
-                    break;
-
-                case PACKET_SCOREBOARD:
-                    logger(MAIN_LOG, "Info", "Get scoreboard request from client");
-                    handle_get_scoreboard(conn_data, buf, nbytes);
-                    break;
-
-                case PACKET_FRIENDLIST:
-                    logger(MAIN_LOG, "Info", "Get friendlist request from client");
-                    handle_get_friendlist(conn_data, buf, nbytes);
-                    break;
-                
-                case PACKET_ADD_FRIEND:
-                    logger(MAIN_LOG, "Info", "Add friend request from client");
-                    handle_add_friend_request(conn_data, buf, nbytes);
-                    break;
-                
-                case PACKET_INVITE_FRIEND:
-                    logger(MAIN_LOG, "Info", "Invite friend request from client");
-                    handle_invite_friend_request(conn_data, buf, nbytes);
-                    break;
-                
-                case PACKET_ACCEPT_INVITE:
-                    logger(MAIN_LOG, "Info", "Accept invite request from client");
-                    handle_accept_invite_request(conn_data, buf, nbytes);
-                    break;
-                
-                case PACKET_REJECT_INVITE:
-                    logger(MAIN_LOG, "Info", "Reject invite request from client");
-                    handle_reject_invite_request(conn_data, buf, nbytes);
-                    break;
-                
-                case PACKET_GET_INVITES:
-                    logger(MAIN_LOG, "Info", "Get invites request from client");
-                    handle_get_invites_request(conn_data, buf, nbytes);
-                    break;
-                
-                case PACKET_GET_FRIEND_LIST:
-                    logger(MAIN_LOG, "Info", "Get friend list request from client");
-                    handle_get_friend_list_request(conn_data, buf, nbytes);
-                    break;
-                
-                case PACKET_INVITE_TO_TABLE:
-                    logger(MAIN_LOG, "Info", "Invite to table request from client");
-                    handle_invite_to_table_request(conn_data, buf, nbytes, table_list);
-                    break;
-                
-                case PACKET_LEAVE_TABLE:
-                    logger(MAIN_LOG, "Info", "Leave table request from client");
-                    handle_leave_table_request(conn_data, buf, nbytes, table_list);
-                    break;
-                
-                case PACKET_ACTION_REQUEST:
-                    logger(MAIN_LOG, "Info", "Action request from client");
-                    handle_action_request(conn_data, buf, nbytes, table_list);
-                    break;
-
-                default:
-                    handle_unknown_request(conn_data, buf, nbytes);
-                    fprintf(stderr, "Header: %d\n", header->packet_type);
-                    break;
-                }
+// Same work as the epoll loop, but completions replace readiness: received bytes arrive in
+// provided buffers and replies queued by sendall go out with the next uring_wait.
+static int run_uring_loop(const ServiceFds* fds, TableList* table_list)
+{
+    int watched[] = {fds->tables, fds->lobby, fds->spectator, fds->presence, fds->metrics, fds->sessions, fds->handoff, fds->admin};
+    for (size_t i = 0; i < sizeof(watched) / sizeof(watched[0]); i++)
+    {
+        if (watched[i] != -1 && uring_watch(watched[i]) == -1)
+        {
+            logger(MAIN_LOG, "Error", "Cannot watch fd with io_uring");
+            return 1;
+        }
+    }
+    handoff_adopt(-1, table_list);
 
-                free(header);
-                memset(buf, 0, MAXLINE);
+    for (;;)
+    {
+        if (uring_wait() == -1)
+        {
+            return 1;
+        }
+
+        UringEvent event;
+        while (uring_next(&event))
+        {
+            switch (event.type)
+            {
+            case URING_EVENT_ACCEPT:
+                // Failures are logged and the socket closed; keep serving everyone else
+                uring_add_connection(event.fd);
+                break;
+
+            case URING_EVENT_READY:
+                handle_service_fd(fds, event.fd, table_list);
+                break;
+
+            case URING_EVENT_DATA:
+                handle_packet(-1, event.conn, event.data, event.len, table_list);
+                uring_release(&event);
+                break;
+
+            case URING_EVENT_CLOSED:
+                logger(MAIN_LOG, event.len == 0 ? "Info" : "Error",
+                       event.len == 0 ? "Client disconnected" : "Cannot receive data");
+                drop_connection(-1, event.conn, table_list);
+                break;
             }
         }
+
+        // Replies and broadcasts queued here go out with the next uring_wait, after the journal has them
+        table_actors_run(table_list);
+        journal_flush(table_list);
+        history_flush();
+        replay_log_flush();
+    }
+}
+
+int main(void)
+{
+    // Bots seed their decisions from rand(); decks never use it (see game_draw_seed)
+    srand((unsigned int)time(NULL));
+    
+    // CARDIO_TAKEOVER=1 takes the listener and the clients over from a running server (see handoff.h)
+    int listener = handoff_requested() ? handoff_receive() : get_listener_socket("0.0.0.0", "8080", 100);
+
+    if (listener == -1)
+    {
+        return 1;
+    }
+
+    TableList* table_list = init_table_list(1000);
+
+    // Scoreboard requests are answered from memory; if the database is down now, the first request retries
+    PGconn* db_conn = METRICS_DB_CONNECT(PQconnectdb(dbconninfo));
+    if (PQstatus(db_conn) == CONNECTION_OK)
+    {
+        leaderboard_seed(db_conn);
+    }
+    PQfinish(db_conn);
+
+    // This thread owns every table; commands posted by other threads wake it through this eventfd
+    int tables_fd = table_actors_init();
+    if (tables_fd == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start table mailboxes");
+        return 1;
+    }
+
+    // CPU-heavy side work runs on a work-stealing pool; bot decisions come back through table mailboxes
+    JobPool* job_pool = job_pool_create(JOB_WORKERS);
+    if (job_pool == NULL || bot_init(job_pool) == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start job pool");
+        return 1;
+    }
+
+    // Lobby deltas are pushed to subscribers when this timer fires, one tick after the first change
+    int lobby_fd = lobby_init();
+    if (lobby_fd == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start lobby tick timer");
+        return 1;
+    }
+
+    // Throttled and delayed spectator frames go out when this timer fires
+    int spectator_fd = spectator_init();
+    if (spectator_fd == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start spectator timer");
+        return 1;
+    }
+
+    // Friend presence changes are published to online friends when this timer fires
+    int presence_fd = presence_init();
+    if (presence_fd == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start presence timer");
+        return 1;
+    }
+
+    // Throughput and latency summary in server.log every METRICS_REPORT_INTERVAL_MS
+    int metrics_fd = metrics_init();
+    if (metrics_fd == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start metrics timer");
+        return 1;
+    }
+
+    // Finished hands are appended to the database in batches by a writer thread
+    if (history_init() == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start hand history writer");
+        return 1;
     }
-}
\ No newline at end of file
+
+    // Each finished hand's seed and actions go to a daily file for Cardio_replay; CARDIO_REPLAY_LOG= (empty) turns it off
+    const char* replay_path = getenv("CARDIO_REPLAY_LOG");
+    replay_path = replay_path != NULL ? replay_path : REPLAY_LOG_PATH;
+    if (replay_path[0] != '\0' && replay_log_open(replay_path) == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot open the replay log, running without it");
+    }
+
+    // Dropped sessions wait here for PACKET_RESUME; this timer closes the ones nobody came back for
+    int sessions_fd = session_init();
+    if (sessions_fd == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot start session expiry timer");
+        return 1;
+    }
+
+    // Tables come back as the journal left them; CARDIO_JOURNAL= (empty) runs without one
+    const char* journal_path = getenv("CARDIO_JOURNAL");
+    if (journal_open(journal_path != NULL ? journal_path : JOURNAL_PATH) == 0 && journal_replay(table_list) == -1)
+    {
+        logger(MAIN_LOG, "Error", "Cannot replay table journal");
+        return 1;
+    }
+
+    // The old process exits once we are ready; its sockets below are ours from then on
+    if (handoff_requested() && handoff_confirm() == -1)
+    {
+        return 1;
+    }
+
+    // Operators read live stats from a local Unix socket; the server runs fine without it
+    int admin_fd = admin_init(NULL);
+
+    // The next binary takes over through this socket; without it upgrades mean a restart
+    int handoff_fd = handoff_init();
+
+    ServiceFds fds = {listener, tables_fd, lobby_fd, spectator_fd, presence_fd, metrics_fd, sessions_fd, handoff_fd, admin_fd};
+
+    // CARDIO_IO_BACKEND=uring swaps epoll for io_uring; without kernel support we stay on epoll
+    if (uring_requested() && uring_init(listener) == 0)
+    {
+        return run_uring_loop(&fds, table_list);
+    }
+    return run_epoll_loop(&fds, table_list);
+}
+
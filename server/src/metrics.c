@@ -0,0 +1,389 @@
+#include "metrics.h"
+#include "main.h"
+#include <stdatomic.h>
+#include <sys/timerfd.h>
+#include <time.h>
+
+typedef struct
+{
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t buckets[METRICS_HIST_BUCKETS];
+} AtomicHistogram;
+
+// One per recording thread. Only the owner writes it (except the shared overflow shard), so the relaxed
+// adds never contend; aligned so two shards never share a cache line.
+typedef struct
+{
+    _Alignas(64) _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    AtomicHistogram latencies[METRIC_LATENCY_COUNT];
+    AtomicHistogram packets[METRICS_PACKET_SLOTS];
+} MetricsShard;
+
+static MetricsShard* _Atomic shards[METRICS_MAX_THREADS + 1];
+static atomic_int num_shards = 0;
+static _Thread_local MetricsShard* local_shard = NULL;
+
+static int timer_fd = -1;
+static uint64_t last_report_ns = 0;
+static uint64_t last_counters[METRIC_COUNTER_COUNT];
+
+static const char* counter_names[METRIC_COUNTER_COUNT] = {
+    "bytes_in",           "bytes_out",      "packets_in",     "packets_out",     "connections_opened",
+    "connections_closed", "tables_created", "tables_removed", "hands_completed", "socket_writes",
+    "history_hands_written", "history_hands_dropped", "history_archive_dropped",
+    "replay_hands_dropped",
+};
+
+static const char* latency_names[METRIC_LATENCY_COUNT] = {
+    "broadcast",
+    "db_connect",
+    "db_query",
+    "bot_decision",
+    "journal_sync",
+    "history_copy",
+};
+
+uint64_t metrics_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ===== Shards =====
+
+static MetricsShard* get_shard(void)
+{
+    if (local_shard != NULL)
+    {
+        return local_shard;
+    }
+
+    int index = atomic_fetch_add_explicit(&num_shards, 1, memory_order_relaxed);
+    if (index >= METRICS_MAX_THREADS)
+    {
+        // Out of private shards: share the overflow one, the adds are atomic so it stays correct
+        index = METRICS_MAX_THREADS;
+        atomic_store_explicit(&num_shards, METRICS_MAX_THREADS + 1, memory_order_relaxed);
+    }
+
+    MetricsShard* shard = atomic_load_explicit(&shards[index], memory_order_acquire);
+    if (shard == NULL)
+    {
+        MetricsShard* fresh = aligned_alloc(64, sizeof(MetricsShard));
+        if (fresh == NULL)
+        {
+            return NULL;
+        }
+        memset(fresh, 0, sizeof(MetricsShard));
+        MetricsShard* expected = NULL;
+        if (atomic_compare_exchange_strong_explicit(&shards[index], &expected, fresh, memory_order_release,
+                                                    memory_order_acquire))
+        {
+            shard = fresh;
+        }
+        else
+        {
+            free(fresh);
+            shard = expected;
+        }
+    }
+    local_shard = shard;
+    return shard;
+}
+
+// ===== Histograms =====
+
+// Values below 8 get a bucket each; above that, bucket = 8 per power of two plus the next 3 bits
+static int bucket_index(uint64_t value)
+{
+    if (value < METRICS_HIST_SUB_BUCKETS)
+    {
+        return (int)value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int index = (exponent - 2) * METRICS_HIST_SUB_BUCKETS + (int)((value >> (exponent - 3)) & 7);
+    return index < METRICS_HIST_BUCKETS ? index : METRICS_HIST_BUCKETS - 1;
+}
+
+// Largest value that maps to the bucket
+static uint64_t bucket_upper_bound(int index)
+{
+    if (index < METRICS_HIST_SUB_BUCKETS)
+    {
+        return (uint64_t)index;
+    }
+    int exponent = index / METRICS_HIST_SUB_BUCKETS + 2;
+    uint64_t sub = (uint64_t)(index % METRICS_HIST_SUB_BUCKETS);
+    return ((METRICS_HIST_SUB_BUCKETS + sub + 1) << (exponent - 3)) - 1;
+}
+
+static void histogram_record(AtomicHistogram* histogram, uint64_t value)
+{
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum_ns, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->buckets[bucket_index(value)], 1, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+    while (value > max &&
+           !atomic_compare_exchange_weak_explicit(&histogram->max_ns, &max, value, memory_order_relaxed,
+                                                  memory_order_relaxed))
+    {
+    }
+}
+
+// Add one shard's histogram into out. Returns false if it holds nothing.
+static bool histogram_merge(MetricsHistogram* out, AtomicHistogram* histogram)
+{
+    uint64_t count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+    if (count == 0)
+    {
+        return false;
+    }
+
+    out->count += count;
+    out->sum_ns += atomic_load_explicit(&histogram->sum_ns, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+    if (max > out->max_ns)
+    {
+        out->max_ns = max;
+    }
+    for (int i = 0; i < METRICS_HIST_BUCKETS; i++)
+    {
+        out->buckets[i] += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+    }
+    return true;
+}
+
+static int active_shards(void)
+{
+    int count = atomic_load_explicit(&num_shards, memory_order_relaxed);
+    return count < METRICS_MAX_THREADS + 1 ? count : METRICS_MAX_THREADS + 1;
+}
+
+// ===== Recording =====
+
+void metrics_add(MetricCounter counter, uint64_t amount)
+{
+    MetricsShard* shard = get_shard();
+    if (shard != NULL && counter < METRIC_COUNTER_COUNT)
+    {
+        atomic_fetch_add_explicit(&shard->counters[counter], amount, memory_order_relaxed);
+    }
+}
+
+void metrics_record(MetricLatency latency, uint64_t elapsed_ns)
+{
+    MetricsShard* shard = get_shard();
+    if (shard != NULL && latency < METRIC_LATENCY_COUNT)
+    {
+        histogram_record(&shard->latencies[latency], elapsed_ns);
+    }
+}
+
+void metrics_record_packet(int packet_type, uint64_t elapsed_ns)
+{
+    MetricsShard* shard = get_shard();
+    if (shard == NULL)
+    {
+        return;
+    }
+    int slot = packet_type / 10;
+    if (packet_type < 0 || slot >= METRICS_PACKET_SLOTS)
+    {
+        slot = 0;
+    }
+    histogram_record(&shard->packets[slot], elapsed_ns);
+}
+
+// ===== Snapshots =====
+
+uint64_t metrics_counter(MetricCounter counter)
+{
+    uint64_t total = 0;
+    int count = active_shards();
+    for (int i = 0; i < count && counter < METRIC_COUNTER_COUNT; i++)
+    {
+        MetricsShard* shard = atomic_load_explicit(&shards[i], memory_order_acquire);
+        if (shard != NULL)
+        {
+            total += atomic_load_explicit(&shard->counters[counter], memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+void metrics_latency(MetricLatency latency, MetricsHistogram* out)
+{
+    memset(out, 0, sizeof(MetricsHistogram));
+    int count = active_shards();
+    for (int i = 0; i < count && latency < METRIC_LATENCY_COUNT; i++)
+    {
+        MetricsShard* shard = atomic_load_explicit(&shards[i], memory_order_acquire);
+        if (shard != NULL)
+        {
+            histogram_merge(out, &shard->latencies[latency]);
+        }
+    }
+}
+
+bool metrics_packet_latency(int slot, MetricsHistogram* out)
+{
+    memset(out, 0, sizeof(MetricsHistogram));
+    if (slot < 0 || slot >= METRICS_PACKET_SLOTS)
+    {
+        return false;
+    }
+
+    bool found = false;
+    int count = active_shards();
+    for (int i = 0; i < count; i++)
+    {
+        MetricsShard* shard = atomic_load_explicit(&shards[i], memory_order_acquire);
+        if (shard != NULL && histogram_merge(out, &shard->packets[slot]))
+        {
+            found = true;
+        }
+    }
+    return found;
+}
+
+void metrics_histogram_add(MetricsHistogram* histogram, uint64_t value_ns)
+{
+    histogram->count++;
+    histogram->sum_ns += value_ns;
+    histogram->buckets[bucket_index(value_ns)]++;
+    if (value_ns > histogram->max_ns)
+    {
+        histogram->max_ns = value_ns;
+    }
+}
+
+uint64_t metrics_percentile(const MetricsHistogram* histogram, double quantile)
+{
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(quantile * (double)histogram->count + 0.5);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < METRICS_HIST_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+        {
+            uint64_t bound = bucket_upper_bound(i);
+            return bound < histogram->max_ns ? bound : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+const char* metrics_counter_name(MetricCounter counter)
+{
+    return counter < METRIC_COUNTER_COUNT ? counter_names[counter] : "unknown";
+}
+
+const char* metrics_latency_name(MetricLatency latency)
+{
+    return latency < METRIC_LATENCY_COUNT ? latency_names[latency] : "unknown";
+}
+
+// ===== Periodic report =====
+
+int metrics_init(void)
+{
+    last_report_ns = metrics_now_ns();
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot create metrics report timer", 1);
+        return -1;
+    }
+
+    struct itimerspec spec = {0};
+    spec.it_value.tv_sec = METRICS_REPORT_INTERVAL_MS / 1000;
+    spec.it_value.tv_nsec = (METRICS_REPORT_INTERVAL_MS % 1000) * 1000000L;
+    spec.it_interval = spec.it_value;
+    timerfd_settime(timer_fd, 0, &spec, NULL);
+    return timer_fd;
+}
+
+void metrics_report(void)
+{
+    if (timer_fd != -1)
+    {
+        uint64_t expirations;
+        while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+        {
+        }
+    }
+
+    uint64_t now = metrics_now_ns();
+    double seconds = (double)(now - last_report_ns) / 1e9;
+    if (seconds <= 0)
+    {
+        return;
+    }
+    last_report_ns = now;
+
+    uint64_t counters[METRIC_COUNTER_COUNT];
+    double rates[METRIC_COUNTER_COUNT];
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++)
+    {
+        counters[i] = metrics_counter((MetricCounter)i);
+        rates[i] = (double)(counters[i] - last_counters[i]) / seconds;
+        last_counters[i] = counters[i];
+    }
+
+    char log_msg[512];
+    snprintf(log_msg, sizeof(log_msg),
+             "%.1f pkt/s in, %.1f pkt/s out, %.0f B/s in, %.0f B/s out, %.2f hands/s, %llu connections, %llu tables",
+             rates[METRIC_PACKETS_IN], rates[METRIC_PACKETS_OUT], rates[METRIC_BYTES_IN], rates[METRIC_BYTES_OUT],
+             rates[METRIC_HANDS_COMPLETED],
+             (unsigned long long)(counters[METRIC_CONNECTIONS_OPENED] - counters[METRIC_CONNECTIONS_CLOSED]),
+             (unsigned long long)(counters[METRIC_TABLES_CREATED] - counters[METRIC_TABLES_REMOVED]));
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+    // Latencies are cumulative since start; the admin socket has the per-packet breakdown
+    static MetricsHistogram histogram;
+    int len = 0;
+    for (int i = 0; i < METRIC_LATENCY_COUNT && len < (int)sizeof(log_msg); i++)
+    {
+        metrics_latency((MetricLatency)i, &histogram);
+        if (histogram.count == 0)
+        {
+            continue;
+        }
+        len += snprintf(log_msg + len, sizeof(log_msg) - len, "%s p50=%lluus p99=%lluus max=%lluus n=%llu; ",
+                        latency_names[i], (unsigned long long)(metrics_percentile(&histogram, 0.5) / 1000),
+                        (unsigned long long)(metrics_percentile(&histogram, 0.99) / 1000),
+                        (unsigned long long)(histogram.max_ns / 1000), (unsigned long long)histogram.count);
+    }
+    if (len > 0)
+    {
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    }
+}
+
+void metrics_reset(void)
+{
+    int count = active_shards();
+    for (int i = 0; i < count; i++)
+    {
+        MetricsShard* shard = atomic_load_explicit(&shards[i], memory_order_acquire);
+        if (shard != NULL)
+        {
+            memset((void*)shard, 0, sizeof(MetricsShard));
+        }
+    }
+    memset(last_counters, 0, sizeof(last_counters));
+    last_report_ns = metrics_now_ns();
+}
@@ -0,0 +1,246 @@
+#include "outbox.h"
+#include "main.h"
+
+typedef struct
+{
+    char* data;
+    size_t len;    // Bytes queued, including those already written
+    size_t offset; // Bytes already written
+    size_t capacity;
+    bool dirty;   // Listed in dirty_fds
+    bool blocked; // Socket buffer full; waiting for EPOLLOUT
+} Outbox;
+
+static bool enabled = false;
+static Outbox* outboxes = NULL; // Indexed by fd
+static int num_outboxes = 0;
+static int* dirty_fds = NULL;
+static int num_dirty = 0;
+static int dirty_capacity = 0;
+
+static Outbox* find_outbox(int fd)
+{
+    return (fd >= 0 && fd < num_outboxes) ? &outboxes[fd] : NULL;
+}
+
+static Outbox* ensure_outbox(int fd)
+{
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (fd >= num_outboxes)
+    {
+        int capacity = num_outboxes > 0 ? num_outboxes : 1024;
+        while (capacity <= fd)
+        {
+            capacity *= 2;
+        }
+        Outbox* grown = realloc(outboxes, (size_t) capacity * sizeof(Outbox));
+        if (grown == NULL)
+        {
+            return NULL;
+        }
+        memset(grown + num_outboxes, 0, (size_t) (capacity - num_outboxes) * sizeof(Outbox));
+        outboxes = grown;
+        num_outboxes = capacity;
+    }
+    return &outboxes[fd];
+}
+
+static void reset_outbox(Outbox* outbox)
+{
+    outbox->len = 0;
+    outbox->offset = 0;
+    outbox->blocked = false;
+    if (outbox->capacity > OUTBOX_KEEP_CAPACITY)
+    {
+        free(outbox->data);
+        outbox->data = NULL;
+        outbox->capacity = 0;
+    }
+}
+
+// Write as much as the socket takes. Returns true once the outbox is empty.
+static bool write_outbox(int fd, Outbox* outbox)
+{
+    while (outbox->offset < outbox->len)
+    {
+        ssize_t n = send(fd, outbox->data + outbox->offset, outbox->len - outbox->offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        metrics_add(METRIC_SOCKET_WRITES, 1);
+        if (n > 0)
+        {
+            outbox->offset += (size_t) n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            outbox->blocked = true;
+            return false;
+        }
+
+        // The connection is gone; its recv side reports that to the loop
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Send failed on fd=%d, dropping %zu queued bytes: %s", fd,
+                 outbox->len - outbox->offset, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        break;
+    }
+    reset_outbox(outbox);
+    return true;
+}
+
+void outbox_enable(void)
+{
+    enabled = true;
+}
+
+bool outbox_enabled(void)
+{
+    return enabled;
+}
+
+int outbox_queue(int fd, const char* buf, int len)
+{
+    Outbox* outbox = enabled && len >= 0 ? ensure_outbox(fd) : NULL;
+    if (outbox == NULL)
+    {
+        return -1;
+    }
+
+    size_t needed = outbox->len + (size_t) len;
+    if (needed - outbox->offset > OUTBOX_MAX_PENDING)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "fd=%d is not reading (%zu bytes queued), disconnecting", fd,
+                 outbox->len - outbox->offset);
+        logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+        shutdown(fd, SHUT_RDWR);
+        reset_outbox(outbox);
+        return 0;
+    }
+
+    if (needed > outbox->capacity)
+    {
+        // Reclaim the written prefix before growing
+        if (outbox->offset > 0)
+        {
+            memmove(outbox->data, outbox->data + outbox->offset, outbox->len - outbox->offset);
+            outbox->len -= outbox->offset;
+            outbox->offset = 0;
+            needed = outbox->len + (size_t) len;
+        }
+        size_t capacity = outbox->capacity > 0 ? outbox->capacity : 4096;
+        while (capacity < needed)
+        {
+            capacity *= 2;
+        }
+        if (capacity != outbox->capacity)
+        {
+            char* grown = realloc(outbox->data, capacity);
+            if (grown == NULL)
+            {
+                return -1;
+            }
+            outbox->data = grown;
+            outbox->capacity = capacity;
+        }
+    }
+
+    memcpy(outbox->data + outbox->len, buf, (size_t) len);
+    outbox->len = needed;
+
+    if (!outbox->dirty && !outbox->blocked)
+    {
+        if (num_dirty == dirty_capacity)
+        {
+            int capacity = dirty_capacity > 0 ? dirty_capacity * 2 : 256;
+            int* grown = realloc(dirty_fds, (size_t) capacity * sizeof(int));
+            if (grown == NULL)
+            {
+                // Keep the bytes; they go out with the connection's next flush
+                return 0;
+            }
+            dirty_fds = grown;
+            dirty_capacity = capacity;
+        }
+        dirty_fds[num_dirty++] = fd;
+        outbox->dirty = true;
+    }
+    return 0;
+}
+
+void outbox_flush(void)
+{
+    for (int i = 0; i < num_dirty; i++)
+    {
+        Outbox* outbox = &outboxes[dirty_fds[i]];
+        outbox->dirty = false;
+        if (!outbox->blocked)
+        {
+            write_outbox(dirty_fds[i], outbox);
+        }
+    }
+    num_dirty = 0;
+}
+
+void outbox_writable(int fd)
+{
+    Outbox* outbox = find_outbox(fd);
+    if (outbox != NULL && outbox->blocked)
+    {
+        outbox->blocked = false;
+        write_outbox(fd, outbox);
+    }
+}
+
+bool outbox_drain(int fd)
+{
+    Outbox* outbox = find_outbox(fd);
+    if (outbox == NULL || outbox->offset == outbox->len)
+    {
+        return true;
+    }
+    outbox->blocked = false;
+    return write_outbox(fd, outbox);
+}
+
+void outbox_close(int fd)
+{
+    Outbox* outbox = find_outbox(fd);
+    if (outbox == NULL)
+    {
+        return;
+    }
+    if (outbox->offset < outbox->len)
+    {
+        outbox->blocked = false;
+        write_outbox(fd, outbox);
+    }
+
+    // A new connection may reuse fd; it starts empty. A stale dirty_fds entry just flushes nothing.
+    free(outbox->data);
+    outbox->data = NULL;
+    outbox->capacity = 0;
+    outbox->len = 0;
+    outbox->offset = 0;
+    outbox->blocked = false;
+}
+
+void outbox_stats(int* connections, size_t* bytes)
+{
+    *connections = 0;
+    *bytes = 0;
+    for (int fd = 0; fd < num_outboxes; fd++)
+    {
+        if (outboxes[fd].offset < outboxes[fd].len)
+        {
+            (*connections)++;
+            *bytes += outboxes[fd].len - outboxes[fd].offset;
+        }
+    }
+}
@@ -0,0 +1,565 @@
+#include "presence.h"
+#include "main.h"
+#include <sys/timerfd.h>
+
+typedef struct PresenceEntry
+{
+    int user_id;
+    char username[32];
+    conn_data_t* conns[PRESENCE_MAX_CONNECTIONS];
+    int num_conns;
+    int status;
+    int table_id;
+    int published_status; // As friends last saw it
+    int published_table_id;
+    bool dirty;
+    uint64_t snapshot_tick; // Tick in which this user receives the status of every online friend
+    int* last_friends;      // Friend ids captured when the last connection closed
+    int num_last_friends;
+    PresenceChange* batch;  // Changes to send this user at the end of the tick
+    int batch_len;
+    int batch_capacity;
+    struct PresenceEntry* next_by_id;
+    struct PresenceEntry* next_by_name;
+} PresenceEntry;
+
+static PresenceEntry* by_id[PRESENCE_BUCKETS];
+static PresenceEntry* by_name[PRESENCE_BUCKETS];
+static int num_online = 0;
+
+static int* dirty_ids = NULL; // Users whose status changed since the last tick, in order of change
+static int num_dirty = 0;
+static int dirty_capacity = 0;
+
+static int* pending_pairs = NULL; // New friendships, two ids each
+static int num_pairs = 0;
+static int pairs_capacity = 0;
+
+static PresenceEntry** recipients = NULL; // Users with a non-empty batch this tick
+static int num_recipients = 0;
+static int recipients_capacity = 0;
+
+static uint64_t tick = 0;
+static int timer_fd = -1;
+static bool timer_armed = false;
+
+int presence_init(void)
+{
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot create presence tick timer", 1);
+    }
+    return timer_fd;
+}
+
+static void arm_tick(void)
+{
+    if (timer_fd == -1 || timer_armed)
+    {
+        return;
+    }
+
+    struct itimerspec spec = {0};
+    spec.it_value.tv_sec = PRESENCE_TICK_MS / 1000;
+    spec.it_value.tv_nsec = (long) (PRESENCE_TICK_MS % 1000) * 1000000L;
+    if (timerfd_settime(timer_fd, 0, &spec, NULL) == 0)
+    {
+        timer_armed = true;
+    }
+}
+
+// Grow *array so it holds at least needed elements. Returns 0 on success, -1 if out of memory.
+static int reserve(void** array, int* capacity, int needed, size_t element_size)
+{
+    if (needed <= *capacity)
+    {
+        return 0;
+    }
+
+    int new_capacity = *capacity ? *capacity : 16;
+    while (new_capacity < needed)
+    {
+        new_capacity *= 2;
+    }
+    void* grown = realloc(*array, new_capacity * element_size);
+    if (grown == NULL)
+    {
+        return -1;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+// ===== Registry =====
+
+static unsigned int name_hash(const char* username)
+{
+    unsigned int hash = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*) username; *c; c++)
+    {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash % PRESENCE_BUCKETS;
+}
+
+static PresenceEntry* find_entry(int user_id)
+{
+    PresenceEntry* entry = by_id[(unsigned int) user_id % PRESENCE_BUCKETS];
+    while (entry != NULL && entry->user_id != user_id)
+    {
+        entry = entry->next_by_id;
+    }
+    return entry;
+}
+
+static PresenceEntry* create_entry(const conn_data_t* conn_data)
+{
+    PresenceEntry* entry = calloc(1, sizeof(PresenceEntry));
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+    entry->user_id = (int) conn_data->user_id;
+    strncpy(entry->username, conn_data->username, sizeof(entry->username) - 1);
+
+    PresenceEntry** id_bucket = &by_id[(unsigned int) entry->user_id % PRESENCE_BUCKETS];
+    entry->next_by_id = *id_bucket;
+    *id_bucket = entry;
+    PresenceEntry** name_bucket = &by_name[name_hash(entry->username)];
+    entry->next_by_name = *name_bucket;
+    *name_bucket = entry;
+    return entry;
+}
+
+static void free_entry(PresenceEntry* entry)
+{
+    PresenceEntry** slot = &by_id[(unsigned int) entry->user_id % PRESENCE_BUCKETS];
+    while (*slot != entry)
+    {
+        slot = &(*slot)->next_by_id;
+    }
+    *slot = entry->next_by_id;
+
+    slot = &by_name[name_hash(entry->username)];
+    while (*slot != entry)
+    {
+        slot = &(*slot)->next_by_name;
+    }
+    *slot = entry->next_by_name;
+
+    free(entry->last_friends);
+    free(entry->batch);
+    free(entry);
+}
+
+static void mark_dirty(PresenceEntry* entry)
+{
+    if (entry->dirty)
+    {
+        return;
+    }
+    if (reserve((void**) &dirty_ids, &dirty_capacity, num_dirty + 1, sizeof(int)) != 0)
+    {
+        return;
+    }
+    dirty_ids[num_dirty++] = entry->user_id;
+    entry->dirty = true;
+    arm_tick();
+}
+
+static void update_status(PresenceEntry* entry)
+{
+    int status = PRESENCE_OFFLINE;
+    int table_id = 0;
+    for (int i = 0; i < entry->num_conns; i++)
+    {
+        const conn_data_t* conn = entry->conns[i];
+        if (conn->table_id != 0)
+        {
+            status = PRESENCE_TABLE;
+            table_id = conn->table_id;
+        }
+        else if (status < PRESENCE_LOBBY && lobby_is_subscribed(conn->fd))
+        {
+            status = PRESENCE_LOBBY;
+        }
+        else if (status < PRESENCE_ONLINE)
+        {
+            status = PRESENCE_ONLINE;
+        }
+    }
+
+    if (status != entry->status || table_id != entry->table_id)
+    {
+        entry->status = status;
+        entry->table_id = table_id;
+        mark_dirty(entry);
+    }
+}
+
+void presence_connect(conn_data_t* conn_data)
+{
+    if (conn_data == NULL || conn_data->user_id == 0)
+    {
+        return;
+    }
+
+    PresenceEntry* entry = find_entry((int) conn_data->user_id);
+    if (entry == NULL && (entry = create_entry(conn_data)) == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < entry->num_conns; i++)
+    {
+        if (entry->conns[i] == conn_data)
+        {
+            return;
+        }
+    }
+    if (entry->num_conns == PRESENCE_MAX_CONNECTIONS)
+    {
+        logger_ex(MAIN_LOG, "WARN", __func__, "Too many connections for one user, presence ignores this one", 1);
+        return;
+    }
+
+    if (entry->num_conns == 0)
+    {
+        num_online++;
+        free(entry->last_friends);
+        entry->last_friends = NULL;
+        entry->num_last_friends = 0;
+    }
+    entry->conns[entry->num_conns++] = conn_data;
+    update_status(entry);
+}
+
+void presence_disconnect(conn_data_t* conn_data)
+{
+    if (conn_data == NULL || conn_data->user_id == 0)
+    {
+        return;
+    }
+
+    PresenceEntry* entry = find_entry((int) conn_data->user_id);
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < entry->num_conns; i++)
+    {
+        if (entry->conns[i] == conn_data)
+        {
+            entry->conns[i] = entry->conns[--entry->num_conns];
+            break;
+        }
+    }
+
+    // The social cache drops the friend list with the last connection; keep who must hear about it
+    if (entry->num_conns == 0)
+    {
+        num_online--;
+        dbFriendList* friends = social_cache_friends(entry->user_id);
+        if (friends != NULL && friends->num > 0)
+        {
+            entry->last_friends = malloc(friends->num * sizeof(int));
+            if (entry->last_friends != NULL)
+            {
+                for (int i = 0; i < friends->num; i++)
+                {
+                    entry->last_friends[i] = friends->friends[i].user_id;
+                }
+                entry->num_last_friends = friends->num;
+            }
+        }
+    }
+    update_status(entry);
+}
+
+void presence_refresh(const conn_data_t* conn_data)
+{
+    if (conn_data == NULL || conn_data->user_id == 0)
+    {
+        return;
+    }
+
+    PresenceEntry* entry = find_entry((int) conn_data->user_id);
+    if (entry != NULL)
+    {
+        update_status(entry);
+    }
+}
+
+void presence_friendship_added(int user_id, int friend_id)
+{
+    if (reserve((void**) &pending_pairs, &pairs_capacity, num_pairs + 2, sizeof(int)) != 0)
+    {
+        return;
+    }
+    pending_pairs[num_pairs++] = user_id;
+    pending_pairs[num_pairs++] = friend_id;
+    arm_tick();
+}
+
+conn_data_t* presence_find_by_username(const char* username)
+{
+    if (username == NULL || username[0] == '\0')
+    {
+        return NULL;
+    }
+
+    PresenceEntry* entry = by_name[name_hash(username)];
+    while (entry != NULL && strcmp(entry->username, username) != 0)
+    {
+        entry = entry->next_by_name;
+    }
+    return entry != NULL && entry->num_conns > 0 ? entry->conns[0] : NULL;
+}
+
+conn_data_t* presence_find_by_user_id(int user_id)
+{
+    PresenceEntry* entry = find_entry(user_id);
+    return entry != NULL && entry->num_conns > 0 ? entry->conns[0] : NULL;
+}
+
+int presence_status(int user_id, int* table_id)
+{
+    PresenceEntry* entry = find_entry(user_id);
+    if (table_id != NULL)
+    {
+        *table_id = entry ? entry->table_id : 0;
+    }
+    return entry ? entry->status : PRESENCE_OFFLINE;
+}
+
+int presence_pending_count(void)
+{
+    return num_dirty;
+}
+
+int presence_online_count(void)
+{
+    return num_online;
+}
+
+// ===== Publishing =====
+
+static void describe(const PresenceEntry* entry, PresenceChange* change)
+{
+    change->user_id = entry->user_id;
+    memcpy(change->username, entry->username, sizeof(change->username));
+    change->status = entry->status;
+    change->table_id = entry->table_id;
+}
+
+static void queue_change(PresenceEntry* recipient, const PresenceChange* change)
+{
+    if (recipient->batch_len == 0)
+    {
+        if (reserve((void**) &recipients, &recipients_capacity, num_recipients + 1, sizeof(PresenceEntry*)) != 0)
+        {
+            return;
+        }
+        recipients[num_recipients++] = recipient;
+    }
+    if (reserve((void**) &recipient->batch, &recipient->batch_capacity, recipient->batch_len + 1,
+                sizeof(PresenceChange)) != 0)
+    {
+        return;
+    }
+    recipient->batch[recipient->batch_len++] = *change;
+}
+
+static PresenceEntry* online_entry(int user_id)
+{
+    PresenceEntry* entry = find_entry(user_id);
+    return entry != NULL && entry->num_conns > 0 ? entry : NULL;
+}
+
+// Queue the change of entry for each online friend, skipping friends that get a full snapshot this tick
+static void notify_friends(PresenceEntry* entry, const PresenceChange* change)
+{
+    dbFriendList* friends = entry->num_conns > 0 ? social_cache_friends(entry->user_id) : NULL;
+    int num_friends = friends ? friends->num : entry->num_last_friends;
+    for (int i = 0; i < num_friends; i++)
+    {
+        int friend_id = friends ? friends->friends[i].user_id : entry->last_friends[i];
+        PresenceEntry* recipient = online_entry(friend_id);
+        if (recipient != NULL && recipient->snapshot_tick != tick)
+        {
+            queue_change(recipient, change);
+        }
+    }
+}
+
+static void queue_snapshot(PresenceEntry* entry)
+{
+    dbFriendList* friends = social_cache_friends(entry->user_id);
+    for (int i = 0; friends != NULL && i < friends->num; i++)
+    {
+        PresenceEntry* other = online_entry(friends->friends[i].user_id);
+        if (other != NULL)
+        {
+            PresenceChange change;
+            describe(other, &change);
+            queue_change(entry, &change);
+        }
+    }
+}
+
+static int send_batch(PresenceEntry* recipient)
+{
+    int packets = 0;
+    for (int start = 0; start < recipient->batch_len; start += PRESENCE_MAX_CHANGES_PER_PACKET)
+    {
+        int count = recipient->batch_len - start;
+        if (count > PRESENCE_MAX_CHANGES_PER_PACKET)
+        {
+            count = PRESENCE_MAX_CHANGES_PER_PACKET;
+        }
+
+        RawBytes* raw_bytes = encode_presence_update(&recipient->batch[start], count);
+        if (raw_bytes == NULL)
+        {
+            continue;
+        }
+        RawBytes* packet = encode_packet(PROTOCOL_V1, PACKET_PRESENCE_UPDATE, raw_bytes->data, raw_bytes->len);
+        for (int i = 0; i < recipient->num_conns; i++)
+        {
+            int len = (int) packet->len;
+            sendall(recipient->conns[i]->fd, packet->data, &len);
+        }
+        packets++;
+
+        free(packet->data);
+        free(packet);
+        free(raw_bytes->data);
+        free(raw_bytes);
+    }
+    recipient->batch_len = 0;
+    return packets;
+}
+
+void presence_flush(void)
+{
+    if (timer_fd != -1)
+    {
+        uint64_t expirations;
+        while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+        {
+        }
+    }
+    timer_armed = false;
+    tick++;
+
+    int num_processed = num_dirty < PRESENCE_MAX_USERS_PER_TICK ? num_dirty : PRESENCE_MAX_USERS_PER_TICK;
+
+    // Users coming online get every online friend's status instead of individual changes
+    for (int i = 0; i < num_processed; i++)
+    {
+        PresenceEntry* entry = find_entry(dirty_ids[i]);
+        if (entry != NULL && entry->published_status == PRESENCE_OFFLINE && entry->status != PRESENCE_OFFLINE)
+        {
+            entry->snapshot_tick = tick;
+        }
+    }
+
+    int num_published = 0;
+    for (int i = 0; i < num_processed; i++)
+    {
+        PresenceEntry* entry = find_entry(dirty_ids[i]);
+        if (entry == NULL)
+        {
+            continue;
+        }
+        entry->dirty = false;
+        if (entry->status == entry->published_status && entry->table_id == entry->published_table_id)
+        {
+            continue;
+        }
+
+        PresenceChange change;
+        describe(entry, &change);
+        notify_friends(entry, &change);
+        if (entry->snapshot_tick == tick)
+        {
+            queue_snapshot(entry);
+        }
+        entry->published_status = entry->status;
+        entry->published_table_id = entry->table_id;
+        num_published++;
+    }
+
+    for (int i = 0; i + 1 < num_pairs; i += 2)
+    {
+        PresenceEntry* a = online_entry(pending_pairs[i]);
+        PresenceEntry* b = online_entry(pending_pairs[i + 1]);
+        if (a == NULL || b == NULL)
+        {
+            continue;
+        }
+        PresenceChange change;
+        describe(b, &change);
+        queue_change(a, &change);
+        describe(a, &change);
+        queue_change(b, &change);
+    }
+    num_pairs = 0;
+
+    int num_packets = 0;
+    int num_notified = num_recipients;
+    for (int i = 0; i < num_recipients; i++)
+    {
+        num_packets += send_batch(recipients[i]);
+    }
+    num_recipients = 0;
+
+    // Users that went offline are forgotten once their friends have been told
+    for (int i = 0; i < num_processed; i++)
+    {
+        PresenceEntry* entry = find_entry(dirty_ids[i]);
+        if (entry != NULL && entry->num_conns == 0 && !entry->dirty)
+        {
+            free_entry(entry);
+        }
+    }
+
+    num_dirty -= num_processed;
+    memmove(dirty_ids, dirty_ids + num_processed, num_dirty * sizeof(int));
+    if (num_dirty > 0)
+    {
+        arm_tick();
+    }
+
+    if (num_published > 0)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Presence: %d users published to %d friends in %d packets (%d pending)",
+                 num_published, num_notified, num_packets, num_dirty);
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    }
+}
+
+void presence_free(void)
+{
+    for (int b = 0; b < PRESENCE_BUCKETS; b++)
+    {
+        while (by_id[b] != NULL)
+        {
+            free_entry(by_id[b]);
+        }
+    }
+    free(dirty_ids);
+    free(pending_pairs);
+    free(recipients);
+    dirty_ids = NULL;
+    pending_pairs = NULL;
+    recipients = NULL;
+    num_dirty = dirty_capacity = 0;
+    num_pairs = pairs_capacity = 0;
+    num_recipients = recipients_capacity = 0;
+    num_online = 0;
+}
@@ -344,9 +344,9 @@ RawBytes* encode_scoreboard_response(dbScoreboard* leaderboard)
     char buffer[MAXLINE];
     mpack_writer_init(&writer, buffer, MAXLINE);
 
-    mpack_start_array(&writer, 20);
+    mpack_start_array(&writer, leaderboard->size);
 
-    for (int i = 0; i < 20; i++)
+    for (int i = 0; i < leaderboard->size; i++)
     {
         mpack_start_map(&writer, 3);
         mpack_write_cstr(&writer, "rank");
@@ -456,6 +456,320 @@ RawBytes* encode_full_tables_response(TableList* table_list)
     return raw_bytes;
 }
 
+static void write_table_summary(mpack_writer_t* writer, const TableSummary* table)
+{
+    mpack_start_map(writer, 5);
+    mpack_write_cstr(writer, "id");
+    mpack_write_i32(writer, table->id);
+    mpack_write_cstr(writer, "tableName");
+    mpack_write_cstr(writer, table->name);
+    mpack_write_cstr(writer, "maxPlayer");
+    mpack_write_i32(writer, table->max_player);
+    mpack_write_cstr(writer, "minBet");
+    mpack_write_i32(writer, table->min_bet);
+    mpack_write_cstr(writer, "currentPlayer");
+    mpack_write_i32(writer, table->current_player);
+    mpack_finish_map(writer);
+}
+
+int decode_tables_query(char* payload, size_t payload_len, TablesQuery* query)
+{
+    memset(query, 0, sizeof(TablesQuery));
+    query->min_bet = -1;
+    query->max_bet = -1;
+    query->sort = TABLES_SORT_STAKES;
+    query->limit = TABLES_PAGE_DEFAULT;
+
+    mpack_reader_t reader;
+    mpack_reader_init(&reader, payload, payload_len, payload_len);
+
+    uint32_t count = mpack_expect_map_max(&reader, 16);
+    for (uint32_t i = 0; i < count && mpack_reader_error(&reader) == mpack_ok; i++)
+    {
+        char key[16];
+        mpack_expect_cstr(&reader, key, sizeof(key));
+
+        if (strcmp(key, "minBet") == 0)
+        {
+            query->min_bet = mpack_expect_int(&reader);
+        }
+        else if (strcmp(key, "maxBet") == 0)
+        {
+            query->max_bet = mpack_expect_int(&reader);
+        }
+        else if (strcmp(key, "minFreeSeats") == 0)
+        {
+            query->min_free_seats = mpack_expect_int(&reader);
+        }
+        else if (strcmp(key, "namePrefix") == 0)
+        {
+            mpack_expect_cstr(&reader, query->name_prefix, sizeof(query->name_prefix));
+        }
+        else if (strcmp(key, "sort") == 0)
+        {
+            char sort[16];
+            mpack_expect_cstr(&reader, sort, sizeof(sort));
+            if (strcmp(sort, "stakes") == 0)
+            {
+                query->sort = TABLES_SORT_STAKES;
+            }
+            else if (strcmp(sort, "freeSeats") == 0)
+            {
+                query->sort = TABLES_SORT_FREE_SEATS;
+            }
+            else if (strcmp(sort, "name") == 0)
+            {
+                query->sort = TABLES_SORT_NAME;
+            }
+            else
+            {
+                mpack_reader_flag_error(&reader, mpack_error_data);
+            }
+        }
+        else if (strcmp(key, "desc") == 0)
+        {
+            query->desc = mpack_expect_bool(&reader);
+        }
+        else if (strcmp(key, "limit") == 0)
+        {
+            query->limit = mpack_expect_int_range(&reader, 1, TABLES_PAGE_MAX);
+        }
+        else if (strcmp(key, "cursor") == 0)
+        {
+            if (mpack_peek_tag(&reader).type == mpack_type_nil)
+            {
+                mpack_expect_nil(&reader);
+                continue;
+            }
+            uint32_t cursor_count = mpack_expect_map_max(&reader, 2);
+            for (uint32_t j = 0; j < cursor_count && mpack_reader_error(&reader) == mpack_ok; j++)
+            {
+                char cursor_field[8];
+                mpack_expect_cstr(&reader, cursor_field, sizeof(cursor_field));
+                if (strcmp(cursor_field, "id") == 0)
+                {
+                    query->cursor_id = mpack_expect_int(&reader);
+                }
+                else if (strcmp(cursor_field, "key") == 0 && mpack_peek_tag(&reader).type == mpack_type_str)
+                {
+                    mpack_expect_cstr(&reader, query->cursor_name, sizeof(query->cursor_name));
+                }
+                else if (strcmp(cursor_field, "key") == 0)
+                {
+                    query->cursor_key = mpack_expect_int(&reader);
+                }
+                else
+                {
+                    mpack_discard(&reader);
+                }
+            }
+            mpack_done_map(&reader);
+            query->has_cursor = true;
+        }
+        else
+        {
+            mpack_discard(&reader);
+        }
+    }
+    mpack_done_map(&reader);
+
+    if (mpack_reader_destroy(&reader) != mpack_ok)
+    {
+        fprintf(stderr, "decode_tables_query: An error occurred decoding the message\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+RawBytes* encode_tables_page_response(const TableSummary* tables, int num_tables, const TablesQuery* next)
+{
+    mpack_writer_t writer;
+    char buffer[MAXLINE];
+    mpack_writer_init(&writer, buffer, MAXLINE);
+    mpack_start_map(&writer, 3);
+    mpack_write_cstr(&writer, "size");
+    mpack_write_i32(&writer, num_tables);
+
+    mpack_write_cstr(&writer, "tables");
+    mpack_start_array(&writer, num_tables);
+    for (int i = 0; i < num_tables; i++)
+    {
+        write_table_summary(&writer, &tables[i]);
+    }
+    mpack_finish_array(&writer);
+
+    mpack_write_cstr(&writer, "cursor");
+    if (next == NULL)
+    {
+        mpack_write_nil(&writer);
+    }
+    else
+    {
+        mpack_start_map(&writer, 2);
+        mpack_write_cstr(&writer, "key");
+        if (next->sort == TABLES_SORT_NAME)
+        {
+            mpack_write_cstr(&writer, next->cursor_name);
+        }
+        else
+        {
+            mpack_write_i32(&writer, next->cursor_key);
+        }
+        mpack_write_cstr(&writer, "id");
+        mpack_write_i32(&writer, next->cursor_id);
+        mpack_finish_map(&writer);
+    }
+    mpack_finish_map(&writer);
+
+    if (mpack_writer_destroy(&writer) != mpack_ok)
+    {
+        fprintf(stderr, "encode_tables_page_response: An error occurred encoding the message\n");
+        return NULL;
+    }
+
+    RawBytes* raw_bytes = malloc(sizeof(RawBytes));
+    raw_bytes->len = mpack_writer_buffer_used(&writer);
+    raw_bytes->data = malloc(raw_bytes->len);
+    memcpy(raw_bytes->data, buffer, raw_bytes->len);
+
+    return raw_bytes;
+}
+
+int decode_lobby_subscribe_request(char* payload, size_t payload_len)
+{
+    if (payload == NULL || payload_len == 0)
+    {
+        return 1;
+    }
+
+    mpack_reader_t reader;
+    mpack_reader_init(&reader, payload, payload_len, payload_len);
+
+    mpack_expect_map_max(&reader, 1);
+    mpack_expect_cstr_match(&reader, "subscribe");
+    bool subscribe = mpack_expect_bool(&reader);
+    mpack_done_map(&reader);
+
+    if (mpack_reader_destroy(&reader) != mpack_ok)
+    {
+        fprintf(stderr, "decode_lobby_subscribe_request: An error occurred decoding the message %s\n",
+                mpack_error_to_string(mpack_reader_destroy(&reader)));
+        return -1;
+    }
+
+    return subscribe ? 1 : 0;
+}
+
+RawBytes* encode_update_tables_response(uint64_t version, const int* removed, int num_removed,
+                                        const TableSummary* added, int num_added, const TableSummary* updated,
+                                        int num_updated)
+{
+    mpack_writer_t writer;
+    char buffer[MAXLINE];
+    mpack_writer_init(&writer, buffer, MAXLINE);
+    mpack_start_map(&writer, 4);
+    mpack_write_cstr(&writer, "version");
+    mpack_write_u64(&writer, version);
+
+    mpack_write_cstr(&writer, "removed");
+    mpack_start_array(&writer, num_removed);
+    for (int i = 0; i < num_removed; i++)
+    {
+        mpack_write_i32(&writer, removed[i]);
+    }
+    mpack_finish_array(&writer);
+
+    mpack_write_cstr(&writer, "added");
+    mpack_start_array(&writer, num_added);
+    for (int i = 0; i < num_added; i++)
+    {
+        write_table_summary(&writer, &added[i]);
+    }
+    mpack_finish_array(&writer);
+
+    mpack_write_cstr(&writer, "updated");
+    mpack_start_array(&writer, num_updated);
+    for (int i = 0; i < num_updated; i++)
+    {
+        mpack_start_map(&writer, 2);
+        mpack_write_cstr(&writer, "id");
+        mpack_write_i32(&writer, updated[i].id);
+        mpack_write_cstr(&writer, "currentPlayer");
+        mpack_write_i32(&writer, updated[i].current_player);
+        mpack_finish_map(&writer);
+    }
+    mpack_finish_array(&writer);
+    mpack_finish_map(&writer);
+
+    // Too many changes for one packet is reported as an error; callers split deltas to stay well under it
+    if (mpack_writer_destroy(&writer) != mpack_ok)
+    {
+        fprintf(stderr, "encode_update_tables_response: An error occurred encoding the message\n");
+        return NULL;
+    }
+
+    RawBytes* raw_bytes = malloc(sizeof(RawBytes));
+    raw_bytes->len = mpack_writer_buffer_used(&writer);
+    raw_bytes->data = malloc(raw_bytes->len);
+    memcpy(raw_bytes->data, buffer, raw_bytes->len);
+
+    return raw_bytes;
+}
+
+static const char* presence_status_name(int status)
+{
+    switch (status)
+    {
+    case PRESENCE_ONLINE:
+        return "online";
+    case PRESENCE_LOBBY:
+        return "lobby";
+    case PRESENCE_TABLE:
+        return "table";
+    default:
+        return "offline";
+    }
+}
+
+RawBytes* encode_presence_update(const PresenceChange* changes, int num_changes)
+{
+    mpack_writer_t writer;
+    char buffer[MAXLINE];
+    mpack_writer_init(&writer, buffer, MAXLINE);
+    mpack_start_map(&writer, 1);
+    mpack_write_cstr(&writer, "friends");
+    mpack_start_array(&writer, num_changes);
+    for (int i = 0; i < num_changes; i++)
+    {
+        mpack_start_map(&writer, 4);
+        mpack_write_cstr(&writer, "id");
+        mpack_write_i32(&writer, changes[i].user_id);
+        mpack_write_cstr(&writer, "username");
+        mpack_write_cstr(&writer, changes[i].username);
+        mpack_write_cstr(&writer, "status");
+        mpack_write_cstr(&writer, presence_status_name(changes[i].status));
+        mpack_write_cstr(&writer, "tableId");
+        mpack_write_i32(&writer, changes[i].table_id);
+        mpack_finish_map(&writer);
+    }
+    mpack_finish_array(&writer);
+    mpack_finish_map(&writer);
+
+    if (mpack_writer_destroy(&writer) != mpack_ok)
+    {
+        fprintf(stderr, "encode_presence_update: An error occurred encoding the message\n");
+        return NULL;
+    }
+
+    RawBytes* raw_bytes = malloc(sizeof(RawBytes));
+    raw_bytes->len = mpack_writer_buffer_used(&writer);
+    raw_bytes->data = malloc(raw_bytes->len);
+    memcpy(raw_bytes->data, buffer, raw_bytes->len);
+
+    return raw_bytes;
+}
+
 int decode_join_table_request(char* payload)
 {
     mpack_reader_t reader;
@@ -476,12 +790,12 @@ int decode_join_table_request(char* payload)
     return table_id;
 }
 
-RawBytes* encode_login_success_response(dbUser* user)
+RawBytes* encode_login_success_response(dbUser* user, const char* session_token)
 {
     mpack_writer_t writer;
     char buffer[MAXLINE];
     mpack_writer_init(&writer, buffer, MAXLINE);
-    mpack_start_map(&writer, 6);
+    mpack_start_map(&writer, session_token ? 7 : 6);
     mpack_write_cstr(&writer, "result");
     mpack_write_u16(&writer, 0);
     mpack_write_cstr(&writer, "user_id");
@@ -494,6 +808,11 @@ RawBytes* encode_login_success_response(dbUser* user)
     mpack_write_cstr(&writer, user->fullname);
     mpack_write_cstr(&writer, "email");
     mpack_write_cstr(&writer, user->email);
+    if (session_token)
+    {
+        mpack_write_cstr(&writer, "session_token");
+        mpack_write_cstr(&writer, session_token);
+    }
     mpack_finish_map(&writer);
 
     if (mpack_writer_destroy(&writer) != mpack_ok)
@@ -510,6 +829,79 @@ RawBytes* encode_login_success_response(dbUser* user)
 
     return raw_bytes;
 }
+int decode_resume_request(char* payload, size_t payload_len, ResumeRequest* request)
+{
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, payload, payload_len);
+
+    memset(request, 0, sizeof(ResumeRequest));
+    uint32_t count = mpack_expect_map_max(&reader, 3);
+    for (uint32_t i = 0; i < count && mpack_reader_error(&reader) == mpack_ok; i++)
+    {
+        char key[16];
+        mpack_expect_cstr(&reader, key, sizeof(key));
+        if (strcmp(key, "token") == 0)
+        {
+            mpack_expect_cstr(&reader, request->token, sizeof(request->token));
+        }
+        else if (strcmp(key, "handId") == 0)
+        {
+            request->hand_id = mpack_expect_u32(&reader);
+        }
+        else if (strcmp(key, "seq") == 0)
+        {
+            request->seq = mpack_expect_u32(&reader);
+        }
+        else
+        {
+            mpack_discard(&reader);
+        }
+    }
+    mpack_done_map(&reader);
+
+    if (mpack_reader_destroy(&reader) != mpack_ok || strlen(request->token) != SESSION_TOKEN_LEN)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+RawBytes* encode_resume_success_response(const conn_data_t* conn_data, const char* session_token)
+{
+    mpack_writer_t writer;
+    char buffer[512];
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    mpack_start_map(&writer, 7);
+    mpack_write_cstr(&writer, "result");
+    mpack_write_u16(&writer, 0);
+    mpack_write_cstr(&writer, "user_id");
+    mpack_write_i32(&writer, conn_data->user_id);
+    mpack_write_cstr(&writer, "username");
+    mpack_write_cstr(&writer, conn_data->username);
+    mpack_write_cstr(&writer, "balance");
+    mpack_write_i32(&writer, conn_data->balance);
+    mpack_write_cstr(&writer, "table_id");
+    mpack_write_i32(&writer, conn_data->table_id);
+    mpack_write_cstr(&writer, "seat");
+    mpack_write_i32(&writer, conn_data->seat);
+    mpack_write_cstr(&writer, "session_token");
+    mpack_write_cstr(&writer, session_token);
+    mpack_finish_map(&writer);
+
+    if (mpack_writer_destroy(&writer) != mpack_ok)
+    {
+        fprintf(stderr, "encode_resume_success_response: An error occurred encoding the message\n");
+        return NULL;
+    }
+
+    RawBytes* raw_bytes = malloc(sizeof(RawBytes));
+    raw_bytes->len = mpack_writer_buffer_used(&writer);
+    raw_bytes->data = malloc(raw_bytes->len);
+    memcpy(raw_bytes->data, buffer, raw_bytes->len);
+
+    return raw_bytes;
+}
+
 // ===== Friend Management Protocol Functions =====
 
 AddFriendRequest* decode_add_friend_request(char* payload)
@@ -720,4 +1112,41 @@ TableInviteRequest* decode_table_invite_request(char* payload)
     request->table_id = table_id;
     
     return request;
-}
\ No newline at end of file
+}
+/**
+ * Decode spectate request
+ * Client sends: { "tableId": int, "watch": bool (optional, default true) }
+ */
+int decode_spectate_request(char* payload, size_t payload_len, int* table_id, bool* watch)
+{
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, payload, payload_len);
+
+    *table_id = 0;
+    *watch = true;
+    uint32_t count = mpack_expect_map_max(&reader, 2);
+    for (uint32_t i = 0; i < count && mpack_reader_error(&reader) == mpack_ok; i++)
+    {
+        char key[16];
+        mpack_expect_cstr(&reader, key, sizeof(key));
+        if (strcmp(key, "tableId") == 0)
+        {
+            *table_id = mpack_expect_int(&reader);
+        }
+        else if (strcmp(key, "watch") == 0)
+        {
+            *watch = mpack_expect_bool(&reader);
+        }
+        else
+        {
+            mpack_discard(&reader);
+        }
+    }
+    mpack_done_map(&reader);
+
+    if (mpack_reader_destroy(&reader) != mpack_ok)
+    {
+        return -1;
+    }
+    return 0;
+}
@@ -152,6 +152,13 @@ static int encode_card(Card* card)
 
 // Encode full game state
 RawBytes* encode_game_state(GameState* state, int viewer_player_id)
+{
+    return encode_game_state_with_actions(state, viewer_player_id, NULL, 0);
+}
+
+// Encode full game state, optionally followed by the actions that produced it
+RawBytes* encode_game_state_with_actions(GameState* state, int viewer_player_id, const ActionRecord* actions,
+                                         int num_actions)
 {
     if (!state) {
         return NULL;
@@ -165,7 +172,7 @@ RawBytes* encode_game_state(GameState* state, int viewer_player_id)
     mpack_writer_t writer;
     mpack_writer_init(&writer, buffer, 16384);
     
-    mpack_start_map(&writer, 21);
+    mpack_start_map(&writer, num_actions > 0 ? 22 : 21);
     
     // Game identification
     mpack_write_cstr(&writer, "game_id");
@@ -400,6 +407,31 @@ RawBytes* encode_game_state(GameState* state, int viewer_player_id)
         mpack_finish_array(&writer);
     }
     
+    // Coalesced automatic actions, oldest first, each with the seq it produced
+    if (num_actions > 0) {
+        const char* action_names[] = {"fold", "check", "call", "bet", "raise", "all_in"};
+        mpack_write_cstr(&writer, "notifications");
+        mpack_start_array(&writer, num_actions);
+        for (int i = 0; i < num_actions; i++) {
+            mpack_start_map(&writer, 6);
+            mpack_write_cstr(&writer, "type");
+            mpack_write_cstr(&writer, "PLAYER_ACTION");
+            mpack_write_cstr(&writer, "seq");
+            mpack_write_u32(&writer, actions[i].seq);
+            mpack_write_cstr(&writer, "seat");
+            mpack_write_int(&writer, actions[i].seat);
+            mpack_write_cstr(&writer, "player_id");
+            mpack_write_int(&writer, actions[i].player_id);
+            mpack_write_cstr(&writer, "action");
+            mpack_write_cstr(&writer, (actions[i].type >= 0 && actions[i].type < 6) ? action_names[actions[i].type]
+                                                                                      : "unknown");
+            mpack_write_cstr(&writer, "amount");
+            mpack_write_int(&writer, actions[i].amount);
+            mpack_finish_map(&writer);
+        }
+        mpack_finish_array(&writer);
+    }
+    
     mpack_finish_map(&writer);
     
     size_t size = mpack_writer_buffer_used(&writer);
@@ -0,0 +1,152 @@
+#include "replay_log.h"
+#include "main.h"
+#include <time.h>
+
+static char log_path[256];
+static bool enabled = false;
+static int log_fd = -1;
+static int log_day = -1; // Days since the epoch (UTC) of the file log_fd appends to
+static bool failing = false;
+
+static unsigned char* pending = NULL; // Hands finished this loop iteration
+static size_t pending_len = 0;
+static size_t pending_cap = 0;
+static long pending_hands = 0;
+
+static int today(void)
+{
+    return (int) (time(NULL) / 86400);
+}
+
+// Append to the file of the given day, closing the previous day's
+static int open_day(int day)
+{
+    if (log_fd != -1)
+    {
+        close(log_fd);
+        log_fd = -1;
+    }
+    time_t seconds = (time_t) day * 86400;
+    struct tm tm;
+    gmtime_r(&seconds, &tm);
+    char path[300];
+    size_t len = (size_t) snprintf(path, sizeof(path), "%s.", log_path);
+    strftime(path + len, sizeof(path) - len, "%Y-%m-%d", &tm);
+
+    log_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd == -1)
+    {
+        char log_msg[400];
+        snprintf(log_msg, sizeof(log_msg), "Cannot open replay log %s: %s", path, strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        return -1;
+    }
+    log_day = day;
+    return 0;
+}
+
+int replay_log_open(const char* path)
+{
+    if (path == NULL || path[0] == '\0' || strlen(path) >= sizeof(log_path))
+    {
+        return -1;
+    }
+    snprintf(log_path, sizeof(log_path), "%s", path);
+    if (open_day(today()) == -1)
+    {
+        return -1;
+    }
+    enabled = true;
+    return 0;
+}
+
+void replay_log_close(void)
+{
+    replay_log_flush();
+    if (log_fd != -1)
+    {
+        close(log_fd);
+        log_fd = -1;
+    }
+    enabled = false;
+    free(pending);
+    pending = NULL;
+    pending_cap = 0;
+}
+
+bool replay_log_enabled(void)
+{
+    return enabled;
+}
+
+void replay_log_table(Table* table)
+{
+    if (enabled && table->game_state != NULL && game_record_hands(table->game_state) == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot allocate a hand log, the table's hands are not logged", 1);
+    }
+}
+
+void replay_log_hand_end(Table* table)
+{
+    const HandLog* log = table->game_state->hand_log;
+    if (!enabled || log == NULL || !log->finished)
+    {
+        return;
+    }
+
+    if (pending_len + HAND_LOG_MAX_RECORD > pending_cap)
+    {
+        size_t new_cap = pending_cap ? pending_cap * 2 : 64 * 1024;
+        unsigned char* grown = realloc(pending, new_cap);
+        if (grown == NULL)
+        {
+            metrics_add(METRIC_REPLAY_HANDS_DROPPED, 1);
+            return;
+        }
+        pending = grown;
+        pending_cap = new_cap;
+    }
+    pending_len += hand_log_encode(log, pending + pending_len);
+    pending_hands++;
+}
+
+void replay_log_flush(void)
+{
+    if (pending_len == 0)
+    {
+        return;
+    }
+
+    int day = today();
+    bool ready = log_fd != -1 && day == log_day;
+    if (!ready)
+    {
+        ready = open_day(day) == 0;
+    }
+
+    // One append per iteration: records from this process never interleave with another's
+    size_t written = 0;
+    while (ready && written < pending_len)
+    {
+        ssize_t n = write(log_fd, pending + written, pending_len - written);
+        if (n == -1 && errno != EINTR)
+        {
+            break;
+        }
+        written += n > 0 ? (size_t) n : 0;
+    }
+    if (written < pending_len)
+    {
+        metrics_add(METRIC_REPLAY_HANDS_DROPPED, (uint64_t) pending_hands);
+        if (!failing)
+        {
+            char log_msg[256];
+            snprintf(log_msg, sizeof(log_msg), "Cannot write the replay log: %s", strerror(errno));
+            logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        }
+    }
+    failing = written < pending_len;
+    pending_len = 0;
+    pending_hands = 0;
+}
@@ -1,4 +1,5 @@
 #include "main.h"
+#include <netinet/tcp.h>
 
 // Global connection map: simple linked list to store all active connections
 // This allows us to find users even when they're not in a table
@@ -128,6 +129,28 @@ int accept_connection(int listenfd)
 
 int sendall(int socketfd, char* buf, int* len)
 {
+    // A parked session has no socket until it is resumed
+    if (socketfd < 0)
+    {
+        return -1;
+    }
+
+    // Under io_uring the bytes are queued and go out with the next loop tick
+    if (uring_enabled() && uring_send(socketfd, buf, *len) == 0)
+    {
+        metrics_add(METRIC_BYTES_OUT, (uint64_t)*len);
+        metrics_add(METRIC_PACKETS_OUT, 1);
+        return 0;
+    }
+
+    // The epoll loop batches per connection and writes at the end of the iteration
+    if (outbox_queue(socketfd, buf, *len) == 0)
+    {
+        metrics_add(METRIC_BYTES_OUT, (uint64_t)*len);
+        metrics_add(METRIC_PACKETS_OUT, 1);
+        return 0;
+    }
+
     int total = 0;        // how many bytes we've sent
     int bytesleft = *len; // how many we have left to send
     int n;
@@ -136,6 +159,7 @@ int sendall(int socketfd, char* buf, int* len)
     while (total < *len)
     {
         n = send(socketfd, buf + total, bytesleft, 0);
+        metrics_add(METRIC_SOCKET_WRITES, 1);
         if (n == -1)
         {
             char log_msg[256];
@@ -148,6 +172,8 @@ int sendall(int socketfd, char* buf, int* len)
     }
 
     *len = total; // return number actually sent here
+    metrics_add(METRIC_BYTES_OUT, (uint64_t)total);
+    metrics_add(METRIC_PACKETS_OUT, 1);
 
     if (n != -1) {
         char log_msg[256];
@@ -179,8 +205,14 @@ conn_data_t* init_connection_data(int client_fd)
     conn_data->seat = -1;  // Not seated
     conn_data->buffer_len = 0;
     conn_data->is_active = false;
+    conn_data->social_ref = false;
+    conn_data->session = NULL;
     conn_data->next = NULL;  // Initialize linked list pointer
 
+    // Output is already batched per loop iteration; Nagle would only hold the batch back
+    int nodelay = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
     char log_msg[256];
     snprintf(log_msg, sizeof(log_msg), "Initialized connection data for fd=%d", client_fd);
     logger_ex(MAIN_LOG, "DEBUG", __func__, log_msg, 0);
@@ -188,7 +220,7 @@ conn_data_t* init_connection_data(int client_fd)
     return conn_data;
 }
 
-int add_connection_to_epoll(int epoll_fd, int client_fd)
+conn_data_t* add_connection_to_epoll(int epoll_fd, int client_fd)
 {
     conn_data_t* conn_data = init_connection_data(client_fd);
 
@@ -196,12 +228,12 @@ int add_connection_to_epoll(int epoll_fd, int client_fd)
     {
         logger_ex(MAIN_LOG, "ERROR", __func__, "Failed to initialize connection data", 1);
         fprintf(stderr, "add_connection_to_epoll: Cannot initialize connection data\n");
-        return -1;
+        return NULL;
     }
 
     // Set up epoll_event
     struct epoll_event event;
-    event.events = EPOLLIN | EPOLLET; // Edge-triggered input events
+    event.events = EPOLLIN | EPOLLOUT | EPOLLET; // Edge-triggered; EPOLLOUT only fires after a full socket buffer
     event.data.ptr = conn_data;       // Associate custom data
 
     if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_fd, &event) == -1)
@@ -212,21 +244,22 @@ int add_connection_to_epoll(int epoll_fd, int client_fd)
         fprintf(stderr, "add_connection_to_epoll: Cannot add client to epoll\n");
         free(conn_data);
         close(client_fd);
-        return -1;
+        return NULL;
     }
 
     char log_msg[256];
     snprintf(log_msg, sizeof(log_msg), "Added client fd=%d to epoll", client_fd);
     logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    metrics_add(METRIC_CONNECTIONS_OPENED, 1);
     fprintf(stdout, "Added client %d to epoll\n", client_fd);
 
-    return 0;
+    return conn_data;
 }
 
 int update_conn_data(int epoll_fd, int client_fd, conn_data_t* conn_data)
 {
     struct epoll_event event;
-    event.events = EPOLLIN | EPOLLET;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLET;
     event.data.ptr = conn_data;
 
     if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client_fd, &event) == -1)
@@ -238,6 +271,35 @@ int update_conn_data(int epoll_fd, int client_fd, conn_data_t* conn_data)
     return 0;
 }
 
+// Stop serving conn_data's socket and close it. The connection itself is left alone.
+static int release_socket(int epoll_fd, conn_data_t* conn_data)
+{
+    int result = 0;
+    lobby_unsubscribe(conn_data->fd);
+    spectator_remove(conn_data->fd);
+    outbox_close(conn_data->fd);
+    if (uring_enabled())
+    {
+        uring_forget(conn_data->fd);
+    }
+    else if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn_data->fd, NULL) == -1)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Failed to remove client fd=%d from epoll", conn_data->fd);
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        fprintf(stderr, "close_connection: Cannot remove client from epoll\n");
+        result = -1;
+    }
+
+    fprintf(stdout, "Closed connection from client %d\n", conn_data->fd);
+    metrics_add(METRIC_CONNECTIONS_CLOSED, 1);
+
+    // Closing the descriptor also drops it from epoll, so a failed EPOLL_CTL_DEL leaves nothing behind
+    close(conn_data->fd);
+    conn_data->fd = -1;
+    return result;
+}
+
 int close_connection(int epoll_fd, conn_data_t* conn_data)
 {
     char log_msg[256];
@@ -247,23 +309,85 @@ int close_connection(int epoll_fd, conn_data_t* conn_data)
     
     // Unregister from global connection map
     unregister_connection(conn_data);
+    session_end(conn_data);
+    if (conn_data->social_ref)
+    {
+        social_cache_release(conn_data->user_id);
+    }
     
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn_data->fd, NULL) == -1)
+    // A parked session's socket is already closed
+    int result = conn_data->fd >= 0 ? release_socket(epoll_fd, conn_data) : 0;
+    free(conn_data);
+    return result;
+}
+
+void drop_connection(int epoll_fd, conn_data_t* conn_data, TableList* table_list)
+{
+    // The seat, presence and friends stay in place for SESSION_GRACE_MS; session_expire closes it after that
+    if (conn_data->user_id != 0 && session_park(conn_data) == 0)
     {
-        snprintf(log_msg, sizeof(log_msg), "Failed to remove client fd=%d from epoll", conn_data->fd);
-        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
-        fprintf(stderr, "close_connection: Cannot remove client from epoll\n");
-        return -1;
+        release_socket(epoll_fd, conn_data);
+        return;
     }
 
-    fprintf(stdout, "Closed connection from client %d\n", conn_data->fd);
+    if (conn_data->table_id > 0)
+    {
+        leave_table(conn_data, table_list);
+    }
+    close_connection(epoll_fd, conn_data);
+}
 
-    // Close file descriptor before freeing conn_data to avoid use-after-free
-    close(conn_data->fd);
+int resume_connection(int epoll_fd, conn_data_t* conn_data, conn_data_t* session_conn)
+{
+    // Events for the new socket carry the resumed connection from now on
+    int client_fd = conn_data->fd;
+    if ((uring_enabled() ? uring_rebind(client_fd, session_conn) : update_conn_data(epoll_fd, client_fd, session_conn)) == -1)
+    {
+        return -1;
+    }
+
+    if (session_conn->fd >= 0)
+    {
+        release_socket(epoll_fd, session_conn);
+    }
+    session_conn->fd = client_fd;
+    session_unpark(session_conn);
     free(conn_data);
     return 0;
 }
 
+conn_data_t* restore_connection(Table* table, int seat)
+{
+    GamePlayer* player = &table->game_state->players[seat];
+    conn_data_t* conn_data = init_connection_data(-1);
+    if (conn_data == NULL || table->current_player >= MAX_PLAYERS)
+    {
+        free(conn_data);
+        return NULL;
+    }
+
+    strncpy(conn_data->username, player->name, sizeof(conn_data->username));
+    conn_data->username[sizeof(conn_data->username) - 1] = '\0';
+    conn_data->user_id = (unsigned int) player->player_id;
+    conn_data->is_active = true;
+    conn_data->table_id = (unsigned short) table->id;
+    conn_data->seat = seat;
+    conn_data->social_ref = false; // Friends are loaded when the player comes back for the seat
+    table->connections[table->current_player] = conn_data;
+    table->seat_to_conn_idx[seat] = table->current_player;
+    table->current_player++;
+    register_connection(conn_data);
+
+    // Nobody holds a token for it: the player gets it back by logging in
+    char session_token[SESSION_TOKEN_LEN + 1];
+    if (session_issue(conn_data, session_token) == -1 || session_park(conn_data) == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot park restored connection", 1);
+    }
+    lobby_table_seats_changed(table);
+    return conn_data;
+}
+
 // Find connection by username in global connection map
 conn_data_t* find_connection_by_username(const char* username, int epoll_fd)
 {
@@ -271,20 +395,20 @@ conn_data_t* find_connection_by_username(const char* username, int epoll_fd)
         return NULL;
     }
     
-    conn_data_t* current = global_connections_head;
-    while (current != NULL) {
-        if (current->username[0] != '\0' && strcmp(current->username, username) == 0) {
-            // Verify connection is still valid
-            if (current->fd > 0) {
-                return current;
-            }
-        }
-        current = current->next;
+    // Presence indexes every registered connection by username
+    conn_data_t* conn_data = presence_find_by_username(username);
+    if (conn_data != NULL && conn_data->fd > 0) {
+        return conn_data;
     }
     
     return NULL;
 }
 
+conn_data_t* registered_connections(void)
+{
+    return global_connections_head;
+}
+
 // Register connection in global map (called after login)
 void register_connection(conn_data_t* conn_data)
 {
@@ -302,6 +426,7 @@ void register_connection(conn_data_t* conn_data)
     // Add to head of list
     conn_data->next = global_connections_head;
     global_connections_head = conn_data;
+    presence_connect(conn_data);
 }
 
 // Unregister connection from global map
@@ -309,6 +434,8 @@ void unregister_connection(conn_data_t* conn_data)
 {
     if (!conn_data) return;
     
+    presence_disconnect(conn_data);
+    
     if (global_connections_head == conn_data) {
         global_connections_head = conn_data->next;
         conn_data->next = NULL;
@@ -0,0 +1,419 @@
+#include "main.h"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <sys/random.h>
+#include <sys/timerfd.h>
+#include <time.h>
+
+#define SESSION_PAYLOAD_LEN 16 // user id (4), session id (8), expiry in Unix seconds (4), big-endian
+#define SESSION_MAC_LEN 32
+
+struct Session
+{
+    uint64_t id;
+    conn_data_t* conn;
+    uint64_t parked_until_ms; // 0 while the connection has a socket
+    int parked_index;         // Position in parked, -1 if not parked
+    Session* next;            // Bucket chain
+};
+
+static unsigned char key[SESSION_KEY_LEN];
+static Session* buckets[SESSION_BUCKETS];
+
+static Session** parked = NULL;
+static int num_parked = 0;
+static int parked_capacity = 0;
+
+static int timer_fd = -1;
+static bool timer_armed = false;
+
+static int random_bytes(void* buf, size_t len)
+{
+    size_t filled = 0;
+    while (filled < len)
+    {
+        ssize_t n = getrandom((char*) buf + filled, len - filled, 0);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        filled += (size_t) n;
+    }
+    return 0;
+}
+
+int session_init(void)
+{
+    if (random_bytes(key, sizeof(key)) == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot draw session signing key", 1);
+        return -1;
+    }
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot create session expiry timer", 1);
+    }
+    return timer_fd;
+}
+
+// Sweep every SESSION_SWEEP_MS while anything is parked, and not at all otherwise
+static void set_timer(bool armed)
+{
+    if (timer_fd == -1 || timer_armed == armed)
+    {
+        return;
+    }
+
+    struct itimerspec spec = {0};
+    if (armed)
+    {
+        spec.it_value.tv_sec = SESSION_SWEEP_MS / 1000;
+        spec.it_value.tv_nsec = (long) (SESSION_SWEEP_MS % 1000) * 1000000L;
+        spec.it_interval = spec.it_value;
+    }
+    if (timerfd_settime(timer_fd, 0, &spec, NULL) == 0)
+    {
+        timer_armed = armed;
+    }
+}
+
+static Session** bucket_of(uint64_t id)
+{
+    return &buckets[(id ^ (id >> 32)) % SESSION_BUCKETS];
+}
+
+static void unlink_session(Session* session)
+{
+    for (Session** link = bucket_of(session->id); *link != NULL; link = &(*link)->next)
+    {
+        if (*link == session)
+        {
+            *link = session->next;
+            session->next = NULL;
+            return;
+        }
+    }
+}
+
+static Session* find_session(uint64_t id)
+{
+    for (Session* session = *bucket_of(id); session != NULL; session = session->next)
+    {
+        if (session->id == id)
+        {
+            return session;
+        }
+    }
+    return NULL;
+}
+
+static void put_u32(unsigned char* out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = (unsigned char) (value >> (24 - 8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char* in)
+{
+    return (uint32_t) in[0] << 24 | (uint32_t) in[1] << 16 | (uint32_t) in[2] << 8 | (uint32_t) in[3];
+}
+
+static void sign(const unsigned char* payload, unsigned char* mac)
+{
+    unsigned int mac_len = SESSION_MAC_LEN;
+    HMAC(EVP_sha256(), key, sizeof(key), payload, SESSION_PAYLOAD_LEN, mac, &mac_len);
+}
+
+static void to_hex(const unsigned char* in, size_t len, char* out)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++)
+    {
+        out[2 * i] = digits[in[i] >> 4];
+        out[2 * i + 1] = digits[in[i] & 0xf];
+    }
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static int from_hex(const char* in, size_t len, unsigned char* out)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        int high = hex_value(in[2 * i]);
+        int low = hex_value(in[2 * i + 1]);
+        if (high == -1 || low == -1)
+        {
+            return -1;
+        }
+        out[i] = (unsigned char) (high << 4 | low);
+    }
+    return 0;
+}
+
+// conn's session, created if it has none, out of its bucket so the caller can give it an id
+static Session* detach_session(conn_data_t* conn)
+{
+    Session* session = conn->session;
+    if (session == NULL)
+    {
+        session = calloc(1, sizeof(Session));
+        if (session == NULL)
+        {
+            return NULL;
+        }
+        session->conn = conn;
+        session->parked_index = -1;
+        conn->session = session;
+    }
+    else
+    {
+        unlink_session(session);
+    }
+    return session;
+}
+
+static void link_session(Session* session)
+{
+    Session** bucket = bucket_of(session->id);
+    session->next = *bucket;
+    *bucket = session;
+}
+
+int session_issue(conn_data_t* conn, char* token)
+{
+    Session* session = detach_session(conn);
+    if (session == NULL)
+    {
+        return -1;
+    }
+
+    // A fresh id retires every token issued before; zero is never used so a zeroed token never matches
+    do
+    {
+        if (random_bytes(&session->id, sizeof(session->id)) == -1)
+        {
+            session->id = 0;
+        }
+    } while (session->id == 0 || find_session(session->id) != NULL);
+    link_session(session);
+
+    unsigned char signed_token[SESSION_PAYLOAD_LEN + SESSION_MAC_LEN];
+    put_u32(signed_token, conn->user_id);
+    put_u32(signed_token + 4, (uint32_t) (session->id >> 32));
+    put_u32(signed_token + 8, (uint32_t) session->id);
+    put_u32(signed_token + 12, (uint32_t) time(NULL) + SESSION_TOKEN_TTL_S);
+    sign(signed_token, signed_token + SESSION_PAYLOAD_LEN);
+
+    to_hex(signed_token, sizeof(signed_token), token);
+    token[SESSION_TOKEN_LEN] = '\0';
+    return 0;
+}
+
+void session_export_key(unsigned char* key_out)
+{
+    memcpy(key_out, key, sizeof(key));
+}
+
+void session_import_key(const unsigned char* key_in)
+{
+    memcpy(key, key_in, sizeof(key));
+}
+
+uint64_t session_id_of(const conn_data_t* conn)
+{
+    return conn->session != NULL ? conn->session->id : 0;
+}
+
+int session_restore(conn_data_t* conn, uint64_t id)
+{
+    Session* owner = id != 0 ? find_session(id) : NULL;
+    if (id == 0 || (owner != NULL && owner->conn != conn))
+    {
+        return -1;
+    }
+
+    Session* session = detach_session(conn);
+    if (session == NULL)
+    {
+        return -1;
+    }
+    session->id = id;
+    link_session(session);
+    return 0;
+}
+
+conn_data_t* session_find(const char* token)
+{
+    unsigned char signed_token[SESSION_PAYLOAD_LEN + SESSION_MAC_LEN];
+    if (token == NULL || strlen(token) != SESSION_TOKEN_LEN || from_hex(token, sizeof(signed_token), signed_token) == -1)
+    {
+        return NULL;
+    }
+
+    unsigned char mac[SESSION_MAC_LEN];
+    sign(signed_token, mac);
+    if (CRYPTO_memcmp(mac, signed_token + SESSION_PAYLOAD_LEN, SESSION_MAC_LEN) != 0)
+    {
+        return NULL;
+    }
+    if (get_u32(signed_token + 12) < (uint32_t) time(NULL))
+    {
+        return NULL;
+    }
+
+    uint64_t id = (uint64_t) get_u32(signed_token + 4) << 32 | get_u32(signed_token + 8);
+    Session* session = find_session(id);
+    if (session == NULL || session->conn->user_id != get_u32(signed_token))
+    {
+        return NULL;
+    }
+    return session->conn;
+}
+
+void session_unpark(conn_data_t* conn)
+{
+    Session* session = conn->session;
+    if (session == NULL || session->parked_index == -1)
+    {
+        return;
+    }
+
+    Session* last = parked[--num_parked];
+    parked[session->parked_index] = last;
+    last->parked_index = session->parked_index;
+    session->parked_index = -1;
+    session->parked_until_ms = 0;
+    if (num_parked == 0)
+    {
+        set_timer(false);
+    }
+}
+
+void session_end(conn_data_t* conn)
+{
+    Session* session = conn->session;
+    if (session == NULL)
+    {
+        return;
+    }
+
+    session_unpark(conn);
+    unlink_session(session);
+    free(session);
+    conn->session = NULL;
+}
+
+int session_park(conn_data_t* conn)
+{
+    Session* session = conn->session;
+    if (session == NULL)
+    {
+        return -1;
+    }
+    if (session->parked_index != -1)
+    {
+        return 0;
+    }
+
+    if (num_parked == parked_capacity)
+    {
+        int new_capacity = parked_capacity ? parked_capacity * 2 : 16;
+        Session** grown = realloc(parked, (size_t) new_capacity * sizeof(Session*));
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        parked = grown;
+        parked_capacity = new_capacity;
+    }
+
+    session->parked_until_ms = game_now_ms() + SESSION_GRACE_MS;
+    session->parked_index = num_parked;
+    parked[num_parked++] = session;
+    set_timer(true);
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "Parked session of user='%s' (id=%u) table=%d for %d ms", conn->username,
+             conn->user_id, conn->table_id, SESSION_GRACE_MS);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    return 0;
+}
+
+bool session_parked(const conn_data_t* conn)
+{
+    return conn->session != NULL && conn->session->parked_index != -1;
+}
+
+conn_data_t* session_find_parked(unsigned int user_id)
+{
+    for (int i = 0; i < num_parked; i++)
+    {
+        if (parked[i]->conn->user_id == user_id)
+        {
+            return parked[i]->conn;
+        }
+    }
+    return NULL;
+}
+
+int session_parked_count(void)
+{
+    return num_parked;
+}
+
+void session_expire(TableList* table_list)
+{
+    if (timer_fd != -1)
+    {
+        uint64_t expirations;
+        while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+        {
+        }
+    }
+    session_expire_at(table_list, game_now_ms());
+}
+
+void session_expire_at(TableList* table_list, uint64_t now_ms)
+{
+    // Backwards, since closing a session moves the last parked one into its place
+    for (int i = num_parked - 1; i >= 0; i--)
+    {
+        if (i >= num_parked || parked[i]->parked_until_ms > now_ms)
+        {
+            continue;
+        }
+
+        conn_data_t* conn = parked[i]->conn;
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Session of user='%s' (id=%u) was not resumed, closing it", conn->username,
+                 conn->user_id);
+        logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+
+        if (conn->table_id > 0)
+        {
+            leave_table(conn, table_list);
+        }
+        close_connection(-1, conn);
+    }
+}
@@ -0,0 +1,353 @@
+#include "social_cache.h"
+#include "main.h"
+
+typedef struct SocialEntry
+{
+    int user_id;
+    int refs; // Logged-in connections of this user
+    dbFriendList friends;
+    int friend_capacity;
+    dbInviteList invites; // Pending invites to this user, newest first like dbGetPendingInvites
+    int invite_capacity;
+    struct SocialEntry* next;
+} SocialEntry;
+
+static SocialEntry* buckets[SOCIAL_CACHE_BUCKETS];
+static int num_entries = 0;
+
+// ===== Entries =====
+
+static SocialEntry** find_slot(int user_id)
+{
+    SocialEntry** slot = &buckets[(unsigned int)user_id % SOCIAL_CACHE_BUCKETS];
+    while (*slot != NULL && (*slot)->user_id != user_id)
+    {
+        slot = &(*slot)->next;
+    }
+    return slot;
+}
+
+static SocialEntry* find_entry(int user_id)
+{
+    return *find_slot(user_id);
+}
+
+static void free_entry(SocialEntry* entry)
+{
+    free(entry->friends.friends);
+    free(entry->invites.invites);
+    free(entry);
+}
+
+// Replace an entry's lists with freshly fetched ones; takes ownership of both
+static void set_lists(SocialEntry* entry, dbFriendList* friends, dbInviteList* invites)
+{
+    free(entry->friends.friends);
+    free(entry->invites.invites);
+    entry->friends = *friends;
+    entry->friend_capacity = friends->num;
+    entry->invites = *invites;
+    entry->invite_capacity = invites->num;
+    free(friends);
+    free(invites);
+}
+
+static int fetch_lists(PGconn* conn, int user_id, dbFriendList** friends, dbInviteList** invites)
+{
+    *friends = METRICS_DB_QUERY(dbGetFriendList(conn, user_id));
+    *invites = *friends ? METRICS_DB_QUERY(dbGetPendingInvites(conn, user_id)) : NULL;
+    if (*friends == NULL || *invites == NULL)
+    {
+        if (*friends != NULL)
+        {
+            free((*friends)->friends);
+            free(*friends);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+int social_cache_adopt(int user_id, dbFriendList* friends, dbInviteList* invites)
+{
+    if (user_id <= 0 || friends == NULL || invites == NULL || find_entry(user_id) != NULL)
+    {
+        return -1;
+    }
+
+    SocialEntry* entry = calloc(1, sizeof(SocialEntry));
+    if (entry == NULL)
+    {
+        return -1;
+    }
+    entry->user_id = user_id;
+    entry->refs = 1;
+    set_lists(entry, friends, invites);
+
+    SocialEntry** slot = &buckets[(unsigned int)user_id % SOCIAL_CACHE_BUCKETS];
+    entry->next = *slot;
+    *slot = entry;
+    num_entries++;
+    return 0;
+}
+
+int social_cache_load(PGconn* conn, int user_id)
+{
+    SocialEntry* entry = find_entry(user_id);
+    if (entry != NULL)
+    {
+        entry->refs++;
+        return 0;
+    }
+
+    dbFriendList* friends;
+    dbInviteList* invites;
+    if (fetch_lists(conn, user_id, &friends, &invites) != 0)
+    {
+        return -1;
+    }
+
+    if (social_cache_adopt(user_id, friends, invites) != 0)
+    {
+        free(friends->friends);
+        free(friends);
+        free(invites->invites);
+        free(invites);
+        return -1;
+    }
+    return 0;
+}
+
+int social_cache_refresh(PGconn* conn, int user_id)
+{
+    SocialEntry* entry = find_entry(user_id);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+
+    dbFriendList* friends;
+    dbInviteList* invites;
+    if (fetch_lists(conn, user_id, &friends, &invites) != 0)
+    {
+        return -1;
+    }
+    set_lists(entry, friends, invites);
+    return 0;
+}
+
+void social_cache_release(int user_id)
+{
+    SocialEntry** slot = find_slot(user_id);
+    SocialEntry* entry = *slot;
+    if (entry == NULL || --entry->refs > 0)
+    {
+        return;
+    }
+
+    *slot = entry->next;
+    free_entry(entry);
+    num_entries--;
+}
+
+bool social_cache_has(int user_id)
+{
+    return find_entry(user_id) != NULL;
+}
+
+int social_cache_size(void)
+{
+    return num_entries;
+}
+
+// ===== Lookups =====
+
+dbFriendList* social_cache_friends(int user_id)
+{
+    SocialEntry* entry = find_entry(user_id);
+    return entry ? &entry->friends : NULL;
+}
+
+dbInviteList* social_cache_invites(int user_id)
+{
+    SocialEntry* entry = find_entry(user_id);
+    return entry ? &entry->invites : NULL;
+}
+
+int social_cache_is_friend(int user_id, int other_id)
+{
+    SocialEntry* entry = find_entry(user_id);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < entry->friends.num; i++)
+    {
+        if (entry->friends.friends[i].user_id == other_id)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int social_cache_friend_id(int user_id, const char* username)
+{
+    SocialEntry* entry = find_entry(user_id);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < entry->friends.num && username != NULL; i++)
+    {
+        if (strcmp(entry->friends.friends[i].user_name, username) == 0)
+        {
+            return entry->friends.friends[i].user_id;
+        }
+    }
+    return 0;
+}
+
+int social_cache_has_invite_from(int to_user_id, int from_user_id)
+{
+    SocialEntry* entry = find_entry(to_user_id);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < entry->invites.num; i++)
+    {
+        if (entry->invites.invites[i].from_user_id == from_user_id)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int social_cache_get_invite(int user_id, int invite_id, dbInvite* out)
+{
+    SocialEntry* entry = find_entry(user_id);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < entry->invites.num; i++)
+    {
+        if (entry->invites.invites[i].invite_id == invite_id)
+        {
+            *out = entry->invites.invites[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// ===== Write-through =====
+
+static void add_friend(SocialEntry* entry, int friend_id, const char* friend_name)
+{
+    for (int i = 0; i < entry->friends.num; i++)
+    {
+        if (entry->friends.friends[i].user_id == friend_id)
+        {
+            return;
+        }
+    }
+
+    if (entry->friends.num == entry->friend_capacity)
+    {
+        int capacity = entry->friend_capacity ? entry->friend_capacity * 2 : 8;
+        dbFriend* grown = realloc(entry->friends.friends, capacity * sizeof(dbFriend));
+        if (grown == NULL)
+        {
+            return;
+        }
+        entry->friends.friends = grown;
+        entry->friend_capacity = capacity;
+    }
+
+    dbFriend* slot = &entry->friends.friends[entry->friends.num++];
+    slot->user_id = friend_id;
+    strncpy(slot->user_name, friend_name, sizeof(slot->user_name) - 1);
+    slot->user_name[sizeof(slot->user_name) - 1] = '\0';
+}
+
+void social_cache_friendship_added(int user_id, const char* username, int friend_id, const char* friend_name)
+{
+    SocialEntry* entry = find_entry(user_id);
+    if (entry != NULL)
+    {
+        add_friend(entry, friend_id, friend_name);
+    }
+
+    entry = find_entry(friend_id);
+    if (entry != NULL)
+    {
+        add_friend(entry, user_id, username);
+    }
+}
+
+void social_cache_invite_sent(const dbInvite* invite)
+{
+    SocialEntry* entry = find_entry(invite->to_user_id);
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    if (entry->invites.num == entry->invite_capacity)
+    {
+        int capacity = entry->invite_capacity ? entry->invite_capacity * 2 : 8;
+        dbInvite* grown = realloc(entry->invites.invites, capacity * sizeof(dbInvite));
+        if (grown == NULL)
+        {
+            return;
+        }
+        entry->invites.invites = grown;
+        entry->invite_capacity = capacity;
+    }
+
+    // Newest first
+    memmove(&entry->invites.invites[1], &entry->invites.invites[0], entry->invites.num * sizeof(dbInvite));
+    entry->invites.invites[0] = *invite;
+    entry->invites.num++;
+}
+
+void social_cache_invite_removed(int to_user_id, int invite_id)
+{
+    SocialEntry* entry = find_entry(to_user_id);
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < entry->invites.num; i++)
+    {
+        if (entry->invites.invites[i].invite_id == invite_id)
+        {
+            memmove(&entry->invites.invites[i], &entry->invites.invites[i + 1],
+                    (entry->invites.num - i - 1) * sizeof(dbInvite));
+            entry->invites.num--;
+            return;
+        }
+    }
+}
+
+void social_cache_free(void)
+{
+    for (int b = 0; b < SOCIAL_CACHE_BUCKETS; b++)
+    {
+        while (buckets[b] != NULL)
+        {
+            SocialEntry* entry = buckets[b];
+            buckets[b] = entry->next;
+            free_entry(entry);
+        }
+    }
+    num_entries = 0;
+}
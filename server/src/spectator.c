@@ -0,0 +1,487 @@
+#include "spectator.h"
+#include "main.h"
+#include <sys/timerfd.h>
+
+// One encoded frame shared by every watcher that still has to write it
+typedef struct
+{
+    char* data;
+    size_t len;
+    int refs;
+} SharedPacket;
+
+typedef struct
+{
+    int fd;
+    SharedPacket* sending; // Frame being written, NULL if idle
+    size_t offset;         // Bytes of sending already written
+    SharedPacket* next;    // Newest frame waiting behind it
+} Watcher;
+
+typedef struct
+{
+    uint64_t due_ms;
+    SharedPacket* packet;
+} DelayedFrame;
+
+typedef struct
+{
+    int table_id;
+    Watcher* watchers;
+    int num_watchers;
+    int capacity;
+    int delay_ms;
+    int min_interval_ms;
+    uint64_t last_encode_ms;
+    bool dirty; // State changed since the last encode
+    DelayedFrame frames[SPECTATE_MAX_DELAYED_FRAMES]; // Ring of encoded frames not yet released
+    int first_frame;
+    int num_frames;
+} Audience;
+
+static Audience* audiences = NULL;
+static int num_audiences = 0;
+static int audiences_capacity = 0;
+static int timer_fd = -1;
+static bool timer_armed = false;
+
+// ===== Shared Packets =====
+
+static void release_packet(SharedPacket* packet)
+{
+    if (packet != NULL && --packet->refs == 0)
+    {
+        free(packet->data);
+        free(packet);
+    }
+}
+
+// ===== Audiences =====
+
+static Audience* find_audience(int table_id)
+{
+    for (int i = 0; i < num_audiences; i++)
+    {
+        if (audiences[i].table_id == table_id)
+        {
+            return &audiences[i];
+        }
+    }
+    return NULL;
+}
+
+static Audience* get_or_create_audience(int table_id)
+{
+    Audience* audience = find_audience(table_id);
+    if (audience != NULL)
+    {
+        return audience;
+    }
+
+    if (num_audiences == audiences_capacity)
+    {
+        int capacity = audiences_capacity > 0 ? audiences_capacity * 2 : 16;
+        Audience* grown = realloc(audiences, capacity * sizeof(Audience));
+        if (grown == NULL)
+        {
+            return NULL;
+        }
+        audiences = grown;
+        audiences_capacity = capacity;
+    }
+
+    audience = &audiences[num_audiences++];
+    memset(audience, 0, sizeof(Audience));
+    audience->table_id = table_id;
+    audience->delay_ms = SPECTATE_DEFAULT_DELAY_MS;
+    audience->min_interval_ms = SPECTATE_DEFAULT_INTERVAL_MS;
+    return audience;
+}
+
+static void clear_watcher(Watcher* watcher)
+{
+    release_packet(watcher->sending);
+    release_packet(watcher->next);
+    watcher->sending = NULL;
+    watcher->next = NULL;
+    watcher->offset = 0;
+}
+
+static void clear_frames(Audience* audience)
+{
+    for (int i = 0; i < audience->num_frames; i++)
+    {
+        release_packet(audience->frames[(audience->first_frame + i) % SPECTATE_MAX_DELAYED_FRAMES].packet);
+    }
+    audience->first_frame = 0;
+    audience->num_frames = 0;
+}
+
+static void remove_watcher_at(Audience* audience, int index)
+{
+    clear_watcher(&audience->watchers[index]);
+    audience->watchers[index] = audience->watchers[--audience->num_watchers];
+    if (audience->num_watchers == 0)
+    {
+        clear_frames(audience);
+        audience->dirty = false;
+    }
+}
+
+static void arm_tick(void)
+{
+    if (timer_fd == -1 || timer_armed)
+    {
+        return;
+    }
+
+    struct itimerspec spec = {0};
+    spec.it_value.tv_nsec = (long) SPECTATE_TICK_MS * 1000000L;
+    if (timerfd_settime(timer_fd, 0, &spec, NULL) == 0)
+    {
+        timer_armed = true;
+    }
+}
+
+// ===== Sending =====
+
+// Write as much of the watcher's queue as the socket takes. Returns -1 if the socket is gone.
+static int write_watcher(Watcher* watcher)
+{
+    // Replies batched for this connection go first, or frames would overtake them
+    if (!outbox_drain(watcher->fd))
+    {
+        return 0;
+    }
+
+    while (watcher->sending != NULL)
+    {
+        SharedPacket* packet = watcher->sending;
+        ssize_t n = send(watcher->fd, packet->data + watcher->offset, packet->len - watcher->offset,
+                         MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+        }
+
+        watcher->offset += (size_t) n;
+        if (watcher->offset == packet->len)
+        {
+            release_packet(packet);
+            watcher->sending = watcher->next;
+            watcher->next = NULL;
+            watcher->offset = 0;
+        }
+    }
+    return 0;
+}
+
+static void enqueue_frame(Watcher* watcher, SharedPacket* packet)
+{
+    packet->refs++;
+    if (watcher->sending == NULL)
+    {
+        watcher->sending = packet;
+        watcher->offset = 0;
+    }
+    else
+    {
+        // Full-state frames supersede each other: keep only the newest behind the one in flight
+        release_packet(watcher->next);
+        watcher->next = packet;
+    }
+}
+
+static void deliver_frame(Audience* audience, SharedPacket* packet)
+{
+    for (int i = 0; i < audience->num_watchers;)
+    {
+        Watcher* watcher = &audience->watchers[i];
+        enqueue_frame(watcher, packet);
+        if (write_watcher(watcher) == -1)
+        {
+            char log_msg[256];
+            snprintf(log_msg, sizeof(log_msg), "Dropping spectator fd=%d of table %d: send failed", watcher->fd,
+                     audience->table_id);
+            logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+            remove_watcher_at(audience, i);
+            continue;
+        }
+        if (watcher->sending != NULL)
+        {
+            arm_tick();
+        }
+        i++;
+    }
+}
+
+// Encode the table's public state once and hand it to every watcher, now or after the delay
+static void encode_frame(Audience* audience, Table* table, uint64_t now)
+{
+    audience->dirty = false;
+    audience->last_encode_ms = now;
+    if (table->game_state == NULL)
+    {
+        return;
+    }
+
+    RawBytes* state = encode_game_state(table->game_state, 0);
+    if (state == NULL)
+    {
+        return;
+    }
+    RawBytes* raw_packet = encode_packet(PROTOCOL_V1, PACKET_UPDATE_GAMESTATE, state->data, state->len);
+    free(state->data);
+    free(state);
+    if (raw_packet == NULL)
+    {
+        return;
+    }
+
+    SharedPacket* packet = malloc(sizeof(SharedPacket));
+    if (packet == NULL)
+    {
+        free(raw_packet->data);
+        free(raw_packet);
+        return;
+    }
+    packet->data = raw_packet->data;
+    packet->len = raw_packet->len;
+    packet->refs = 1;
+    free(raw_packet);
+
+    if (audience->delay_ms <= 0)
+    {
+        deliver_frame(audience, packet);
+        release_packet(packet);
+        return;
+    }
+
+    if (audience->num_frames == SPECTATE_MAX_DELAYED_FRAMES)
+    {
+        release_packet(audience->frames[audience->first_frame].packet);
+        audience->first_frame = (audience->first_frame + 1) % SPECTATE_MAX_DELAYED_FRAMES;
+        audience->num_frames--;
+    }
+    DelayedFrame* frame =
+        &audience->frames[(audience->first_frame + audience->num_frames) % SPECTATE_MAX_DELAYED_FRAMES];
+    frame->due_ms = now + (uint64_t) audience->delay_ms;
+    frame->packet = packet;
+    audience->num_frames++;
+    arm_tick();
+}
+
+// ===== Public API =====
+
+int spectator_init(void)
+{
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot create spectator timer", 1);
+    }
+    return timer_fd;
+}
+
+int spectator_add(int fd, Table* table)
+{
+    spectator_remove(fd);
+
+    Audience* audience = get_or_create_audience(table->id);
+    if (audience == NULL || audience->num_watchers == SPECTATE_MAX_PER_TABLE)
+    {
+        return -1;
+    }
+
+    if (audience->num_watchers == audience->capacity)
+    {
+        int capacity = audience->capacity > 0 ? audience->capacity * 2 : 8;
+        Watcher* grown = realloc(audience->watchers, capacity * sizeof(Watcher));
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        audience->watchers = grown;
+        audience->capacity = capacity;
+    }
+
+    Watcher* watcher = &audience->watchers[audience->num_watchers++];
+    memset(watcher, 0, sizeof(Watcher));
+    watcher->fd = fd;
+
+    // The newcomer's first frame comes through the normal path, so the delay applies to it too
+    audience->dirty = true;
+    arm_tick();
+    return 0;
+}
+
+void spectator_remove(int fd)
+{
+    for (int i = 0; i < num_audiences; i++)
+    {
+        Audience* audience = &audiences[i];
+        for (int j = 0; j < audience->num_watchers; j++)
+        {
+            if (audience->watchers[j].fd == fd)
+            {
+                remove_watcher_at(audience, j);
+                return;
+            }
+        }
+    }
+}
+
+int spectator_table_of(int fd)
+{
+    for (int i = 0; i < num_audiences; i++)
+    {
+        for (int j = 0; j < audiences[i].num_watchers; j++)
+        {
+            if (audiences[i].watchers[j].fd == fd)
+            {
+                return audiences[i].table_id;
+            }
+        }
+    }
+    return 0;
+}
+
+int spectator_count(int table_id)
+{
+    Audience* audience = find_audience(table_id);
+    return audience != NULL ? audience->num_watchers : 0;
+}
+
+void spectator_stats(int* watchers, int* blocked, int* delayed_frames)
+{
+    *watchers = 0;
+    *blocked = 0;
+    *delayed_frames = 0;
+    for (int i = 0; i < num_audiences; i++)
+    {
+        *watchers += audiences[i].num_watchers;
+        *delayed_frames += audiences[i].num_frames;
+        for (int j = 0; j < audiences[i].num_watchers; j++)
+        {
+            if (audiences[i].watchers[j].sending != NULL)
+            {
+                (*blocked)++;
+            }
+        }
+    }
+}
+
+void spectator_configure(int table_id, int delay_ms, int min_interval_ms)
+{
+    Audience* audience = get_or_create_audience(table_id);
+    if (audience == NULL)
+    {
+        return;
+    }
+    if (delay_ms >= 0)
+    {
+        audience->delay_ms = delay_ms;
+    }
+    if (min_interval_ms >= 0)
+    {
+        audience->min_interval_ms = min_interval_ms;
+    }
+}
+
+void spectator_state_changed(Table* table)
+{
+    Audience* audience = find_audience(table->id);
+    if (audience == NULL || audience->num_watchers == 0)
+    {
+        return;
+    }
+
+    uint64_t now = game_now_ms();
+    if (now - audience->last_encode_ms >= (uint64_t) audience->min_interval_ms)
+    {
+        encode_frame(audience, table, now);
+    }
+    else
+    {
+        audience->dirty = true;
+        arm_tick();
+    }
+}
+
+void spectator_table_removed(int table_id)
+{
+    Audience* audience = find_audience(table_id);
+    if (audience == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < audience->num_watchers; i++)
+    {
+        clear_watcher(&audience->watchers[i]);
+    }
+    clear_frames(audience);
+    free(audience->watchers);
+    *audience = audiences[--num_audiences];
+}
+
+void spectator_flush(TableList* table_list)
+{
+    if (timer_fd != -1)
+    {
+        uint64_t expirations;
+        while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+        {
+        }
+    }
+    timer_armed = false;
+
+    uint64_t now = game_now_ms();
+    bool pending = false;
+    for (int i = 0; i < num_audiences; i++)
+    {
+        Audience* audience = &audiences[i];
+
+        if (audience->dirty && now - audience->last_encode_ms >= (uint64_t) audience->min_interval_ms)
+        {
+            int index = find_table_by_id(table_list, audience->table_id);
+            if (index != -1)
+            {
+                encode_frame(audience, &table_list->tables[index], now);
+            }
+            else
+            {
+                audience->dirty = false;
+            }
+        }
+
+        while (audience->num_frames > 0 && audience->frames[audience->first_frame].due_ms <= now)
+        {
+            SharedPacket* packet = audience->frames[audience->first_frame].packet;
+            audience->first_frame = (audience->first_frame + 1) % SPECTATE_MAX_DELAYED_FRAMES;
+            audience->num_frames--;
+            deliver_frame(audience, packet);
+            release_packet(packet);
+        }
+
+        // Retry sockets that were full last time
+        for (int j = 0; j < audience->num_watchers;)
+        {
+            Watcher* watcher = &audience->watchers[j];
+            if (watcher->sending != NULL && write_watcher(watcher) == -1)
+            {
+                remove_watcher_at(audience, j);
+                continue;
+            }
+            pending = pending || watcher->sending != NULL;
+            j++;
+        }
+
+        pending = pending || audience->dirty || audience->num_frames > 0;
+    }
+
+    if (pending)
+    {
+        arm_tick();
+    }
+}
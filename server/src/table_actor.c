@@ -0,0 +1,199 @@
+#include "table_actor.h"
+#include "main.h"
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+
+// Tables with commands waiting, in the order they became ready. Each entry holds a reference.
+static Mailbox ready = {.head = &ready.stub, .tail = &ready.stub};
+static int wake_fd = -1;
+static _Thread_local bool on_owner_thread = false;
+static atomic_int pending = 0;
+
+int table_actors_init(void)
+{
+    if (wake_fd != -1)
+    {
+        return wake_fd;
+    }
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd == -1)
+    {
+        perror("eventfd");
+        return -1;
+    }
+    on_owner_thread = true;
+    return wake_fd;
+}
+
+int table_actors_fd(void)
+{
+    return wake_fd;
+}
+
+TableActor* table_actor_create(int table_id)
+{
+    TableActor* actor = malloc(sizeof(TableActor));
+    if (actor == NULL)
+    {
+        return NULL;
+    }
+    mailbox_init(&actor->mailbox);
+    atomic_init(&actor->scheduled, false);
+    atomic_init(&actor->refs, 1);
+    actor->table_id = table_id;
+    return actor;
+}
+
+void table_actor_retain(TableActor* actor)
+{
+    atomic_fetch_add_explicit(&actor->refs, 1, memory_order_relaxed);
+}
+
+// Bot decisions carry their command inside the job
+static void free_command(TableCommand* cmd)
+{
+    atomic_fetch_sub_explicit(&pending, 1, memory_order_relaxed);
+    if (cmd->job != NULL)
+    {
+        free(cmd->job);
+    }
+    else
+    {
+        free(cmd);
+    }
+}
+
+void table_actor_release(TableActor* actor)
+{
+    if (actor == NULL || atomic_fetch_sub_explicit(&actor->refs, 1, memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+
+    // Nobody can post any more, so whichever thread got here owns the mailbox
+    MailboxNode* node;
+    while ((node = mailbox_pop(&actor->mailbox)) != NULL)
+    {
+        free_command(MAILBOX_ENTRY(node, TableCommand, node));
+    }
+    free(actor);
+}
+
+static void schedule(TableActor* actor)
+{
+    if (atomic_exchange_explicit(&actor->scheduled, true, memory_order_acq_rel))
+    {
+        return; // Already queued, or being drained and will be seen
+    }
+
+    table_actor_retain(actor);
+    mailbox_push(&ready, &actor->ready_node);
+    if (!on_owner_thread && wake_fd != -1)
+    {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        {
+            perror("table actor eventfd write");
+        }
+    }
+}
+
+void table_actor_post(TableActor* actor, TableCommand* cmd)
+{
+    atomic_fetch_add_explicit(&pending, 1, memory_order_relaxed);
+    mailbox_push(&actor->mailbox, &cmd->node);
+    schedule(actor);
+}
+
+// One follow-up per batch: chain to the next bot, broadcast, and settle a finished hand.
+// handle_hand_complete may remove the table, so nothing touches it afterwards.
+static void follow_up(Table* table, TableList* table_list, bool player_acted)
+{
+    GameState* gs = table->game_state;
+    bool hand_ended = false;
+    if (gs->betting_round != BETTING_ROUND_COMPLETE)
+    {
+        hand_ended = process_all_bot_actions(table);
+    }
+
+    // While bots act in a row, hold the broadcast until the chain reaches a player or ends the hand
+    if (!player_acted && !hand_ended && table->bot_ticket != 0)
+    {
+        return;
+    }
+
+    broadcast_game_state_to_table(table);
+    table->active_seat = gs->active_seat;
+    handle_hand_complete(table, table_list);
+}
+
+static void run_actor(TableActor* actor, TableList* table_list)
+{
+    // Cleared before draining, so a command posted from here on schedules the table again
+    atomic_exchange_explicit(&actor->scheduled, false, memory_order_acq_rel);
+
+    // A removed table's id may be reused; commands for the old one are dropped
+    int index = find_table_by_id(table_list, actor->table_id);
+    Table* table = index >= 0 && table_list->tables[index].actor == actor ? &table_list->tables[index] : NULL;
+
+    bool changed = false;
+    bool player_acted = false;
+    MailboxNode* node;
+    for (int applied = 0; applied < TABLE_ACTOR_BATCH && (node = mailbox_pop(&actor->mailbox)) != NULL; applied++)
+    {
+        TableCommand* cmd = MAILBOX_ENTRY(node, TableCommand, node);
+        if (table != NULL && table->game_state != NULL)
+        {
+            switch (cmd->type)
+            {
+            case TABLE_CMD_ACTION:
+                if (apply_player_action(table, cmd))
+                {
+                    changed = true;
+                    player_acted = true;
+                }
+                break;
+
+            case TABLE_CMD_BOT_DECISION:
+                changed |= bot_apply_decision(table, cmd->job);
+                break;
+            }
+        }
+        free_command(cmd);
+    }
+
+    if (changed)
+    {
+        follow_up(table, table_list, player_acted);
+    }
+
+    // Batch was cut short: take another turn after the tables already waiting
+    if (!mailbox_empty(&actor->mailbox))
+    {
+        schedule(actor);
+    }
+    table_actor_release(actor);
+}
+
+void table_actors_run(TableList* table_list)
+{
+    if (wake_fd != -1)
+    {
+        uint64_t count;
+        while (read(wake_fd, &count, sizeof(count)) > 0)
+        {
+        }
+    }
+
+    MailboxNode* node;
+    while ((node = mailbox_pop(&ready)) != NULL)
+    {
+        run_actor(MAILBOX_ENTRY(node, TableActor, ready_node), table_list);
+    }
+}
+
+int table_actors_pending(void)
+{
+    return atomic_load_explicit(&pending, memory_order_relaxed);
+}
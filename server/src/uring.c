@@ -0,0 +1,752 @@
+#include "uring.h"
+#include "main.h"
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// user_data: operation in the top byte. Receives carry (generation, fd) so a completion that arrives
+// after its connection was closed, possibly with the fd already reused, is recognised and dropped.
+#define OP_SHIFT 56
+#define OP_ACCEPT 1ull
+#define OP_RECV 2ull
+#define OP_SEND 3ull
+#define OP_POLL 4ull
+#define OP_CANCEL 5ull
+#define FD_MASK 0xFFFFFFull
+#define GEN_SHIFT 24
+#define PAYLOAD_MASK ((1ull << OP_SHIFT) - 1)
+
+typedef struct
+{
+    int fd;
+    uint32_t gen;
+    char* data;
+    size_t len;
+    size_t offset;
+} OutSend;
+
+// Per-fd state, indexed by fd
+typedef struct
+{
+    conn_data_t* conn; // NULL if the fd is not a ring connection
+    uint32_t gen;      // Bumped by uring_forget
+    char* pending;     // Bytes queued since the last submit
+    size_t pending_len;
+    size_t pending_cap;
+    OutSend* in_flight;
+    bool dirty; // Listed in dirty_fds
+} Slot;
+
+static bool enabled = false;
+static int ring_fd = -1;
+static int listener_fd = -1;
+
+static void* sq_ptr = MAP_FAILED;
+static size_t sq_map_size = 0;
+static void* cq_ptr = MAP_FAILED;
+static size_t cq_map_size = 0;
+static struct io_uring_sqe* sqes = MAP_FAILED;
+static size_t sqes_map_size = 0;
+
+static unsigned* sq_head;
+static unsigned* sq_tail;
+static unsigned sq_mask;
+static unsigned sq_entries;
+static unsigned sqe_tail = 0; // Local tail, published before each enter
+static unsigned* cq_head;
+static unsigned* cq_tail;
+static unsigned cq_mask;
+static struct io_uring_cqe* cqes;
+
+static struct io_uring_buf_ring* buf_ring = MAP_FAILED;
+static size_t buf_ring_size = 0;
+static uint16_t buf_tail = 0;
+static char* buffers = NULL;
+
+static Slot* slots = NULL;
+static int num_slots = 0;
+static int* dirty_fds = NULL;
+static int num_dirty = 0;
+static int dirty_capacity = 0;
+
+// ===== Ring =====
+
+static int sys_enter(unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int) syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static unsigned unsubmitted(void)
+{
+    return sqe_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+}
+
+static int submit(unsigned min_complete)
+{
+    __atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+    for (;;)
+    {
+        int ret = sys_enter(unsubmitted(), min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+        if (ret >= 0)
+        {
+            return 0;
+        }
+        if (errno == EINTR && min_complete == 0)
+        {
+            continue;
+        }
+        // EINTR while waiting, or EBUSY/EAGAIN with completions to reap first: the caller reaps and comes back
+        return (errno == EINTR || errno == EBUSY || errno == EAGAIN) ? 0 : -1;
+    }
+}
+
+static struct io_uring_sqe* get_sqe(void)
+{
+    if (unsubmitted() >= sq_entries && (submit(0) == -1 || unsubmitted() >= sq_entries))
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Submission queue is full", 1);
+        return NULL;
+    }
+
+    struct io_uring_sqe* sqe = &sqes[sqe_tail & sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe_tail++;
+    return sqe;
+}
+
+static int arm_accept(void)
+{
+    struct io_uring_sqe* sqe = get_sqe();
+    if (sqe == NULL)
+    {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = OP_ACCEPT << OP_SHIFT;
+    return 0;
+}
+
+static int arm_recv(int fd, uint32_t gen)
+{
+    struct io_uring_sqe* sqe = get_sqe();
+    if (sqe == NULL)
+    {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUFFER_GROUP;
+    sqe->user_data = (OP_RECV << OP_SHIFT) | ((uint64_t) gen << GEN_SHIFT) | ((uint64_t) fd & FD_MASK);
+    return 0;
+}
+
+static int arm_poll(int fd)
+{
+    struct io_uring_sqe* sqe = get_sqe();
+    if (sqe == NULL)
+    {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = (OP_POLL << OP_SHIFT) | ((uint64_t) fd & FD_MASK);
+    return 0;
+}
+
+static int submit_send(OutSend* out)
+{
+    struct io_uring_sqe* sqe = get_sqe();
+    if (sqe == NULL)
+    {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = out->fd;
+    sqe->addr = (uint64_t) (uintptr_t) (out->data + out->offset);
+    sqe->len = (uint32_t) (out->len - out->offset);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (OP_SEND << OP_SHIFT) | (uint64_t) (uintptr_t) out;
+    metrics_add(METRIC_SOCKET_WRITES, 1);
+    return 0;
+}
+
+// ===== Receive buffers =====
+
+static char* buffer_at(uint16_t id)
+{
+    return buffers + (size_t) id * (URING_BUFFER_SIZE + 1);
+}
+
+static void recycle_buffer(uint16_t id)
+{
+    struct io_uring_buf* buf = &buf_ring->bufs[buf_tail & (URING_BUFFERS - 1)];
+    buf->addr = (uint64_t) (uintptr_t) buffer_at(id);
+    buf->len = URING_BUFFER_SIZE;
+    buf->bid = id;
+    buf_tail++;
+    __atomic_store_n(&buf_ring->tail, buf_tail, __ATOMIC_RELEASE);
+}
+
+// ===== Connections =====
+
+static Slot* find_slot(int fd)
+{
+    return (fd >= 0 && fd < num_slots) ? &slots[fd] : NULL;
+}
+
+static Slot* ensure_slot(int fd)
+{
+    if (fd < 0 || (uint64_t) fd > FD_MASK)
+    {
+        return NULL;
+    }
+    if (fd >= num_slots)
+    {
+        int capacity = num_slots > 0 ? num_slots : 1024;
+        while (capacity <= fd)
+        {
+            capacity *= 2;
+        }
+        Slot* grown = realloc(slots, (size_t) capacity * sizeof(Slot));
+        if (grown == NULL)
+        {
+            return NULL;
+        }
+        memset(grown + num_slots, 0, (size_t) (capacity - num_slots) * sizeof(Slot));
+        slots = grown;
+        num_slots = capacity;
+    }
+    return &slots[fd];
+}
+
+static void mark_dirty(int fd, Slot* slot)
+{
+    if (slot->dirty)
+    {
+        return;
+    }
+    if (num_dirty == dirty_capacity)
+    {
+        int capacity = dirty_capacity > 0 ? dirty_capacity * 2 : 256;
+        int* grown = realloc(dirty_fds, (size_t) capacity * sizeof(int));
+        if (grown == NULL)
+        {
+            return; // Stays pending; the next uring_send retries
+        }
+        dirty_fds = grown;
+        dirty_capacity = capacity;
+    }
+    dirty_fds[num_dirty++] = fd;
+    slot->dirty = true;
+}
+
+// Hand each connection's queued bytes to the kernel as one send, unless one is still in flight
+static void flush_sends(void)
+{
+    for (int i = 0; i < num_dirty; i++)
+    {
+        int fd = dirty_fds[i];
+        Slot* slot = &slots[fd];
+        slot->dirty = false;
+        if (slot->conn == NULL || slot->in_flight != NULL || slot->pending_len == 0)
+        {
+            continue;
+        }
+
+        OutSend* out = malloc(sizeof(OutSend));
+        if (out == NULL)
+        {
+            continue; // Stays pending until the connection's next send
+        }
+        out->fd = fd;
+        out->gen = slot->gen;
+        out->data = slot->pending;
+        out->len = slot->pending_len;
+        out->offset = 0;
+        slot->pending = NULL;
+        slot->pending_len = 0;
+        slot->pending_cap = 0;
+        slot->in_flight = out;
+        if (submit_send(out) == -1)
+        {
+            slot->in_flight = NULL;
+            free(out->data);
+            free(out);
+        }
+    }
+    num_dirty = 0;
+}
+
+static void complete_send(OutSend* out, int res)
+{
+    Slot* slot = find_slot(out->fd);
+    bool current = slot != NULL && slot->conn != NULL && slot->gen == out->gen;
+
+    if (current && res > 0 && out->offset + (size_t) res < out->len)
+    {
+        out->offset += (size_t) res;
+        if (submit_send(out) == 0)
+        {
+            return;
+        }
+    }
+    else if (current && res < 0)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "Send failed on fd=%d after %zu/%zu bytes: %s", out->fd, out->offset,
+                 out->len, strerror(-res));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+    }
+
+    if (current)
+    {
+        slot->in_flight = NULL;
+        if (slot->pending_len > 0)
+        {
+            mark_dirty(out->fd, slot);
+        }
+    }
+    free(out->data);
+    free(out);
+}
+
+// ===== Setup =====
+
+static void teardown(void)
+{
+    if (buf_ring != MAP_FAILED)
+    {
+        munmap(buf_ring, buf_ring_size);
+        buf_ring = MAP_FAILED;
+    }
+    free(buffers);
+    buffers = NULL;
+    if (sqes != MAP_FAILED)
+    {
+        munmap(sqes, sqes_map_size);
+        sqes = MAP_FAILED;
+    }
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+    {
+        munmap(cq_ptr, cq_map_size);
+    }
+    cq_ptr = MAP_FAILED;
+    if (sq_ptr != MAP_FAILED)
+    {
+        munmap(sq_ptr, sq_map_size);
+        sq_ptr = MAP_FAILED;
+    }
+    if (ring_fd != -1)
+    {
+        close(ring_fd);
+        ring_fd = -1;
+    }
+}
+
+static int init_fail(const char* what)
+{
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "io_uring unavailable (%s: %s)", what, strerror(errno));
+    logger_ex(MAIN_LOG, "WARN", __func__, log_msg, 1);
+    teardown();
+    return -1;
+}
+
+static int map_rings(const struct io_uring_params* params)
+{
+    sq_map_size = params->sq_off.array + params->sq_entries * sizeof(unsigned);
+    cq_map_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    if (params->features & IORING_FEAT_SINGLE_MMAP)
+    {
+        sq_map_size = sq_map_size > cq_map_size ? sq_map_size : cq_map_size;
+    }
+
+    sq_ptr = mmap(NULL, sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED)
+    {
+        return -1;
+    }
+    if (params->features & IORING_FEAT_SINGLE_MMAP)
+    {
+        cq_ptr = sq_ptr;
+    }
+    else
+    {
+        cq_ptr = mmap(NULL, cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                      IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED)
+        {
+            return -1;
+        }
+    }
+    sqes_map_size = params->sq_entries * sizeof(struct io_uring_sqe);
+    sqes = mmap(NULL, sqes_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    char* sq = sq_ptr;
+    sq_head = (unsigned*) (sq + params->sq_off.head);
+    sq_tail = (unsigned*) (sq + params->sq_off.tail);
+    sq_mask = *(unsigned*) (sq + params->sq_off.ring_mask);
+    sq_entries = *(unsigned*) (sq + params->sq_off.ring_entries);
+    unsigned* sq_array = (unsigned*) (sq + params->sq_off.array);
+    for (unsigned i = 0; i < sq_entries; i++)
+    {
+        sq_array[i] = i; // SQE i always sits in slot i
+    }
+    sqe_tail = *sq_tail;
+
+    char* cq = cq_ptr;
+    cq_head = (unsigned*) (cq + params->cq_off.head);
+    cq_tail = (unsigned*) (cq + params->cq_off.tail);
+    cq_mask = *(unsigned*) (cq + params->cq_off.ring_mask);
+    cqes = (struct io_uring_cqe*) (cq + params->cq_off.cqes);
+    return 0;
+}
+
+static int setup_buffers(void)
+{
+    buf_ring_size = URING_BUFFERS * sizeof(struct io_uring_buf);
+    buf_ring = mmap(NULL, buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf_ring == MAP_FAILED)
+    {
+        return -1;
+    }
+    // One spare byte per buffer so received data can always be NUL-terminated
+    buffers = malloc((size_t) URING_BUFFERS * (URING_BUFFER_SIZE + 1));
+    if (buffers == NULL)
+    {
+        return -1;
+    }
+
+    struct io_uring_buf_reg reg = {0};
+    reg.ring_addr = (uint64_t) (uintptr_t) buf_ring;
+    reg.ring_entries = URING_BUFFERS;
+    reg.bgid = URING_BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1)
+    {
+        return -1;
+    }
+
+    buf_tail = 0;
+    for (int i = 0; i < URING_BUFFERS; i++)
+    {
+        recycle_buffer((uint16_t) i);
+    }
+    return 0;
+}
+
+bool uring_requested(void)
+{
+    const char* backend = getenv("CARDIO_IO_BACKEND");
+    return backend != NULL && (strcmp(backend, "uring") == 0 || strcmp(backend, "io_uring") == 0);
+}
+
+int uring_init(int listener)
+{
+    struct io_uring_params params = {0};
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    ring_fd = (int) syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (ring_fd == -1 && errno == EINVAL)
+    {
+        // Older kernel without the optional flags
+        memset(&params, 0, sizeof(params));
+        ring_fd = (int) syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    }
+    if (ring_fd == -1)
+    {
+        return init_fail("io_uring_setup");
+    }
+    if (!(params.features & IORING_FEAT_NODROP))
+    {
+        errno = ENOTSUP;
+        return init_fail("completion overflow protection");
+    }
+    if (map_rings(&params) == -1)
+    {
+        return init_fail("mmap");
+    }
+    if (setup_buffers() == -1)
+    {
+        return init_fail("provided buffer ring");
+    }
+
+    listener_fd = listener;
+    if (arm_accept() == -1 || submit(0) == -1)
+    {
+        return init_fail("multishot accept");
+    }
+
+    enabled = true;
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "io_uring backend ready: %u entries, %d x %d byte receive buffers",
+             sq_entries, URING_BUFFERS, URING_BUFFER_SIZE);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    return 0;
+}
+
+bool uring_enabled(void)
+{
+    return enabled;
+}
+
+int uring_watch(int fd)
+{
+    return arm_poll(fd);
+}
+
+conn_data_t* uring_add_connection(int client_fd)
+{
+    Slot* slot = ensure_slot(client_fd);
+    if (slot == NULL)
+    {
+        logger_ex(MAIN_LOG, "ERROR", __func__, "Cannot track client socket", 1);
+        close(client_fd);
+        return NULL;
+    }
+
+    conn_data_t* conn_data = init_connection_data(client_fd);
+    if (conn_data == NULL)
+    {
+        return NULL;
+    }
+
+    slot->conn = conn_data;
+    if (arm_recv(client_fd, slot->gen) == -1)
+    {
+        slot->conn = NULL;
+        free(conn_data);
+        close(client_fd);
+        return NULL;
+    }
+
+    struct sockaddr_storage client_addr;
+    socklen_t addr_size = sizeof(client_addr);
+    char client_ip[INET6_ADDRSTRLEN] = "unknown";
+    if (getpeername(client_fd, (struct sockaddr*) &client_addr, &addr_size) == 0)
+    {
+        inet_ntop(client_addr.ss_family, get_in_addr((struct sockaddr*) &client_addr), client_ip, sizeof client_ip);
+    }
+
+    char log_msg[256];
+    snprintf(log_msg, sizeof(log_msg), "New connection from %s [fd=%d]", client_ip, client_fd);
+    logger_ex(MAIN_LOG, "INFO", __func__, log_msg, 1);
+    metrics_add(METRIC_CONNECTIONS_OPENED, 1);
+    return conn_data;
+}
+
+void uring_forget(int fd)
+{
+    Slot* slot = find_slot(fd);
+    if (slot == NULL || slot->conn == NULL)
+    {
+        return;
+    }
+
+    // Completions still on their way carry the old generation and are dropped
+    slot->conn = NULL;
+    slot->gen++;
+    slot->in_flight = NULL;
+    free(slot->pending);
+    slot->pending = NULL;
+    slot->pending_len = 0;
+    slot->pending_cap = 0;
+
+    // Cancel the receive and any send now, before the caller closes fd and the number can be reused
+    struct io_uring_sqe* sqe = get_sqe();
+    if (sqe != NULL)
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = OP_CANCEL << OP_SHIFT;
+        submit(0);
+    }
+}
+
+int uring_rebind(int fd, conn_data_t* conn_data)
+{
+    Slot* slot = find_slot(fd);
+    if (slot == NULL || slot->conn == NULL)
+    {
+        return -1;
+    }
+    slot->conn = conn_data;
+    return 0;
+}
+
+int uring_send(int fd, const char* buf, int len)
+{
+    Slot* slot = find_slot(fd);
+    if (slot == NULL || slot->conn == NULL || len < 0)
+    {
+        return -1;
+    }
+
+    size_t needed = slot->pending_len + (size_t) len;
+    if (needed > slot->pending_cap)
+    {
+        size_t capacity = slot->pending_cap > 0 ? slot->pending_cap * 2 : 4096;
+        while (capacity < needed)
+        {
+            capacity *= 2;
+        }
+        char* grown = realloc(slot->pending, capacity);
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        slot->pending = grown;
+        slot->pending_cap = capacity;
+    }
+    memcpy(slot->pending + slot->pending_len, buf, (size_t) len);
+    slot->pending_len = needed;
+    mark_dirty(fd, slot);
+    return 0;
+}
+
+// ===== Event loop =====
+
+int uring_wait(void)
+{
+    flush_sends();
+    if (submit(1) == -1)
+    {
+        char log_msg[256];
+        snprintf(log_msg, sizeof(log_msg), "io_uring_enter failed: %s", strerror(errno));
+        logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+        return -1;
+    }
+    return 0;
+}
+
+bool uring_next(UringEvent* event)
+{
+    for (;;)
+    {
+        unsigned head = *cq_head;
+        if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+        struct io_uring_cqe* cqe = &cqes[head & cq_mask];
+        uint64_t user_data = cqe->user_data;
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+        bool more = (flags & IORING_CQE_F_MORE) != 0;
+        uint64_t payload = user_data & PAYLOAD_MASK;
+        memset(event, 0, sizeof(*event));
+
+        switch (user_data >> OP_SHIFT)
+        {
+        case OP_ACCEPT:
+            if (!more)
+            {
+                arm_accept();
+            }
+            if (res < 0)
+            {
+                char log_msg[256];
+                snprintf(log_msg, sizeof(log_msg), "Failed to accept connection: %s", strerror(-res));
+                logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+                continue;
+            }
+            event->type = URING_EVENT_ACCEPT;
+            event->fd = res;
+            return true;
+
+        case OP_RECV:
+        {
+            int fd = (int) (payload & FD_MASK);
+            uint32_t gen = (uint32_t) (payload >> GEN_SHIFT);
+            Slot* slot = find_slot(fd);
+            bool has_buffer = (flags & IORING_CQE_F_BUFFER) != 0;
+            uint16_t buffer_id = (uint16_t) (flags >> IORING_CQE_BUFFER_SHIFT);
+
+            if (slot == NULL || slot->conn == NULL || slot->gen != gen)
+            {
+                if (has_buffer)
+                {
+                    recycle_buffer(buffer_id);
+                }
+                continue;
+            }
+            if (res > 0 && has_buffer)
+            {
+                if (!more)
+                {
+                    arm_recv(fd, gen);
+                }
+                event->type = URING_EVENT_DATA;
+                event->fd = fd;
+                event->conn = slot->conn;
+                event->data = buffer_at(buffer_id);
+                event->data[res] = '\0';
+                event->len = res;
+                event->buffer_id = buffer_id;
+                return true;
+            }
+            if (has_buffer)
+            {
+                recycle_buffer(buffer_id);
+            }
+            if (res == -ENOBUFS)
+            {
+                // Every buffer was in use; the data is still in the socket, so just ask again
+                arm_recv(fd, gen);
+                continue;
+            }
+            event->type = URING_EVENT_CLOSED;
+            event->fd = fd;
+            event->conn = slot->conn;
+            event->len = res;
+            return true;
+        }
+
+        case OP_SEND:
+            complete_send((OutSend*) (uintptr_t) payload, res);
+            continue;
+
+        case OP_POLL:
+        {
+            int fd = (int) (payload & FD_MASK);
+            if (res < 0)
+            {
+                char log_msg[256];
+                snprintf(log_msg, sizeof(log_msg), "Poll failed on fd=%d: %s", fd, strerror(-res));
+                logger_ex(MAIN_LOG, "ERROR", __func__, log_msg, 1);
+                continue;
+            }
+            if (!more)
+            {
+                arm_poll(fd);
+            }
+            event->type = URING_EVENT_READY;
+            event->fd = fd;
+            return true;
+        }
+
+        default:
+            continue; // Cancellations
+        }
+    }
+}
+
+void uring_release(const UringEvent* event)
+{
+    if (event->type == URING_EVENT_DATA)
+    {
+        recycle_buffer(event->buffer_id);
+    }
+}
@@ -0,0 +1,381 @@
+/*
+ * Protocol Encode/Decode Benchmark
+ *
+ * Times the packet and payload codecs on realistic inputs: game states for 2 to 9 seats in every
+ * betting round, lobby lists of 10 to 100k tables, and client requests. Reports ns/op, output bytes/op
+ * and heap allocations/op. Allocations are counted by wrapping malloc/calloc/realloc at link time
+ * (-Wl,--wrap, see CMakeLists.txt), so the numbers include allocations made inside mpack.
+ *
+ * Usage: bench_protocol [filter] [min_ms]
+ *   filter  only run benchmarks whose name contains this string
+ *   min_ms  minimum measuring time per benchmark (default 200)
+ *
+ * Results go to stdout; the DEBUG lines the encoders log are discarded (their cost is still measured).
+ */
+
+#include "main.h"
+
+#define DEFAULT_MIN_MS 200
+#define MAX_LOBBY_TABLES 100000
+
+// ===== Allocation counting =====
+
+static uint64_t alloc_count = 0;
+static uint64_t alloc_bytes = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    alloc_count++;
+    alloc_bytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+// ===== Harness =====
+
+// One operation; returns the bytes it produced (0 if it failed) and frees its output
+typedef size_t (*BenchOp)(void* ctx);
+
+static const char* filter = NULL;
+static FILE* results = NULL;
+static uint64_t min_ns = DEFAULT_MIN_MS * 1000000ull;
+static volatile size_t sink;
+
+static void run_bench(const char* name, BenchOp op, void* ctx)
+{
+    if (filter != NULL && strstr(name, filter) == NULL)
+    {
+        return;
+    }
+
+    // Warm up, and skip operations that cannot succeed on this input
+    size_t bytes = op(ctx);
+    if (bytes == 0)
+    {
+        fprintf(results, "%-44s %12s\n", name, "failed");
+        fflush(results);
+        return;
+    }
+
+    uint64_t ops = 0;
+    uint64_t total_bytes = 0;
+    uint64_t batch = 1;
+    alloc_count = 0;
+    alloc_bytes = 0;
+    uint64_t started = metrics_now_ns();
+    uint64_t elapsed = 0;
+    while (elapsed < min_ns)
+    {
+        for (uint64_t i = 0; i < batch; i++)
+        {
+            total_bytes += op(ctx);
+        }
+        ops += batch;
+        batch *= 2;
+        elapsed = metrics_now_ns() - started;
+    }
+    uint64_t allocs = alloc_count;
+    uint64_t allocated = alloc_bytes;
+    sink = total_bytes;
+
+    fprintf(results, "%-44s %12.1f %12.0f %10.2f %12.0f\n", name, (double)elapsed / ops, (double)total_bytes / ops,
+           (double)allocs / ops, (double)allocated / ops);
+    fflush(results);
+}
+
+static void free_raw(RawBytes* raw)
+{
+    if (raw)
+    {
+        free(raw->data);
+        free(raw);
+    }
+}
+
+// ===== Packets =====
+
+typedef struct
+{
+    char* payload;
+    size_t payload_len;
+    RawBytes* packet; // Same payload framed, for decoding
+} PacketCase;
+
+static size_t bench_encode_packet(void* ctx)
+{
+    PacketCase* c = ctx;
+    RawBytes* packet = encode_packet(PROTOCOL_V1, PACKET_UPDATE_GAMESTATE, c->payload, c->payload_len);
+    size_t len = packet ? packet->len : 0;
+    free_raw(packet);
+    return len;
+}
+
+static size_t bench_decode_packet(void* ctx)
+{
+    PacketCase* c = ctx;
+    Packet* packet = decode_packet(c->packet->data, c->packet->len);
+    size_t len = packet ? packet->header->packet_len : 0;
+    free_packet(packet);
+    return len;
+}
+
+static void bench_packets(void)
+{
+    size_t sizes[] = {64, 1024, 16384};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        PacketCase c;
+        c.payload_len = sizes[i];
+        c.payload = malloc(c.payload_len);
+        memset(c.payload, 0xA5, c.payload_len);
+        c.packet = encode_packet(PROTOCOL_V1, PACKET_UPDATE_GAMESTATE, c.payload, c.payload_len);
+
+        char name[64];
+        snprintf(name, sizeof(name), "encode_packet/%zuB", sizes[i]);
+        run_bench(name, bench_encode_packet, &c);
+        snprintf(name, sizeof(name), "decode_packet/%zuB", sizes[i]);
+        run_bench(name, bench_decode_packet, &c);
+
+        free(c.payload);
+        free_raw(c.packet);
+    }
+}
+
+// ===== Requests =====
+
+typedef struct
+{
+    char payload[128];
+    size_t len;
+} ActionCase;
+
+static size_t bench_decode_action_request(void* ctx)
+{
+    ActionCase* c = ctx;
+    ActionRequest* request = decode_action_request(c->payload);
+    size_t len = request ? c->len : 0;
+    free(request);
+    return len;
+}
+
+static void bench_requests(void)
+{
+    ActionCase c;
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, c.payload, sizeof(c.payload));
+    mpack_start_map(&writer, 3);
+    mpack_write_cstr(&writer, "game_id");
+    mpack_write_int(&writer, 42);
+    mpack_write_cstr(&writer, "action");
+    mpack_start_map(&writer, 2);
+    mpack_write_cstr(&writer, "type");
+    mpack_write_cstr(&writer, "raise");
+    mpack_write_cstr(&writer, "amount");
+    mpack_write_int(&writer, 250);
+    mpack_finish_map(&writer);
+    mpack_write_cstr(&writer, "client_seq");
+    mpack_write_u32(&writer, 17);
+    mpack_finish_map(&writer);
+    c.len = mpack_writer_buffer_used(&writer);
+    mpack_writer_destroy(&writer);
+
+    run_bench("decode_action_request", bench_decode_action_request, &c);
+}
+
+// ===== Game states =====
+
+typedef struct
+{
+    GameState* state;
+    int viewer;
+    ActionRecord actions[4];
+    int num_actions;
+} GameStateCase;
+
+static size_t bench_encode_game_state(void* ctx)
+{
+    GameStateCase* c = ctx;
+    RawBytes* raw = c->num_actions > 0
+                        ? encode_game_state_with_actions(c->state, c->viewer, c->actions, c->num_actions)
+                        : encode_game_state(c->state, c->viewer);
+    size_t len = raw ? raw->len : 0;
+    free_raw(raw);
+    return len;
+}
+
+// A hand at the given round with every seat filled; the viewer is the player to act
+static GameState* make_game_state(int seats, BettingRound round)
+{
+    GameState* state = game_state_create(1, seats, 5, 10);
+    for (int seat = 0; seat < seats; seat++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "player_%d", seat);
+        game_add_player(state, 1000 + seat, name, seat, 1000);
+    }
+    game_start_hand(state);
+    while (state->betting_round < round)
+    {
+        game_advance_betting_round(state);
+    }
+    return state;
+}
+
+static void bench_game_states(void)
+{
+    static const char* round_names[] = {"preflop", "flop", "turn", "river"};
+    int seat_counts[] = {2, 6, 9};
+    for (size_t s = 0; s < sizeof(seat_counts) / sizeof(seat_counts[0]); s++)
+    {
+        for (int round = BETTING_ROUND_PREFLOP; round <= BETTING_ROUND_RIVER; round++)
+        {
+            GameStateCase c = {0};
+            c.state = make_game_state(seat_counts[s], (BettingRound)round);
+            c.viewer = c.state->active_seat >= 0 ? c.state->players[c.state->active_seat].player_id : 1000;
+
+            char name[64];
+            snprintf(name, sizeof(name), "encode_game_state/%dseats/%s", seat_counts[s], round_names[round]);
+            run_bench(name, bench_encode_game_state, &c);
+
+            // Coalesced broadcast carrying the actions that led here
+            c.num_actions = 3;
+            for (int i = 0; i < c.num_actions; i++)
+            {
+                c.actions[i] = (ActionRecord){.seq = (uint32_t)i + 1, .seat = i, .player_id = 1000 + i,
+                                              .type = i == 0 ? ACTION_CALL : ACTION_CHECK, .amount = i == 0 ? 10 : 0};
+            }
+            snprintf(name, sizeof(name), "encode_game_state_with_actions/%dseats/%s", seat_counts[s],
+                     round_names[round]);
+            run_bench(name, bench_encode_game_state, &c);
+
+            game_state_destroy(c.state);
+        }
+    }
+}
+
+// ===== Lobby =====
+
+typedef struct
+{
+    TableList* table_list;
+    TablesQuery query;
+} LobbyCase;
+
+static size_t bench_encode_full_tables(void* ctx)
+{
+    LobbyCase* c = ctx;
+    RawBytes* raw = encode_full_tables_response(c->table_list);
+    size_t len = raw ? raw->len : 0;
+    free_raw(raw);
+    return len;
+}
+
+static size_t bench_tables_page(void* ctx)
+{
+    LobbyCase* c = ctx;
+    TableSummary page[TABLES_PAGE_MAX];
+    TablesQuery next;
+    bool has_more;
+    int count = lobby_query_tables(&c->query, page, &next, &has_more);
+    RawBytes* raw = encode_tables_page_response(page, count, has_more ? &next : NULL);
+    size_t len = raw ? raw->len : 0;
+    free_raw(raw);
+    return len;
+}
+
+static void bench_lobby(void)
+{
+    // Tables are filled in key order so building the lobby index stays linear
+    TableList table_list = {0};
+    table_list.tables = calloc(MAX_LOBBY_TABLES, sizeof(Table));
+    if (table_list.tables == NULL)
+    {
+        fprintf(results, "%-44s %12s\n", "lobby", "out of memory");
+        return;
+    }
+    table_list.capacity = MAX_LOBBY_TABLES;
+
+    int sizes[] = {10, 100, 1000, 10000, 100000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        while ((int)table_list.size < sizes[s])
+        {
+            int i = (int)table_list.size;
+            Table* table = &table_list.tables[i];
+            table->id = i + 1;
+            snprintf(table->name, sizeof(table->name), "table_%06d", i);
+            table->max_player = 9;
+            table->min_bet = 10 * (1 + (int)((int64_t)i * 100 / MAX_LOBBY_TABLES));
+            table->current_player = 8 - (int)((int64_t)i * 9 / MAX_LOBBY_TABLES);
+            table_list.size++;
+            lobby_table_added(table);
+        }
+
+        LobbyCase c = {.table_list = &table_list};
+        char name[64];
+        snprintf(name, sizeof(name), "encode_full_tables_response/%d", sizes[s]);
+        run_bench(name, bench_encode_full_tables, &c);
+
+        c.query = (TablesQuery){.min_bet = -1, .max_bet = -1, .sort = TABLES_SORT_STAKES,
+                                .limit = TABLES_PAGE_DEFAULT};
+        snprintf(name, sizeof(name), "tables_page/%d/first_%d", sizes[s], TABLES_PAGE_DEFAULT);
+        run_bench(name, bench_tables_page, &c);
+
+        c.query = (TablesQuery){.min_bet = 10, .max_bet = 30, .min_free_seats = 1, .sort = TABLES_SORT_NAME,
+                                .limit = TABLES_PAGE_MAX};
+        snprintf(name, sizeof(name), "tables_page/%d/filtered_%d", sizes[s], TABLES_PAGE_MAX);
+        run_bench(name, bench_tables_page, &c);
+    }
+
+    for (size_t i = 0; i < table_list.size; i++)
+    {
+        lobby_table_removed(table_list.tables[i].id);
+    }
+    free(table_list.tables);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && argv[1][0] != '\0')
+    {
+        filter = argv[1];
+    }
+    if (argc > 2 && atoi(argv[2]) > 0)
+    {
+        min_ns = (uint64_t)atoi(argv[2]) * 1000000ull;
+    }
+    srand(1);
+
+    // Keep the encoders' DEBUG logging off the results table
+    results = fdopen(dup(STDOUT_FILENO), "w");
+    if (results == NULL || freopen("/dev/null", "w", stdout) == NULL)
+    {
+        perror("bench_protocol");
+        return 1;
+    }
+
+    fprintf(results, "%-44s %12s %12s %10s %12s\n", "benchmark", "ns/op", "bytes/op", "allocs/op", "alloc B/op");
+    bench_packets();
+    bench_requests();
+    bench_game_states();
+    bench_lobby();
+    fclose(results);
+    return 0;
+}
@@ -0,0 +1,937 @@
+/**
+ * Load generator for the Cardio game server
+ *
+ * Drives thousands of non-blocking client connections from one process (a single epoll loop). Every
+ * client signs up (an existing account is fine), logs in, sits at a table and plays until the run ends,
+ * waiting a random think time before each action. Clients are grouped into tables of --seats players:
+ * the first of each group creates the table and the others join it.
+ *
+ * Measured:
+ *   - action round trip: PACKET_ACTION_REQUEST sent -> PACKET_ACTION_RESULT with the same client_seq
+ *   - fan-out delay: action sent -> the resulting game state reaching each other player at the table
+ *   - login round trip, throughput (actions, hands, packets and bytes per second) and errors
+ *
+ * For more players than one machine can drive, run one process per machine with --shard i/n. Shards
+ * use disjoint usernames, so their counts add up and their latencies can be compared side by side.
+ *
+ * Usage: loadgen [--host 127.0.0.1] [--port 8080] [--clients 1000] [--seats 6] [--duration 60]
+ *                [--think-ms 500] [--ramp 200] [--shard 0/1] [--prefix lg] [--no-signup]
+ */
+
+#include "main.h"
+#include <getopt.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+
+#define LOADGEN_RX_BUFFER (2 * MAXLINE)
+#define LOADGEN_TX_BUFFER 1024
+#define LOADGEN_PASSWORD "loadgen12345"
+#define LOADGEN_REPORT_INTERVAL_S 5
+#define LOADGEN_MAX_EVENTS 1024
+#define LOADGEN_MAX_ACTIONS 8
+
+typedef enum {
+    CLIENT_IDLE,          // Not connected yet (ramping up)
+    CLIENT_CONNECTING,
+    CLIENT_SIGNUP,
+    CLIENT_LOGIN,
+    CLIENT_CREATE_TABLE,
+    CLIENT_WAIT_TABLE,    // Logged in, waiting for the group's creator
+    CLIENT_JOIN,
+    CLIENT_PLAYING,
+    CLIENT_FAILED,
+} ClientState;
+
+typedef struct {
+    char type[16];
+    int min_amount;
+} LoadAction;
+
+typedef struct {
+    int index;
+    int fd;
+    ClientState state;
+    char username[32];
+    int group;
+
+    char* rx;
+    size_t rx_len;
+    char tx[LOADGEN_TX_BUFFER];
+    size_t tx_len;
+    bool want_write;          // EPOLLOUT registered
+
+    uint64_t request_ns;      // Login sent
+    int game_id;
+    LoadAction actions[LOADGEN_MAX_ACTIONS]; // Offered in the last state that made it our turn
+    int num_actions;
+    uint64_t act_at_ns;       // When the think time is over, 0 if it's not our turn
+    uint32_t client_seq;
+    uint64_t action_sent_ns;  // 0 if no action is in flight
+    bool awaiting_fanout;
+} Client;
+
+typedef struct {
+    int table_id;             // 0 until the creator got it
+    uint64_t action_sent_ns;  // Last action sent by a member
+    uint32_t hand_id;
+} Group;
+
+typedef struct {
+    uint64_t due_ns;
+    int client;
+} Timer;
+
+typedef struct {
+    const char* host;
+    const char* port;
+    int clients;
+    int seats;
+    int duration_s;
+    int think_ms;
+    int ramp;
+    int shard;
+    int num_shards;
+    const char* prefix;
+    bool signup;
+} LoadConfig;
+
+typedef struct {
+    uint64_t connect_errors;
+    uint64_t login_failures;
+    uint64_t table_failures;
+    uint64_t disconnects;
+    uint64_t actions;
+    uint64_t action_rejects;
+    uint64_t hands;
+    uint64_t packets_in;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+} LoadCounters;
+
+static LoadConfig config = {
+    .host = "127.0.0.1",
+    .port = "8080",
+    .clients = 1000,
+    .seats = 6,
+    .duration_s = 60,
+    .think_ms = 500,
+    .ramp = 200,
+    .shard = 0,
+    .num_shards = 1,
+    .prefix = "lg",
+    .signup = true,
+};
+
+static Client* clients = NULL;
+static Group* groups = NULL;
+static int epoll_fd = -1;
+static struct sockaddr_storage server_addr;
+static socklen_t server_addr_len = 0;
+
+static Timer* timers = NULL;
+static int num_timers = 0;
+static int timers_capacity = 0;
+
+static LoadCounters counters;
+static LoadCounters last_counters;
+static MetricsHistogram action_rtt;
+static MetricsHistogram fanout_delay;
+static MetricsHistogram login_rtt;
+
+// ===== Timers (binary min-heap) =====
+
+// Timers of turns that ended early stay in the heap and are skipped when they come due
+static void timer_push(uint64_t due_ns, int client)
+{
+    if (num_timers == timers_capacity) {
+        int capacity = timers_capacity ? timers_capacity * 2 : 1024;
+        Timer* grown = realloc(timers, sizeof(Timer) * (size_t)capacity);
+        if (grown == NULL) {
+            return;
+        }
+        timers = grown;
+        timers_capacity = capacity;
+    }
+    int i = num_timers++;
+    while (i > 0 && timers[(i - 1) / 2].due_ns > due_ns) {
+        timers[i] = timers[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    timers[i].due_ns = due_ns;
+    timers[i].client = client;
+}
+
+static Timer timer_pop(void)
+{
+    Timer top = timers[0];
+    Timer last = timers[--num_timers];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= num_timers) {
+            break;
+        }
+        if (child + 1 < num_timers && timers[child + 1].due_ns < timers[child].due_ns) {
+            child++;
+        }
+        if (last.due_ns <= timers[child].due_ns) {
+            break;
+        }
+        timers[i] = timers[child];
+        i = child;
+    }
+    if (num_timers > 0) {
+        timers[i] = last;
+    }
+    return top;
+}
+
+// ===== Connections =====
+
+static void client_fail(Client* c, uint64_t* counter)
+{
+    if (counter) {
+        (*counter)++;
+    }
+    if (c->fd != -1) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+        c->fd = -1;
+    }
+    c->state = CLIENT_FAILED;
+    c->act_at_ns = 0;
+}
+
+static void client_watch(Client* c, bool want_write)
+{
+    if (c->want_write == want_write) {
+        return;
+    }
+    c->want_write = want_write;
+    struct epoll_event event;
+    event.events = EPOLLIN | (want_write ? EPOLLOUT : 0);
+    event.data.u32 = (uint32_t)c->index;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &event);
+}
+
+static void client_flush(Client* c)
+{
+    while (c->tx_len > 0) {
+        ssize_t n = send(c->fd, c->tx, c->tx_len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                client_watch(c, true);
+                return;
+            }
+            client_fail(c, &counters.disconnects);
+            return;
+        }
+        counters.bytes_out += (uint64_t)n;
+        memmove(c->tx, c->tx + n, c->tx_len - (size_t)n);
+        c->tx_len -= (size_t)n;
+    }
+    client_watch(c, false);
+}
+
+// The server reads one packet per recv, so a client never has more than one request unsent
+static void client_send(Client* c, uint16_t packet_type, char* payload, size_t payload_len)
+{
+    RawBytes* packet = encode_packet(PROTOCOL_V1, packet_type, payload, payload_len);
+    if (packet == NULL || c->tx_len + packet->len > sizeof(c->tx)) {
+        if (packet) {
+            free(packet->data);
+            free(packet);
+        }
+        client_fail(c, &counters.disconnects);
+        return;
+    }
+    memcpy(c->tx + c->tx_len, packet->data, packet->len);
+    c->tx_len += packet->len;
+    free(packet->data);
+    free(packet);
+    client_flush(c);
+}
+
+static void client_connect(Client* c)
+{
+    c->fd = socket(server_addr.ss_family, SOCK_STREAM, 0);
+    if (c->fd == -1 || set_nonblocking(c->fd) == -1) {
+        client_fail(c, &counters.connect_errors);
+        return;
+    }
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(c->fd, (struct sockaddr*)&server_addr, server_addr_len) == -1 && errno != EINPROGRESS) {
+        client_fail(c, &counters.connect_errors);
+        return;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u32 = (uint32_t)c->index;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c->fd, &event) == -1) {
+        client_fail(c, &counters.connect_errors);
+        return;
+    }
+    c->state = CLIENT_CONNECTING;
+    c->want_write = true;
+}
+
+// ===== Requests =====
+
+static void send_signup(Client* c)
+{
+    char buffer[512];
+    char phone[16];
+    char email[64];
+    snprintf(phone, sizeof(phone), "%03d%07d", config.shard % 1000, c->index % 10000000);
+    snprintf(email, sizeof(email), "%s@loadgen.test", c->username);
+
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    mpack_start_map(&writer, 8);
+    mpack_write_cstr(&writer, "user");
+    mpack_write_cstr(&writer, c->username);
+    mpack_write_cstr(&writer, "pass");
+    mpack_write_cstr(&writer, LOADGEN_PASSWORD);
+    mpack_write_cstr(&writer, "fullname");
+    mpack_write_cstr(&writer, "Load Generator");
+    mpack_write_cstr(&writer, "phone");
+    mpack_write_cstr(&writer, phone);
+    mpack_write_cstr(&writer, "dob");
+    mpack_write_cstr(&writer, "1990-01-01");
+    mpack_write_cstr(&writer, "email");
+    mpack_write_cstr(&writer, email);
+    mpack_write_cstr(&writer, "country");
+    mpack_write_cstr(&writer, "USA");
+    mpack_write_cstr(&writer, "gender");
+    mpack_write_cstr(&writer, "Other");
+    mpack_finish_map(&writer);
+
+    size_t size = mpack_writer_buffer_used(&writer);
+    if (mpack_writer_destroy(&writer) != mpack_ok) {
+        client_fail(c, &counters.login_failures);
+        return;
+    }
+    c->state = CLIENT_SIGNUP;
+    client_send(c, PACKET_SIGNUP, buffer, size);
+}
+
+static void send_login(Client* c)
+{
+    char buffer[256];
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    mpack_start_map(&writer, 2);
+    mpack_write_cstr(&writer, "user");
+    mpack_write_cstr(&writer, c->username);
+    mpack_write_cstr(&writer, "pass");
+    mpack_write_cstr(&writer, LOADGEN_PASSWORD);
+    mpack_finish_map(&writer);
+
+    size_t size = mpack_writer_buffer_used(&writer);
+    if (mpack_writer_destroy(&writer) != mpack_ok) {
+        client_fail(c, &counters.login_failures);
+        return;
+    }
+    c->state = CLIENT_LOGIN;
+    c->request_ns = metrics_now_ns();
+    client_send(c, PACKET_LOGIN, buffer, size);
+}
+
+static void send_create_table(Client* c)
+{
+    char buffer[256];
+    char name[32];
+    snprintf(name, sizeof(name), "%s%d_t%d", config.prefix, config.shard, c->group);
+
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    mpack_start_map(&writer, 3);
+    mpack_write_cstr(&writer, "name");
+    mpack_write_cstr(&writer, name);
+    mpack_write_cstr(&writer, "max_player");
+    mpack_write_int(&writer, config.seats);
+    mpack_write_cstr(&writer, "min_bet");
+    mpack_write_int(&writer, 10);
+    mpack_finish_map(&writer);
+
+    size_t size = mpack_writer_buffer_used(&writer);
+    if (mpack_writer_destroy(&writer) != mpack_ok) {
+        client_fail(c, &counters.table_failures);
+        return;
+    }
+    c->state = CLIENT_CREATE_TABLE;
+    client_send(c, PACKET_CREATE_TABLE, buffer, size);
+}
+
+static void send_join_table(Client* c, int table_id)
+{
+    char buffer[64];
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    mpack_start_map(&writer, 1);
+    mpack_write_cstr(&writer, "table_id");
+    mpack_write_int(&writer, table_id);
+    mpack_finish_map(&writer);
+
+    size_t size = mpack_writer_buffer_used(&writer);
+    if (mpack_writer_destroy(&writer) != mpack_ok) {
+        client_fail(c, &counters.table_failures);
+        return;
+    }
+    c->state = CLIENT_JOIN;
+    client_send(c, PACKET_JOIN_TABLE, buffer, size);
+}
+
+// Realistic-ish mix: mostly check/call, some aggression, folds only when checking is not possible
+static const LoadAction* choose_action(Client* c)
+{
+    static const char* names[] = {"check", "call", "fold", "bet", "raise", "all_in"};
+    static const int weights[] = {50, 30, 15, 10, 8, 1};
+    bool can_check = false;
+    for (int i = 0; i < c->num_actions; i++) {
+        if (strcmp(c->actions[i].type, "check") == 0) {
+            can_check = true;
+        }
+    }
+
+    int total = 0;
+    int action_weights[LOADGEN_MAX_ACTIONS];
+    for (int i = 0; i < c->num_actions; i++) {
+        action_weights[i] = 0;
+        for (size_t k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+            if (strcmp(c->actions[i].type, names[k]) == 0 && !(can_check && k == 2)) {
+                action_weights[i] = weights[k];
+            }
+        }
+        total += action_weights[i];
+    }
+    if (total == 0) {
+        return c->num_actions > 0 ? &c->actions[0] : NULL;
+    }
+
+    int pick = rand() % total;
+    for (int i = 0; i < c->num_actions; i++) {
+        pick -= action_weights[i];
+        if (pick < 0) {
+            return &c->actions[i];
+        }
+    }
+    return &c->actions[0];
+}
+
+static void send_action(Client* c, uint64_t now)
+{
+    const LoadAction* action = choose_action(c);
+    if (action == NULL) {
+        return;
+    }
+    bool sized = strcmp(action->type, "bet") == 0 || strcmp(action->type, "raise") == 0;
+
+    char buffer[128];
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    mpack_start_map(&writer, 3);
+    mpack_write_cstr(&writer, "game_id");
+    mpack_write_int(&writer, c->game_id);
+    mpack_write_cstr(&writer, "action");
+    mpack_start_map(&writer, sized ? 2 : 1);
+    mpack_write_cstr(&writer, "type");
+    mpack_write_cstr(&writer, action->type);
+    if (sized) {
+        mpack_write_cstr(&writer, "amount");
+        mpack_write_int(&writer, action->min_amount);
+    }
+    mpack_finish_map(&writer);
+    mpack_write_cstr(&writer, "client_seq");
+    mpack_write_u32(&writer, ++c->client_seq);
+    mpack_finish_map(&writer);
+
+    size_t size = mpack_writer_buffer_used(&writer);
+    if (mpack_writer_destroy(&writer) != mpack_ok) {
+        return;
+    }
+
+    c->action_sent_ns = now;
+    Group* group = &groups[c->group];
+    group->action_sent_ns = now;
+    int first = c->group * config.seats;
+    for (int i = first; i < first + config.seats && i < config.clients; i++) {
+        if (i != c->index && clients[i].state == CLIENT_PLAYING) {
+            clients[i].awaiting_fanout = true;
+        }
+    }
+    client_send(c, PACKET_ACTION_REQUEST, buffer, size);
+}
+
+// ===== Responses =====
+
+// Value of an integer key in a flat response map, -1 if missing
+static int read_int_key(const char* payload, size_t len, const char* wanted)
+{
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, payload, len);
+    uint32_t count = mpack_expect_map(&reader);
+    int value = -1;
+    for (uint32_t i = 0; i < count && mpack_reader_error(&reader) == mpack_ok; i++) {
+        char key[32];
+        mpack_expect_cstr(&reader, key, sizeof(key));
+        if (strcmp(key, wanted) == 0) {
+            value = mpack_expect_int(&reader);
+        } else {
+            mpack_discard(&reader);
+        }
+    }
+    bool ok = mpack_reader_destroy(&reader) == mpack_ok;
+    return ok ? value : -1;
+}
+
+static void handle_game_state(Client* c, const char* payload, size_t len, uint64_t now)
+{
+    if (c->awaiting_fanout) {
+        metrics_histogram_add(&fanout_delay, now - groups[c->group].action_sent_ns);
+        c->awaiting_fanout = false;
+    }
+
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, payload, len);
+    uint32_t count = mpack_expect_map(&reader);
+    int game_id = c->game_id;
+    uint32_t hand_id = 0;
+    int num_actions = 0;
+    for (uint32_t i = 0; i < count && mpack_reader_error(&reader) == mpack_ok; i++) {
+        char key[32];
+        mpack_expect_cstr(&reader, key, sizeof(key));
+        if (strcmp(key, "game_id") == 0) {
+            game_id = mpack_expect_int(&reader);
+        } else if (strcmp(key, "hand_id") == 0) {
+            hand_id = mpack_expect_u32(&reader);
+        } else if (strcmp(key, "available_actions") == 0) {
+            uint32_t n = mpack_expect_array(&reader);
+            for (uint32_t a = 0; a < n && mpack_reader_error(&reader) == mpack_ok; a++) {
+                LoadAction action = {0};
+                uint32_t fields = mpack_expect_map(&reader);
+                for (uint32_t f = 0; f < fields; f++) {
+                    char field[32];
+                    mpack_expect_cstr(&reader, field, sizeof(field));
+                    if (strcmp(field, "type") == 0) {
+                        mpack_expect_cstr(&reader, action.type, sizeof(action.type));
+                    } else if (strcmp(field, "min_amount") == 0) {
+                        action.min_amount = mpack_expect_int(&reader);
+                    } else {
+                        mpack_discard(&reader);
+                    }
+                }
+                mpack_done_map(&reader);
+                if (num_actions < LOADGEN_MAX_ACTIONS) {
+                    c->actions[num_actions++] = action;
+                }
+            }
+            mpack_done_array(&reader);
+        } else {
+            mpack_discard(&reader);
+        }
+    }
+    if (mpack_reader_destroy(&reader) != mpack_ok) {
+        return;
+    }
+
+    c->game_id = game_id;
+    Group* group = &groups[c->group];
+    if (hand_id > group->hand_id) {
+        if (group->hand_id != 0) {
+            counters.hands++;
+        }
+        group->hand_id = hand_id;
+    }
+
+    // Our turn: act after a think time of 0.5x-1.5x the configured mean
+    c->num_actions = num_actions;
+    if (num_actions > 0 && c->act_at_ns == 0 && c->action_sent_ns == 0) {
+        uint64_t think_ns = (uint64_t)config.think_ms * 1000000ull;
+        c->act_at_ns = now + think_ns / 2 + (think_ns > 0 ? (uint64_t)rand() % think_ns : 0);
+        timer_push(c->act_at_ns, c->index);
+    } else if (num_actions == 0) {
+        c->act_at_ns = 0; // Turn timed out or the hand moved on
+    }
+}
+
+static void handle_packet(Client* c, uint16_t packet_type, const char* payload, size_t len, uint64_t now)
+{
+    counters.packets_in++;
+    int first = c->group * config.seats;
+
+    switch (c->state) {
+    case CLIENT_SIGNUP:
+        if (packet_type == PACKET_SIGNUP) {
+            send_login(c); // R_SIGNUP_NOT_OK usually means the account exists from an earlier run
+        }
+        break;
+
+    case CLIENT_LOGIN:
+        if (packet_type != PACKET_LOGIN) {
+            break;
+        }
+        if (read_int_key(payload, len, "result") != R_LOGIN_OK) {
+            client_fail(c, &counters.login_failures);
+            break;
+        }
+        metrics_histogram_add(&login_rtt, now - c->request_ns);
+        if (c->index == first) {
+            send_create_table(c);
+        } else if (groups[c->group].table_id > 0) {
+            send_join_table(c, groups[c->group].table_id);
+        } else {
+            c->state = CLIENT_WAIT_TABLE;
+        }
+        break;
+
+    case CLIENT_CREATE_TABLE:
+        if (packet_type != PACKET_CREATE_TABLE) {
+            break;
+        }
+        if (read_int_key(payload, len, "res") != R_CREATE_TABLE_OK) {
+            client_fail(c, &counters.table_failures);
+            break;
+        }
+        groups[c->group].table_id = read_int_key(payload, len, "table_id");
+        c->state = CLIENT_PLAYING;
+        for (int i = first + 1; i < first + config.seats && i < config.clients; i++) {
+            if (clients[i].state == CLIENT_WAIT_TABLE) {
+                send_join_table(&clients[i], groups[c->group].table_id);
+            }
+        }
+        break;
+
+    case CLIENT_JOIN:
+        if (packet_type != PACKET_JOIN_TABLE) {
+            break;
+        }
+        // Success carries the game state, failure a {"res": code} map
+        if (read_int_key(payload, len, "res") != -1) {
+            client_fail(c, &counters.table_failures);
+            break;
+        }
+        c->state = CLIENT_PLAYING;
+        handle_game_state(c, payload, len, now);
+        break;
+
+    case CLIENT_PLAYING:
+        if (packet_type == PACKET_UPDATE_GAMESTATE || packet_type == PACKET_UPDATE_BUNDLE) {
+            handle_game_state(c, payload, len, now);
+        } else if (packet_type == PACKET_ACTION_RESULT && c->action_sent_ns != 0) {
+            if (read_int_key(payload, len, "client_seq") == (int)c->client_seq) {
+                metrics_histogram_add(&action_rtt, now - c->action_sent_ns);
+                counters.actions++;
+                if (read_int_key(payload, len, "result") != 0) {
+                    counters.action_rejects++;
+                }
+                c->action_sent_ns = 0;
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void client_read(Client* c, uint64_t now)
+{
+    for (;;) {
+        ssize_t n = recv(c->fd, c->rx + c->rx_len, LOADGEN_RX_BUFFER - c->rx_len, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            client_fail(c, &counters.disconnects);
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+        counters.bytes_in += (uint64_t)n;
+        c->rx_len += (size_t)n;
+
+        // Several packets can arrive in one read and a packet can span reads
+        size_t offset = 0;
+        while (c->rx_len - offset >= sizeof(Header)) {
+            uint16_t packet_len = ntohs(*(uint16_t*)&c->rx[offset]);
+            uint16_t packet_type = ntohs(*(uint16_t*)&c->rx[offset + 3]);
+            if (packet_len < sizeof(Header)) {
+                client_fail(c, &counters.disconnects);
+                return;
+            }
+            if (c->rx_len - offset < packet_len) {
+                break;
+            }
+            handle_packet(c, packet_type, c->rx + offset + sizeof(Header), packet_len - sizeof(Header), now);
+            if (c->state == CLIENT_FAILED) {
+                return;
+            }
+            offset += packet_len;
+        }
+        memmove(c->rx, c->rx + offset, c->rx_len - offset);
+        c->rx_len -= offset;
+    }
+}
+
+static void client_writable(Client* c)
+{
+    if (c->state == CLIENT_CONNECTING) {
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &error, &error_len) == -1 || error != 0) {
+            client_fail(c, &counters.connect_errors);
+            return;
+        }
+        if (config.signup) {
+            send_signup(c);
+        } else {
+            send_login(c);
+        }
+        return;
+    }
+    client_flush(c);
+}
+
+// ===== Reporting =====
+
+static void print_histogram(const char* name, const MetricsHistogram* h)
+{
+    printf("  %-18s n=%-9llu p50=%8.3fms p99=%8.3fms p999=%8.3fms max=%8.3fms\n", name,
+           (unsigned long long)h->count, metrics_percentile(h, 0.5) / 1e6, metrics_percentile(h, 0.99) / 1e6,
+           metrics_percentile(h, 0.999) / 1e6, h->max_ns / 1e6);
+}
+
+static void print_progress(double elapsed_s, double interval_s)
+{
+    int connected = 0;
+    int playing = 0;
+    for (int i = 0; i < config.clients; i++) {
+        connected += clients[i].fd != -1;
+        playing += clients[i].state == CLIENT_PLAYING;
+    }
+    printf("[%6.1fs] connected=%d playing=%d actions/s=%.1f hands/s=%.2f rx=%.1fKB/s p99 rtt=%.3fms "
+           "p99 fanout=%.3fms\n",
+           elapsed_s, connected, playing, (counters.actions - last_counters.actions) / interval_s,
+           (counters.hands - last_counters.hands) / interval_s,
+           (counters.bytes_in - last_counters.bytes_in) / interval_s / 1024.0,
+           metrics_percentile(&action_rtt, 0.99) / 1e6, metrics_percentile(&fanout_delay, 0.99) / 1e6);
+    fflush(stdout);
+    last_counters = counters;
+}
+
+static void print_summary(double elapsed_s)
+{
+    printf("\nShard %d/%d: %d clients, %d seats per table, %.1fs\n", config.shard, config.num_shards,
+           config.clients, config.seats, elapsed_s);
+    printf("Throughput:\n");
+    printf("  actions            %llu (%.1f/s), %llu rejected by the server\n", (unsigned long long)counters.actions,
+           counters.actions / elapsed_s, (unsigned long long)counters.action_rejects);
+    printf("  hands              %llu (%.2f/s)\n", (unsigned long long)counters.hands, counters.hands / elapsed_s);
+    printf("  packets in         %llu (%.1f/s)\n", (unsigned long long)counters.packets_in,
+           counters.packets_in / elapsed_s);
+    printf("  bytes in/out       %llu / %llu (%.1f / %.1f KB/s)\n", (unsigned long long)counters.bytes_in,
+           (unsigned long long)counters.bytes_out, counters.bytes_in / elapsed_s / 1024.0,
+           counters.bytes_out / elapsed_s / 1024.0);
+    printf("Latency:\n");
+    print_histogram("action round trip", &action_rtt);
+    print_histogram("fan-out delay", &fanout_delay);
+    print_histogram("login round trip", &login_rtt);
+    printf("Errors: connect=%llu login=%llu table=%llu disconnects=%llu\n",
+           (unsigned long long)counters.connect_errors, (unsigned long long)counters.login_failures,
+           (unsigned long long)counters.table_failures, (unsigned long long)counters.disconnects);
+}
+
+// ===== Main =====
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [--host H] [--port P] [--clients N] [--seats S] [--duration SEC] [--think-ms MS]\n"
+            "          [--ramp CONN_PER_SEC] [--shard I/N] [--prefix NAME] [--no-signup]\n",
+            program);
+}
+
+static int parse_args(int argc, char* argv[])
+{
+    static struct option options[] = {
+        {"host", required_argument, NULL, 'h'},     {"port", required_argument, NULL, 'p'},
+        {"clients", required_argument, NULL, 'c'},  {"seats", required_argument, NULL, 's'},
+        {"duration", required_argument, NULL, 'd'}, {"think-ms", required_argument, NULL, 't'},
+        {"ramp", required_argument, NULL, 'r'},     {"shard", required_argument, NULL, 'S'},
+        {"prefix", required_argument, NULL, 'P'},   {"no-signup", no_argument, NULL, 'n'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (opt) {
+        case 'h': config.host = optarg; break;
+        case 'p': config.port = optarg; break;
+        case 'c': config.clients = atoi(optarg); break;
+        case 's': config.seats = atoi(optarg); break;
+        case 'd': config.duration_s = atoi(optarg); break;
+        case 't': config.think_ms = atoi(optarg); break;
+        case 'r': config.ramp = atoi(optarg); break;
+        case 'P': config.prefix = optarg; break;
+        case 'n': config.signup = false; break;
+        case 'S':
+            if (sscanf(optarg, "%d/%d", &config.shard, &config.num_shards) != 2) {
+                return -1;
+            }
+            break;
+        default: return -1;
+        }
+    }
+
+    if (config.clients <= 0 || config.seats < 2 || config.seats > MAX_PLAYERS || config.duration_s <= 0 ||
+        config.think_ms < 0 || config.ramp <= 0 || config.num_shards <= 0 || config.shard < 0 ||
+        config.shard >= config.num_shards) {
+        return -1;
+    }
+    return 0;
+}
+
+static int resolve_server(void)
+{
+    struct addrinfo hints = {0};
+    struct addrinfo* info;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int rv = getaddrinfo(config.host, config.port, &hints, &info);
+    if (rv != 0) {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(rv));
+        return -1;
+    }
+    memcpy(&server_addr, info->ai_addr, info->ai_addrlen);
+    server_addr_len = info->ai_addrlen;
+    freeaddrinfo(info);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (parse_args(argc, argv) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (resolve_server() != 0) {
+        return 1;
+    }
+    srand((unsigned int)(time(NULL) ^ ((unsigned int)config.shard << 16)));
+
+    // One fd per client
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int num_groups = (config.clients + config.seats - 1) / config.seats;
+    clients = calloc(config.clients, sizeof(Client));
+    groups = calloc(num_groups, sizeof(Group));
+    epoll_fd = epoll_create1(0);
+    struct epoll_event* events = calloc(LOADGEN_MAX_EVENTS, sizeof(struct epoll_event));
+    if (!clients || !groups || !events || epoll_fd == -1) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < config.clients; i++) {
+        Client* c = &clients[i];
+        c->index = i;
+        c->fd = -1;
+        c->group = i / config.seats;
+        c->rx = malloc(LOADGEN_RX_BUFFER);
+        if (c->rx == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        snprintf(c->username, sizeof(c->username), "%s%d_%d", config.prefix, config.shard, i);
+    }
+
+    printf("Load test: %d clients against %s:%s, shard %d/%d, %d seats per table, think %dms, ramp %d/s\n",
+           config.clients, config.host, config.port, config.shard, config.num_shards, config.seats,
+           config.think_ms, config.ramp);
+
+    uint64_t start_ns = metrics_now_ns();
+    uint64_t end_ns = start_ns + (uint64_t)config.duration_s * 1000000000ull;
+    uint64_t next_report_ns = start_ns + LOADGEN_REPORT_INTERVAL_S * 1000000000ull;
+    uint64_t last_report_ns = start_ns;
+    int next_client = 0;
+
+    for (;;) {
+        uint64_t now = metrics_now_ns();
+        if (now >= end_ns) {
+            break;
+        }
+
+        // Ramp up at config.ramp connections per second
+        uint64_t ramp_due = start_ns + (uint64_t)next_client * 1000000000ull / (uint64_t)config.ramp;
+        while (next_client < config.clients && now >= ramp_due) {
+            client_connect(&clients[next_client++]);
+            ramp_due = start_ns + (uint64_t)next_client * 1000000000ull / (uint64_t)config.ramp;
+        }
+
+        // Think times that are over
+        while (num_timers > 0 && timers[0].due_ns <= now) {
+            Timer timer = timer_pop();
+            Client* c = &clients[timer.client];
+            if (c->state == CLIENT_PLAYING && c->act_at_ns == timer.due_ns) {
+                c->act_at_ns = 0;
+                send_action(c, now);
+            }
+        }
+
+        if (now >= next_report_ns) {
+            print_progress((now - start_ns) / 1e9, (now - last_report_ns) / 1e9);
+            last_report_ns = now;
+            next_report_ns += LOADGEN_REPORT_INTERVAL_S * 1000000000ull;
+        }
+
+        uint64_t wake_ns = end_ns < next_report_ns ? end_ns : next_report_ns;
+        if (next_client < config.clients && ramp_due < wake_ns) {
+            wake_ns = ramp_due;
+        }
+        if (num_timers > 0 && timers[0].due_ns < wake_ns) {
+            wake_ns = timers[0].due_ns;
+        }
+        int timeout_ms = wake_ns > now ? (int)((wake_ns - now + 999999) / 1000000) : 0;
+
+        int n = epoll_wait(epoll_fd, events, LOADGEN_MAX_EVENTS, timeout_ms);
+        now = metrics_now_ns();
+        for (int i = 0; i < n; i++) {
+            Client* c = &clients[events[i].data.u32];
+            if (c->fd == -1) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP) && c->state == CLIENT_CONNECTING) {
+                client_fail(c, &counters.connect_errors);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                client_writable(c);
+            }
+            if (c->fd != -1 && events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                client_read(c, now);
+            }
+        }
+    }
+
+    print_progress((metrics_now_ns() - start_ns) / 1e9, (metrics_now_ns() - last_report_ns) / 1e9);
+    print_summary((metrics_now_ns() - start_ns) / 1e9);
+
+    for (int i = 0; i < config.clients; i++) {
+        if (clients[i].fd != -1) {
+            close(clients[i].fd);
+        }
+        free(clients[i].rx);
+    }
+    free(clients);
+    free(groups);
+    free(timers);
+    free(events);
+    close(epoll_fd);
+    return counters.actions > 0 ? 0 : 1;
+}
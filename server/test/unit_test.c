@@ -1,4 +1,6 @@
 #include "test.h"
+#include <pthread.h>
+#include <sys/un.h>
 
 TEST(test_decode_packet)
 {
@@ -237,6 +239,1264 @@ TEST(test_encode_full_tables_resp)
     }
 }
 
+TEST(test_lobby_tables_packet_cache)
+{
+    TableList* table_list = init_table_list(2);
+    add_table(table_list, "Lobby 1", 6, 100);
+
+    uint64_t version = lobby_version();
+    const RawBytes* first = lobby_tables_packet(table_list);
+    const RawBytes* again = lobby_tables_packet(table_list);
+    ASSERT(first != NULL);
+    ASSERT(first == again); // Unchanged lobby serves the same bytes
+    ASSERT(lobby_version() == version);
+
+    Header* header = decode_header(first->data);
+    ASSERT(header->packet_type == PACKET_TABLES);
+    ASSERT(header->packet_len == first->len);
+    free(header);
+
+    // Seat count change invalidates; the rebuilt snapshot carries the new count
+    table_list->tables[0].current_player = 3;
+    lobby_invalidate();
+    ASSERT(lobby_version() > version);
+    const RawBytes* updated = lobby_tables_packet(table_list);
+    RawBytes* expected = encode_full_tables_response(table_list);
+    ASSERT(updated->len == expected->len + sizeof(Header));
+    ASSERT(compare_raw_bytes(updated->data + sizeof(Header), expected->data, expected->len) == 1);
+
+    // Creating a table invalidates without an explicit call
+    version = lobby_version();
+    add_table(table_list, "Lobby 2", 4, 50);
+    ASSERT(lobby_version() > version);
+
+    free(expected->data);
+    free(expected);
+    free_table_list(table_list);
+}
+
+TEST(test_lobby_subscription_delta)
+{
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    TableList* table_list = init_table_list(4);
+    int kept = add_table(table_list, "Kept", 6, 100);
+    int dropped = add_table(table_list, "Dropped", 4, 50);
+    ASSERT(lobby_subscribe(fds[0], table_list) == 0);
+    ASSERT(lobby_subscriber_count() == 1);
+
+    // Several changes inside one tick go out as a single delta
+    table_list->tables[find_table_by_id(table_list, kept)].current_player = 2;
+    lobby_invalidate();
+    remove_table(table_list, dropped);
+    int created = add_table(table_list, "Created", 9, 200);
+    lobby_flush(table_list);
+
+    char buf[1024];
+    ssize_t n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+    ASSERT(n > (ssize_t) sizeof(Header));
+    Packet* packet = decode_packet(buf, n);
+    ASSERT(packet->header->packet_type == PACKET_LOBBY_DELTA);
+    ASSERT(packet->header->packet_len == n);
+
+    mpack_reader_t reader;
+    mpack_reader_init(&reader, packet->data, n - sizeof(Header), n - sizeof(Header));
+    mpack_expect_map_match(&reader, 4);
+    mpack_expect_cstr_match(&reader, "version");
+    ASSERT(mpack_expect_u64(&reader) == lobby_version());
+    mpack_expect_cstr_match(&reader, "removed");
+    ASSERT(mpack_expect_array(&reader) == 1);
+    ASSERT(mpack_expect_i32(&reader) == dropped);
+    mpack_done_array(&reader);
+    mpack_expect_cstr_match(&reader, "added");
+    ASSERT(mpack_expect_array(&reader) == 1);
+    mpack_expect_map_match(&reader, 5);
+    mpack_expect_cstr_match(&reader, "id");
+    ASSERT(mpack_expect_i32(&reader) == created);
+    mpack_expect_cstr_match(&reader, "tableName");
+    char name[32];
+    mpack_expect_cstr(&reader, name, sizeof(name));
+    ASSERT(strcmp(name, "Created") == 0);
+    mpack_expect_cstr_match(&reader, "maxPlayer");
+    ASSERT(mpack_expect_i32(&reader) == 9);
+    mpack_expect_cstr_match(&reader, "minBet");
+    ASSERT(mpack_expect_i32(&reader) == 200);
+    mpack_expect_cstr_match(&reader, "currentPlayer");
+    ASSERT(mpack_expect_i32(&reader) == 0);
+    mpack_done_map(&reader);
+    mpack_done_array(&reader);
+    mpack_expect_cstr_match(&reader, "updated");
+    ASSERT(mpack_expect_array(&reader) == 1);
+    mpack_expect_map_match(&reader, 2);
+    mpack_expect_cstr_match(&reader, "id");
+    ASSERT(mpack_expect_i32(&reader) == kept);
+    mpack_expect_cstr_match(&reader, "currentPlayer");
+    ASSERT(mpack_expect_i32(&reader) == 2);
+    mpack_done_map(&reader);
+    mpack_done_array(&reader);
+    mpack_done_map(&reader);
+    ASSERT(mpack_reader_destroy(&reader) == mpack_ok);
+    free_packet(packet);
+
+    // Nothing changed since: no push
+    lobby_flush(table_list);
+    ASSERT(recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT) == -1);
+
+    // A client subscribing mid-tick is given the lobby as it is now: the pending change goes out to the
+    // others at once, so the next delta does not repeat it to the newcomer
+    int late[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, late) == 0);
+    table_list->tables[find_table_by_id(table_list, kept)].current_player = 3;
+    lobby_invalidate();
+    ASSERT(lobby_subscribe(late[0], table_list) == 0);
+    n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+    ASSERT(n > (ssize_t) sizeof(Header));
+    packet = decode_packet(buf, n);
+    ASSERT(packet->header->packet_type == PACKET_LOBBY_DELTA);
+    free_packet(packet);
+    lobby_flush(table_list);
+    ASSERT(recv(late[1], buf, sizeof(buf), MSG_DONTWAIT) == -1);
+    lobby_unsubscribe(late[0]);
+    close(late[0]);
+    close(late[1]);
+
+    lobby_unsubscribe(fds[0]);
+    ASSERT(lobby_subscriber_count() == 0);
+    free_table_list(table_list);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(test_lobby_delta_split)
+{
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    TableList* table_list = init_table_list(4);
+    ASSERT(lobby_subscribe(fds[0], table_list) == 0);
+
+    // More changes than one packet holds go out as several deltas of the same version
+    int num_created = LOBBY_DELTA_MAX_ENTRIES + 10;
+    for (int i = 0; i < num_created; i++)
+    {
+        add_table(table_list, "Table with a rather long name", 9, 1000);
+    }
+    ASSERT(table_list->size == (size_t) num_created);
+    lobby_flush(table_list);
+
+    static char buf[2 * UINT16_MAX];
+    size_t len = 0;
+    ssize_t n;
+    while ((n = recv(fds[1], buf + len, sizeof(buf) - len, MSG_DONTWAIT)) > 0)
+    {
+        len += (size_t) n;
+    }
+
+    int num_packets = 0;
+    int num_added = 0;
+    for (size_t offset = 0; offset + sizeof(Header) <= len;)
+    {
+        uint16_t packet_len = ntohs(*(uint16_t*) (buf + offset));
+        ASSERT(packet_len > sizeof(Header) && offset + packet_len <= len);
+        Packet* packet = decode_packet(buf + offset, packet_len);
+        ASSERT(packet->header->packet_type == PACKET_LOBBY_DELTA);
+
+        mpack_reader_t reader;
+        mpack_reader_init(&reader, packet->data, packet_len - sizeof(Header), packet_len - sizeof(Header));
+        mpack_expect_map_match(&reader, 4);
+        mpack_expect_cstr_match(&reader, "version");
+        ASSERT(mpack_expect_u64(&reader) == lobby_version());
+        mpack_expect_cstr_match(&reader, "removed");
+        ASSERT(mpack_expect_array(&reader) == 0);
+        mpack_done_array(&reader);
+        mpack_expect_cstr_match(&reader, "added");
+        int count = (int) mpack_expect_array(&reader);
+        ASSERT(count > 0 && count <= LOBBY_DELTA_MAX_ENTRIES);
+        num_added += count;
+        ASSERT(mpack_reader_error(&reader) == mpack_ok);
+        free_packet(packet);
+
+        offset += packet_len;
+        num_packets++;
+    }
+    ASSERT(num_packets == 2);
+    ASSERT(num_added == num_created);
+
+    // Both packets were sent, so the next flush has nothing left to push
+    lobby_flush(table_list);
+    ASSERT(recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT) == -1);
+
+    lobby_unsubscribe(fds[0]);
+    free_table_list(table_list);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(test_lobby_query_tables)
+{
+    TableList* table_list = init_table_list(8);
+    add_table(table_list, "Alpha", 6, 100);
+    add_table(table_list, "alpine", 9, 50);
+    add_table(table_list, "Beta", 4, 200);
+    add_table(table_list, "Gamma", 6, 100);
+    int full = add_table(table_list, "Albatross", 2, 400);
+    Table* table = &table_list->tables[find_table_by_id(table_list, full)];
+    table->current_player = 2;
+    lobby_table_seats_changed(table);
+
+    // Decode a client query: stakes 50..200, at least one free seat, two per page
+    char buffer[256];
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, sizeof(buffer));
+    mpack_start_map(&writer, 4);
+    mpack_write_cstr(&writer, "minBet");
+    mpack_write_i32(&writer, 50);
+    mpack_write_cstr(&writer, "maxBet");
+    mpack_write_i32(&writer, 200);
+    mpack_write_cstr(&writer, "minFreeSeats");
+    mpack_write_i32(&writer, 1);
+    mpack_write_cstr(&writer, "limit");
+    mpack_write_i32(&writer, 2);
+    mpack_finish_map(&writer);
+    size_t len = mpack_writer_buffer_used(&writer);
+    ASSERT(mpack_writer_destroy(&writer) == mpack_ok);
+
+    TablesQuery query;
+    ASSERT(decode_tables_query(buffer, len, &query) == 0);
+    ASSERT(query.sort == TABLES_SORT_STAKES && query.limit == 2 && !query.has_cursor);
+
+    // Walk the pages: ascending stakes, ties broken by id, "Albatross" filtered out by stakes
+    TableSummary page[TABLES_PAGE_MAX];
+    TablesQuery next;
+    bool has_more;
+    int count = lobby_query_tables(&query, page, &next, &has_more);
+    ASSERT(count == 2 && has_more);
+    ASSERT(strcmp(page[0].name, "alpine") == 0 && strcmp(page[1].name, "Alpha") == 0);
+    count = lobby_query_tables(&next, page, &next, &has_more);
+    ASSERT(count == 2 && !has_more);
+    ASSERT(strcmp(page[0].name, "Gamma") == 0 && strcmp(page[1].name, "Beta") == 0);
+
+    // Case-insensitive name prefix, most free seats first
+    memset(&query, 0, sizeof(query));
+    query.min_bet = -1;
+    query.max_bet = -1;
+    strcpy(query.name_prefix, "al");
+    query.sort = TABLES_SORT_FREE_SEATS;
+    query.desc = true;
+    query.limit = TABLES_PAGE_MAX;
+    count = lobby_query_tables(&query, page, &next, &has_more);
+    ASSERT(count == 3 && !has_more);
+    ASSERT(strcmp(page[0].name, "alpine") == 0 && strcmp(page[2].name, "Albatross") == 0);
+
+    query.sort = TABLES_SORT_NAME;
+    query.desc = false;
+    count = lobby_query_tables(&query, page, &next, &has_more);
+    ASSERT(count == 3);
+    ASSERT(strcmp(page[0].name, "Albatross") == 0 && strcmp(page[2].name, "alpine") == 0);
+
+    // Removal drops the table from every index
+    remove_table(table_list, full);
+    count = lobby_query_tables(&query, page, &next, &has_more);
+    ASSERT(count == 2);
+
+    free_table_list(table_list);
+}
+
+TEST(test_spectator_shared_fanout)
+{
+    int first[2];
+    int second[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, first) == 0);
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, second) == 0);
+
+    TableList* table_list = init_table_list(2);
+    int table_id = add_table(table_list, "Watched", 6, 100);
+    Table* table = &table_list->tables[find_table_by_id(table_list, table_id)];
+    game_add_player(table->game_state, 7, "seated", 0, 1000);
+    game_add_player(table->game_state, 8, "other", 1, 1000);
+    game_start_hand(table->game_state);
+
+    spectator_configure(table_id, 0, 0);
+    ASSERT(spectator_add(first[0], table) == 0);
+    ASSERT(spectator_add(second[0], table) == 0);
+    ASSERT(spectator_count(table_id) == 2);
+
+    // Both watchers get the same public frame: no hole cards before showdown
+    spectator_flush(table_list);
+    char a[MAXLINE];
+    char b[MAXLINE];
+    ssize_t na = recv(first[1], a, sizeof(a), MSG_DONTWAIT);
+    ssize_t nb = recv(second[1], b, sizeof(b), MSG_DONTWAIT);
+    ASSERT(na > 0 && na == nb);
+    ASSERT(compare_raw_bytes(a, b, na) == 1);
+    Packet* packet = decode_packet(a, na);
+    ASSERT(packet->header->packet_type == PACKET_UPDATE_GAMESTATE);
+    free_packet(packet);
+    RawBytes* public_state = encode_game_state(table->game_state, 0);
+    ASSERT(public_state->len == na - sizeof(Header));
+    ASSERT(compare_raw_bytes(a + sizeof(Header), public_state->data, public_state->len) == 1);
+    free(public_state->data);
+    free(public_state);
+
+    // Throttled: a change inside the interval is held back
+    spectator_configure(table_id, -1, 60000);
+    spectator_state_changed(table);
+    ASSERT(recv(first[1], a, sizeof(a), MSG_DONTWAIT) == -1);
+
+    // Delayed: the frame is encoded now but released only after the delay
+    spectator_configure(table_id, 30, 0);
+    spectator_state_changed(table);
+    ASSERT(recv(first[1], a, sizeof(a), MSG_DONTWAIT) == -1);
+    usleep(40 * 1000);
+    spectator_flush(table_list);
+    ASSERT(recv(first[1], a, sizeof(a), MSG_DONTWAIT) > 0);
+
+    spectator_remove(first[0]);
+    ASSERT(spectator_count(table_id) == 1);
+    game_state_destroy(table->game_state);
+    remove_table(table_list, table_id);
+    ASSERT(spectator_count(table_id) == 0);
+
+    free_table_list(table_list);
+    close(first[0]);
+    close(first[1]);
+    close(second[0]);
+    close(second[1]);
+}
+
+TEST(test_leaderboard_incremental)
+{
+    leaderboard_free();
+    for (int user_id = 1; user_id <= LEADERBOARD_SIZE + 10; user_id++)
+    {
+        leaderboard_set_balance(user_id, user_id * 100);
+    }
+    ASSERT(leaderboard_size() == LEADERBOARD_SIZE + 10);
+
+    dbRanking top[LEADERBOARD_SIZE];
+    ASSERT(leaderboard_top(top, LEADERBOARD_SIZE) == LEADERBOARD_SIZE);
+    ASSERT(top[0].user_id == LEADERBOARD_SIZE + 10 && top[0].balance == (LEADERBOARD_SIZE + 10) * 100);
+
+    // Changes below the top keep the cached packet
+    const RawBytes* packet = leaderboard_packet();
+    ASSERT(packet != NULL);
+    leaderboard_add_balance(1, 50);
+    ASSERT(leaderboard_packet() == packet);
+
+    // Climbing into the top rebuilds it; equal balances rank by user id
+    leaderboard_add_balance(2, 100000);
+    leaderboard_set_balance(3, 100200);
+    const RawBytes* updated = leaderboard_packet();
+    ASSERT(updated != NULL);
+    leaderboard_top(top, 2);
+    ASSERT(top[0].user_id == 2 && top[0].balance == 100200);
+    ASSERT(top[1].user_id == 3);
+
+    Header* header = decode_header(updated->data);
+    ASSERT(header->packet_type == PACKET_SCOREBOARD);
+    free(header);
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, updated->data + sizeof(Header), updated->len - sizeof(Header));
+    ASSERT(mpack_expect_array(&reader) == LEADERBOARD_SIZE);
+    mpack_expect_map_match(&reader, 3);
+    mpack_expect_cstr_match(&reader, "rank");
+    ASSERT(mpack_expect_i32(&reader) == 1);
+    mpack_expect_cstr_match(&reader, "id");
+    ASSERT(mpack_expect_i32(&reader) == 2);
+    mpack_reader_destroy(&reader);
+
+    // Falling out of the top also rebuilds it
+    leaderboard_set_balance(2, 0);
+    ASSERT(leaderboard_top(top, 1) == 1 && top[0].user_id == 3);
+
+    // Unknown users only enter through an absolute balance
+    leaderboard_add_balance(999, 100);
+    ASSERT(leaderboard_size() == LEADERBOARD_SIZE + 10);
+    leaderboard_free();
+}
+
+TEST(test_social_cache_write_through)
+{
+    social_cache_free();
+    dbFriendList* friends = malloc(sizeof(dbFriendList));
+    friends->num = 1;
+    friends->friends = calloc(1, sizeof(dbFriend));
+    friends->friends[0].user_id = 2;
+    strcpy(friends->friends[0].user_name, "bob");
+    dbInviteList* invites = malloc(sizeof(dbInviteList));
+    invites->num = 0;
+    invites->invites = NULL;
+    ASSERT(social_cache_adopt(1, friends, invites) == 0);
+
+    dbFriendList* carol_friends = calloc(1, sizeof(dbFriendList));
+    dbInviteList* carol_invites = calloc(1, sizeof(dbInviteList));
+    ASSERT(social_cache_adopt(3, carol_friends, carol_invites) == 0);
+    ASSERT(social_cache_size() == 2);
+
+    ASSERT(social_cache_is_friend(1, 2) == 1);
+    ASSERT(social_cache_is_friend(1, 3) == 0);
+    ASSERT(social_cache_is_friend(2, 1) == -1);
+    ASSERT(social_cache_friend_id(1, "bob") == 2);
+    ASSERT(social_cache_friend_id(1, "carol") == 0);
+
+    // alice (1) invites carol (3): only carol's entry holds the invite, newest first
+    dbInvite invite = {0};
+    invite.invite_id = 10;
+    invite.from_user_id = 1;
+    invite.to_user_id = 3;
+    strcpy(invite.from_username, "alice");
+    strcpy(invite.status, "pending");
+    social_cache_invite_sent(&invite);
+    invite.invite_id = 11;
+    invite.from_user_id = 4;
+    strcpy(invite.from_username, "dave");
+    social_cache_invite_sent(&invite);
+    ASSERT(social_cache_has_invite_from(3, 1) == 1);
+    ASSERT(social_cache_has_invite_from(1, 3) == 0);
+    ASSERT(social_cache_invites(3)->num == 2);
+    ASSERT(social_cache_invites(3)->invites[0].invite_id == 11);
+
+    // carol accepts: the invite goes away and both cached users see the friendship
+    dbInvite accepted;
+    ASSERT(social_cache_get_invite(3, 10, &accepted) == 0);
+    social_cache_invite_removed(3, 10);
+    social_cache_friendship_added(3, "carol", accepted.from_user_id, accepted.from_username);
+    ASSERT(social_cache_get_invite(3, 10, &accepted) == -1);
+    ASSERT(social_cache_invites(3)->num == 1);
+    ASSERT(social_cache_friend_id(3, "alice") == 1);
+    ASSERT(social_cache_friend_id(1, "carol") == 3);
+    ASSERT(social_cache_friends(1)->num == 2);
+
+    // Adding an existing friend again is a no-op
+    social_cache_friendship_added(1, "alice", 3, "carol");
+    ASSERT(social_cache_friends(1)->num == 2);
+
+    // Entries are reference counted per logged-in connection
+    ASSERT(social_cache_load(NULL, 1) == 0);
+    social_cache_release(1);
+    ASSERT(social_cache_has(1));
+    social_cache_release(1);
+    ASSERT(!social_cache_has(1));
+    ASSERT(social_cache_friends(1) == NULL);
+    social_cache_free();
+    ASSERT(social_cache_size() == 0);
+}
+
+// Reads one PACKET_PRESENCE_UPDATE from fd; returns the number of changes (the first one in *first), -1 if none
+static int read_presence_update(int fd, PresenceChange* first)
+{
+    char buf[MAXLINE];
+    ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n <= (ssize_t) sizeof(Header))
+    {
+        return -1;
+    }
+    Header* header = decode_header(buf);
+    int type = header->packet_type;
+    free(header);
+    if (type != PACKET_PRESENCE_UPDATE)
+    {
+        return -1;
+    }
+
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, buf + sizeof(Header), n - sizeof(Header));
+    mpack_expect_map_match(&reader, 1);
+    mpack_expect_cstr_match(&reader, "friends");
+    int count = (int) mpack_expect_array(&reader);
+    if (count > 0)
+    {
+        char status[16];
+        mpack_expect_map_match(&reader, 4);
+        mpack_expect_cstr_match(&reader, "id");
+        first->user_id = mpack_expect_i32(&reader);
+        mpack_expect_cstr_match(&reader, "username");
+        mpack_expect_cstr(&reader, first->username, sizeof(first->username));
+        mpack_expect_cstr_match(&reader, "status");
+        mpack_expect_cstr(&reader, status, sizeof(status));
+        first->status = strcmp(status, "table") == 0    ? PRESENCE_TABLE
+                        : strcmp(status, "lobby") == 0  ? PRESENCE_LOBBY
+                        : strcmp(status, "online") == 0 ? PRESENCE_ONLINE
+                                                        : PRESENCE_OFFLINE;
+        mpack_expect_cstr_match(&reader, "tableId");
+        first->table_id = mpack_expect_i32(&reader);
+    }
+    mpack_reader_destroy(&reader);
+    return count;
+}
+
+TEST(test_presence_batched_updates)
+{
+    presence_free();
+    social_cache_free();
+    int alice_fds[2];
+    int bob_fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, alice_fds) == 0);
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, bob_fds) == 0);
+
+    // alice (1) is friends with bob (2) and carol (3, offline)
+    dbFriendList* alice_friends = malloc(sizeof(dbFriendList));
+    alice_friends->num = 2;
+    alice_friends->friends = calloc(2, sizeof(dbFriend));
+    alice_friends->friends[0].user_id = 2;
+    alice_friends->friends[1].user_id = 3;
+    ASSERT(social_cache_adopt(1, alice_friends, calloc(1, sizeof(dbInviteList))) == 0);
+    dbFriendList* bob_friends = malloc(sizeof(dbFriendList));
+    bob_friends->num = 1;
+    bob_friends->friends = calloc(1, sizeof(dbFriend));
+    bob_friends->friends[0].user_id = 1;
+    ASSERT(social_cache_adopt(2, bob_friends, calloc(1, sizeof(dbInviteList))) == 0);
+
+    conn_data_t* alice = init_connection_data(alice_fds[0]);
+    alice->user_id = 1;
+    strcpy(alice->username, "alice");
+    conn_data_t* bob = init_connection_data(bob_fds[0]);
+    bob->user_id = 2;
+    strcpy(bob->username, "bob");
+
+    presence_connect(alice);
+    presence_connect(bob);
+    ASSERT(presence_online_count() == 2);
+    ASSERT(presence_find_by_username("bob") == bob);
+    ASSERT(presence_find_by_username("carol") == NULL);
+
+    // Both come online in the same tick: each gets one snapshot of the other, nothing twice
+    PresenceChange change;
+    presence_flush();
+    ASSERT(read_presence_update(alice_fds[1], &change) == 1);
+    ASSERT(change.user_id == 2 && change.status == PRESENCE_ONLINE);
+    ASSERT(read_presence_update(bob_fds[1], &change) == 1);
+    ASSERT(change.user_id == 1 && strcmp(change.username, "alice") == 0);
+    ASSERT(read_presence_update(bob_fds[1], &change) == -1);
+
+    // Flapping within a tick is published once, with the final state
+    alice->table_id = 5;
+    presence_refresh(alice);
+    alice->table_id = 0;
+    presence_refresh(alice);
+    alice->table_id = 7;
+    presence_refresh(alice);
+    presence_flush();
+    ASSERT(read_presence_update(bob_fds[1], &change) == 1);
+    ASSERT(change.user_id == 1 && change.status == PRESENCE_TABLE && change.table_id == 7);
+    ASSERT(read_presence_update(bob_fds[1], &change) == -1);
+    ASSERT(read_presence_update(alice_fds[1], &change) == -1);
+
+    // A change that is undone before the tick sends nothing
+    alice->table_id = 0;
+    presence_refresh(alice);
+    alice->table_id = 7;
+    presence_refresh(alice);
+    presence_flush();
+    ASSERT(read_presence_update(bob_fds[1], &change) == -1);
+
+    // Going offline reaches the friends, then the user is forgotten
+    presence_disconnect(alice);
+    social_cache_release(1);
+    presence_flush();
+    ASSERT(read_presence_update(bob_fds[1], &change) == 1);
+    ASSERT(change.user_id == 1 && change.status == PRESENCE_OFFLINE);
+    ASSERT(presence_status(1, NULL) == PRESENCE_OFFLINE);
+    ASSERT(presence_find_by_username("alice") == NULL);
+    ASSERT(presence_online_count() == 1);
+
+    presence_free();
+    social_cache_free();
+    free(alice);
+    free(bob);
+    close(alice_fds[0]);
+    close(alice_fds[1]);
+    close(bob_fds[0]);
+    close(bob_fds[1]);
+}
+
+static void* record_metrics_thread(void* arg)
+{
+    (void)arg;
+    for (uint64_t i = 1; i <= 1000; i++)
+    {
+        metrics_record(METRIC_LATENCY_DB_QUERY, i * 1000);
+    }
+    metrics_add(METRIC_BYTES_OUT, 500);
+    return NULL;
+}
+
+TEST(test_metrics_histograms)
+{
+    metrics_reset();
+
+    // Two threads record into their own shards; snapshots see the sum
+    pthread_t thread;
+    ASSERT(pthread_create(&thread, NULL, record_metrics_thread, NULL) == 0);
+    for (uint64_t i = 1; i <= 1000; i++)
+    {
+        metrics_record(METRIC_LATENCY_DB_QUERY, i * 1000);
+    }
+    metrics_add(METRIC_BYTES_OUT, 250);
+    pthread_join(thread, NULL);
+
+    ASSERT(metrics_counter(METRIC_BYTES_OUT) == 750);
+    MetricsHistogram histogram;
+    metrics_latency(METRIC_LATENCY_DB_QUERY, &histogram);
+    ASSERT(histogram.count == 2000);
+    ASSERT(histogram.max_ns == 1000000);
+
+    // Reported percentiles stay within one sub-bucket (12.5%) above the exact value
+    uint64_t p50 = metrics_percentile(&histogram, 0.5);
+    uint64_t p99 = metrics_percentile(&histogram, 0.99);
+    ASSERT(p50 >= 500000 && p50 <= 562500);
+    ASSERT(p99 >= 990000 && p99 <= 1000000);
+
+    // Small values are exact
+    metrics_record(METRIC_LATENCY_BROADCAST, 3);
+    metrics_latency(METRIC_LATENCY_BROADCAST, &histogram);
+    ASSERT(metrics_percentile(&histogram, 1.0) == 3);
+
+    // Request latency is kept per packet type
+    metrics_record_packet(PACKET_ACTION_REQUEST, 2000);
+    ASSERT(metrics_packet_latency(PACKET_ACTION_REQUEST / 10, &histogram));
+    ASSERT(histogram.count == 1);
+    ASSERT(!metrics_packet_latency(PACKET_LOGIN / 10, &histogram));
+    metrics_reset();
+}
+
+TEST(test_admin_snapshot)
+{
+    TableList* table_list = init_table_list(4);
+    add_table(table_list, "Admin 1", 6, 100);
+    metrics_reset();
+    metrics_record_packet(PACKET_LOGIN, 5000);
+
+    char* snapshot = NULL;
+    size_t len = admin_render(table_list, &snapshot);
+    ASSERT(len > 0 && snapshot != NULL);
+    ASSERT(strstr(snapshot, "cardio_tables 1\n") != NULL);
+    ASSERT(strstr(snapshot, "cardio_table_max_players{table=\"1\"} 6\n") != NULL);
+    ASSERT(strstr(snapshot, "cardio_packet_latency_count{type=\"100\"} 1\n") != NULL);
+    ASSERT(strstr(snapshot, "cardio_queue_depth{queue=\"bot_decisions\"} ") != NULL);
+    ASSERT(len > 6 && strcmp(snapshot + len - 6, "# EOF\n") == 0);
+    free(snapshot);
+
+    // Served over the Unix socket: one snapshot per connection
+    const char* path = "/tmp/cardio_admin_test.sock";
+    int listen_fd = admin_init(path);
+    ASSERT(listen_fd != -1);
+    int client_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    ASSERT(connect(client_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    admin_accept(listen_fd, table_list);
+
+    char buf[65536];
+    size_t received = 0;
+    ssize_t n;
+    while ((n = recv(client_fd, buf + received, sizeof(buf) - 1 - received, 0)) > 0)
+    {
+        received += n;
+    }
+    buf[received] = '\0';
+    ASSERT(strstr(buf, "cardio_tables 1\n") != NULL);
+    ASSERT(received > 6 && strcmp(buf + received - 6, "# EOF\n") == 0);
+
+    close(client_fd);
+    admin_shutdown();
+    ASSERT(access(path, F_OK) != 0);
+    free_table_list(table_list);
+    metrics_reset();
+}
+
+// Pump completions until one of the given type arrives
+static bool uring_expect(UringEventType type, UringEvent* event)
+{
+    for (int waits = 0; waits < 8; waits++)
+    {
+        while (uring_next(event))
+        {
+            if (event->type == type)
+            {
+                return true;
+            }
+            uring_release(event);
+        }
+        if (uring_wait() == -1)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+TEST(test_uring_backend)
+{
+    int listener = get_listener_socket("127.0.0.1", "18091", 8);
+    ASSERT(listener != -1);
+    if (uring_init(listener) != 0)
+    {
+        printf("io_uring unavailable, skipping\n");
+        close(listener);
+        return;
+    }
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(18091);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT(connect(client_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+
+    UringEvent event;
+    ASSERT(uring_expect(URING_EVENT_ACCEPT, &event));
+    conn_data_t* conn = uring_add_connection(event.fd);
+    ASSERT(conn != NULL);
+
+    ASSERT(send(client_fd, "hello", 5, 0) == 5);
+    ASSERT(uring_expect(URING_EVENT_DATA, &event));
+    ASSERT(event.conn == conn && event.len == 5 && memcmp(event.data, "hello", 5) == 0);
+    uring_release(&event);
+
+    // Replies are queued, then leave in order as one send on the next wait
+    int len = 3;
+    ASSERT(sendall(conn->fd, "abc", &len) == 0);
+    len = 3;
+    ASSERT(sendall(conn->fd, "def", &len) == 0);
+    ASSERT(uring_wait() == 0);
+    char buf[16] = {0};
+    size_t received = 0;
+    while (received < 6)
+    {
+        ssize_t n = recv(client_fd, buf + received, sizeof(buf) - 1 - received, 0);
+        ASSERT(n > 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        received += (size_t)n;
+    }
+    ASSERT_STR_EQ(buf, "abcdef");
+
+    close(client_fd);
+    ASSERT(uring_expect(URING_EVENT_CLOSED, &event));
+    ASSERT(event.conn == conn && event.len == 0);
+    close_connection(-1, conn);
+    close(listener);
+}
+
+TEST(test_outbox_batching)
+{
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    outbox_enable();
+
+    // Three packets queued during one iteration leave in one write at the end of it
+    uint64_t writes = metrics_counter(METRIC_SOCKET_WRITES);
+    const char* packets[] = {"result;", "state;", "balance;"};
+    for (int i = 0; i < 3; i++)
+    {
+        int len = (int)strlen(packets[i]);
+        ASSERT(sendall(fds[0], (char*)packets[i], &len) == 0);
+    }
+    char buf[64] = {0};
+    ASSERT(recv(fds[1], buf, sizeof(buf) - 1, MSG_DONTWAIT) == -1);
+
+    outbox_flush();
+    ASSERT(metrics_counter(METRIC_SOCKET_WRITES) == writes + 1);
+    ASSERT(recv(fds[1], buf, sizeof(buf) - 1, 0) == 21);
+    ASSERT_STR_EQ(buf, "result;state;balance;");
+
+    int connections;
+    size_t bytes;
+    outbox_stats(&connections, &bytes);
+    ASSERT(connections == 0 && bytes == 0);
+
+    outbox_close(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+#define MAILBOX_TEST_PRODUCERS 4
+#define MAILBOX_TEST_MESSAGES 20000
+
+typedef struct
+{
+    MailboxNode node;
+    int producer;
+    int seq;
+} MailboxTestMessage;
+
+typedef struct
+{
+    Mailbox* mailbox;
+    MailboxTestMessage* messages;
+} MailboxTestProducer;
+
+static void* mailbox_producer_thread(void* arg)
+{
+    MailboxTestProducer* producer = arg;
+    for (int i = 0; i < MAILBOX_TEST_MESSAGES; i++)
+    {
+        mailbox_push(producer->mailbox, &producer->messages[i].node);
+    }
+    return NULL;
+}
+
+TEST(test_table_mailbox)
+{
+    // Producers push concurrently while the owner pops; each producer's messages arrive in order
+    Mailbox mailbox;
+    mailbox_init(&mailbox);
+    ASSERT(mailbox_empty(&mailbox));
+    ASSERT(mailbox_pop(&mailbox) == NULL);
+
+    pthread_t threads[MAILBOX_TEST_PRODUCERS];
+    MailboxTestProducer producers[MAILBOX_TEST_PRODUCERS];
+    for (int p = 0; p < MAILBOX_TEST_PRODUCERS; p++)
+    {
+        producers[p].mailbox = &mailbox;
+        producers[p].messages = calloc(MAILBOX_TEST_MESSAGES, sizeof(MailboxTestMessage));
+        ASSERT(producers[p].messages != NULL);
+        for (int i = 0; i < MAILBOX_TEST_MESSAGES; i++)
+        {
+            producers[p].messages[i].producer = p;
+            producers[p].messages[i].seq = i;
+        }
+        ASSERT(pthread_create(&threads[p], NULL, mailbox_producer_thread, &producers[p]) == 0);
+    }
+
+    int next_seq[MAILBOX_TEST_PRODUCERS] = {0};
+    int received = 0;
+    bool in_order = true;
+    while (received < MAILBOX_TEST_PRODUCERS * MAILBOX_TEST_MESSAGES)
+    {
+        MailboxNode* node = mailbox_pop(&mailbox);
+        if (node == NULL)
+        {
+            continue;
+        }
+        MailboxTestMessage* message = MAILBOX_ENTRY(node, MailboxTestMessage, node);
+        in_order &= message->seq == next_seq[message->producer];
+        next_seq[message->producer] = message->seq + 1;
+        received++;
+    }
+    for (int p = 0; p < MAILBOX_TEST_PRODUCERS; p++)
+    {
+        pthread_join(threads[p], NULL);
+        free(producers[p].messages);
+    }
+    ASSERT(in_order);
+    ASSERT(mailbox_pop(&mailbox) == NULL && mailbox_empty(&mailbox));
+
+    // A queued action from someone not seated is dropped when the table's batch runs
+    TableList* table_list = init_table_list(4);
+    int table_id = add_table(table_list, "Mailbox", 6, 100);
+    Table* table = &table_list->tables[find_table_by_id(table_list, table_id)];
+    ASSERT(table->actor != NULL);
+
+    TableCommand* cmd = calloc(1, sizeof(TableCommand));
+    cmd->type = TABLE_CMD_ACTION;
+    cmd->user_id = 4242;
+    cmd->action.type = ACTION_CHECK;
+    table_actor_post(table->actor, cmd);
+    ASSERT(table_actors_pending() == 1);
+    table_actors_run(table_list);
+    ASSERT(table_actors_pending() == 0);
+    ASSERT(table->game_state->seq == 0);
+
+    free_table_list(table_list);
+}
+
+// Receive one queued packet from the test end of a socketpair and return its type
+static int recv_packet_type(int fd)
+{
+    outbox_flush();
+    char buf[8192];
+    if (recv(fd, buf, sizeof(buf), 0) < (ssize_t)sizeof(Header))
+    {
+        return -1;
+    }
+    Header* header = decode_header(buf);
+    int type = header->packet_type;
+    free(header);
+    return type;
+}
+
+TEST(test_session_resume)
+{
+    ASSERT(session_init() != -1);
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    conn_data_t* conn = init_connection_data(fds[0]);
+    conn->user_id = 77;
+    strcpy(conn->username, "resumer");
+
+    // Tokens are signed: any change to one is rejected
+    char token[SESSION_TOKEN_LEN + 1];
+    ASSERT(session_issue(conn, token) == 0);
+    ASSERT(strlen(token) == SESSION_TOKEN_LEN);
+    ASSERT(session_find(token) == conn);
+    char forged[SESSION_TOKEN_LEN + 1];
+    strcpy(forged, token);
+    forged[7] = forged[7] == '0' ? '1' : '0'; // Different user id
+    ASSERT(session_find(forged) == NULL);
+    strcpy(forged, token);
+    forged[SESSION_TOKEN_LEN - 1] = forged[SESSION_TOKEN_LEN - 1] == '0' ? '1' : '0';
+    ASSERT(session_find(forged) == NULL);
+    ASSERT(session_find("00") == NULL);
+
+    // Issuing again rotates the session, so each token resumes once
+    char rotated[SESSION_TOKEN_LEN + 1];
+    ASSERT(session_issue(conn, rotated) == 0);
+    ASSERT(session_find(token) == NULL);
+    ASSERT(session_find(rotated) == conn);
+
+    // A dropped connection is parked, socket closed, and stays findable until its grace window ends
+    TableList* table_list = init_table_list(4);
+    drop_connection(-1, conn, table_list);
+    ASSERT(conn->fd == -1 && session_parked(conn));
+    ASSERT(session_parked_count() == 1);
+    ASSERT(session_find(rotated) == conn);
+    session_expire_at(table_list, 0);
+    ASSERT(session_find(rotated) == conn);
+    session_expire_at(table_list, UINT64_MAX);
+    ASSERT(session_parked_count() == 0);
+    ASSERT(session_find(rotated) == NULL);
+    close(fds[1]);
+
+    // Catch-up replays the actions a resumed client missed while the table still remembers them
+    int table_id = add_table(table_list, "Resume", 6, 100);
+    Table* table = &table_list->tables[find_table_by_id(table_list, table_id)];
+    GameState* gs = table->game_state;
+    gs->hand_id = 3;
+    for (uint32_t seq = 1; seq <= 70; seq++)
+    {
+        ActionRecord record = {.seq = seq, .seat = (int)seq % 2, .player_id = 1 + (int)seq % 2, .type = ACTION_CALL};
+        table_remember_action(table, &record);
+        gs->seq = seq;
+        if (seq == 5)
+        {
+            ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+            conn = init_connection_data(fds[0]);
+            conn->user_id = 1;
+            table_send_catch_up(table, conn, 3, 2);
+            ASSERT(recv_packet_type(fds[1]) == PACKET_UPDATE_BUNDLE);
+            table_send_catch_up(table, conn, 2, 5);
+            ASSERT(recv_packet_type(fds[1]) == PACKET_UPDATE_GAMESTATE);
+        }
+    }
+    table_send_catch_up(table, conn, 3, 1);
+    ASSERT(recv_packet_type(fds[1]) == PACKET_UPDATE_GAMESTATE);
+    table_send_catch_up(table, conn, 3, 10);
+    ASSERT(recv_packet_type(fds[1]) == PACKET_UPDATE_BUNDLE);
+
+    outbox_close(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+    free(conn);
+    free_table_list(table_list);
+}
+
+static bool same_card(const Card* a, const Card* b)
+{
+    return a && b && a->suit == b->suit && a->rank == b->rank;
+}
+
+TEST(test_journal_replay)
+{
+    char path[] = "/tmp/cardio_journal_XXXXXX";
+    int tmp_fd = mkstemp(path);
+    ASSERT(tmp_fd != -1);
+    close(tmp_fd);
+
+    // Seats, the deal and each action are journaled while a hand is played
+    ASSERT(journal_open(path) == 0);
+    TableList* table_list = init_table_list(4);
+    int table_id = add_table(table_list, "Journal", 6, 100);
+    Table* table = &table_list->tables[find_table_by_id(table_list, table_id)];
+    GameState* gs = table->game_state;
+    ASSERT(game_add_player(gs, 501, "alice", 0, 2000) == 0);
+    journal_seat(table, 0);
+    ASSERT(game_add_player(gs, 502, "bob", 2, 3000) == 0);
+    journal_seat(table, 2);
+    journal_hand_start(table);
+    ASSERT(game_start_hand(gs) == 0);
+    for (int i = 0; i < 3; i++)
+    {
+        int seat = gs->active_seat;
+        Action action = {.type = gs->current_bet > gs->players[seat].bet ? ACTION_CALL : ACTION_CHECK};
+        if (i == 2)
+        {
+            action = (Action){.type = ACTION_BET, .amount = 300};
+        }
+        ASSERT(game_process_action(gs, gs->players[seat].player_id, &action) == 0);
+        journal_action(table, seat, &action);
+    }
+    journal_flush(table_list);
+    journal_close();
+
+    // The process died halfway through writing the next record
+    FILE* file = fopen(path, "ab");
+    ASSERT(file != NULL);
+    fwrite("\x40\x00\x00\x00\x01", 1, 5, file);
+    fclose(file);
+
+    // Replay deals the same cards from the same seed and ends on the same turn
+    ASSERT(journal_open(path) == 0);
+    TableList* replayed = init_table_list(4);
+    ASSERT(journal_replay(replayed) == 7);
+    int index = find_table_by_id(replayed, table_id);
+    ASSERT(index != -1);
+    GameState* restored = replayed->tables[index].game_state;
+    ASSERT(restored->hand_id == gs->hand_id && restored->seq == gs->seq && restored->deck_seed == gs->deck_seed);
+    ASSERT(restored->betting_round == gs->betting_round && restored->active_seat == gs->active_seat);
+    ASSERT(restored->current_bet == gs->current_bet && restored->num_community_cards == gs->num_community_cards);
+    ASSERT(same_card(restored->community_cards[0], gs->community_cards[0]));
+    bool same_seats = true;
+    for (int seat = 0; seat < MAX_PLAYERS; seat++)
+    {
+        GamePlayer* a = &restored->players[seat];
+        GamePlayer* b = &gs->players[seat];
+        same_seats &= a->state == b->state && a->money == b->money && a->bet == b->bet && a->player_id == b->player_id;
+        if (b->state == PLAYER_STATE_ACTIVE)
+        {
+            same_seats &= same_card(a->hole_cards[0], b->hole_cards[0]) && same_card(a->hole_cards[1], b->hole_cards[1]);
+        }
+    }
+    ASSERT(same_seats);
+
+    // Both players wait, parked, for their next login
+    conn_data_t* alice = session_find_parked(501);
+    ASSERT(alice != NULL && alice->fd == -1 && alice->table_id == table_id && alice->seat == 0);
+    ASSERT(session_find_parked(502) != NULL && session_parked_count() == 2);
+    ASSERT(replayed->tables[index].current_player == 2);
+
+    journal_close();
+    session_expire_at(replayed, UINT64_MAX);
+    ASSERT(session_parked_count() == 0);
+
+    // The torn record is gone: the file is now a checkpoint of the table and the hand it is playing
+    ASSERT(journal_open(path) == 0);
+    TableList* again = init_table_list(4);
+    ASSERT(journal_replay(again) == 5);
+    ASSERT(again->tables[0].game_state->seq == gs->seq && again->tables[0].game_state->players[2].money == gs->players[2].money);
+    journal_close();
+    session_expire_at(again, UINT64_MAX);
+    unlink(path);
+
+    free_table_list(table_list);
+}
+
+TEST(test_handoff_state)
+{
+    ASSERT(session_init() != -1);
+    TableList* table_list = init_table_list(4);
+    int table_id = add_table(table_list, "Handoff", 6, 100);
+    Table* table = &table_list->tables[find_table_by_id(table_list, table_id)];
+    ASSERT(game_add_player(table->game_state, 93, "seated", 2, 2000) == 0);
+
+    // The old process: a lobby player subscribed to deltas, a seated one, and one parked in the lobby
+    int lobby_fds[2];
+    int seated_fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, lobby_fds) == 0);
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, seated_fds) == 0);
+    conn_data_t* lobby_conn = init_connection_data(lobby_fds[0]);
+    lobby_conn->user_id = 91;
+    lobby_conn->balance = 750;
+    strcpy(lobby_conn->username, "mover");
+    conn_data_t* seated_conn = init_connection_data(seated_fds[0]);
+    seated_conn->user_id = 93;
+    seated_conn->table_id = (unsigned short) table_id;
+    seated_conn->seat = 2;
+    strcpy(seated_conn->username, "seated");
+    conn_data_t* parked_conn = init_connection_data(-1);
+    parked_conn->user_id = 92;
+    strcpy(parked_conn->username, "gone");
+
+    char lobby_token[SESSION_TOKEN_LEN + 1];
+    char seated_token[SESSION_TOKEN_LEN + 1];
+    char parked_token[SESSION_TOKEN_LEN + 1];
+    conn_data_t* conns[] = {lobby_conn, seated_conn, parked_conn};
+    char* tokens[] = {lobby_token, seated_token, parked_token};
+    for (int i = 0; i < 3; i++)
+    {
+        register_connection(conns[i]);
+        ASSERT(session_issue(conns[i], tokens[i]) == 0);
+    }
+    ASSERT(session_park(parked_conn) == 0);
+    ASSERT(lobby_subscribe(lobby_fds[0], table_list) == 0);
+
+    int peer[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, peer) == 0);
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT(handoff_send_state(peer[0], listener) == 0);
+
+    // The old process exits; the new one draws its own key, then the journal brings the seat back parked
+    for (int i = 0; i < 3; i++)
+    {
+        close_connection(-1, conns[i]);
+    }
+    close(listener);
+    ASSERT(session_init() != -1);
+    conn_data_t* restored = restore_connection(table, 2);
+    ASSERT(restored != NULL && session_parked(restored));
+
+    int new_listener = handoff_recv_state(peer[1]);
+    ASSERT(new_listener != -1);
+    int epoll_fd = epoll_create1(0);
+    handoff_adopt(epoll_fd, table_list);
+
+    // Tokens from the old process still work: the lobby player kept their socket and subscription,
+    // the seated one's socket is back on the seat, and the lobby parking ended with the old process
+    conn_data_t* moved = session_find(lobby_token);
+    ASSERT(moved != NULL && moved->user_id == 91 && moved->balance == 750 && strcmp(moved->username, "mover") == 0);
+    ASSERT(moved->fd >= 0 && lobby_is_subscribed(moved->fd));
+    ASSERT(session_find(seated_token) == restored && restored->fd >= 0 && !session_parked(restored));
+    ASSERT(session_find(parked_token) == NULL && session_parked_count() == 0);
+
+    // Bytes go through the handed-over sockets
+    ASSERT(send(lobby_fds[1], "hi", 2, 0) == 2);
+    char buf[4] = {0};
+    ASSERT(recv(moved->fd, buf, sizeof(buf), 0) == 2 && strcmp(buf, "hi") == 0);
+
+    close_connection(epoll_fd, moved);
+    drop_connection(epoll_fd, restored, table_list);
+    session_expire_at(table_list, UINT64_MAX);
+    close(lobby_fds[1]);
+    close(seated_fds[1]);
+    close(new_listener);
+    close(epoll_fd);
+    close(peer[0]);
+    close(peer[1]);
+    free_table_list(table_list);
+}
+
+TEST(test_hand_history)
+{
+    TableList* table_list = init_table_list(4);
+    int table_id = add_table(table_list, "History", 6, 100);
+    Table* table = &table_list->tables[find_table_by_id(table_list, table_id)];
+    GameState* gs = table->game_state;
+    ASSERT(game_add_player(gs, 601, "carol", 1, 2000) == 0);
+    ASSERT(game_add_player(gs, 602, "dave", 4, 3000) == 0);
+
+    // The small blind raises to 300 and the big blind folds: the history has both players, both actions,
+    // and stacks that add up; only the raiser put chips in voluntarily
+    history_hand_start(table);
+    ASSERT(game_start_hand(gs) == 0);
+    int seats[2];
+    for (int i = 0; i < 2; i++)
+    {
+        int seat = seats[i] = gs->active_seat;
+        int player_id = gs->players[seat].player_id;
+        int before = gs->players[seat].total_bet;
+        Action action = {.type = i == 0 ? ACTION_RAISE : ACTION_FOLD, .amount = i == 0 ? 300 : 0};
+        ASSERT(game_process_action(gs, player_id, &action) == 0);
+        ActionRecord record = {.seq = gs->seq, .seat = seat, .player_id = player_id, .type = action.type,
+                               .amount = gs->players[seat].total_bet - before, .round = BETTING_ROUND_PREFLOP};
+        table_remember_action(table, &record);
+    }
+    ASSERT(gs->betting_round == BETTING_ROUND_COMPLETE);
+    ASSERT(table->hand_flags[seats[0]] == (ARCHIVE_FLAG_VPIP | ARCHIVE_FLAG_PFR) && table->hand_flags[seats[1]] == 0);
+    history_hand_end(table);
+    ASSERT(table->hand_flags[seats[0]] == 0);
+    history_flush();
+    ASSERT(history_queued_bytes() > 0);
+
+    char* hands;
+    char* players;
+    size_t hands_len;
+    size_t players_len;
+    ASSERT(history_take_batch(HISTORY_BATCH_HANDS, &hands, &hands_len, &players, &players_len) == 1);
+    ASSERT(history_queued_bytes() == 0);
+    unsigned long long key;
+    int row_table;
+    unsigned hand_no;
+    int pot;
+    char actions[32];
+    ASSERT(sscanf(hands, "%llu\t%d\t%u\t%*s %*s\t\t%d\t%31[^\n]", &key, &row_table, &hand_no, &pot, actions) == 5);
+    ASSERT(row_table == table_id && hand_no == gs->hand_id && pot == 400 && hands[hands_len - 1] == '\n');
+    char expected[16];
+    snprintf(expected, sizeof(expected), "%dr250 %df", seats[0], seats[1]);
+    ASSERT(strcmp(actions, expected) == 0);
+
+    int rows = 0;
+    int net = 0;
+    for (char* line = players; line < players + players_len; line = strchr(line, '\n') + 1)
+    {
+        unsigned long long row_key;
+        int row_seat, user_id, start, bet, won;
+        char bot[2], hole[5];
+        ASSERT(sscanf(line, "%llu\t%d\t%d\t%1s\t%4s\t%d\t%d\t%d", &row_key, &row_seat, &user_id, bot, hole, &start,
+                      &bet, &won) == 8);
+        ASSERT(row_key == key && strlen(hole) == 4 && strcmp(bot, "f") == 0);
+        ASSERT(start - bet + won == gs->players[row_seat].money && user_id == gs->players[row_seat].player_id);
+        net += won - bet;
+        rows++;
+    }
+    ASSERT(rows == 2 && net == 0);
+    free(hands);
+    free(players);
+
+    // Without the stacks from the start of the hand (dealt before a restart) nothing is recorded
+    history_hand_end(table);
+    history_flush();
+    ASSERT(history_queued_bytes() == 0);
+    free_table_list(table_list);
+}
+
+TEST(test_replay_log)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/cardio_replay_%d", (int) getpid());
+    ASSERT(replay_log_open(path) == 0);
+    TableList* table_list = init_table_list(4);
+    int table_id = add_table(table_list, "Replay", 6, 100);
+    Table* table = &table_list->tables[find_table_by_id(table_list, table_id)];
+    GameState* gs = table->game_state;
+    ASSERT(gs->hand_log != NULL);
+    game_add_player(gs, 701, "erin", 0, 2000);
+    game_add_player(gs, 702, "frank", 3, 3000);
+
+    // A raise and a fold end the hand: it is logged. The next one is still going when the table closes.
+    ASSERT(game_start_hand(gs) == 0);
+    uint64_t seed = gs->deck_seed;
+    Action raise = {ACTION_RAISE, 300};
+    Action fold = {ACTION_FOLD, 0};
+    ASSERT(game_process_action(gs, gs->players[gs->active_seat].player_id, &raise) == 0);
+    ASSERT(game_process_action(gs, gs->players[gs->active_seat].player_id, &fold) == 0);
+    uint64_t final_hash = game_state_hash(gs);
+    replay_log_hand_end(table);
+    gs->hand_in_progress = false;
+    ASSERT(game_start_hand(gs) == 0);
+    replay_log_hand_end(table);
+    replay_log_close();
+
+    char file[96];
+    char day[16];
+    time_t now = time(NULL);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    strftime(day, sizeof(day), "%Y-%m-%d", &tm);
+    snprintf(file, sizeof(file), "%s.%s", path, day);
+    unsigned char data[2 * HAND_LOG_MAX_RECORD];
+    FILE* in = fopen(file, "rb");
+    ASSERT(in != NULL);
+    size_t len = fread(data, 1, sizeof(data), in);
+    fclose(in);
+    unlink(file);
+
+    // One record, and the engine plays it again to the same state
+    HandLog log;
+    ASSERT(hand_log_decode(data, len, &log) == (long) len);
+    ASSERT(log.game_id == table_id && log.hand_id == 0 && log.deck_seed == seed && log.num_events == 2);
+    ASSERT(log.finished && log.final_hash == final_hash);
+    GameState* replayed = game_state_create(0, 6, 1, 2);
+    ASSERT(replay_hand(replayed, &log, NULL) == 0);
+    ASSERT(replayed->players[0].money + replayed->players[3].money == 5000);
+    game_state_destroy(replayed);
+    free_table_list(table_list);
+}
+
 TEST(test_encode_friendlist_response)
 {
     PGconn* conn = PQconnectdb(dbconninfo);
@@ -333,7 +1593,7 @@ TEST(test_encode_login_success_resp)
     strcpy(user->dob, "2004/01/01");
     strcpy(user->country, "Vietnam");
     strcpy(user->gender, "Male");
-    RawBytes* rawbytes = encode_login_success_response(user);
+    RawBytes* rawbytes = encode_login_success_response(user, NULL);
 
     mpack_reader_t reader;
     mpack_reader_init(&reader, rawbytes->data, rawbytes->len, rawbytes->len);
@@ -535,6 +1795,47 @@ TEST(test_decode_table_invite_request)
     free(request);
 }
 
+TEST(test_encode_game_state_with_actions)
+{
+    GameState* state = game_state_create(1, 4, 5, 10);
+    game_add_player(state, 7, "alice", 0, 500);
+    game_add_player(state, 8, "bob", 1, 500);
+
+    ActionRecord actions[2] = {
+        {.seq = 1, .seat = 0, .player_id = -1, .type = ACTION_CALL, .amount = 5},
+        {.seq = 2, .seat = 1, .player_id = -2, .type = ACTION_CHECK, .amount = 0},
+    };
+
+    RawBytes* encoded = encode_game_state_with_actions(state, 7, actions, 2);
+    ASSERT(encoded != NULL);
+
+    mpack_tree_t tree;
+    mpack_tree_init_data(&tree, encoded->data, encoded->len);
+    mpack_tree_parse(&tree);
+    mpack_node_t root = mpack_tree_root(&tree);
+
+    mpack_node_t notifications = mpack_node_map_cstr(root, "notifications");
+    ASSERT(mpack_node_array_length(notifications) == 2);
+    mpack_node_t second = mpack_node_array_at(notifications, 1);
+    ASSERT(mpack_node_u32(mpack_node_map_cstr(second, "seq")) == 2);
+    ASSERT(mpack_node_int(mpack_node_map_cstr(second, "seat")) == 1);
+    ASSERT(mpack_tree_error(&tree) == mpack_ok);
+    mpack_tree_destroy(&tree);
+
+    // Without actions the payload is the plain 21-key game state
+    RawBytes* plain = encode_game_state(state, 7);
+    mpack_tree_init_data(&tree, plain->data, plain->len);
+    mpack_tree_parse(&tree);
+    ASSERT(mpack_node_map_count(mpack_tree_root(&tree)) == 21);
+    mpack_tree_destroy(&tree);
+
+    free(encoded->data);
+    free(encoded);
+    free(plain->data);
+    free(plain);
+    game_state_destroy(state);
+}
+
 int main()
 {
     RUN_TEST(test_db_conn);
@@ -555,4 +1856,23 @@ int main()
     RUN_TEST(test_decode_action_request_signed_seq);
     RUN_TEST(test_encode_action_result);
     RUN_TEST(test_decode_table_invite_request);
+    RUN_TEST(test_encode_game_state_with_actions);
+    RUN_TEST(test_lobby_tables_packet_cache);
+    RUN_TEST(test_lobby_subscription_delta);
+    RUN_TEST(test_lobby_delta_split);
+    RUN_TEST(test_lobby_query_tables);
+    RUN_TEST(test_spectator_shared_fanout);
+    RUN_TEST(test_leaderboard_incremental);
+    RUN_TEST(test_social_cache_write_through);
+    RUN_TEST(test_presence_batched_updates);
+    RUN_TEST(test_metrics_histograms);
+    RUN_TEST(test_admin_snapshot);
+    RUN_TEST(test_uring_backend);
+    RUN_TEST(test_outbox_batching);
+    RUN_TEST(test_table_mailbox);
+    RUN_TEST(test_session_resume);
+    RUN_TEST(test_journal_replay);
+    RUN_TEST(test_handoff_state);
+    RUN_TEST(test_hand_history);
+    RUN_TEST(test_replay_log);
 }
\ No newline at end of file